@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// render a fixed number of frames offscreen and write the timings
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+#include "TransformKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const int DEFAULT_BENCHMARK_FRAMES = 1000;
+	const int DEFAULT_WARMUP_FRAMES = 30;
+	const char* const DEFAULT_OUTPUT_FILENAME = "benchmark_results.csv";
+
+	// camera orbit used with --orbit
+	const glm::vec3 ORBIT_CENTER = glm::vec3(0.0f, 1.0f, 0.0f);
+	const float ORBIT_RADIUS = 18.0f;
+	const float ORBIT_HEIGHT = 5.5f;
+
+	// counters written for each frame
+	const char* const g_CounterNames[] =
+	{
+		"draws",
+		"instances",
+		"uniform uploads",
+		"uniforms skipped",
+		"culled"
+	};
+	const int COUNTER_COUNT = sizeof(g_CounterNames) / sizeof(g_CounterNames[0]);
+
+	/***********************************************************
+	 *  GetFrameCounter()
+	 *
+	 *  Gets a counter of a logged frame, 0 if it was not set.
+	 ***********************************************************/
+	int GetFrameCounter(const Profiler::FRAME_RECORD& record, const char* name)
+	{
+		std::unordered_map<std::string, int>::const_iterator found = record.counters.find(name);
+
+		return((found != record.counters.end()) ? found->second : 0);
+	}
+
+	/***********************************************************
+	 *  GetGLString()
+	 *
+	 *  Gets an OpenGL description string, never NULL.
+	 ***********************************************************/
+	const char* GetGLString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+
+		return((value != NULL) ? (const char*)value : "unknown");
+	}
+}
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark()
+{
+	m_bEnabled = false;
+	m_bOrbit = false;
+	m_frameCount = DEFAULT_BENCHMARK_FRAMES;
+	m_warmupFrames = DEFAULT_WARMUP_FRAMES;
+	m_outputFilename = DEFAULT_OUTPUT_FILENAME;
+	m_frame = 0;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_startSeconds = 0.0;
+	m_endSeconds = 0.0;
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		m_colorBuffer = 0;
+	}
+	if (m_depthBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  ParseArguments()
+ *
+ *  This method is used for reading the benchmark options
+ *  from the command line.
+ ***********************************************************/
+bool Benchmark::ParseArguments(int argc, char* argv[])
+{
+	for (int index = 1; index < argc; index++)
+	{
+		const char* argument = argv[index];
+		bool bHasValue = (index + 1 < argc);
+
+		if (strcmp(argument, "--benchmark") == 0)
+		{
+			m_bEnabled = true;
+		}
+		else if (strcmp(argument, "--orbit") == 0)
+		{
+			m_bOrbit = true;
+		}
+		else if ((strcmp(argument, "--frames") == 0) && (bHasValue == true))
+		{
+			m_frameCount = atoi(argv[++index]);
+		}
+		else if ((strcmp(argument, "--warmup") == 0) && (bHasValue == true))
+		{
+			m_warmupFrames = atoi(argv[++index]);
+		}
+		else if ((strcmp(argument, "--output") == 0) && (bHasValue == true))
+		{
+			m_outputFilename = argv[++index];
+		}
+		else
+		{
+			std::cout << "Unknown argument:" << argument << std::endl;
+			return(false);
+		}
+	}
+
+	if ((m_frameCount <= 0) || (m_warmupFrames < 0))
+	{
+		std::cout << "The benchmark frame counts must be positive" << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsEnabled()
+ *
+ *  This method is used for checking whether benchmark mode
+ *  was requested.
+ ***********************************************************/
+bool Benchmark::IsEnabled() const
+{
+	return(m_bEnabled);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for turning off vsync and creating
+ *  the offscreen framebuffer with the size of the view.
+ ***********************************************************/
+bool Benchmark::Start(ViewManager* pViewManager)
+{
+	pViewManager->GetViewSize(m_width, m_height);
+
+	// never wait for the display between frames
+	glfwSwapInterval(0);
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Benchmark framebuffer is not complete:" << status << std::endl;
+		return(false);
+	}
+
+	std::cout << "Benchmark: " << m_warmupFrames << " warmup and " << m_frameCount << " measured frames at "
+		<< m_width << "x" << m_height << " on " << GetGLString(GL_RENDERER) << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the offscreen framebuffer
+ *  and placing the camera for the next frame.  The frame log
+ *  of the profiler starts after the warmup frames.
+ ***********************************************************/
+void Benchmark::BeginFrame(ViewManager* pViewManager, Profiler* pProfiler)
+{
+	if (m_frame == m_warmupFrames)
+	{
+		pProfiler->EnableFrameLog();
+		m_startSeconds = glfwGetTime();
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	if (m_bOrbit == true)
+	{
+		// one full orbit over the measured frames, the warmup
+		// frames hold the start pose so that every run measures
+		// the same camera path
+		int measuredFrame = (m_frame > m_warmupFrames) ? m_frame - m_warmupFrames : 0;
+		float angle = 6.2831853f * (float)measuredFrame / (float)m_frameCount;
+		glm::vec3 position = ORBIT_CENTER + glm::vec3(
+			ORBIT_RADIUS * sinf(angle),
+			ORBIT_HEIGHT,
+			ORBIT_RADIUS * cosf(angle));
+
+		pViewManager->SetCameraView(position, glm::normalize(ORBIT_CENTER - position));
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the drawn frame.  The
+ *  commands are flushed in place of the buffer swap.
+ ***********************************************************/
+void Benchmark::EndFrame()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glFlush();
+
+	m_frame++;
+	if (m_frame == m_warmupFrames + m_frameCount)
+	{
+		glFinish();
+		m_endSeconds = glfwGetTime();
+	}
+}
+
+/***********************************************************
+ *  IsFinished()
+ *
+ *  This method is used for checking whether every measured
+ *  frame has been drawn.
+ ***********************************************************/
+bool Benchmark::IsFinished() const
+{
+	return(m_frame >= m_warmupFrames + m_frameCount);
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for reading the last GPU results and
+ *  writing the benchmark results.  Files ending in .json are
+ *  written as JSON, anything else as CSV.
+ ***********************************************************/
+bool Benchmark::WriteResults(Profiler* pProfiler)
+{
+	double seconds = m_endSeconds - m_startSeconds;
+	size_t length = m_outputFilename.length();
+	bool bReturn = false;
+
+	pProfiler->ResolveAllQueries();
+
+	if ((length >= 5) && (m_outputFilename.compare(length - 5, 5, ".json") == 0))
+	{
+		bReturn = WriteJSON(pProfiler, seconds);
+	}
+	else
+	{
+		bReturn = WriteCSV(pProfiler, seconds);
+	}
+
+	if (bReturn == true)
+	{
+		std::cout << "Benchmark: " << pProfiler->GetFrameLog().size() << " frames in " << seconds << " s, "
+			<< ((seconds > 0.0) ? pProfiler->GetFrameLog().size() / seconds : 0.0) << " fps, results written to "
+			<< m_outputFilename << std::endl;
+	}
+
+	return(bReturn);
+}
+
+/***********************************************************
+ *  WriteCSV()
+ *
+ *  This method is used for writing one row per measured
+ *  frame.  The summary is written as comment lines first.
+ ***********************************************************/
+bool Benchmark::WriteCSV(const Profiler* pProfiler, double seconds) const
+{
+	const std::vector<Profiler::FRAME_RECORD>& frames = pProfiler->GetFrameLog();
+
+	std::ofstream outputFile(m_outputFilename.c_str(), std::ios::trunc);
+	if (!outputFile)
+	{
+		std::cout << "Could not write benchmark results:" << m_outputFilename << std::endl;
+		return(false);
+	}
+
+	outputFile << "# renderer: " << GetGLString(GL_RENDERER) << "\n";
+	outputFile << "# version: " << GetGLString(GL_VERSION) << "\n";
+	outputFile << "# simd: " << TransformKernel::GetInstructionSet() << "\n";
+	outputFile << "# frames: " << frames.size() << ", seconds: " << seconds
+		<< ", fps: " << ((seconds > 0.0) ? frames.size() / seconds : 0.0) << "\n";
+
+	outputFile << "frame,cpu_ms,gpu_ms";
+	for (int counter = 0; counter < COUNTER_COUNT; counter++)
+	{
+		outputFile << "," << g_CounterNames[counter];
+	}
+	outputFile << "\n";
+
+	for (size_t index = 0; index < frames.size(); index++)
+	{
+		outputFile << index << "," << frames[index].cpuMilliseconds << "," << frames[index].gpuMilliseconds;
+		for (int counter = 0; counter < COUNTER_COUNT; counter++)
+		{
+			outputFile << "," << GetFrameCounter(frames[index], g_CounterNames[counter]);
+		}
+		outputFile << "\n";
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used for writing the summary statistics
+ *  and every measured frame as a JSON document.
+ ***********************************************************/
+bool Benchmark::WriteJSON(const Profiler* pProfiler, double seconds) const
+{
+	const std::vector<Profiler::FRAME_RECORD>& frames = pProfiler->GetFrameLog();
+	std::vector<float> cpuTimes;
+	std::vector<float> gpuTimes;
+
+	for (size_t index = 0; index < frames.size(); index++)
+	{
+		cpuTimes.push_back(frames[index].cpuMilliseconds);
+		gpuTimes.push_back(frames[index].gpuMilliseconds);
+	}
+	Profiler::FRAME_STATS cpuStats = Profiler::ComputeStats(cpuTimes);
+	Profiler::FRAME_STATS gpuStats = Profiler::ComputeStats(gpuTimes);
+
+	std::ofstream outputFile(m_outputFilename.c_str(), std::ios::trunc);
+	if (!outputFile)
+	{
+		std::cout << "Could not write benchmark results:" << m_outputFilename << std::endl;
+		return(false);
+	}
+
+	// the renderer strings do not contain quotes or backslashes
+	outputFile << "{\n";
+	outputFile << "  \"renderer\": \"" << GetGLString(GL_RENDERER) << "\",\n";
+	outputFile << "  \"version\": \"" << GetGLString(GL_VERSION) << "\",\n";
+	outputFile << "  \"simd\": \"" << TransformKernel::GetInstructionSet() << "\",\n";
+	outputFile << "  \"width\": " << m_width << ",\n";
+	outputFile << "  \"height\": " << m_height << ",\n";
+	outputFile << "  \"frames\": " << frames.size() << ",\n";
+	outputFile << "  \"seconds\": " << seconds << ",\n";
+	outputFile << "  \"fps\": " << ((seconds > 0.0) ? frames.size() / seconds : 0.0) << ",\n";
+	outputFile << "  \"cpu_ms\": { \"min\": " << cpuStats.minMilliseconds << ", \"avg\": " << cpuStats.averageMilliseconds
+		<< ", \"p99\": " << cpuStats.p99Milliseconds << " },\n";
+	outputFile << "  \"gpu_ms\": { \"min\": " << gpuStats.minMilliseconds << ", \"avg\": " << gpuStats.averageMilliseconds
+		<< ", \"p99\": " << gpuStats.p99Milliseconds << " },\n";
+	outputFile << "  \"per_frame\": [\n";
+
+	for (size_t index = 0; index < frames.size(); index++)
+	{
+		outputFile << "    { \"cpu_ms\": " << frames[index].cpuMilliseconds << ", \"gpu_ms\": " << frames[index].gpuMilliseconds;
+		for (int counter = 0; counter < COUNTER_COUNT; counter++)
+		{
+			outputFile << ", \"" << g_CounterNames[counter] << "\": " << GetFrameCounter(frames[index], g_CounterNames[counter]);
+		}
+		outputFile << " }" << ((index + 1 < frames.size()) ? ",\n" : "\n");
+	}
+
+	outputFile << "  ]\n";
+	outputFile << "}\n";
+
+	return(true);
+}
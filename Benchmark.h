@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// render a fixed number of frames offscreen and write the timings
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Profiler.h"
+#include "ViewManager.h"
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class runs the render loop in benchmark mode.  The
+ *  window is hidden, vsync is turned off and every frame is
+ *  drawn into an offscreen framebuffer, optionally while the
+ *  camera orbits the scene.  After the requested number of
+ *  frames the per-frame CPU and GPU timings and counters are
+ *  written to a CSV or JSON file.
+ *
+ *  Command line:
+ *    --benchmark              turn on benchmark mode
+ *    --frames <count>         number of measured frames
+ *    --warmup <count>         frames drawn before measuring
+ *    --output <file>          .csv or .json results file
+ *    --orbit                  orbit the camera around the scene
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// constructor
+	Benchmark();
+	// destructor
+	~Benchmark();
+
+private:
+	bool m_bEnabled;
+	bool m_bOrbit;
+	int m_frameCount;
+	int m_warmupFrames;
+	std::string m_outputFilename;
+
+	// frames drawn since the benchmark started
+	int m_frame;
+	// offscreen framebuffer the frames are drawn into
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_width;
+	int m_height;
+	// wall clock time of the first and last measured frames
+	double m_startSeconds;
+	double m_endSeconds;
+
+	// write the results in each supported format
+	bool WriteCSV(const Profiler* pProfiler, double seconds) const;
+	bool WriteJSON(const Profiler* pProfiler, double seconds) const;
+
+public:
+	// read the benchmark options from the command line, false
+	// is returned if the options are not valid
+	bool ParseArguments(int argc, char* argv[]);
+
+	// check whether benchmark mode was requested
+	bool IsEnabled() const;
+
+	// create the offscreen framebuffer, must be called once the
+	// OpenGL context has been created
+	bool Start(ViewManager* pViewManager);
+
+	// bind the framebuffer and move the camera for the next frame
+	void BeginFrame(ViewManager* pViewManager, Profiler* pProfiler);
+	// finish the frame that was drawn
+	void EndFrame();
+
+	// check whether every measured frame has been drawn
+	bool IsFinished() const;
+
+	// write the benchmark results to the output file
+	bool WriteResults(Profiler* pProfiler);
+};
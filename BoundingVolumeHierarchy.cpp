@@ -0,0 +1,693 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// bounding volume hierarchy over the world bounds of the scene objects
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// most objects a leaf holds before it is split
+	const int LEAF_SIZE = 4;
+	// the tree is built again when refitting has grown the
+	// total area of its boxes past this much of the built area
+	const float REBUILD_AREA_RATIO = 1.5f;
+	// the median split halves every node, so this covers far
+	// more objects than a scene can hold
+	const int MAX_STACK_DEPTH = 64;
+	// one byte of the plane masks per frustum: a bit for each
+	// plane still to be tested, and a bit that stays set while
+	// the frustum may still hold objects under the node
+	const uint32_t ALL_PLANES = (1u << Frustum::PLANE_COUNT) - 1u;
+	const uint32_t FRUSTUM_ACTIVE = 1u << Frustum::PLANE_COUNT;
+	const int FRUSTUM_MASK_BITS = 8;
+
+	// get the surface area of a box
+	float GetBoxArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 size = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+
+		return(2.0f * (size.x * size.y + size.y * size.z + size.z * size.x));
+	}
+
+	// get the distance of the box corner furthest along the
+	// plane normal, the box is outside when it is negative
+	float GetFarDistance(const glm::vec4& plane, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		return(
+			plane.x * ((plane.x >= 0.0f) ? boundsMax.x : boundsMin.x) +
+			plane.y * ((plane.y >= 0.0f) ? boundsMax.y : boundsMin.y) +
+			plane.z * ((plane.z >= 0.0f) ? boundsMax.z : boundsMin.z) +
+			plane.w);
+	}
+
+	// get the distance of the box corner furthest against the
+	// plane normal, the box is inside when it is not negative
+	float GetNearDistance(const glm::vec4& plane, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		return(
+			plane.x * ((plane.x >= 0.0f) ? boundsMin.x : boundsMax.x) +
+			plane.y * ((plane.y >= 0.0f) ? boundsMin.y : boundsMax.y) +
+			plane.z * ((plane.z >= 0.0f) ? boundsMin.z : boundsMax.z) +
+			plane.w);
+	}
+
+	// check whether two boxes overlap, touching counts
+	bool BoxesOverlap(
+		const glm::vec3& aMin,
+		const glm::vec3& aMax,
+		const glm::vec3& bMin,
+		const glm::vec3& bMax)
+	{
+		return(
+			(aMin.x <= bMax.x) && (aMax.x >= bMin.x) &&
+			(aMin.y <= bMax.y) && (aMax.y >= bMin.y) &&
+			(aMin.z <= bMax.z) && (aMax.z >= bMin.z));
+	}
+
+	// check a world space box against the planes left in one
+	// byte of the masks
+	bool IsBoxInFrustum(
+		const Frustum& frustum,
+		uint32_t planeMask,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax)
+	{
+		for (int plane = 0; plane < Frustum::PLANE_COUNT; plane++)
+		{
+			if (((planeMask & (1u << plane)) != 0) &&
+				(GetFarDistance(frustum.GetPlane((Frustum::FRUSTUM_PLANE)plane), boundsMin, boundsMax) < 0.0f))
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+
+	// record an object found by a query
+	void AddObject(int object, uint32_t* pVisibleBits, std::vector<int>* pObjects)
+	{
+		if (NULL != pVisibleBits)
+		{
+			pVisibleBits[object / 32] |= 1u << (object % 32);
+		}
+		if (NULL != pObjects)
+		{
+			pObjects->push_back(object);
+		}
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	m_totalArea = 0.0f;
+	m_builtArea = 0.0f;
+	m_buildCount = 0;
+	m_refitCount = 0;
+}
+
+/***********************************************************
+ *  ~BoundingVolumeHierarchy()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the world
+ *  bounds of every object.  The bounds are copied, so the
+ *  arrays may change before the next refit.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const TransformKernel::BOUNDS_ARRAYS& bounds)
+{
+	int objectCount = (int)bounds.minX.size();
+
+	m_objectMin.resize(objectCount);
+	m_objectMax.resize(objectCount);
+	m_objectOrder.resize(objectCount);
+	m_objectLeaf.resize(objectCount);
+	for (int index = 0; index < objectCount; index++)
+	{
+		m_objectMin[index] = glm::vec3(bounds.minX[index], bounds.minY[index], bounds.minZ[index]);
+		m_objectMax[index] = glm::vec3(bounds.maxX[index], bounds.maxY[index], bounds.maxZ[index]);
+		m_objectOrder[index] = index;
+	}
+
+	m_nodes.clear();
+	m_totalArea = 0.0f;
+	if (objectCount > 0)
+	{
+		m_nodes.reserve(2 * (objectCount / LEAF_SIZE + 1));
+		BuildNode(0, objectCount, -1);
+	}
+	m_builtArea = m_totalArea;
+	m_buildCount++;
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the node over a range of
+ *  the object order, and the nodes below it.  The range is
+ *  split at the median of the object centers along its
+ *  longest axis.  The index of the node is returned.
+ ***********************************************************/
+int BoundingVolumeHierarchy::BuildNode(int first, int count, int parent)
+{
+	int node = (int)m_nodes.size();
+	BVH_NODE newNode;
+
+	newNode.boundsMin = glm::vec3(0.0f);
+	newNode.boundsMax = glm::vec3(0.0f);
+	newNode.first = first;
+	newNode.count = count;
+	newNode.right = -1;
+	newNode.parent = parent;
+	m_nodes.push_back(newNode);
+
+	if (count <= LEAF_SIZE)
+	{
+		for (int index = first; index < first + count; index++)
+		{
+			m_objectLeaf[m_objectOrder[index]] = node;
+		}
+	}
+	else
+	{
+		// the centers are left doubled, which does not change
+		// their order
+		glm::vec3 centerMin(m_objectMin[m_objectOrder[first]] + m_objectMax[m_objectOrder[first]]);
+		glm::vec3 centerMax(centerMin);
+		for (int index = first + 1; index < first + count; index++)
+		{
+			int object = m_objectOrder[index];
+			glm::vec3 center = m_objectMin[object] + m_objectMax[object];
+
+			centerMin = glm::min(centerMin, center);
+			centerMax = glm::max(centerMax, center);
+		}
+
+		glm::vec3 extent = centerMax - centerMin;
+		int axis = 0;
+		if (extent.y > extent[axis])
+		{
+			axis = 1;
+		}
+		if (extent.z > extent[axis])
+		{
+			axis = 2;
+		}
+
+		int middle = first + count / 2;
+		std::nth_element(
+			m_objectOrder.begin() + first,
+			m_objectOrder.begin() + middle,
+			m_objectOrder.begin() + first + count,
+			[this, axis](int a, int b)
+		{
+			return((m_objectMin[a][axis] + m_objectMax[a][axis]) < (m_objectMin[b][axis] + m_objectMax[b][axis]));
+		});
+
+		// the left child is always the next node
+		BuildNode(first, middle - first, node);
+		int right = BuildNode(middle, first + count - middle, node);
+		m_nodes[node].right = right;
+	}
+
+	FitNode(node);
+	m_totalArea += GetBoxArea(m_nodes[node].boundsMin, m_nodes[node].boundsMax);
+
+	return(node);
+}
+
+/***********************************************************
+ *  FitNode()
+ *
+ *  This method is used for setting the box of a node to the
+ *  box around its objects, or around its two children.
+ ***********************************************************/
+void BoundingVolumeHierarchy::FitNode(int node)
+{
+	BVH_NODE& fitNode = m_nodes[node];
+
+	if (fitNode.right < 0)
+	{
+		int object = m_objectOrder[fitNode.first];
+
+		fitNode.boundsMin = m_objectMin[object];
+		fitNode.boundsMax = m_objectMax[object];
+		for (int index = fitNode.first + 1; index < fitNode.first + fitNode.count; index++)
+		{
+			object = m_objectOrder[index];
+			fitNode.boundsMin = glm::min(fitNode.boundsMin, m_objectMin[object]);
+			fitNode.boundsMax = glm::max(fitNode.boundsMax, m_objectMax[object]);
+		}
+	}
+	else
+	{
+		const BVH_NODE& left = m_nodes[node + 1];
+		const BVH_NODE& right = m_nodes[fitNode.right];
+
+		fitNode.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		fitNode.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the tree after some of
+ *  the objects have moved.  The leaf of each moved object is
+ *  fitted to its new bounds, and so are its ancestors until
+ *  one of them keeps its box.  The tree is built again when
+ *  the refitted boxes have grown too large to cull well.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::Refit(
+	const TransformKernel::BOUNDS_ARRAYS& bounds,
+	const std::vector<int>& changedObjects)
+{
+	if ((int)bounds.minX.size() != GetObjectCount())
+	{
+		return(false);
+	}
+	if (changedObjects.size() == 0)
+	{
+		return(true);
+	}
+
+	// every bound is copied first, so a leaf holding several
+	// moved objects is only walked up once
+	for (int object : changedObjects)
+	{
+		m_objectMin[object] = glm::vec3(bounds.minX[object], bounds.minY[object], bounds.minZ[object]);
+		m_objectMax[object] = glm::vec3(bounds.maxX[object], bounds.maxY[object], bounds.maxZ[object]);
+	}
+
+	for (int object : changedObjects)
+	{
+		int node = m_objectLeaf[object];
+
+		while (node >= 0)
+		{
+			glm::vec3 oldMin = m_nodes[node].boundsMin;
+			glm::vec3 oldMax = m_nodes[node].boundsMax;
+
+			FitNode(node);
+
+			const BVH_NODE& fitNode = m_nodes[node];
+			if ((fitNode.boundsMin == oldMin) && (fitNode.boundsMax == oldMax))
+			{
+				break;
+			}
+
+			m_totalArea += GetBoxArea(fitNode.boundsMin, fitNode.boundsMax) - GetBoxArea(oldMin, oldMax);
+			node = fitNode.parent;
+		}
+	}
+	m_refitCount++;
+
+	if (m_totalArea > m_builtArea * REBUILD_AREA_RATIO)
+	{
+		Build(bounds);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects the
+ *  tree was built over.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetObjectCount() const
+{
+	return((int)m_objectOrder.size());
+}
+
+/***********************************************************
+ *  CollectFrusta()
+ *
+ *  This method is used for adding the objects under a node
+ *  that may be inside any of the frusta.  A frustum the node
+ *  is outside of is dropped for the nodes below it, and so
+ *  is each plane the node is completely in front of.  Once a
+ *  frustum has no plane left, every object under the node is
+ *  added without another test.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CollectFrusta(
+	int node,
+	uint32_t planeMasks,
+	const Frustum* pFrusta,
+	int frustumCount,
+	uint32_t* pVisibleBits,
+	std::vector<int>* pObjects) const
+{
+	const BVH_NODE& testNode = m_nodes[node];
+	bool bInside = false;
+
+	for (int frustum = 0; frustum < frustumCount; frustum++)
+	{
+		int shift = frustum * FRUSTUM_MASK_BITS;
+		uint32_t planeMask = (planeMasks >> shift) & 0xFFu;
+
+		if ((planeMask & FRUSTUM_ACTIVE) == 0)
+		{
+			continue;
+		}
+
+		for (int index = 0; index < Frustum::PLANE_COUNT; index++)
+		{
+			if ((planeMask & (1u << index)) == 0)
+			{
+				continue;
+			}
+
+			const glm::vec4& plane = pFrusta[frustum].GetPlane((Frustum::FRUSTUM_PLANE)index);
+			if (GetFarDistance(plane, testNode.boundsMin, testNode.boundsMax) < 0.0f)
+			{
+				planeMask = 0;
+				break;
+			}
+			if (GetNearDistance(plane, testNode.boundsMin, testNode.boundsMax) >= 0.0f)
+			{
+				planeMask &= ~(1u << index);
+			}
+		}
+
+		planeMasks = (planeMasks & ~(0xFFu << shift)) | (planeMask << shift);
+		if (planeMask == FRUSTUM_ACTIVE)
+		{
+			bInside = true;
+		}
+	}
+
+	if (planeMasks == 0)
+	{
+		return;
+	}
+
+	if ((bInside == true) || (testNode.right < 0))
+	{
+		for (int index = testNode.first; index < testNode.first + testNode.count; index++)
+		{
+			int object = m_objectOrder[index];
+			bool bVisible = bInside;
+
+			for (int frustum = 0; (frustum < frustumCount) && (bVisible == false); frustum++)
+			{
+				uint32_t planeMask = (planeMasks >> (frustum * FRUSTUM_MASK_BITS)) & 0xFFu;
+
+				bVisible = ((planeMask & FRUSTUM_ACTIVE) != 0) &&
+					(IsBoxInFrustum(pFrusta[frustum], planeMask, m_objectMin[object], m_objectMax[object]) == true);
+			}
+
+			if (bVisible == true)
+			{
+				AddObject(object, pVisibleBits, pObjects);
+			}
+		}
+		return;
+	}
+
+	CollectFrusta(node + 1, planeMasks, pFrusta, frustumCount, pVisibleBits, pObjects);
+	CollectFrusta(testNode.right, planeMasks, pFrusta, frustumCount, pVisibleBits, pObjects);
+}
+
+/***********************************************************
+ *  CullFrustum()
+ *
+ *  This method is used for writing one bit per object, set
+ *  for the objects that may be inside the frustum.  A box is
+ *  kept by the same test as Frustum::IsBoxVisible(), so the
+ *  bits match testing every object on its own.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CullFrustum(const Frustum& frustum, uint32_t* pVisibleBits) const
+{
+	CullFrusta(&frustum, 1, pVisibleBits);
+}
+
+/***********************************************************
+ *  CullFrusta()
+ *
+ *  This method is used for writing one bit per object, set
+ *  for the objects that may be inside any of the frusta, such
+ *  as the views of a split screen.  The tree is walked once
+ *  for all of them, so a node outside every frustum is only
+ *  tested once.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CullFrusta(const Frustum* pFrusta, int frustumCount, uint32_t* pVisibleBits) const
+{
+	int wordCount = (GetObjectCount() + 31) / 32;
+	uint32_t planeMasks = 0;
+
+	for (int word = 0; word < wordCount; word++)
+	{
+		pVisibleBits[word] = 0;
+	}
+
+	if (frustumCount > MAX_FRUSTA)
+	{
+		frustumCount = MAX_FRUSTA;
+	}
+	for (int frustum = 0; frustum < frustumCount; frustum++)
+	{
+		planeMasks |= (ALL_PLANES | FRUSTUM_ACTIVE) << (frustum * FRUSTUM_MASK_BITS);
+	}
+
+	if ((m_nodes.size() > 0) && (planeMasks != 0))
+	{
+		CollectFrusta(0, planeMasks, pFrusta, frustumCount, pVisibleBits, NULL);
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the objects that may be
+ *  inside a frustum, in no particular order.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<int>& objects) const
+{
+	objects.clear();
+
+	if (m_nodes.size() > 0)
+	{
+		CollectFrusta(0, ALL_PLANES | FRUSTUM_ACTIVE, &frustum, 1, NULL, &objects);
+	}
+}
+
+/***********************************************************
+ *  QueryBox()
+ *
+ *  This method is used for finding the objects whose world
+ *  bounds overlap a world space box, in no particular order.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryBox(
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	std::vector<int>& objects) const
+{
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+
+	objects.clear();
+	if (m_nodes.size() > 0)
+	{
+		stack[stackSize++] = 0;
+	}
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		if (BoxesOverlap(node.boundsMin, node.boundsMax, boundsMin, boundsMax) == false)
+		{
+			continue;
+		}
+
+		if (node.right >= 0)
+		{
+			stack[stackSize++] = node.right;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+
+		for (int index = node.first; index < node.first + node.count; index++)
+		{
+			int object = m_objectOrder[index];
+
+			if (BoxesOverlap(m_objectMin[object], m_objectMax[object], boundsMin, boundsMax) == true)
+			{
+				objects.push_back(object);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  IntersectRay()
+ *
+ *  This method is used for finding the objects whose world
+ *  bounds are passed through by a ray, sorted by where the
+ *  ray enters them.  The ray parameter is measured in units
+ *  of the direction, which does not need to be normalized.
+ ***********************************************************/
+void BoundingVolumeHierarchy::IntersectRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	std::vector<RAY_HIT>& hits) const
+{
+	glm::vec3 inverseDirection = InvertDirection(direction);
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	float entry = 0.0f;
+	float exit = 0.0f;
+
+	hits.clear();
+	if (m_nodes.size() > 0)
+	{
+		stack[stackSize++] = 0;
+	}
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		if ((IntersectBox(origin, inverseDirection, node.boundsMin, node.boundsMax, entry, exit) == false) ||
+			(entry > maxDistance))
+		{
+			continue;
+		}
+
+		if (node.right >= 0)
+		{
+			stack[stackSize++] = node.right;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+
+		for (int index = node.first; index < node.first + node.count; index++)
+		{
+			int object = m_objectOrder[index];
+
+			if ((IntersectBox(origin, inverseDirection, m_objectMin[object], m_objectMax[object], entry, exit) == true) &&
+				(entry <= maxDistance))
+			{
+				RAY_HIT hit;
+				hit.object = object;
+				hit.distance = entry;
+				hits.push_back(hit);
+			}
+		}
+	}
+
+	std::sort(hits.begin(), hits.end(), [](const RAY_HIT& a, const RAY_HIT& b)
+	{
+		return(a.distance < b.distance);
+	});
+}
+
+/***********************************************************
+ *  GetBuildCount()
+ *
+ *  This method is used for getting the number of times the
+ *  tree has been built.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetBuildCount() const
+{
+	return(m_buildCount);
+}
+
+/***********************************************************
+ *  GetRefitCount()
+ *
+ *  This method is used for getting the number of times the
+ *  tree has been refitted.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetRefitCount() const
+{
+	return(m_refitCount);
+}
+
+/***********************************************************
+ *  InvertDirection()
+ *
+ *  This method is used for getting the reciprocal of each
+ *  component of a ray direction.  A zero component would
+ *  give an infinity, which multiplied by a zero distance to
+ *  a slab gives a NaN, so a large finite value is used.
+ ***********************************************************/
+glm::vec3 BoundingVolumeHierarchy::InvertDirection(const glm::vec3& direction)
+{
+	glm::vec3 inverseDirection;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (fabsf(direction[axis]) > 1e-20f)
+		{
+			inverseDirection[axis] = 1.0f / direction[axis];
+		}
+		else
+		{
+			inverseDirection[axis] = (direction[axis] < 0.0f) ? -1e30f : 1e30f;
+		}
+	}
+
+	return(inverseDirection);
+}
+
+/***********************************************************
+ *  IntersectBox()
+ *
+ *  This method is used for intersecting a ray with the three
+ *  slabs of a box.  The ray enters the box where it has
+ *  entered every slab and leaves it at the first slab it
+ *  leaves.  A ray starting inside the box enters it at 0.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IntersectBox(
+	const glm::vec3& origin,
+	const glm::vec3& inverseDirection,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	float& entry,
+	float& exit)
+{
+	entry = 0.0f;
+	exit = 1e30f;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float slabNear = (boundsMin[axis] - origin[axis]) * inverseDirection[axis];
+		float slabFar = (boundsMax[axis] - origin[axis]) * inverseDirection[axis];
+
+		if (slabNear > slabFar)
+		{
+			std::swap(slabNear, slabFar);
+		}
+		entry = std::max(entry, slabNear);
+		exit = std::min(exit, slabFar);
+	}
+
+	return(entry <= exit);
+}
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// bounding volume hierarchy over the world bounds of the scene objects
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Frustum.h"
+#include "TransformKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class keeps a binary tree of boxes over the world
+ *  bounds of the scene objects, used for culling, picking and
+ *  range queries without testing every object.  The tree is
+ *  built by splitting the objects at the median of their
+ *  centers along the longest axis, so the objects under each
+ *  node are one range of the object order.
+ *
+ *  When objects move, only their leaves and the ancestors of
+ *  those leaves are refitted.  Refitting keeps the tree
+ *  correct but lets its boxes grow, so it is built again once
+ *  the total area of its boxes has grown too far past the
+ *  area it was built with.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+	// destructor
+	~BoundingVolumeHierarchy();
+
+	// most frusta culled together in one pass
+	static const int MAX_FRUSTA = 4;
+
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// range of the object order under the node
+		int first;
+		int count;
+		// right child, -1 for a leaf; the left child always
+		// follows its parent
+		int right;
+		int parent;
+	};
+
+	// an object whose world bounds a ray passes through
+	struct RAY_HIT
+	{
+		int object;
+		// ray parameter where the ray enters the bounds
+		float distance;
+	};
+
+private:
+	// nodes in depth first order, the root is node 0
+	std::vector<BVH_NODE> m_nodes;
+	// world bounds of each object, by object index
+	std::vector<glm::vec3> m_objectMin;
+	std::vector<glm::vec3> m_objectMax;
+	// object indices in leaf order, and the leaf of each object
+	std::vector<int> m_objectOrder;
+	std::vector<int> m_objectLeaf;
+	// total area of the node boxes now and after the last build
+	float m_totalArea;
+	float m_builtArea;
+	// times the tree was built and refitted
+	int m_buildCount;
+	int m_refitCount;
+
+	// build the node over [first, first + count) of the order
+	int BuildNode(int first, int count, int parent);
+	// set the box of a node from its objects or its children
+	void FitNode(int node);
+	// add the objects under a node inside any of the frusta,
+	// with one byte of the masks per frustum holding the planes
+	// that still have to be tested
+	void CollectFrusta(
+		int node,
+		uint32_t planeMasks,
+		const Frustum* pFrusta,
+		int frustumCount,
+		uint32_t* pVisibleBits,
+		std::vector<int>* pObjects) const;
+
+public:
+	// build the tree over the passed in world bounds
+	void Build(const TransformKernel::BOUNDS_ARRAYS& bounds);
+
+	// copy the bounds of the changed objects and refit their
+	// leaves, building again when the tree has degraded; false
+	// is returned when the object count no longer matches
+	bool Refit(
+		const TransformKernel::BOUNDS_ARRAYS& bounds,
+		const std::vector<int>& changedObjects);
+
+	// get the number of objects in the tree
+	int GetObjectCount() const;
+
+	// set bit i of the visible bits for each object i that may
+	// be inside the frustum, clearing the others
+	void CullFrustum(const Frustum& frustum, uint32_t* pVisibleBits) const;
+	// the same for the objects that may be inside any of up to
+	// MAX_FRUSTA frusta, walking the tree once for all of them
+	void CullFrusta(const Frustum* pFrusta, int frustumCount, uint32_t* pVisibleBits) const;
+
+	// find the objects that may be inside the frustum
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& objects) const;
+	// find the objects whose bounds overlap a world space box
+	void QueryBox(
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		std::vector<int>& objects) const;
+
+	// find the objects whose bounds a ray passes through,
+	// nearest first; hits further than maxDistance are skipped
+	void IntersectRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		std::vector<RAY_HIT>& hits) const;
+
+	// get the times the tree was built and refitted
+	int GetBuildCount() const;
+	int GetRefitCount() const;
+
+	// get the reciprocal of a ray direction for IntersectBox(),
+	// with zero components replaced by a large finite value
+	static glm::vec3 InvertDirection(const glm::vec3& direction);
+
+	// get the ray parameters where a ray enters and leaves a
+	// box, false when it misses the box
+	static bool IntersectBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		float& entry,
+		float& exit);
+};
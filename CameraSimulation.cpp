@@ -0,0 +1,366 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerasimulation.cpp
+// ============
+// move the camera at a fixed tick on its own thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraSimulation.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// ticks run back to back to catch up before the missed
+	// ticks are dropped, for example after the process was
+	// suspended
+	const int MAX_CATCH_UP_TICKS = 60;
+
+	/***********************************************************
+	 *  IsSameState()
+	 *
+	 *  Checks whether two camera states are exactly equal.
+	 ***********************************************************/
+	bool IsSameState(
+		const CameraSimulation::CAMERA_STATE& first,
+		const CameraSimulation::CAMERA_STATE& second)
+	{
+		return((first.position == second.position) &&
+			(first.front == second.front) &&
+			(first.up == second.up) &&
+			(first.zoom == second.zoom));
+	}
+
+	/***********************************************************
+	 *  BlendDirection()
+	 *
+	 *  Blends two unit directions, keeping the second one if
+	 *  the blend is too short to normalize.
+	 ***********************************************************/
+	glm::vec3 BlendDirection(const glm::vec3& first, const glm::vec3& second, float amount)
+	{
+		glm::vec3 direction = glm::mix(first, second, amount);
+		float length = glm::length(direction);
+
+		if (length < 0.0001f)
+		{
+			return(second);
+		}
+
+		return(direction / length);
+	}
+}
+
+/***********************************************************
+ *  CameraSimulation()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraSimulation::CameraSimulation(Camera* pCamera, int ticksPerSecond)
+{
+	m_pCamera = pCamera;
+	m_tickSeconds = 1.0f / (float)ticksPerSecond;
+	m_tickLength = std::chrono::duration_cast<CLOCK::duration>(
+		std::chrono::duration<double>(1.0 / (double)ticksPerSecond));
+	m_bRunning = false;
+	for (int key = 0; key < MOVE_KEY_COUNT; key++)
+	{
+		m_keysDown[key] = false;
+	}
+	m_mouseOffset = glm::vec2(0.0f);
+	m_moveSpeed = 1.0f;
+	m_previous = ReadCamera();
+	m_current = m_previous;
+	m_currentTime = CLOCK::now();
+	m_bChanged = true;
+}
+
+/***********************************************************
+ *  ~CameraSimulation()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CameraSimulation::~CameraSimulation()
+{
+	Stop();
+	m_pCamera = NULL;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the simulation thread.
+ ***********************************************************/
+void CameraSimulation::Start()
+{
+	if (m_bRunning == true)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_previous = ReadCamera();
+		m_current = m_previous;
+		m_currentTime = CLOCK::now();
+	}
+
+	m_bRunning = true;
+	m_thread = std::thread(&CameraSimulation::ThreadMain, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the simulation thread
+ *  and waiting for it to exit.
+ ***********************************************************/
+void CameraSimulation::Stop()
+{
+	m_bRunning = false;
+	if (m_thread.joinable() == true)
+	{
+		m_thread.join();
+	}
+}
+
+/***********************************************************
+ *  ThreadMain()
+ *
+ *  This method is run by the simulation thread.  Every tick
+ *  that is due is run with the same fixed length, so a late
+ *  wake up runs several ticks instead of one long one.  The
+ *  main loop is woken when the camera starts moving, since
+ *  it may be waiting for events.
+ ***********************************************************/
+void CameraSimulation::ThreadMain()
+{
+	CLOCK::time_point nextTick = CLOCK::now() + m_tickLength;
+
+	while (m_bRunning == true)
+	{
+		CLOCK::time_point now = CLOCK::now();
+		bool bChanged = false;
+		bool bWake = false;
+
+		if (now - nextTick > MAX_CATCH_UP_TICKS * m_tickLength)
+		{
+			nextTick = now;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			while (nextTick <= now)
+			{
+				if (Tick(nextTick) == true)
+				{
+					bChanged = true;
+				}
+				nextTick += m_tickLength;
+			}
+
+			bWake = (bChanged == true) && (m_bChanged == false);
+			if (bChanged == true)
+			{
+				m_bChanged = true;
+			}
+		}
+
+		if (bWake == true)
+		{
+			glfwPostEmptyEvent();
+		}
+
+		std::this_thread::sleep_until(nextTick);
+	}
+}
+
+/***********************************************************
+ *  Tick()
+ *
+ *  This method is used for moving the camera by the input
+ *  gathered since the last tick.  True is returned when the
+ *  blend between the last two states has changed.
+ ***********************************************************/
+bool CameraSimulation::Tick(CLOCK::time_point tickTime)
+{
+	float distance = m_tickSeconds * m_moveSpeed;
+	CAMERA_STATE state;
+	bool bChanged = false;
+
+	if (m_keysDown[MOVE_FORWARD] == true)
+	{
+		m_pCamera->ProcessKeyboard(FORWARD, distance);
+	}
+	if (m_keysDown[MOVE_BACKWARD] == true)
+	{
+		m_pCamera->ProcessKeyboard(BACKWARD, distance);
+	}
+	if (m_keysDown[MOVE_LEFT] == true)
+	{
+		m_pCamera->ProcessKeyboard(LEFT, distance);
+	}
+	if (m_keysDown[MOVE_RIGHT] == true)
+	{
+		m_pCamera->ProcessKeyboard(RIGHT, distance);
+	}
+	if (m_keysDown[MOVE_UP] == true)
+	{
+		m_pCamera->ProcessKeyboard(UP, distance);
+	}
+	if (m_keysDown[MOVE_DOWN] == true)
+	{
+		m_pCamera->ProcessKeyboard(DOWN, distance);
+	}
+
+	if ((m_mouseOffset.x != 0.0f) || (m_mouseOffset.y != 0.0f))
+	{
+		m_pCamera->ProcessMouseMovement(m_mouseOffset.x, m_mouseOffset.y);
+		m_mouseOffset = glm::vec2(0.0f);
+	}
+
+	// the blend keeps changing for one tick after the camera
+	// stops, until the previous state catches up
+	state = ReadCamera();
+	bChanged = (IsSameState(state, m_current) == false) ||
+		(IsSameState(m_previous, m_current) == false);
+
+	m_previous = m_current;
+	m_current = state;
+	m_currentTime = tickTime;
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  ReadCamera()
+ *
+ *  This method is used for copying the camera values into a
+ *  camera state.
+ ***********************************************************/
+CameraSimulation::CAMERA_STATE CameraSimulation::ReadCamera() const
+{
+	CAMERA_STATE state;
+
+	state.position = m_pCamera->Position;
+	state.front = m_pCamera->Front;
+	state.up = m_pCamera->Up;
+	state.zoom = m_pCamera->Zoom;
+
+	return(state);
+}
+
+/***********************************************************
+ *  SetKeyDown()
+ *
+ *  This method is used for recording a movement key being
+ *  pressed or released.  The camera moves at every tick
+ *  while the key is down.
+ ***********************************************************/
+void CameraSimulation::SetKeyDown(MOVE_KEY key, bool bDown)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_keysDown[key] = bDown;
+}
+
+/***********************************************************
+ *  AddMouseOffset()
+ *
+ *  This method is used for adding a mouse movement, which is
+ *  applied to the camera at the next tick.
+ ***********************************************************/
+void CameraSimulation::AddMouseOffset(float xOffset, float yOffset)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_mouseOffset += glm::vec2(xOffset, yOffset);
+}
+
+/***********************************************************
+ *  SetMoveSpeed()
+ *
+ *  This method is used for setting the multiplier for the
+ *  distance the movement keys move the camera each second.
+ ***********************************************************/
+void CameraSimulation::SetMoveSpeed(float speed)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_moveSpeed = speed;
+}
+
+/***********************************************************
+ *  SetCameraView()
+ *
+ *  This method is used for placing the camera, for example
+ *  along a scripted benchmark path.  Both simulated states
+ *  are set, so the next frame shows the new view without
+ *  blending from the old one.
+ ***********************************************************/
+void CameraSimulation::SetCameraView(glm::vec3 position, glm::vec3 front)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_pCamera->Position = position;
+	m_pCamera->Front = front;
+	m_previous = ReadCamera();
+	m_current = m_previous;
+	m_currentTime = CLOCK::now();
+	m_bChanged = true;
+}
+
+/***********************************************************
+ *  GetInterpolatedState()
+ *
+ *  This method is used for getting the camera state for the
+ *  current time.  The previous state is blended towards the
+ *  current one by the part of a tick that has passed since
+ *  the current state was simulated, so the view trails the
+ *  simulation by at most one tick.
+ ***********************************************************/
+CameraSimulation::CAMERA_STATE CameraSimulation::GetInterpolatedState()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	CAMERA_STATE state;
+	float amount = std::chrono::duration<float>(CLOCK::now() - m_currentTime).count() / m_tickSeconds;
+
+	amount = glm::clamp(amount, 0.0f, 1.0f);
+
+	state.position = glm::mix(m_previous.position, m_current.position, amount);
+	state.front = BlendDirection(m_previous.front, m_current.front, amount);
+	state.up = BlendDirection(m_previous.up, m_current.up, amount);
+	state.zoom = glm::mix(m_previous.zoom, m_current.zoom, amount);
+
+	return(state);
+}
+
+/***********************************************************
+ *  IsChanged()
+ *
+ *  This method is used for checking whether the blended
+ *  camera state has changed since the last ResetChanged().
+ ***********************************************************/
+bool CameraSimulation::IsChanged()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return(m_bChanged);
+}
+
+/***********************************************************
+ *  ResetChanged()
+ *
+ *  This method is used for clearing the changed flag once a
+ *  frame has been drawn with the blended state.
+ ***********************************************************/
+void CameraSimulation::ResetChanged()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_bChanged = false;
+}
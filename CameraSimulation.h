@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerasimulation.h
+// ============
+// move the camera at a fixed tick on its own thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "camera.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+/***********************************************************
+ *  CameraSimulation
+ *
+ *  This class moves the camera at a fixed tick rate on a
+ *  thread of its own, so camera motion does not depend on
+ *  how long the frames take to draw.  The input is gathered
+ *  from the GLFW callbacks on the main thread and applied at
+ *  the next tick.  The last two simulated camera states are
+ *  kept, and the render thread draws a blend of them for the
+ *  time it reads them at, which keeps the motion smooth when
+ *  the frame rate and tick rate differ.
+ ***********************************************************/
+class CameraSimulation
+{
+public:
+	// constructor, the camera must outlive the simulation
+	CameraSimulation(Camera* pCamera, int ticksPerSecond = 240);
+	// destructor
+	~CameraSimulation();
+
+	// camera movement keys that can be held down
+	enum MOVE_KEY
+	{
+		MOVE_FORWARD,
+		MOVE_BACKWARD,
+		MOVE_LEFT,
+		MOVE_RIGHT,
+		MOVE_UP,
+		MOVE_DOWN,
+		MOVE_KEY_COUNT
+	};
+
+	// camera values the view is built from
+	struct CAMERA_STATE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float zoom;
+	};
+
+private:
+	typedef std::chrono::steady_clock CLOCK;
+
+	// camera moved by the simulation thread
+	Camera* m_pCamera;
+	// length of one simulation tick
+	CLOCK::duration m_tickLength;
+	float m_tickSeconds;
+	std::thread m_thread;
+	std::atomic<bool> m_bRunning;
+
+	// guards the input and the simulated states
+	std::mutex m_mutex;
+	// input gathered since the last tick
+	bool m_keysDown[MOVE_KEY_COUNT];
+	glm::vec2 m_mouseOffset;
+	// multiplier for the camera movement speed
+	float m_moveSpeed;
+	// last two simulated states, and the tick time of the
+	// current one
+	CAMERA_STATE m_previous;
+	CAMERA_STATE m_current;
+	CLOCK::time_point m_currentTime;
+	// the blended state changed since the last ResetChanged()
+	bool m_bChanged;
+
+	// run the ticks until the simulation is stopped
+	void ThreadMain();
+	// apply the gathered input for one tick, the mutex must be held
+	bool Tick(CLOCK::time_point tickTime);
+	// copy the camera values into a state
+	CAMERA_STATE ReadCamera() const;
+
+public:
+	// start and stop the simulation thread
+	void Start();
+	void Stop();
+
+	// record a movement key being pressed or released
+	void SetKeyDown(MOVE_KEY key, bool bDown);
+	// add a mouse movement that has been scaled by the speed
+	void AddMouseOffset(float xOffset, float yOffset);
+	// set the speed multiplier for the movement keys
+	void SetMoveSpeed(float speed);
+
+	// place the camera, skipping the blend from the old state
+	void SetCameraView(glm::vec3 position, glm::vec3 front);
+
+	// get the camera state blended for the current time
+	CAMERA_STATE GetInterpolatedState();
+
+	// check whether the blended state has changed since the
+	// last ResetChanged()
+	bool IsChanged();
+	void ResetChanged();
+};
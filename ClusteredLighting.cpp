@@ -0,0 +1,340 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.cpp
+// ============
+// bin point lights into view space clusters on the GPU
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLighting.h"
+
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// shader storage binding points, these must match the
+	// values in the light binning compute shader
+	const GLuint LIGHT_BINDING = 0;
+	const GLuint COUNT_BINDING = 1;
+	const GLuint INDEX_BINDING = 2;
+
+	// local work group size of the light binning shader
+	const GLuint CLUSTER_GROUP_SIZE = 64;
+
+	/***********************************************************
+	 *  GetViewDepth()
+	 *
+	 *  Gets the view space distance of a normalized device depth
+	 *  on the view axis, for perspective and orthographic
+	 *  projections alike.
+	 ***********************************************************/
+	float GetViewDepth(const glm::mat4& inverseProjection, float ndcDepth)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4(0.0f, 0.0f, ndcDepth, 1.0f);
+
+		return(-point.z / point.w);
+	}
+}
+
+/***********************************************************
+ *  ClusteredLighting()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLighting::ClusteredLighting()
+{
+	m_clusterProgram = 0;
+	m_inverseProjectionLocation = -1;
+	m_viewLocation = -1;
+	m_depthRangeLocation = -1;
+	m_lightCountLocation = -1;
+	m_pShaderCache = NULL;
+	m_clusterHandle = -1;
+	for (int index = 0; index < TEXTURE_COUNT; index++)
+	{
+		m_buffers[index] = 0;
+		m_textures[index] = 0;
+	}
+	m_lightCount = 0;
+	m_clusterView.clusterCounts = glm::vec3(0.0f);
+	m_clusterView.tileScale = glm::vec2(0.0f);
+	m_clusterView.viewportOrigin = glm::vec2(0.0f);
+	m_clusterView.depthScaleBias = glm::vec2(0.0f);
+}
+
+/***********************************************************
+ *  ~ClusteredLighting()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLighting::~ClusteredLighting()
+{
+	DestroyBuffers();
+	m_pShaderCache = NULL;
+
+	if (m_clusterProgram != 0)
+	{
+		glDeleteProgram(m_clusterProgram);
+		m_clusterProgram = 0;
+	}
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the light and cluster
+ *  buffers and their buffer textures.
+ ***********************************************************/
+void ClusteredLighting::DestroyBuffers()
+{
+	if (m_buffers[0] != 0)
+	{
+		glDeleteTextures(TEXTURE_COUNT, m_textures);
+		glDeleteBuffers(TEXTURE_COUNT, m_buffers);
+	}
+	for (int index = 0; index < TEXTURE_COUNT; index++)
+	{
+		m_buffers[index] = 0;
+		m_textures[index] = 0;
+	}
+	m_lightCount = 0;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for checking that compute shaders are
+ *  supported, compiling the light binning shader and creating
+ *  the cluster buffers.  With a shader cache the shader is
+ *  requested from the cache and picked up by IsAvailable()
+ *  once it is ready.
+ ***********************************************************/
+bool ClusteredLighting::Initialize(const char* computeShaderFile, ShaderCache* pShaderCache)
+{
+	if ((GLEW_VERSION_4_3 == false) &&
+		((GLEW_ARB_compute_shader == false) ||
+		(GLEW_ARB_shader_storage_buffer_object == false)))
+	{
+		std::cout << "Compute shaders are not supported, clustered lights are off" << std::endl;
+		return(false);
+	}
+
+	if (NULL != pShaderCache)
+	{
+		std::vector<ShaderCache::SHADER_STAGE> stages(1);
+
+		stages[0].type = GL_COMPUTE_SHADER;
+		stages[0].filename = computeShaderFile;
+		m_clusterHandle = pShaderCache->RequestProgram(stages);
+		if (m_clusterHandle < 0)
+		{
+			return(false);
+		}
+		m_pShaderCache = pShaderCache;
+	}
+	else
+	{
+		// a cache without a directory just compiles the shader
+		ShaderCache shaderCache;
+
+		SetClusterProgram(shaderCache.LoadComputeProgram(computeShaderFile));
+		if (m_clusterProgram == 0)
+		{
+			return(false);
+		}
+	}
+
+	// the light list of each cluster has a fixed slot, so the
+	// lists need no allocation on the GPU
+	GLenum formats[TEXTURE_COUNT] = { GL_RGBA32F, GL_R32UI, GL_R32UI };
+	GLsizeiptr sizes[TEXTURE_COUNT] = {
+		sizeof(POINT_LIGHT),
+		CLUSTER_COUNT * sizeof(GLuint),
+		CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(GLuint) };
+
+	glGenBuffers(TEXTURE_COUNT, m_buffers);
+	glGenTextures(TEXTURE_COUNT, m_textures);
+	for (int index = 0; index < TEXTURE_COUNT; index++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[index]);
+		glBufferData(GL_TEXTURE_BUFFER, sizes[index], NULL, GL_DYNAMIC_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[index]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[index], m_buffers[index]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetClusterProgram()
+ *
+ *  This method is used for setting the light binning compute
+ *  program and looking up its uniform locations.
+ ***********************************************************/
+void ClusteredLighting::SetClusterProgram(GLuint program)
+{
+	m_clusterProgram = program;
+	if (m_clusterProgram == 0)
+	{
+		return;
+	}
+
+	m_inverseProjectionLocation = glGetUniformLocation(m_clusterProgram, "inverseProjection");
+	m_viewLocation = glGetUniformLocation(m_clusterProgram, "view");
+	m_depthRangeLocation = glGetUniformLocation(m_clusterProgram, "depthRange");
+	m_lightCountLocation = glGetUniformLocation(m_clusterProgram, "lightCount");
+}
+
+/***********************************************************
+ *  IsAvailable()
+ *
+ *  This method is used for checking whether the binning
+ *  shader is ready.  A shader that is built by the shader
+ *  cache is picked up here once the cache has finished it.
+ ***********************************************************/
+bool ClusteredLighting::IsAvailable()
+{
+	if ((m_clusterProgram == 0) &&
+		(NULL != m_pShaderCache) &&
+		(m_pShaderCache->IsProgramReady(m_clusterHandle) == true))
+	{
+		SetClusterProgram(m_pShaderCache->GetProgram(m_clusterHandle));
+		m_pShaderCache = NULL;
+	}
+
+	return((m_clusterProgram != 0) && (m_buffers[0] != 0));
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for uploading the point lights.  The
+ *  buffer is resized to the number of lights.
+ ***********************************************************/
+void ClusteredLighting::SetLights(const std::vector<POINT_LIGHT>& lights)
+{
+	if (m_buffers[TEXTURE_LIGHTS] == 0)
+	{
+		return;
+	}
+
+	m_lightCount = (int)lights.size();
+
+	// an empty buffer store is not allowed for the texture
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[TEXTURE_LIGHTS]);
+	glBufferData(
+		GL_TEXTURE_BUFFER,
+		(lights.empty() == true) ? sizeof(POINT_LIGHT) : lights.size() * sizeof(POINT_LIGHT),
+		(lights.empty() == true) ? NULL : lights.data(),
+		GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used for getting the number of point
+ *  lights uploaded by the last SetLights().
+ ***********************************************************/
+int ClusteredLighting::GetLightCount() const
+{
+	return(m_lightCount);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for running the light binning compute
+ *  shader for a frame.  One invocation per cluster builds the
+ *  view space box of its cluster from the projection and
+ *  lists the lights whose bounding spheres touch it.  The
+ *  cluster values that the fragment shader needs are kept for
+ *  GetClusterView().
+ ***********************************************************/
+void ClusteredLighting::Update(const glm::mat4& view, const glm::mat4& projection)
+{
+	GLint previousProgram = 0;
+	GLint viewport[4] = { 0, 0, 0, 0 };
+
+	m_clusterView.clusterCounts = glm::vec3(0.0f);
+	if ((IsAvailable() == false) || (m_lightCount == 0))
+	{
+		return;
+	}
+
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glm::vec2 depthRange(
+		GetViewDepth(inverseProjection, -1.0f),
+		GetViewDepth(inverseProjection, 1.0f));
+
+	// the slices grow exponentially from the near to the far
+	// plane, which keeps the clusters close to cubes
+	float depthRatio = std::log(depthRange.y / depthRange.x);
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0) || (depthRange.x <= 0.0f) || (depthRatio <= 0.0f))
+	{
+		return;
+	}
+
+	m_clusterView.clusterCounts = glm::vec3(CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+	m_clusterView.tileScale = glm::vec2(
+		(float)CLUSTER_COUNT_X / (float)viewport[2],
+		(float)CLUSTER_COUNT_Y / (float)viewport[3]);
+	m_clusterView.viewportOrigin = glm::vec2((float)viewport[0], (float)viewport[1]);
+	m_clusterView.depthScaleBias = glm::vec2(
+		(float)CLUSTER_COUNT_Z / depthRatio,
+		-(float)CLUSTER_COUNT_Z * std::log(depthRange.x) / depthRatio);
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_clusterProgram);
+	glUniformMatrix4fv(m_inverseProjectionLocation, 1, GL_FALSE, &inverseProjection[0][0]);
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, &view[0][0]);
+	glUniform2fv(m_depthRangeLocation, 1, &depthRange.x);
+	glUniform1ui(m_lightCountLocation, (GLuint)m_lightCount);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BINDING, m_buffers[TEXTURE_LIGHTS]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNT_BINDING, m_buffers[TEXTURE_COUNTS]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDEX_BINDING, m_buffers[TEXTURE_INDICES]);
+
+	glDispatchCompute((CLUSTER_COUNT + CLUSTER_GROUP_SIZE - 1) / CLUSTER_GROUP_SIZE, 1, 1);
+
+	// the lists are read through buffer textures by the draws
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  BindTextures()
+ *
+ *  This method is used for binding the light and cluster
+ *  buffer textures for the fragment shader.  They are bound
+ *  even when the lights are off, so that the samplers never
+ *  share a unit with a texture of another type.
+ ***********************************************************/
+void ClusteredLighting::BindTextures(GLuint firstUnit)
+{
+	for (int index = 0; index < TEXTURE_COUNT; index++)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstUnit + (GLenum)index);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[index]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  GetClusterView()
+ *
+ *  This method is used for getting the values the fragment
+ *  shader finds its cluster with.  The cluster counts are 0
+ *  when the lights were not binned in the last Update().
+ ***********************************************************/
+const ClusteredLighting::CLUSTER_VIEW& ClusteredLighting::GetClusterView() const
+{
+	return(m_clusterView);
+}
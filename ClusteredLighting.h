@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.h
+// ============
+// bin point lights into view space clusters on the GPU
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ClusteredLighting
+ *
+ *  This class lets the scene be lit by many small point
+ *  lights.  The view volume is split into a grid of clusters,
+ *  CLUSTER_COUNT_X by CLUSTER_COUNT_Y tiles of the screen and
+ *  CLUSTER_COUNT_Z depth slices that grow exponentially with
+ *  the distance.  Each frame a compute shader tests the
+ *  bounding sphere of every light against the clusters and
+ *  writes the lights that reach each cluster into its list,
+ *  and the fragment shader only adds up the lights in the
+ *  list of its own cluster.
+ *
+ *  The lights and lists are kept in buffers that the compute
+ *  shader writes as shader storage and the fragment shader
+ *  reads as buffer textures, so the scene shaders can stay
+ *  at GLSL 3.30.  OpenGL 4.3 (compute shaders and shader
+ *  storage buffers) is needed; without it Initialize() fails
+ *  and only the scene lights are used.
+ ***********************************************************/
+class ClusteredLighting
+{
+public:
+	// constructor
+	ClusteredLighting();
+	// destructor
+	~ClusteredLighting();
+
+	// size of the cluster grid and the longest light list,
+	// these must match the values in the compute shader
+	static const int CLUSTER_COUNT_X = 16;
+	static const int CLUSTER_COUNT_Y = 9;
+	static const int CLUSTER_COUNT_Z = 24;
+	static const int CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+	static const int MAX_LIGHTS_PER_CLUSTER = 64;
+
+	// buffer textures read by the fragment shader
+	enum LIGHT_TEXTURE
+	{
+		TEXTURE_LIGHTS,
+		TEXTURE_COUNTS,
+		TEXTURE_INDICES,
+		TEXTURE_COUNT
+	};
+
+	// one point light, the std430 layout in the compute shader
+	// and the texel layout in the fragment shader must match
+	struct POINT_LIGHT
+	{
+		// world space position
+		glm::vec3 position;
+		// distance at which the light has faded out
+		float range;
+		glm::vec3 color;
+		float specularIntensity;
+	};
+
+	// values the fragment shader finds its cluster with
+	struct CLUSTER_VIEW
+	{
+		// clusters along each axis
+		glm::vec3 clusterCounts;
+		// scale from window coordinates to screen tiles, and the
+		// window coordinates of the viewport corner they start at
+		glm::vec2 tileScale;
+		glm::vec2 viewportOrigin;
+		// the slice of a view depth d is
+		// log(d) * depthScaleBias.x + depthScaleBias.y
+		glm::vec2 depthScaleBias;
+	};
+
+private:
+	// light binning compute shader program
+	GLuint m_clusterProgram;
+	GLint m_inverseProjectionLocation;
+	GLint m_viewLocation;
+	GLint m_depthRangeLocation;
+	GLint m_lightCountLocation;
+	// shader cache building the binning shader, and its
+	// handle there, until the program has been picked up
+	ShaderCache* m_pShaderCache;
+	int m_clusterHandle;
+	// lights, light counts per cluster and light lists
+	GLuint m_buffers[TEXTURE_COUNT];
+	GLuint m_textures[TEXTURE_COUNT];
+	int m_lightCount;
+	// cluster values of the last Update()
+	CLUSTER_VIEW m_clusterView;
+
+	// free the buffers and their textures
+	void DestroyBuffers();
+	// set the binning program and look up its uniforms
+	void SetClusterProgram(GLuint program);
+
+public:
+	// compile the binning shader, in the background when a
+	// shader cache is passed in; false is returned when the
+	// OpenGL version does not support compute shaders
+	bool Initialize(const char* computeShaderFile, ShaderCache* pShaderCache = NULL);
+
+	// check whether the binning shader is ready
+	bool IsAvailable();
+
+	// upload the point lights, only needed after they change
+	void SetLights(const std::vector<POINT_LIGHT>& lights);
+	int GetLightCount() const;
+
+	// bin the lights into the clusters of a frame
+	void Update(const glm::mat4& view, const glm::mat4& projection);
+
+	// bind the buffer textures to firstUnit and the units
+	// after it, in LIGHT_TEXTURE order
+	void BindTextures(GLuint firstUnit);
+
+	// get the cluster values of the last Update()
+	const CLUSTER_VIEW& GetClusterView() const;
+};
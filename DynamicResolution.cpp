@@ -0,0 +1,300 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// scale the resolution the scene is drawn at to hold a GPU frame time
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the default target leaves some of a 60 Hz frame for the
+	// overlay, the blit and the driver
+	const float DEFAULT_TARGET_MILLISECONDS = 1000.0f / 60.0f * 0.85f;
+	const float DEFAULT_MIN_SCALE = 0.5f;
+
+	// fraction of the way to the wanted scale taken with each
+	// new time; the scale drops quickly when the frame is over
+	// budget and recovers slowly, so it does not oscillate
+	const float SCALE_DOWN_RATE = 0.5f;
+	const float SCALE_UP_RATE = 0.1f;
+	// changes smaller than this are ignored
+	const float SCALE_DEAD_BAND = 0.02f;
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_scale = 1.0f;
+	m_minScale = DEFAULT_MIN_SCALE;
+	m_targetMilliseconds = DEFAULT_TARGET_MILLISECONDS;
+	for (int index = 0; index < SCALE_HISTORY_SIZE; index++)
+	{
+		m_frameScales[index] = 1.0f;
+	}
+	m_lastSampleFrame = -1;
+	m_bFullScaleRequested = false;
+	m_bReduced = false;
+	m_pProfiler = NULL;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	DestroyBuffers();
+	m_pProfiler = NULL;
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the offscreen framebuffer
+ *  and its attachments.
+ ***********************************************************/
+void DynamicResolution::DestroyBuffers()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the color and depth
+ *  attachments at the size of the window.  Every scale draws
+ *  into a corner of them.
+ ***********************************************************/
+bool DynamicResolution::CreateBuffers(int width, int height)
+{
+	DestroyBuffers();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Scene framebuffer is not complete:" << status << std::endl;
+		DestroyBuffers();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler whose GPU
+ *  frame times drive the scale.  Without one the scene is
+ *  always drawn at full scale.
+ ***********************************************************/
+void DynamicResolution::SetProfiler(Profiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
+
+/***********************************************************
+ *  SetTargetFrameTime()
+ *
+ *  This method is used for setting the GPU time per frame
+ *  that the scale is adjusted to hold.
+ ***********************************************************/
+void DynamicResolution::SetTargetFrameTime(float milliseconds)
+{
+	if (milliseconds > 0.0f)
+	{
+		m_targetMilliseconds = milliseconds;
+	}
+}
+
+/***********************************************************
+ *  SetMinimumScale()
+ *
+ *  This method is used for setting the lowest scale of the
+ *  window size the scene is drawn at.
+ ***********************************************************/
+void DynamicResolution::SetMinimumScale(float scale)
+{
+	m_minScale = std::min(std::max(scale, 0.1f), 1.0f);
+	m_scale = std::max(m_scale, m_minScale);
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for moving the scale with the latest
+ *  GPU frame time.  The time is compared with the scale its
+ *  frame was drawn at, as it arrives a few frames late and
+ *  the scale may have changed since.  Times whose frame has
+ *  left the scale history are skipped.
+ ***********************************************************/
+void DynamicResolution::UpdateScale()
+{
+	float milliseconds = 0.0f;
+	int frame = m_pProfiler->GetLastGpuFrame(milliseconds);
+
+	if ((frame <= m_lastSampleFrame) ||
+		(m_pProfiler->GetFrameIndex() - frame >= SCALE_HISTORY_SIZE) ||
+		(milliseconds <= 0.0f))
+	{
+		return;
+	}
+	m_lastSampleFrame = frame;
+
+	// the cost grows with the pixel count, the square of the scale
+	float sampleScale = m_frameScales[frame % SCALE_HISTORY_SIZE];
+	float wantedScale = sampleScale * sqrtf(m_targetMilliseconds / milliseconds);
+	wantedScale = std::min(std::max(wantedScale, m_minScale), 1.0f);
+
+	if (fabsf(wantedScale - m_scale) < SCALE_DEAD_BAND)
+	{
+		return;
+	}
+
+	float rate = (wantedScale < m_scale) ? SCALE_DOWN_RATE : SCALE_UP_RATE;
+	m_scale += (wantedScale - m_scale) * rate;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the offscreen framebuffer
+ *  before the scene is drawn, with the viewport of the scaled
+ *  rectangle.  The attachments are created again when the
+ *  window has changed size.
+ ***********************************************************/
+bool DynamicResolution::BeginFrame(int windowWidth, int windowHeight)
+{
+	if ((windowWidth <= 0) || (windowHeight <= 0))
+	{
+		return(false);
+	}
+	if (((windowWidth != m_width) || (windowHeight != m_height)) &&
+		(CreateBuffers(windowWidth, windowHeight) == false))
+	{
+		return(false);
+	}
+
+	float scale = 1.0f;
+	if (NULL != m_pProfiler)
+	{
+		UpdateScale();
+		if (m_bFullScaleRequested == false)
+		{
+			scale = m_scale;
+		}
+		m_frameScales[m_pProfiler->GetFrameIndex() % SCALE_HISTORY_SIZE] = scale;
+	}
+	m_bFullScaleRequested = false;
+
+	m_renderWidth = std::max((int)(m_width * scale + 0.5f), 1);
+	m_renderHeight = std::max((int)(m_height * scale + 0.5f), 1);
+	m_bReduced = ((m_renderWidth < m_width) || (m_renderHeight < m_height));
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stretching the drawn rectangle
+ *  over the window with linear filtering.  The window
+ *  framebuffer is bound with a full viewport afterwards, for
+ *  whatever is drawn over the scene.
+ ***********************************************************/
+void DynamicResolution::EndFrame()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(
+		0, 0, m_renderWidth, m_renderHeight,
+		0, 0, m_width, m_height,
+		GL_COLOR_BUFFER_BIT,
+		(m_bReduced == true) ? GL_LINEAR : GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  RequestFullScale()
+ *
+ *  This method is used for drawing the next frame at full
+ *  scale, so that a view that stands still is left sharp.
+ ***********************************************************/
+void DynamicResolution::RequestFullScale()
+{
+	m_bFullScaleRequested = true;
+}
+
+/***********************************************************
+ *  IsReduced()
+ *
+ *  This method is used for checking whether the last frame
+ *  was drawn below full scale.
+ ***********************************************************/
+bool DynamicResolution::IsReduced() const
+{
+	return(m_bReduced);
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used for getting the current scale of the
+ *  window size the scene is drawn at.
+ ***********************************************************/
+float DynamicResolution::GetScale() const
+{
+	return(m_scale);
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// scale the resolution the scene is drawn at to hold a GPU frame time
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Profiler.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class draws the scene into an offscreen framebuffer
+ *  the size of the window, using only a scaled rectangle of
+ *  it, and stretches that rectangle over the window with a
+ *  filtered blit.  The scale follows the GPU frame times the
+ *  profiler reads back: the cost of a frame is taken to grow
+ *  with its pixel count, so the scale that would have met
+ *  the target is worked out from the scale each measured
+ *  frame was drawn at, and the scale moves part of the way
+ *  there each time a new time arrives.
+ *
+ *  Changing the scale only changes the viewport, so nothing
+ *  is reallocated until the window itself changes size.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// scales of the frames whose GPU times may still arrive,
+	// this must be more than the profiler query ring
+	static const int SCALE_HISTORY_SIZE = 8;
+
+private:
+	// offscreen framebuffer and its attachments
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	// size of the attachments, the size of the window
+	int m_width;
+	int m_height;
+	// size of the rectangle the current frame is drawn into
+	int m_renderWidth;
+	int m_renderHeight;
+	// current scale of the window size, and its lowest value
+	float m_scale;
+	float m_minScale;
+	// GPU time per frame the scale is adjusted to hold
+	float m_targetMilliseconds;
+	// scale each recent frame was drawn at, by profiler frame
+	float m_frameScales[SCALE_HISTORY_SIZE];
+	// frame of the last GPU time used
+	int m_lastSampleFrame;
+	// the next frame is drawn at full scale
+	bool m_bFullScaleRequested;
+	// the last frame was drawn below full scale
+	bool m_bReduced;
+	Profiler* m_pProfiler;
+
+	// move the scale towards the latest GPU frame time
+	void UpdateScale();
+	// create the attachments at the size of the window
+	bool CreateBuffers(int width, int height);
+	// free the framebuffer and its attachments
+	void DestroyBuffers();
+
+public:
+	// set the profiler the GPU frame times are read from
+	void SetProfiler(Profiler* pProfiler);
+
+	// set the GPU time per frame to hold, and the lowest scale
+	void SetTargetFrameTime(float milliseconds);
+	void SetMinimumScale(float scale);
+
+	// bind the offscreen framebuffer with the viewport of the
+	// scaled rectangle, false is returned when it could not be
+	// created and the window should be drawn to directly
+	bool BeginFrame(int windowWidth, int windowHeight);
+	// stretch the drawn rectangle over the window and bind the
+	// window framebuffer again
+	void EndFrame();
+
+	// draw the next frame at full scale, for the last frame
+	// before the view stands still
+	void RequestFullScale();
+	// check whether the last frame was drawn below full scale
+	bool IsReduced() const;
+
+	// get the current scale of the window size
+	float GetScale() const;
+};
@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// linear allocator for the temporary data of one frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+// declaration of the global variables and defines
+namespace
+{
+	// size of the first block of each arena
+	const size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+	// block sizes are kept at a multiple of this
+	const size_t BLOCK_GRANULARITY = 4096;
+
+	// number of calls to the global operator new
+	std::atomic<uint64_t> g_HeapAllocations(0);
+
+	// every thread arena that exists, for resetting them all
+	std::mutex& GetArenaMutex()
+	{
+		static std::mutex arenaMutex;
+		return(arenaMutex);
+	}
+	std::vector<FrameArena*>& GetArenas()
+	{
+		static std::vector<FrameArena*> arenas;
+		return(arenas);
+	}
+
+	/***********************************************************
+	 *  THREAD_ARENA
+	 *
+	 *  Owns the arena of one thread and removes it from the
+	 *  list of arenas when the thread exits.
+	 ***********************************************************/
+	struct THREAD_ARENA
+	{
+		std::unique_ptr<FrameArena> pArena;
+
+		~THREAD_ARENA()
+		{
+			if (pArena)
+			{
+				std::lock_guard<std::mutex> lock(GetArenaMutex());
+				std::vector<FrameArena*>& arenas = GetArenas();
+				arenas.erase(std::remove(arenas.begin(), arenas.end(), pArena.get()), arenas.end());
+			}
+		}
+	};
+
+	thread_local THREAD_ARENA g_ThreadArena;
+
+	/***********************************************************
+	 *  AlignOffset()
+	 *
+	 *  Rounds an offset up to a multiple of a power of two.
+	 ***********************************************************/
+	size_t AlignOffset(size_t offset, size_t alignment)
+	{
+		return((offset + alignment - 1) & ~(alignment - 1));
+	}
+}
+
+/***********************************************************
+ *  operator new()
+ *
+ *  The global allocation functions are replaced so that
+ *  every heap allocation of the program is counted.  The
+ *  array and nothrow forms call these.
+ ***********************************************************/
+void* operator new(std::size_t size)
+{
+	g_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* pMemory = std::malloc((size > 0) ? size : 1);
+	if (NULL == pMemory)
+	{
+		throw std::bad_alloc();
+	}
+	return(pMemory);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena()
+{
+	m_pBlock = NULL;
+	m_blockSize = 0;
+	m_head = 0;
+	m_usedBytes = 0;
+	m_peakBytes = 0;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	for (size_t index = 0; index < m_overflowBlocks.size(); index++)
+	{
+		::operator delete(m_overflowBlocks[index]);
+	}
+	m_overflowBlocks.clear();
+
+	if (NULL != m_pBlock)
+	{
+		::operator delete(m_pBlock);
+		m_pBlock = NULL;
+	}
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting memory that lives until
+ *  the next reset.  The alignment must be a power of two.
+ *  Memory that does not fit in the block comes from the heap
+ *  for this frame only.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	if (NULL == m_pBlock)
+	{
+		m_blockSize = INITIAL_BLOCK_SIZE;
+		m_pBlock = (unsigned char*)::operator new(m_blockSize);
+	}
+
+	// the block itself is aligned for any standard type
+	size_t start = AlignOffset(m_head, alignment);
+	if (start + size <= m_blockSize)
+	{
+		m_usedBytes += (start + size) - m_head;
+		m_head = start + size;
+		return(m_pBlock + start);
+	}
+
+	unsigned char* pOverflow = (unsigned char*)::operator new(size + alignment);
+	m_overflowBlocks.push_back(pOverflow);
+	m_usedBytes += size + alignment;
+
+	return((void*)AlignOffset((size_t)pOverflow, alignment));
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for freeing everything allocated
+ *  since the last reset.  When the frame overflowed, the
+ *  block is replaced with one that has room for the largest
+ *  frame so far and some to spare.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	m_peakBytes = std::max(m_peakBytes, m_usedBytes);
+
+	if (m_overflowBlocks.empty() == false)
+	{
+		for (size_t index = 0; index < m_overflowBlocks.size(); index++)
+		{
+			::operator delete(m_overflowBlocks[index]);
+		}
+		m_overflowBlocks.clear();
+
+		::operator delete(m_pBlock);
+		m_blockSize = AlignOffset(m_peakBytes + m_peakBytes / 2, BLOCK_GRANULARITY);
+		m_pBlock = (unsigned char*)::operator new(m_blockSize);
+	}
+
+	m_head = 0;
+	m_usedBytes = 0;
+}
+
+/***********************************************************
+ *  GetUsedBytes()
+ *
+ *  This method is used for getting the number of bytes used
+ *  since the last reset.
+ ***********************************************************/
+size_t FrameArena::GetUsedBytes() const
+{
+	return(m_usedBytes);
+}
+
+/***********************************************************
+ *  GetPeakBytes()
+ *
+ *  This method is used for getting the largest number of
+ *  bytes used between two resets.
+ ***********************************************************/
+size_t FrameArena::GetPeakBytes() const
+{
+	return(std::max(m_peakBytes, m_usedBytes));
+}
+
+/***********************************************************
+ *  ThreadArena()
+ *
+ *  This method is used for getting the arena of the calling
+ *  thread, which is created the first time it is used.
+ ***********************************************************/
+FrameArena& FrameArena::ThreadArena()
+{
+	if (!g_ThreadArena.pArena)
+	{
+		g_ThreadArena.pArena.reset(new FrameArena());
+
+		std::lock_guard<std::mutex> lock(GetArenaMutex());
+		GetArenas().push_back(g_ThreadArena.pArena.get());
+	}
+
+	return(*g_ThreadArena.pArena);
+}
+
+/***********************************************************
+ *  ResetThreadArenas()
+ *
+ *  This method is used for resetting the arena of every
+ *  thread at the top of a frame.  The worker threads only
+ *  use their arenas inside jobs, which have all finished by
+ *  then.
+ ***********************************************************/
+void FrameArena::ResetThreadArenas()
+{
+	std::lock_guard<std::mutex> lock(GetArenaMutex());
+	std::vector<FrameArena*>& arenas = GetArenas();
+
+	for (size_t index = 0; index < arenas.size(); index++)
+	{
+		arenas[index]->Reset();
+	}
+}
+
+/***********************************************************
+ *  GetHeapAllocationCount()
+ *
+ *  This method is used for getting the number of heap
+ *  allocations made since the program started.
+ ***********************************************************/
+uint64_t FrameArena::GetHeapAllocationCount()
+{
+	return(g_HeapAllocations.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// linear allocator for the temporary data of one frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class hands out memory for data that only lives
+ *  until the end of the frame by bumping an offset through
+ *  one block, and frees all of it at once when the frame is
+ *  reset.  Every thread has its own arena, so allocating
+ *  needs no lock, and ResetThreadArenas() is called at the
+ *  top of each frame while no jobs are running.
+ *
+ *  A frame that needs more than the block gets overflow
+ *  blocks from the heap, and the next reset replaces the
+ *  block with one large enough for everything, so a steady
+ *  frame allocates nothing from the heap.  The heap
+ *  allocations of the whole program are counted, which shows
+ *  whether that holds for everything else.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena();
+	// destructor
+	~FrameArena();
+
+private:
+	// block the frame data is bumped through
+	unsigned char* m_pBlock;
+	size_t m_blockSize;
+	size_t m_head;
+	// heap blocks for the data that did not fit this frame
+	std::vector<unsigned char*> m_overflowBlocks;
+	// bytes used this frame, in the block and the overflow
+	size_t m_usedBytes;
+	// largest number of bytes used by one frame
+	size_t m_peakBytes;
+
+	// the arena cannot be copied, its memory is owned
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+public:
+	// get memory that lives until the next reset
+	void* Allocate(size_t size, size_t alignment);
+	// free everything allocated since the last reset
+	void Reset();
+
+	// get the bytes used this frame and by the largest frame
+	size_t GetUsedBytes() const;
+	size_t GetPeakBytes() const;
+
+	// get the arena of the calling thread
+	static FrameArena& ThreadArena();
+	// reset the arena of every thread, only while no other
+	// thread is using its arena
+	static void ResetThreadArenas();
+	// get the number of heap allocations made by the program
+	static uint64_t GetHeapAllocationCount();
+};
+
+/***********************************************************
+ *  FrameAllocator
+ *
+ *  Standard allocator that takes its memory from a frame
+ *  arena, for containers that are rebuilt every frame.
+ *  Nothing is freed until the arena is reset, and the
+ *  container must not be used after that.
+ ***********************************************************/
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+	// the arena moves with the contents of a container
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	FrameAllocator() : m_pArena(&FrameArena::ThreadArena()) {}
+	explicit FrameAllocator(FrameArena& arena) : m_pArena(&arena) {}
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : m_pArena(other.GetArena()) {}
+
+	T* allocate(size_t count)
+	{
+		return((T*)m_pArena->Allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t)
+	{
+	}
+
+	FrameArena* GetArena() const
+	{
+		return(m_pArena);
+	}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>& other) const
+	{
+		return(m_pArena == other.GetArena());
+	}
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>& other) const
+	{
+		return(m_pArena != other.GetArena());
+	}
+
+private:
+	FrameArena* m_pArena;
+};
+
+// vector that lives in the arena of the thread it was made on
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,631 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.cpp
+// ============
+// read the drawn frames back without stalling and hand them to an encoder
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// bytes of each captured pixel, read as RGBA
+	const int PIXEL_SIZE = 4;
+
+	// largest block of a stored deflate stream, and the most
+	// bytes the Adler-32 sums can take before they overflow
+	const size_t MAX_STORED_BLOCK = 65535;
+	const size_t ADLER_BLOCK = 5552;
+
+	// longest wait for a read when the capture is finished
+	const GLuint64 FINISH_WAIT_NANOSECONDS = 1000000000;
+
+	/***********************************************************
+	 *  GetCrcTable()
+	 *
+	 *  Gets the table of the CRC-32 used by PNG chunks, which
+	 *  is built the first time it is used.
+	 ***********************************************************/
+	const uint32_t* GetCrcTable()
+	{
+		static uint32_t crcTable[256];
+		static bool bBuilt = false;
+
+		if (bBuilt == false)
+		{
+			for (uint32_t index = 0; index < 256; index++)
+			{
+				uint32_t value = index;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+				}
+				crcTable[index] = value;
+			}
+			bBuilt = true;
+		}
+
+		return(crcTable);
+	}
+
+	/***********************************************************
+	 *  AppendUint32()
+	 *
+	 *  Adds a 32 bit value to a byte vector, most significant
+	 *  byte first as PNG stores it.
+	 ***********************************************************/
+	void AppendUint32(std::vector<unsigned char>& data, uint32_t value)
+	{
+		data.push_back((unsigned char)(value >> 24));
+		data.push_back((unsigned char)(value >> 16));
+		data.push_back((unsigned char)(value >> 8));
+		data.push_back((unsigned char)value);
+	}
+
+	/***********************************************************
+	 *  WriteChunk()
+	 *
+	 *  Writes one PNG chunk with its length and CRC.
+	 ***********************************************************/
+	bool WriteChunk(FILE* pFile, const char* type, const unsigned char* pData, size_t size)
+	{
+		const uint32_t* crcTable = GetCrcTable();
+		unsigned char header[8];
+		unsigned char footer[4];
+		uint32_t crc = 0xFFFFFFFFu;
+
+		header[0] = (unsigned char)(size >> 24);
+		header[1] = (unsigned char)(size >> 16);
+		header[2] = (unsigned char)(size >> 8);
+		header[3] = (unsigned char)size;
+		memcpy(header + 4, type, 4);
+
+		for (size_t index = 4; index < 8; index++)
+		{
+			crc = crcTable[(crc ^ header[index]) & 0xFF] ^ (crc >> 8);
+		}
+		for (size_t index = 0; index < size; index++)
+		{
+			crc = crcTable[(crc ^ pData[index]) & 0xFF] ^ (crc >> 8);
+		}
+		crc ^= 0xFFFFFFFFu;
+
+		footer[0] = (unsigned char)(crc >> 24);
+		footer[1] = (unsigned char)(crc >> 16);
+		footer[2] = (unsigned char)(crc >> 8);
+		footer[3] = (unsigned char)crc;
+
+		return((fwrite(header, 1, 8, pFile) == 8) &&
+			((size == 0) || (fwrite(pData, 1, size, pFile) == size)) &&
+			(fwrite(footer, 1, 4, pFile) == 4));
+	}
+}
+
+/***********************************************************
+ *  FrameCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCapture::FrameCapture()
+{
+	m_mode = CAPTURE_RAW;
+	m_bStarted = false;
+	for (int slot = 0; slot < SLOT_COUNT; slot++)
+	{
+		m_slots[slot].buffer = 0;
+		m_slots[slot].fence = 0;
+		m_slots[slot].state = SLOT_FREE;
+		m_slots[slot].width = 0;
+		m_slots[slot].height = 0;
+		m_slots[slot].frame = 0;
+		m_slots[slot].pPixels = NULL;
+	}
+	m_nextSlot = 0;
+	m_streamWidth = 0;
+	m_streamHeight = 0;
+	m_pStream = NULL;
+	m_capturedFrames = 0;
+	m_writtenFrames = 0;
+	m_droppedFrames = 0;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameCapture::~FrameCapture()
+{
+	Finish();
+}
+
+/***********************************************************
+ *  ParseMode()
+ *
+ *  This method is used for getting the capture mode of a
+ *  name passed on the command line.
+ ***********************************************************/
+bool FrameCapture::ParseMode(const char* name, CAPTURE_MODE& mode)
+{
+	if (strcmp(name, "raw") == 0)
+	{
+		mode = CAPTURE_RAW;
+	}
+	else if (strcmp(name, "png") == 0)
+	{
+		mode = CAPTURE_PNG;
+	}
+	else if (strcmp(name, "pipe") == 0)
+	{
+		mode = CAPTURE_PIPE;
+	}
+	else
+	{
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for opening the output of the capture
+ *  and starting the encoder thread.  The raw file is one
+ *  RGBA frame after the other, top row first, and the piped
+ *  command gets the same bytes on its standard input.
+ ***********************************************************/
+bool FrameCapture::Start(CAPTURE_MODE mode, const char* target)
+{
+	if ((m_bStarted == true) || (NULL == target))
+	{
+		return(false);
+	}
+
+	m_mode = mode;
+	m_target = target;
+
+	if (m_mode == CAPTURE_RAW)
+	{
+		m_pStream = fopen(target, "wb");
+	}
+	else if (m_mode == CAPTURE_PIPE)
+	{
+#ifdef _WIN32
+		m_pStream = popen(target, "wb");
+#else
+		m_pStream = popen(target, "w");
+#endif
+	}
+
+	if ((m_mode != CAPTURE_PNG) && (NULL == m_pStream))
+	{
+		std::cout << "Could not open the capture output:" << target << std::endl;
+		return(false);
+	}
+
+	for (int slot = 0; slot < SLOT_COUNT; slot++)
+	{
+		glGenBuffers(1, &m_slots[slot].buffer);
+	}
+
+	m_bStopping = false;
+	m_encoder = std::thread(&FrameCapture::EncoderLoop, this);
+	m_bStarted = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsStarted()
+ *
+ *  This method is used for checking whether frames are
+ *  being captured.
+ ***********************************************************/
+bool FrameCapture::IsStarted() const
+{
+	return(m_bStarted);
+}
+
+/***********************************************************
+ *  ProcessSlots()
+ *
+ *  This method is used for moving the slots along, oldest
+ *  first.  A read whose fence has been signalled is mapped
+ *  and queued for the encoder, and a frame the encoder has
+ *  written is unmapped so its buffer can be read into again.
+ *  The fences signal in order, so the first read that is not
+ *  done ends the check.
+ ***********************************************************/
+void FrameCapture::ProcessSlots(bool bWait)
+{
+	for (int step = 0; step < SLOT_COUNT; step++)
+	{
+		CAPTURE_SLOT& slot = m_slots[(m_nextSlot + step) % SLOT_COUNT];
+		SLOT_STATE state;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			state = slot.state;
+		}
+
+		if (state == SLOT_ENCODED)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			slot.pPixels = NULL;
+			slot.state = SLOT_FREE;
+		}
+		else if (state == SLOT_READING)
+		{
+			GLenum result = glClientWaitSync(
+				slot.fence,
+				(bWait == true) ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+				(bWait == true) ? FINISH_WAIT_NANOSECONDS : 0);
+			if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+			{
+				break;
+			}
+
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			const unsigned char* pPixels = (const unsigned char*)glMapBufferRange(
+				GL_PIXEL_PACK_BUFFER,
+				0,
+				(GLsizeiptr)slot.width * slot.height * PIXEL_SIZE,
+				GL_MAP_READ_BIT);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (NULL == pPixels)
+			{
+				slot.state = SLOT_FREE;
+				m_droppedFrames++;
+				continue;
+			}
+
+			slot.pPixels = pPixels;
+			slot.state = SLOT_ENCODING;
+			m_encodeQueue.push_back((int)(&slot - m_slots));
+			m_framesReady.notify_one();
+		}
+	}
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used for queueing the read of the back
+ *  buffer into the next slot, after the frame is drawn and
+ *  before it is swapped.  The frame is dropped when that
+ *  slot is still in use, and for a raw or piped stream when
+ *  the window has changed size since the first frame, as
+ *  the stream has no way to tell.
+ ***********************************************************/
+void FrameCapture::CaptureFrame(int width, int height)
+{
+	if ((m_bStarted == false) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	ProcessSlots(false);
+
+	CAPTURE_SLOT& slot = m_slots[m_nextSlot];
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (slot.state != SLOT_FREE)
+		{
+			m_droppedFrames++;
+			return;
+		}
+	}
+
+	if (m_mode != CAPTURE_PNG)
+	{
+		if (m_streamWidth == 0)
+		{
+			m_streamWidth = width;
+			m_streamHeight = height;
+			std::cout << "Capturing " << width << "x" << height << " RGBA frames to " << m_target << std::endl;
+		}
+		if ((width != m_streamWidth) || (height != m_streamHeight))
+		{
+			m_droppedFrames++;
+			return;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if ((slot.width != width) || (slot.height != height))
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * PIXEL_SIZE, NULL, GL_STREAM_READ);
+		slot.width = width;
+		slot.height = height;
+	}
+
+	// the copy runs on the GPU after the frame, the call only
+	// queues it
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = m_capturedFrames++;
+	slot.state = SLOT_READING;
+	m_nextSlot = (m_nextSlot + 1) % SLOT_COUNT;
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for waiting for every frame in
+ *  flight to be written, then stopping the encoder and
+ *  closing the output.  This is the only place that waits.
+ ***********************************************************/
+void FrameCapture::Finish()
+{
+	if (m_bStarted == false)
+	{
+		return;
+	}
+
+	bool bBusy = true;
+	while (bBusy == true)
+	{
+		ProcessSlots(true);
+
+		bBusy = false;
+		for (int slot = 0; slot < SLOT_COUNT; slot++)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_slots[slot].state != SLOT_FREE)
+			{
+				bBusy = true;
+			}
+		}
+		if (bBusy == true)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_framesReady.notify_one();
+	m_encoder.join();
+
+	for (int slot = 0; slot < SLOT_COUNT; slot++)
+	{
+		glDeleteBuffers(1, &m_slots[slot].buffer);
+		m_slots[slot].buffer = 0;
+		m_slots[slot].width = 0;
+		m_slots[slot].height = 0;
+	}
+
+	if (NULL != m_pStream)
+	{
+		if (m_mode == CAPTURE_PIPE)
+		{
+			pclose(m_pStream);
+		}
+		else
+		{
+			fclose(m_pStream);
+		}
+		m_pStream = NULL;
+	}
+
+	std::cout << "Captured " << m_writtenFrames << " frames, " << m_droppedFrames << " dropped" << std::endl;
+	m_bStarted = false;
+}
+
+/***********************************************************
+ *  EncoderLoop()
+ *
+ *  This method is used as the encoder thread, which writes
+ *  the queued slots in the order they were captured and
+ *  hands each one back once it is written.
+ ***********************************************************/
+void FrameCapture::EncoderLoop()
+{
+	size_t queueHead = 0;
+	bool bFailed = false;
+
+	while (true)
+	{
+		int slotIndex;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_framesReady.wait(lock, [this, queueHead]()
+			{
+				return((m_bStopping == true) || (queueHead < m_encodeQueue.size()));
+			});
+
+			if (queueHead >= m_encodeQueue.size())
+			{
+				return;
+			}
+
+			slotIndex = m_encodeQueue[queueHead++];
+			// the queue is reused once the encoder has caught up,
+			// so it stops growing
+			if (queueHead == m_encodeQueue.size())
+			{
+				m_encodeQueue.clear();
+				queueHead = 0;
+			}
+		}
+
+		// the slot is not touched by the render thread until it
+		// is marked as encoded
+		if ((bFailed == false) && (WriteFrame(m_slots[slotIndex]) == false))
+		{
+			std::cout << "Could not write the captured frames to " << m_target << std::endl;
+			bFailed = true;
+		}
+		if (bFailed == false)
+		{
+			m_writtenFrames++;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_slots[slotIndex].state = SLOT_ENCODED;
+	}
+}
+
+/***********************************************************
+ *  WriteFrame()
+ *
+ *  This method is used for writing the pixels of a slot to
+ *  the output.  The rows were read bottom row first, so they
+ *  are written in reverse.
+ ***********************************************************/
+bool FrameCapture::WriteFrame(const CAPTURE_SLOT& slot)
+{
+	if (m_mode == CAPTURE_PNG)
+	{
+		return(WritePng(slot));
+	}
+
+	size_t rowSize = (size_t)slot.width * PIXEL_SIZE;
+	for (int row = slot.height - 1; row >= 0; row--)
+	{
+		if (fwrite(slot.pPixels + row * rowSize, 1, rowSize, m_pStream) != rowSize)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WritePng()
+ *
+ *  This method is used for writing a slot as the PNG file of
+ *  its frame number.  The image data is kept in stored
+ *  deflate blocks, so encoding only copies the rows and sums
+ *  them; the files are larger than compressed ones, but the
+ *  encoder keeps up with the frame rate.
+ ***********************************************************/
+bool FrameCapture::WritePng(const CAPTURE_SLOT& slot)
+{
+	static const unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	char filename[1024];
+	snprintf(filename, sizeof(filename), "%s%06d.png", m_target.c_str(), slot.frame);
+
+	FILE* pFile = fopen(filename, "wb");
+	if (NULL == pFile)
+	{
+		return(false);
+	}
+
+	// every row starts with filter type 0, top row first
+	size_t rowSize = (size_t)slot.width * PIXEL_SIZE;
+	m_pngRows.resize((rowSize + 1) * slot.height);
+	for (int row = 0; row < slot.height; row++)
+	{
+		unsigned char* pRow = &m_pngRows[row * (rowSize + 1)];
+		pRow[0] = 0;
+		memcpy(pRow + 1, slot.pPixels + (slot.height - 1 - row) * rowSize, rowSize);
+	}
+
+	// zlib stream of stored blocks, ended by the Adler-32 of
+	// the rows
+	uint32_t adlerLow = 1;
+	uint32_t adlerHigh = 0;
+	for (size_t index = 0; index < m_pngRows.size(); index++)
+	{
+		adlerLow += m_pngRows[index];
+		adlerHigh += adlerLow;
+		// the sums are reduced before they can overflow
+		if ((index + 1) % ADLER_BLOCK == 0)
+		{
+			adlerLow %= 65521;
+			adlerHigh %= 65521;
+		}
+	}
+	adlerLow %= 65521;
+	adlerHigh %= 65521;
+
+	m_pngData.clear();
+	m_pngData.push_back(0x78);
+	m_pngData.push_back(0x01);
+	for (size_t offset = 0; offset < m_pngRows.size(); offset += MAX_STORED_BLOCK)
+	{
+		size_t blockSize = std::min(MAX_STORED_BLOCK, m_pngRows.size() - offset);
+		bool bFinal = (offset + blockSize == m_pngRows.size());
+
+		m_pngData.push_back(bFinal ? 1 : 0);
+		m_pngData.push_back((unsigned char)blockSize);
+		m_pngData.push_back((unsigned char)(blockSize >> 8));
+		m_pngData.push_back((unsigned char)~blockSize);
+		m_pngData.push_back((unsigned char)(~blockSize >> 8));
+		m_pngData.insert(m_pngData.end(), m_pngRows.begin() + offset, m_pngRows.begin() + offset + blockSize);
+	}
+	AppendUint32(m_pngData, (adlerHigh << 16) | adlerLow);
+
+	// 8 bit RGBA without interlacing
+	unsigned char header[13] =
+	{
+		(unsigned char)(slot.width >> 24), (unsigned char)(slot.width >> 16),
+		(unsigned char)(slot.width >> 8), (unsigned char)slot.width,
+		(unsigned char)(slot.height >> 24), (unsigned char)(slot.height >> 16),
+		(unsigned char)(slot.height >> 8), (unsigned char)slot.height,
+		8, 6, 0, 0, 0
+	};
+
+	bool bWritten = (fwrite(PNG_SIGNATURE, 1, 8, pFile) == 8) &&
+		(WriteChunk(pFile, "IHDR", header, sizeof(header)) == true) &&
+		(WriteChunk(pFile, "IDAT", m_pngData.data(), m_pngData.size()) == true) &&
+		(WriteChunk(pFile, "IEND", NULL, 0) == true);
+
+	fclose(pFile);
+
+	return(bWritten);
+}
+
+/***********************************************************
+ *  GetWrittenCount()
+ *
+ *  This method is used for getting the number of frames the
+ *  encoder has written so far.
+ ***********************************************************/
+int FrameCapture::GetWrittenCount() const
+{
+	return(m_writtenFrames);
+}
+
+/***********************************************************
+ *  GetDroppedCount()
+ *
+ *  This method is used for getting the number of frames that
+ *  were dropped because every slot was in use.
+ ***********************************************************/
+int FrameCapture::GetDroppedCount() const
+{
+	return(m_droppedFrames);
+}
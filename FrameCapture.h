@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.h
+// ============
+// read the drawn frames back without stalling and hand them to an encoder
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FrameCapture
+ *
+ *  This class records the frames of the window.  Each frame
+ *  is read into the next of SLOT_COUNT pixel pack buffers
+ *  with glReadPixels, which only queues the copy, and a fence
+ *  is placed after it.  Later frames check the fences without
+ *  waiting; a buffer whose copy has finished is mapped and
+ *  its memory is handed to the encoder thread as it is, and
+ *  the buffer is unmapped again once the encoder is done with
+ *  it.  The render thread therefore never waits for the GPU
+ *  nor copies the pixels.
+ *
+ *  When every buffer is still in use, because the GPU or the
+ *  encoder is behind, the frame is dropped and counted rather
+ *  than waited for.  The encoder writes the frames as one raw
+ *  RGBA file, as a numbered sequence of PNG files, or into
+ *  the standard input of a command such as ffmpeg.
+ ***********************************************************/
+class FrameCapture
+{
+public:
+	// constructor
+	FrameCapture();
+	// destructor
+	~FrameCapture();
+
+	// number of frames that can be in flight at once
+	static const int SLOT_COUNT = 4;
+
+	enum CAPTURE_MODE
+	{
+		CAPTURE_RAW,
+		CAPTURE_PNG,
+		CAPTURE_PIPE
+	};
+
+	enum SLOT_STATE
+	{
+		// the buffer can take the next frame
+		SLOT_FREE,
+		// the copy into the buffer was queued behind a fence
+		SLOT_READING,
+		// the buffer is mapped and queued for the encoder
+		SLOT_ENCODING,
+		// the encoder is done, the buffer can be unmapped
+		SLOT_ENCODED
+	};
+
+	// one pixel pack buffer of the ring
+	struct CAPTURE_SLOT
+	{
+		GLuint buffer;
+		GLsync fence;
+		SLOT_STATE state;
+		int width;
+		int height;
+		// number of the captured frame, for the file names
+		int frame;
+		// mapped pixels while the encoder has the slot
+		const unsigned char* pPixels;
+	};
+
+private:
+	CAPTURE_MODE m_mode;
+	// raw file name, PNG file prefix or command line
+	std::string m_target;
+	bool m_bStarted;
+	CAPTURE_SLOT m_slots[SLOT_COUNT];
+	// slot the next frame is read into
+	int m_nextSlot;
+	// size of the raw and piped stream, set by the first frame
+	int m_streamWidth;
+	int m_streamHeight;
+	// file or pipe the raw and piped frames are written to
+	FILE* m_pStream;
+	// frames read back, written by the encoder and dropped
+	int m_capturedFrames;
+	std::atomic<int> m_writtenFrames;
+	int m_droppedFrames;
+
+	// encoder thread, and the slots that it has to write in
+	// the order they were captured
+	std::thread m_encoder;
+	std::mutex m_mutex;
+	std::condition_variable m_framesReady;
+	std::vector<int> m_encodeQueue;
+	bool m_bStopping;
+	// rows and image data of a PNG file, kept by the encoder
+	// so that a steady capture does not allocate
+	std::vector<unsigned char> m_pngRows;
+	std::vector<unsigned char> m_pngData;
+
+	// encoder thread loop
+	void EncoderLoop();
+	// write the pixels of a slot, which were read bottom row first
+	bool WriteFrame(const CAPTURE_SLOT& slot);
+	// write a frame as a PNG file with stored deflate blocks
+	bool WritePng(const CAPTURE_SLOT& slot);
+	// check every slot, mapping finished reads and unmapping
+	// encoded frames, waiting for the reads when bWait is set
+	void ProcessSlots(bool bWait);
+
+public:
+	// open the output and create the buffers, the size of each
+	// frame is passed to CaptureFrame()
+	bool Start(CAPTURE_MODE mode, const char* target);
+
+	// check whether frames are being captured
+	bool IsStarted() const;
+
+	// queue the read of the back buffer of the drawn frame
+	void CaptureFrame(int width, int height);
+
+	// write every frame in flight and close the output
+	void Finish();
+
+	// get the frames written and dropped so far
+	int GetWrittenCount() const;
+	int GetDroppedCount() const;
+
+	// parse a capture mode name, false for an unknown name
+	static bool ParseMode(const char* name, CAPTURE_MODE& mode);
+};
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// view frustum planes for culling bounding boxes
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class.  The planes start out
+ *  accepting everything until they are extracted.
+ ***********************************************************/
+Frustum::Frustum()
+{
+	for (int index = 0; index < PLANE_COUNT; index++)
+	{
+		m_planes[index] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  Extract()
+ *
+ *  This method is used for extracting the six frustum planes
+ *  from a combined projection * view matrix.  Each plane is
+ *  the sum or difference of the fourth row and one of the
+ *  other rows, normalized so that distances are in world
+ *  units.
+ ***********************************************************/
+void Frustum::Extract(const glm::mat4& viewProjection)
+{
+	// glm matrices are column major, so build the rows first
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	m_planes[PLANE_LEFT] = rows[3] + rows[0];
+	m_planes[PLANE_RIGHT] = rows[3] - rows[0];
+	m_planes[PLANE_BOTTOM] = rows[3] + rows[1];
+	m_planes[PLANE_TOP] = rows[3] - rows[1];
+	m_planes[PLANE_NEAR] = rows[3] + rows[2];
+	m_planes[PLANE_FAR] = rows[3] - rows[2];
+
+	for (int index = 0; index < PLANE_COUNT; index++)
+	{
+		float length = glm::length(glm::vec3(m_planes[index]));
+
+		if (length > 0.0f)
+		{
+			m_planes[index] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for checking a world space bounding
+ *  box against the frustum.  The box is only rejected when
+ *  the corner furthest along a plane normal is behind that
+ *  plane, so boxes near the frustum corners may be kept.
+ ***********************************************************/
+bool Frustum::IsBoxVisible(
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax) const
+{
+	for (int index = 0; index < PLANE_COUNT; index++)
+	{
+		const glm::vec4& plane = m_planes[index];
+		glm::vec3 corner;
+
+		corner.x = (plane.x >= 0.0f) ? boundsMax.x : boundsMin.x;
+		corner.y = (plane.y >= 0.0f) ? boundsMax.y : boundsMin.y;
+		corner.z = (plane.z >= 0.0f) ? boundsMax.z : boundsMin.z;
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPlane()
+ *
+ *  This method is used for getting one of the planes.
+ ***********************************************************/
+const glm::vec4& Frustum::GetPlane(FRUSTUM_PLANE plane) const
+{
+	return(m_planes[plane]);
+}
+
+/***********************************************************
+ *  TransformBox()
+ *
+ *  This method is used for getting the world space box that
+ *  holds a local box after it is transformed.  The centre is
+ *  transformed and the extents are grown by the absolute
+ *  values of the matrix, which gives the same result as
+ *  transforming all eight corners.
+ ***********************************************************/
+void Frustum::TransformBox(
+	const glm::mat4& matrix,
+	const glm::vec3& localMin,
+	const glm::vec3& localMax,
+	glm::vec3& worldMin,
+	glm::vec3& worldMax)
+{
+	glm::vec3 center = (localMin + localMax) * 0.5f;
+	glm::vec3 extents = (localMax - localMin) * 0.5f;
+	glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtents;
+
+	for (int row = 0; row < 3; row++)
+	{
+		worldExtents[row] =
+			fabsf(matrix[0][row]) * extents.x +
+			fabsf(matrix[1][row]) * extents.y +
+			fabsf(matrix[2][row]) * extents.z;
+	}
+
+	worldMin = worldCenter - worldExtents;
+	worldMax = worldCenter + worldExtents;
+}
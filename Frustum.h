@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// view frustum planes for culling bounding boxes
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class holds the six planes of a view frustum taken
+ *  from a combined projection and view matrix.  The planes
+ *  come straight from the matrix rows, so the same code
+ *  handles perspective and orthographic projections.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+
+	enum FRUSTUM_PLANE
+	{
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+private:
+	// xyz = inward facing normal, w = distance
+	glm::vec4 m_planes[PLANE_COUNT];
+
+public:
+	// extract the planes from a projection * view matrix
+	void Extract(const glm::mat4& viewProjection);
+
+	// check whether any part of a world space box may be visible
+	bool IsBoxVisible(
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax) const;
+
+	// get one of the normalized planes
+	const glm::vec4& GetPlane(FRUSTUM_PLANE plane) const;
+
+	// get the world space box around a transformed local box
+	static void TransformBox(
+		const glm::mat4& matrix,
+		const glm::vec3& localMin,
+		const glm::vec3& localMax,
+		glm::vec3& worldMin,
+		glm::vec3& worldMax);
+};
@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.cpp
+// ============
+// cull the scene on the GPU and draw it with multi-draw indirect
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "IndirectRenderer.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// shader storage binding points, these must match the
+	// values in the culling compute shader
+	const GLuint CANDIDATE_BINDING = 0;
+	const GLuint COMMAND_BINDING = 1;
+	const GLuint INSTANCE_BINDING = 2;
+
+	// local work group size of the culling compute shader
+	const GLuint CULL_GROUP_SIZE = 64;
+
+	/***********************************************************
+	 *  CompileComputeProgram()
+	 *
+	 *  Reads, compiles and links a compute shader program.  The
+	 *  program ID is returned, or 0 if any step failed.
+	 ***********************************************************/
+	GLuint CompileComputeProgram(const char* filename)
+	{
+		std::ifstream shaderFile(filename);
+		if (shaderFile.is_open() == false)
+		{
+			std::cout << "Could not open compute shader:" << filename << std::endl;
+			return(0);
+		}
+
+		std::stringstream sourceStream;
+		sourceStream << shaderFile.rdbuf();
+		std::string source = sourceStream.str();
+		const char* pSource = source.c_str();
+
+		GLint bSuccess = GL_FALSE;
+		char infoLog[1024];
+
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bSuccess);
+		if (bSuccess == GL_FALSE)
+		{
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Compute shader compile failed:" << filename << std::endl << infoLog << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glDeleteShader(shader);
+		glGetProgramiv(program, GL_LINK_STATUS, &bSuccess);
+		if (bSuccess == GL_FALSE)
+		{
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Compute shader link failed:" << filename << std::endl << infoLog << std::endl;
+			glDeleteProgram(program);
+			return(0);
+		}
+
+		return(program);
+	}
+}
+
+/***********************************************************
+ *  IndirectRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+IndirectRenderer::IndirectRenderer()
+{
+	m_cullProgram = 0;
+	m_planesLocation = -1;
+	m_candidateCountLocation = -1;
+	m_clipRowLocation = -1;
+	m_projectionScaleLocation = -1;
+	m_lodSizesLocation = -1;
+	m_pShaderCache = NULL;
+	m_cullHandle = -1;
+	m_candidateBuffer = 0;
+	m_commandBuffer = 0;
+	m_instanceBuffer = 0;
+	m_candidateCount = 0;
+}
+
+/***********************************************************
+ *  ~IndirectRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+IndirectRenderer::~IndirectRenderer()
+{
+	DestroyBuffers();
+	m_pShaderCache = NULL;
+
+	if (m_cullProgram != 0)
+	{
+		glDeleteProgram(m_cullProgram);
+		m_cullProgram = 0;
+	}
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the candidate, command
+ *  and instance buffers.
+ ***********************************************************/
+void IndirectRenderer::DestroyBuffers()
+{
+	GLuint buffers[3] = { m_candidateBuffer, m_commandBuffer, m_instanceBuffer };
+
+	if (m_candidateBuffer != 0)
+	{
+		glDeleteBuffers(3, buffers);
+	}
+	m_candidateBuffer = 0;
+	m_commandBuffer = 0;
+	m_instanceBuffer = 0;
+	m_commands.clear();
+	m_candidateCount = 0;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for checking that indirect drawing is
+ *  supported and compiling the culling compute shader.  With
+ *  a shader cache the shader is requested from the cache and
+ *  picked up by IsAvailable() once it is ready.
+ ***********************************************************/
+bool IndirectRenderer::Initialize(const char* computeShaderFile, ShaderCache* pShaderCache)
+{
+	if ((GLEW_VERSION_4_3 == false) &&
+		((GLEW_ARB_multi_draw_indirect == false) ||
+		(GLEW_ARB_compute_shader == false) ||
+		(GLEW_ARB_shader_storage_buffer_object == false)))
+	{
+		std::cout << "Indirect drawing is not supported, using instanced draws" << std::endl;
+		return(false);
+	}
+
+	if (NULL != pShaderCache)
+	{
+		std::vector<ShaderCache::SHADER_STAGE> stages(1);
+
+		stages[0].type = GL_COMPUTE_SHADER;
+		stages[0].filename = computeShaderFile;
+		m_cullHandle = pShaderCache->RequestProgram(stages);
+		if (m_cullHandle < 0)
+		{
+			return(false);
+		}
+		m_pShaderCache = pShaderCache;
+		return(true);
+	}
+
+	SetCullProgram(CompileComputeProgram(computeShaderFile));
+
+	return(m_cullProgram != 0);
+}
+
+/***********************************************************
+ *  SetCullProgram()
+ *
+ *  This method is used for setting the culling compute
+ *  program and looking up its uniform locations.
+ ***********************************************************/
+void IndirectRenderer::SetCullProgram(GLuint program)
+{
+	m_cullProgram = program;
+	if (m_cullProgram == 0)
+	{
+		return;
+	}
+
+	m_planesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+	m_candidateCountLocation = glGetUniformLocation(m_cullProgram, "candidateCount");
+	m_clipRowLocation = glGetUniformLocation(m_cullProgram, "clipRowW");
+	m_projectionScaleLocation = glGetUniformLocation(m_cullProgram, "projectionScale");
+	m_lodSizesLocation = glGetUniformLocation(m_cullProgram, "lodScreenSizes");
+}
+
+/***********************************************************
+ *  IsAvailable()
+ *
+ *  This method is used for checking whether the culling
+ *  shader is ready for indirect drawing.  A shader that is
+ *  built by the shader cache is picked up here once the
+ *  cache has finished it.
+ ***********************************************************/
+bool IndirectRenderer::IsAvailable()
+{
+	if ((m_cullProgram == 0) &&
+		(NULL != m_pShaderCache) &&
+		(m_pShaderCache->IsProgramReady(m_cullHandle) == true))
+	{
+		SetCullProgram(m_pShaderCache->GetProgram(m_cullHandle));
+		m_pShaderCache = NULL;
+	}
+
+	return(m_cullProgram != 0);
+}
+
+/***********************************************************
+ *  SetDrawData()
+ *
+ *  This method is used for uploading the candidates and the
+ *  commands they are drawn with.  The visible candidates of
+ *  each command are written from its base instance, so the
+ *  instance buffer has room for every candidate at every
+ *  level of detail.
+ ***********************************************************/
+void IndirectRenderer::SetDrawData(
+	const std::vector<CANDIDATE>& candidates,
+	const std::vector<INDIRECT_COMMAND>& commands)
+{
+	if (IsAvailable() == false)
+	{
+		return;
+	}
+
+	if (m_candidateBuffer == 0)
+	{
+		glGenBuffers(1, &m_candidateBuffer);
+		glGenBuffers(1, &m_commandBuffer);
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	m_candidateCount = (int)candidates.size();
+	m_commands = commands;
+	for (size_t index = 0; index < m_commands.size(); index++)
+	{
+		m_commands[index].instanceCount = 0;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_candidateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, candidates.size() * sizeof(CANDIDATE), candidates.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+	glBufferData(
+		GL_SHADER_STORAGE_BUFFER,
+		candidates.size() * PrimitiveMeshes::LOD_COUNT * sizeof(PrimitiveMeshes::INSTANCE_DATA),
+		NULL,
+		GL_DYNAMIC_COPY);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_commands.size() * sizeof(INDIRECT_COMMAND), m_commands.data(), GL_DYNAMIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for running the culling compute
+ *  shader for a frame.  The instance counts of the commands
+ *  are cleared first, then one invocation per candidate
+ *  tests it against the frustum planes and appends it to
+ *  the command for its level of detail when it may be
+ *  visible.  Only the commands are touched on the CPU, so
+ *  the cost is the same for any number of objects.
+ ***********************************************************/
+void IndirectRenderer::Cull(const Frustum& frustum, const LOD_VIEW& lodView)
+{
+	GLint previousProgram = 0;
+	glm::vec4 planes[Frustum::PLANE_COUNT];
+
+	if ((IsAvailable() == false) || (m_candidateCount == 0))
+	{
+		return;
+	}
+
+	for (int index = 0; index < Frustum::PLANE_COUNT; index++)
+	{
+		planes[index] = frustum.GetPlane((Frustum::FRUSTUM_PLANE)index);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_commands.size() * sizeof(INDIRECT_COMMAND), m_commands.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_cullProgram);
+	glUniform4fv(m_planesLocation, Frustum::PLANE_COUNT, &planes[0].x);
+	glUniform1ui(m_candidateCountLocation, (GLuint)m_candidateCount);
+	glUniform4fv(m_clipRowLocation, 1, &lodView.clipRowW.x);
+	glUniform1f(m_projectionScaleLocation, lodView.projectionScale);
+	glUniform2fv(m_lodSizesLocation, 1, &lodView.screenSizes.x);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CANDIDATE_BINDING, m_candidateBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, m_instanceBuffer);
+
+	glDispatchCompute((m_candidateCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	// the commands and instances are read by the next draws
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing a range of the culled
+ *  commands with one multi-draw indirect call.
+ ***********************************************************/
+void IndirectRenderer::Draw(PrimitiveMeshes* pMeshes, int firstCommand, int commandCount)
+{
+	if ((IsAvailable() == false) || (m_candidateCount == 0))
+	{
+		return;
+	}
+
+	pMeshes->DrawIndirect(m_commandBuffer, m_instanceBuffer, firstCommand, commandCount);
+}
+
+/***********************************************************
+ *  GetCandidateCount()
+ *
+ *  This method is used for getting the number of candidates
+ *  uploaded by the last SetDrawData().
+ ***********************************************************/
+int IndirectRenderer::GetCandidateCount() const
+{
+	return(m_candidateCount);
+}
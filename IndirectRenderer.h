@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.h
+// ============
+// cull the scene on the GPU and draw it with multi-draw indirect
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+#include "Frustum.h"
+#include "ShaderCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  IndirectRenderer
+ *
+ *  This class draws the scene without any per-object work on
+ *  the CPU.  Every object part that might be drawn is uploaded
+ *  once as a candidate, together with one indirect draw
+ *  command per render state.  Each frame a compute shader
+ *  tests the candidates against the view frustum, appends the
+ *  visible ones to the instance range of their command and
+ *  counts them in the command, and the commands are drawn with
+ *  glMultiDrawElementsIndirect().  Every batch has one command
+ *  per level of detail, and the shader picks the level from
+ *  the projected size of each candidate.
+ *
+ *  OpenGL 4.3 (compute shaders, shader storage buffers and
+ *  multi-draw indirect) is needed; without it Initialize()
+ *  fails and the scene is drawn with instanced draws instead.
+ *  When the culling shader is built by a shader cache, the
+ *  instanced draws are also used until it has compiled.
+ ***********************************************************/
+class IndirectRenderer
+{
+public:
+	// constructor
+	IndirectRenderer();
+	// destructor
+	~IndirectRenderer();
+
+	// layout of DrawElementsIndirectCommand
+	struct INDIRECT_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// one object part that may be drawn, the std430 layout in
+	// the compute shader must match
+	struct CANDIDATE
+	{
+		PrimitiveMeshes::INSTANCE_DATA instance;
+		// world space bounding box, the w value of the minimum
+		// holds the batch index of the candidate
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+	};
+
+	// camera values the levels of detail are picked with
+	struct LOD_VIEW
+	{
+		// fourth row of projection * view
+		glm::vec4 clipRowW;
+		// projection[1][1]
+		float projectionScale;
+		// projected sizes below which levels 1 and 2 are drawn,
+		// 0 keeps every candidate at level 0
+		glm::vec2 screenSizes;
+	};
+
+private:
+	// culling compute shader program
+	GLuint m_cullProgram;
+	GLint m_planesLocation;
+	GLint m_candidateCountLocation;
+	GLint m_clipRowLocation;
+	GLint m_projectionScaleLocation;
+	GLint m_lodSizesLocation;
+	// shader cache building the culling shader, and its
+	// handle there, until the program has been picked up
+	ShaderCache* m_pShaderCache;
+	int m_cullHandle;
+	// candidates read by the compute shader
+	GLuint m_candidateBuffer;
+	// commands written by the compute shader and drawn
+	GLuint m_commandBuffer;
+	// visible instances written by the compute shader
+	GLuint m_instanceBuffer;
+	// commands with no instances, copied over the command
+	// buffer before each culling pass
+	std::vector<INDIRECT_COMMAND> m_commands;
+	int m_candidateCount;
+
+	// free the buffers holding the draw data
+	void DestroyBuffers();
+	// set the culling program and look up its uniforms
+	void SetCullProgram(GLuint program);
+
+public:
+	// compile the culling shader, in the background when a
+	// shader cache is passed in; false is returned when the
+	// OpenGL version does not support indirect drawing
+	bool Initialize(const char* computeShaderFile, ShaderCache* pShaderCache = NULL);
+
+	// check whether the culling shader is ready
+	bool IsAvailable();
+
+	// upload the candidates and commands, only needed after
+	// the scene objects or their transformations change; the
+	// commands hold LOD_COUNT commands per batch, each with room
+	// for every candidate of the batch
+	void SetDrawData(
+		const std::vector<CANDIDATE>& candidates,
+		const std::vector<INDIRECT_COMMAND>& commands);
+
+	// cull the candidates and write the commands for a frame
+	void Cull(const Frustum& frustum, const LOD_VIEW& lodView);
+
+	// draw a range of the commands written by Cull()
+	void Draw(PrimitiveMeshes* pMeshes, int firstCommand, int commandCount);
+
+	// get the number of uploaded candidates
+	int GetCandidateCount() const;
+};
@@ -0,0 +1,252 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// work stealing thread pool for splitting frame work into chunks
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int workerCount)
+{
+	m_queuedJobs = 0;
+	m_bStopping = false;
+
+	if (workerCount <= 0)
+	{
+		// the calling thread also runs jobs, so leave it a core
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+
+	// every queue exists before the first worker can steal
+	for (int index = 0; index <= workerCount; index++)
+	{
+		m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+		m_queues.back()->head = 0;
+		m_queues.back()->count = 0;
+	}
+
+	for (int index = 0; index < workerCount; index++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, index));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	// tell the workers to exit and wait for them
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopping = true;
+	}
+	m_jobsReady.notify_all();
+
+	for (size_t index = 0; index < m_workers.size(); index++)
+	{
+		m_workers[index].join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is run by each worker thread.  It runs jobs
+ *  for as long as any can be found, and sleeps until more
+ *  are queued when all of the queues are empty.
+ ***********************************************************/
+void JobSystem::WorkerMain(int queueIndex)
+{
+	JOB job;
+
+	while (true)
+	{
+		if (FindJob(queueIndex, job) == true)
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		while ((m_bStopping == false) && (m_queuedJobs.load() == 0))
+		{
+			m_jobsReady.wait(lock);
+		}
+		if (m_bStopping == true)
+		{
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  PushJob()
+ *
+ *  This method is used for adding a job to the back of a
+ *  queue, which must be locked by the caller.  A full ring is
+ *  doubled, with the queued jobs moved to its start.
+ ***********************************************************/
+void JobSystem::PushJob(JOB_QUEUE& queue, const JOB& job)
+{
+	if (queue.count == queue.jobs.size())
+	{
+		std::vector<JOB> jobs((queue.jobs.size() > 0) ? queue.jobs.size() * 2 : 64);
+
+		for (size_t index = 0; index < queue.count; index++)
+		{
+			jobs[index] = queue.jobs[(queue.head + index) % queue.jobs.size()];
+		}
+		queue.jobs.swap(jobs);
+		queue.head = 0;
+	}
+
+	queue.jobs[(queue.head + queue.count) % queue.jobs.size()] = job;
+	queue.count++;
+}
+
+/***********************************************************
+ *  FindJob()
+ *
+ *  This method is used for taking the next job for a thread.
+ *  The newest job in the thread's own queue is taken first,
+ *  then the oldest job of each other queue, in order from
+ *  the next queue along so that thieves spread out.
+ ***********************************************************/
+bool JobSystem::FindJob(int queueIndex, JOB& job)
+{
+	int queueCount = (int)m_queues.size();
+
+	for (int offset = 0; offset < queueCount; offset++)
+	{
+		JOB_QUEUE& queue = *m_queues[(queueIndex + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.count == 0)
+		{
+			continue;
+		}
+
+		if (offset == 0)
+		{
+			job = queue.jobs[(queue.head + queue.count - 1) % queue.jobs.size()];
+		}
+		else
+		{
+			job = queue.jobs[queue.head];
+			queue.head = (queue.head + 1) % queue.jobs.size();
+		}
+		queue.count--;
+		m_queuedJobs--;
+
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running one chunk of a job group
+ *  and counting it as finished.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job)
+{
+	(*job.pGroup->pFunction)(job.begin, job.end);
+
+	// release so the caller sees the results of the chunk
+	job.pGroup->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting the items [0, count)
+ *  into chunks of chunkSize items and running the function
+ *  once for every chunk.  The chunks are spread over all of
+ *  the queues, and the caller keeps running chunks until the
+ *  whole group has finished.  Work that fits in one chunk is
+ *  run directly on the calling thread.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int chunkSize, const JOB_FUNCTION& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if ((chunkSize <= 0) || (count <= chunkSize) || (m_workers.size() == 0))
+	{
+		function(0, count);
+		return;
+	}
+
+	int jobCount = (count + chunkSize - 1) / chunkSize;
+	int queueCount = (int)m_queues.size();
+	int callerQueue = queueCount - 1;
+
+	JOB_GROUP group;
+	group.pFunction = &function;
+	group.remaining = jobCount;
+
+	for (int index = 0; index < jobCount; index++)
+	{
+		JOB job;
+		job.pGroup = &group;
+		job.begin = index * chunkSize;
+		job.end = (job.begin + chunkSize < count) ? job.begin + chunkSize : count;
+
+		JOB_QUEUE& queue = *m_queues[(callerQueue + index) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		PushJob(queue, job);
+	}
+
+	// the count is raised before the sleeping workers are
+	// woken, so a worker cannot miss the new jobs
+	m_queuedJobs += jobCount;
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_jobsReady.notify_all();
+
+	// help with the group until every chunk has finished, the
+	// group lives on this stack so it must not be left early
+	JOB job;
+	while (group.remaining.load(std::memory_order_acquire) > 0)
+	{
+		if (FindJob(callerQueue, job) == true)
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that run jobs, including the thread calling ParallelFor().
+ ***********************************************************/
+int JobSystem::GetThreadCount() const
+{
+	return((int)m_workers.size() + 1);
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// work stealing thread pool for splitting frame work into chunks
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class runs chunks of work on a pool of worker
+ *  threads.  Each thread owns a queue of jobs; it takes new
+ *  jobs from the back of its own queue and steals from the
+ *  front of the other queues when it runs out.  The thread
+ *  that calls ParallelFor() works on the jobs as well, and
+ *  returns once every chunk has finished, so the results can
+ *  be used straight away on the OpenGL thread.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor, 0 workers uses one per spare hardware thread
+	JobSystem(int workerCount = 0);
+	// destructor
+	~JobSystem();
+
+	// function called for the items in [begin, end)
+	typedef std::function<void(int begin, int end)> JOB_FUNCTION;
+
+	// jobs started by one ParallelFor() call
+	struct JOB_GROUP
+	{
+		const JOB_FUNCTION* pFunction;
+		// number of jobs that have not finished yet
+		std::atomic<int> remaining;
+	};
+
+	struct JOB
+	{
+		JOB_GROUP* pGroup;
+		int begin;
+		int end;
+	};
+
+	// queue of jobs owned by one thread, kept as a ring in a
+	// vector that only grows, so queueing does not allocate
+	// once it has held the most jobs of a frame
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::vector<JOB> jobs;
+		// index of the oldest job and number of queued jobs
+		size_t head;
+		size_t count;
+	};
+
+private:
+	std::vector<std::thread> m_workers;
+	// one queue per worker, plus the last one for the caller
+	std::vector<std::unique_ptr<JOB_QUEUE>> m_queues;
+	// number of jobs waiting in all of the queues
+	std::atomic<int> m_queuedJobs;
+	// wakes the workers when new jobs are queued
+	std::mutex m_sleepMutex;
+	std::condition_variable m_jobsReady;
+	// tells the workers to exit
+	bool m_bStopping;
+
+	// worker thread loop
+	void WorkerMain(int queueIndex);
+	// add a job to the back of a locked queue
+	void PushJob(JOB_QUEUE& queue, const JOB& job);
+	// take a job from the owned queue, or steal one
+	bool FindJob(int queueIndex, JOB& job);
+	// run a job and mark it as finished
+	void RunJob(const JOB& job);
+
+public:
+	// split [0, count) into chunks and run them in parallel,
+	// returns once every chunk has finished
+	void ParallelFor(int count, int chunkSize, const JOB_FUNCTION& function);
+
+	// get the number of threads that run jobs, including the caller
+	int GetThreadCount() const;
+};
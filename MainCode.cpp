@@ -1,5 +1,9 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <cstdio>           // snprintf
+#include <string>
+#include <vector>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +17,14 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "ShaderCache.h"
+#include "FrameArena.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "ResourcePaths.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +41,35 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// profiler object for recording the frame timings
+	Profiler* g_Profiler = nullptr;
+	// offscreen benchmark run requested on the command line
+	Benchmark* g_Benchmark = nullptr;
+	// thread pool the scene draw list is built on
+	JobSystem* g_JobSystem = nullptr;
+	// shader programs cached as driver binaries between runs
+	ShaderCache* g_ShaderCache = nullptr;
+	// frames recorded for streaming, when --capture is passed
+	FrameCapture* g_FrameCapture = nullptr;
+	// offscreen scene framebuffer scaled to hold the GPU frame
+	// time, unless --no-dynamic-resolution is passed
+	DynamicResolution* g_DynamicResolution = nullptr;
+
+	// frames are only drawn when the camera or the scene has
+	// changed, unless --continuous is passed on the command line
+	bool g_bOnDemand = true;
+	// longest wait for events between on-demand frames
+	const double ON_DEMAND_WAIT_SECONDS = 0.5;
+
+	// heap allocation count at the start of the last frame
+	uint64_t g_FrameHeapAllocations = 0;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void DestroyManagers();
 
 
 /***********************************************************
@@ -45,17 +80,130 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the shaders, textures and caches are found from the
+	// executable location rather than the working directory
+	ResourcePaths::Initialize(argv[0]);
+
+	// take the main loop and scene options out of the command
+	// line, the rest are benchmark options
+	std::vector<char*> arguments;
+	const char* sceneFilename = NULL;
+	bool bDepthPrepass = true;
+	bool bOcclusionCulling = true;
+	bool bCompactVertices = false;
+	bool bDemoPointLights = false;
+	const char* captureMode = NULL;
+	const char* captureTarget = NULL;
+	bool bDynamicResolution = true;
+	float frameBudgetMilliseconds = 0.0f;
+	const char* viewLayout = NULL;
+	for (int index = 0; index < argc; index++)
+	{
+		if ((index > 0) && (strcmp(argv[index], "--continuous") == 0))
+		{
+			g_bOnDemand = false;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--scene") == 0) && (index + 1 < argc))
+		{
+			sceneFilename = argv[++index];
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--no-depth-prepass") == 0))
+		{
+			bDepthPrepass = false;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--no-occlusion") == 0))
+		{
+			bOcclusionCulling = false;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--compact-vertices") == 0))
+		{
+			bCompactVertices = true;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--point-lights") == 0))
+		{
+			bDemoPointLights = true;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--no-dynamic-resolution") == 0))
+		{
+			bDynamicResolution = false;
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--frame-budget") == 0) && (index + 1 < argc))
+		{
+			frameBudgetMilliseconds = (float)atof(argv[++index]);
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--views") == 0) && (index + 1 < argc))
+		{
+			viewLayout = argv[++index];
+		}
+		else if ((index > 0) && (strcmp(argv[index], "--capture") == 0) && (index + 2 < argc))
+		{
+			captureMode = argv[++index];
+			captureTarget = argv[++index];
+		}
+		else
+		{
+			arguments.push_back(argv[index]);
+		}
+	}
+
+	// read the benchmark options from the command line
+	g_Benchmark = new Benchmark();
+	if (g_Benchmark->ParseArguments((int)arguments.size(), arguments.data()) == false)
+	{
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	// the frames can be recorded as raw RGBA, as a PNG sequence
+	// or into the standard input of a command such as ffmpeg
+	FrameCapture::CAPTURE_MODE frameCaptureMode = FrameCapture::CAPTURE_RAW;
+	if ((NULL != captureMode) && (FrameCapture::ParseMode(captureMode, frameCaptureMode) == false))
+	{
+		std::cout << "Unknown capture mode:" << captureMode << std::endl;
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	// the views can be one camera, the camera beside top and
+	// front views, or a stereo pair
+	ViewManager::VIEW_LAYOUT layout = ViewManager::LAYOUT_SINGLE;
+	if ((NULL != viewLayout) && (ViewManager::ParseViewLayout(viewLayout, layout) == false))
+	{
+		std::cout << "Unknown view layout:" << viewLayout << std::endl;
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	// the benchmark measures every frame it draws, and a capture
+	// streams at a steady frame rate
+	if ((g_Benchmark->IsEnabled() == true) || (NULL != captureMode))
+	{
+		g_bOnDemand = false;
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
+		DestroyManagers();
 		return(EXIT_FAILURE);
 	}
 
+	// the benchmark draws offscreen, so the window is hidden
+	if (g_Benchmark->IsEnabled() == true)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
+	// the benchmark always measures the single view
+	if (g_Benchmark->IsEnabled() == false)
+	{
+		g_ViewManager->SetViewLayout(layout);
+	}
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
@@ -63,23 +211,156 @@ int main(int argc, char* argv[])
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
 	{
+		DestroyManagers();
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../../Utilities/shaders/vertexShader.glsl",
-		"../../../Utilities/shaders/fragmentShader.glsl");
+	// load the scene program from the binary cache, or compile
+	// the external GLSL files and cache the result
+	g_ShaderCache = new ShaderCache();
+	g_ShaderCache->SetCacheDirectory(ResourcePaths::Resolve("../ShaderCache").c_str());
+	std::string vertexShaderPath = ResourcePaths::Resolve("shaders/vertexShader.glsl");
+	std::string fragmentShaderPath = ResourcePaths::Resolve("shaders/fragmentShader.glsl");
+	g_ShaderManager->m_programID = g_ShaderCache->LoadProgram(
+		vertexShaderPath.c_str(),
+		fragmentShaderPath.c_str());
+	if (g_ShaderManager->m_programID == 0)
+	{
+		// load the shader code from the external GLSL files
+		g_ShaderManager->LoadShaders(
+			vertexShaderPath.c_str(),
+			fragmentShaderPath.c_str());
+	}
 	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	// build the draw list on every core, OpenGL calls stay on
+	// this thread
+	g_JobSystem = new JobSystem();
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	g_SceneManager->SetShaderCache(g_ShaderCache);
+	// build the objects from a binary scene file when one is
+	// passed on the command line
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->SetSceneFile(sceneFilename);
+	}
+	// the depth pre-pass and occlusion culling can be turned
+	// off to compare the GPU cost with them
+	g_SceneManager->SetDepthPrepassEnabled(bDepthPrepass);
+	g_SceneManager->SetOcclusionCullingEnabled(bOcclusionCulling);
+	// the meshes use the full precision vertex layout unless
+	// the compact one is asked for, so the two can be compared
+	g_SceneManager->SetCompactVerticesEnabled(bCompactVertices);
+	// a strip of point lights runs the clustered lighting
+	g_SceneManager->SetDemoPointLightsEnabled(bDemoPointLights);
 	g_SceneManager->PrepareScene();
 
+	// record the frame timings - F1 shows the overlay and F12
+	// captures a Chrome trace
+	g_Profiler = new Profiler();
+	g_ViewManager->SetProfiler(g_Profiler);
+	g_SceneManager->SetProfiler(g_Profiler);
+
+	// the scene is drawn at a reduced resolution when the GPU
+	// cannot hold the frame budget; the benchmark measures its
+	// own fixed resolution
+	if ((bDynamicResolution == true) && (g_Benchmark->IsEnabled() == false))
+	{
+		g_DynamicResolution = new DynamicResolution();
+		g_DynamicResolution->SetProfiler(g_Profiler);
+		g_DynamicResolution->SetTargetFrameTime(frameBudgetMilliseconds);
+	}
+
+	// the benchmark draws offscreen, so only the window is
+	// captured
+	if ((NULL != captureMode) && (g_Benchmark->IsEnabled() == false))
+	{
+		g_FrameCapture = new FrameCapture();
+		if (g_FrameCapture->Start(frameCaptureMode, captureTarget) == false)
+		{
+			DestroyManagers();
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// the benchmark measures the scene with all of its textures
+	if (g_Benchmark->IsEnabled() == true)
+	{
+		if (g_Benchmark->Start(g_ViewManager) == false)
+		{
+			DestroyManagers();
+			return(EXIT_FAILURE);
+		}
+		g_SceneManager->WaitForTextures();
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		// the temporary data of the last frame is freed at once,
+		// every job of that frame has finished by now
+		FrameArena::ResetThreadArenas();
+
+		// handle the window and profiler keys, the camera is
+		// moved at a fixed tick by the camera simulation thread
+		g_ViewManager->ProcessInput();
+
+		// in on-demand mode nothing is drawn until the camera or
+		// the scene changes, the loop sleeps in the event wait
+		// instead so the GPU stays idle
+		if ((g_bOnDemand == true) &&
+			(g_ViewManager->IsViewChanged() == false) &&
+			(g_SceneManager->IsSceneChanged() == false))
+		{
+			// a view drawn at a reduced resolution is drawn once
+			// more at full resolution before the loop goes idle
+			if ((NULL != g_DynamicResolution) && (g_DynamicResolution->IsReduced() == true))
+			{
+				g_DynamicResolution->RequestFullScale();
+			}
+			else
+			{
+				glfwWaitEventsTimeout(ON_DEMAND_WAIT_SECONDS);
+				continue;
+			}
+		}
+		g_ViewManager->ResetViewChanged();
+
+		g_Profiler->BeginFrame();
+
+		// a steady frame should not allocate from the heap at all,
+		// the counter shows the allocations made by the last frame
+		uint64_t heapAllocations = FrameArena::GetHeapAllocationCount();
+		g_Profiler->SetCounter("heap allocations", (int)(heapAllocations - g_FrameHeapAllocations));
+		g_FrameHeapAllocations = heapAllocations;
+
+		// the scene is drawn into the scaled scene framebuffer, or
+		// straight into the window at its framebuffer size
+		bool bSceneFramebuffer = false;
+		if (g_Benchmark->IsEnabled() == true)
+		{
+			g_Benchmark->BeginFrame(g_ViewManager, g_Profiler);
+		}
+		else
+		{
+			int framebufferWidth = 0;
+			int framebufferHeight = 0;
+
+			glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+			if (NULL != g_DynamicResolution)
+			{
+				bSceneFramebuffer = g_DynamicResolution->BeginFrame(framebufferWidth, framebufferHeight);
+				g_Profiler->SetCounter("render scale %", (int)(g_DynamicResolution->GetScale() * 100.0f + 0.5f));
+			}
+			if (bSceneFramebuffer == false)
+			{
+				glViewport(0, 0, framebufferWidth, framebufferHeight);
+			}
+		}
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -91,36 +372,104 @@ int main(int argc, char* argv[])
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
 
+		// cull the scene objects against every view together,
+		// each view is then drawn into its own viewport
+		SceneManager::SCENE_VIEW sceneViews[ViewManager::MAX_CAMERA_VIEWS];
+		int viewCount = g_ViewManager->GetViewCount();
+		for (int view = 0; view < viewCount; view++)
+		{
+			const ViewManager::CAMERA_VIEW& cameraView = g_ViewManager->GetView(view);
+
+			sceneViews[view].view = cameraView.view;
+			sceneViews[view].projection = cameraView.projection;
+			sceneViews[view].x = cameraView.x;
+			sceneViews[view].y = cameraView.y;
+			sceneViews[view].width = cameraView.width;
+			sceneViews[view].height = cameraView.height;
+		}
+		g_SceneManager->SetViews(sceneViews, viewCount);
+
+		// select the object under a click, with the bounds of
+		// the last frame, and show it in the window title; a
+		// click on nothing clears the selection
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+		if (g_ViewManager->GetPickRay(pickOrigin, pickDirection) == true)
+		{
+			ProfileScope scope(g_Profiler, "PickObject");
+			float pickDistance = 0.0f;
+			int picked = g_SceneManager->PickObject(pickOrigin, pickDirection, pickDistance);
+			std::string selection;
+
+			if (picked >= 0)
+			{
+				char distance[32];
+				snprintf(distance, sizeof(distance), " | %.1f away", pickDistance * glm::length(pickDirection));
+				selection = g_SceneManager->GetObjectDescription(picked) + distance;
+			}
+			g_Profiler->SetSelection(selection);
+		}
+
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		if (g_Benchmark->IsEnabled() == true)
+		{
+			g_Benchmark->EndFrame();
+		}
+		else
+		{
+			// stretch the scene over the window
+			if (bSceneFramebuffer == true)
+			{
+				ProfileScope scope(g_Profiler, "UpscaleBlit");
+				g_DynamicResolution->EndFrame();
+			}
+
+			// read the scene back before the overlay is drawn over it,
+			// the pixels are picked up a few frames later
+			if (NULL != g_FrameCapture)
+			{
+				ProfileScope scope(g_Profiler, "CaptureFrame");
+				int framebufferWidth = 0;
+				int framebufferHeight = 0;
+
+				glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+				g_FrameCapture->CaptureFrame(framebufferWidth, framebufferHeight);
+				g_Profiler->SetCounter("capture drops", g_FrameCapture->GetDroppedCount());
+			}
+
+			// draw the frame time graph over the scene
+			g_Profiler->DrawOverlay(g_Window, WINDOW_TITLE);
 
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+			// Flips the the back buffer with the front buffer every frame.
+			ProfileScope scope(g_Profiler, "SwapBuffers");
+			glfwSwapBuffers(g_Window);
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
-	}
 
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
+		g_Profiler->EndFrame();
+
+		if ((g_Benchmark->IsEnabled() == true) && (g_Benchmark->IsFinished() == true))
+		{
+			break;
+		}
 	}
-	if (NULL != g_ViewManager)
+
+	int exitCode = EXIT_SUCCESS;
+	if ((g_Benchmark->IsEnabled() == true) &&
+		(g_Benchmark->WriteResults(g_Profiler) == false))
 	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
+		exitCode = EXIT_FAILURE;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// clear the allocated manager objects from memory
+	DestroyManagers();
+
+	// Terminates the program
+	exit(exitCode);
 }
 
 /***********************************************************
@@ -175,4 +524,67 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
+}
+
+/***********************************************************
+ *	DestroyManagers()
+ *
+ *  This function is used to free the manager objects and
+ *  terminate GLFW, on the normal exit and when the startup
+ *  fails part of the way through.
+ ***********************************************************/
+void DestroyManagers()
+{
+	// write the frames still in flight while the context exists
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
+
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
+
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
+	if (NULL != g_ShaderCache)
+	{
+		delete g_ShaderCache;
+		g_ShaderCache = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_Profiler)
+	{
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
+	if (NULL != g_Benchmark)
+	{
+		delete g_Benchmark;
+		g_Benchmark = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+
+	// GLFW may be terminated before it was initialized
+	glfwTerminate();
+	g_Window = nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,412 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// skip the objects that were hidden behind others in the last frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+
+// declaration of the global variables and defines
+namespace
+{
+	// the boxes are grown by this fraction of their size plus
+	// a fixed margin, so their faces are always in front of the
+	// depth written by the object itself
+	const float BOX_GROWTH = 0.02f;
+	const float BOX_MARGIN = 0.01f;
+
+	// objects whose grown box the camera is this close to are
+	// always drawn, as the near plane (0.1) may clip the box
+	const float CAMERA_MARGIN = 0.2f;
+
+	// corners of a box, bit 0 picks x, bit 1 y and bit 2 z
+	const int CORNER_COUNT = 8;
+
+	// two triangles for each face of the box
+	const GLubyte BOX_INDICES[36] =
+	{
+		0, 2, 6, 0, 6, 4,
+		1, 5, 7, 1, 7, 3,
+		0, 4, 5, 0, 5, 1,
+		2, 3, 7, 2, 7, 6,
+		0, 1, 3, 0, 3, 2,
+		4, 6, 7, 4, 7, 5
+	};
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_boxProgram = 0;
+	m_viewProjectionLocation = -1;
+	m_pShaderCache = NULL;
+	m_boxHandle = -1;
+	m_vertexArray = 0;
+	m_cornerBuffer = 0;
+	m_indexBuffer = 0;
+	m_queryTarget = GL_ANY_SAMPLES_PASSED;
+	m_changedCount = 0;
+	m_waitingCount = 0;
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	DestroyQueries();
+	m_pShaderCache = NULL;
+
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		glDeleteBuffers(1, &m_cornerBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_vertexArray = 0;
+		m_cornerBuffer = 0;
+		m_indexBuffer = 0;
+	}
+	if (m_boxProgram != 0)
+	{
+		glDeleteProgram(m_boxProgram);
+		m_boxProgram = 0;
+	}
+}
+
+/***********************************************************
+ *  DestroyQueries()
+ *
+ *  This method is used for freeing the query of every object.
+ ***********************************************************/
+void OcclusionCuller::DestroyQueries()
+{
+	for (size_t index = 0; index < m_objects.size(); index++)
+	{
+		glDeleteQueries(1, &m_objects[index].query);
+	}
+	m_objects.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the program the boxes
+ *  are drawn with and creating the box geometry.  With a
+ *  shader cache the program is requested from the cache and
+ *  picked up by IsAvailable() once it is ready.
+ ***********************************************************/
+bool OcclusionCuller::Initialize(
+	const char* vertexShaderFile,
+	const char* fragmentShaderFile,
+	ShaderCache* pShaderCache)
+{
+	if (NULL != pShaderCache)
+	{
+		m_boxHandle = pShaderCache->RequestProgram(vertexShaderFile, fragmentShaderFile);
+		if (m_boxHandle < 0)
+		{
+			return(false);
+		}
+		m_pShaderCache = pShaderCache;
+	}
+	else
+	{
+		// a cache without a directory just compiles the shaders
+		ShaderCache shaderCache;
+
+		SetBoxProgram(shaderCache.LoadProgram(vertexShaderFile, fragmentShaderFile));
+		if (m_boxProgram == 0)
+		{
+			return(false);
+		}
+	}
+
+	// the conservative query may count samples that are not
+	// quite covered, which only keeps objects drawn
+	if ((GLEW_VERSION_4_3) || (GLEW_ARB_ES3_compatibility))
+	{
+		m_queryTarget = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+	}
+
+	glGenVertexArrays(1, &m_vertexArray);
+	glBindVertexArray(m_vertexArray);
+
+	glGenBuffers(1, &m_cornerBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(BOX_INDICES), BOX_INDICES, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetBoxProgram()
+ *
+ *  This method is used for setting the box program and
+ *  looking up its uniform location.
+ ***********************************************************/
+void OcclusionCuller::SetBoxProgram(GLuint program)
+{
+	m_boxProgram = program;
+	if (m_boxProgram == 0)
+	{
+		return;
+	}
+
+	m_viewProjectionLocation = glGetUniformLocation(m_boxProgram, "viewProjection");
+}
+
+/***********************************************************
+ *  IsAvailable()
+ *
+ *  This method is used for checking whether the box program
+ *  is ready for querying.  A program that is built by the
+ *  shader cache is picked up here once the cache has
+ *  finished it.
+ ***********************************************************/
+bool OcclusionCuller::IsAvailable()
+{
+	if ((m_boxProgram == 0) &&
+		(NULL != m_pShaderCache) &&
+		(m_pShaderCache->IsProgramReady(m_boxHandle) == true))
+	{
+		SetBoxProgram(m_pShaderCache->GetProgram(m_boxHandle));
+		m_pShaderCache = NULL;
+	}
+
+	return((m_boxProgram != 0) && (m_vertexArray != 0));
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method is used for reading the query results that
+ *  OpenGL has finished.  A query without a result yet keeps
+ *  the object as it was, and is read again next frame.  When
+ *  the number of objects changes every object starts out
+ *  visible with new queries.
+ ***********************************************************/
+void OcclusionCuller::CollectResults(int objectCount)
+{
+	m_changedCount = 0;
+	m_waitingCount = 0;
+
+	if ((int)m_objects.size() != objectCount)
+	{
+		DestroyQueries();
+		m_objects.resize(objectCount);
+		for (int index = 0; index < objectCount; index++)
+		{
+			glGenQueries(1, &m_objects[index].query);
+			m_objects[index].bPending = false;
+			m_objects[index].bOccluded = false;
+		}
+		return;
+	}
+
+	for (size_t index = 0; index < m_objects.size(); index++)
+	{
+		OBJECT_QUERY& object = m_objects[index];
+		GLuint bAvailable = GL_FALSE;
+		GLuint samples = 0;
+
+		if (object.bPending == false)
+		{
+			continue;
+		}
+
+		glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == GL_FALSE)
+		{
+			m_waitingCount++;
+			continue;
+		}
+
+		glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samples);
+		object.bPending = false;
+		if (object.bOccluded != (samples == 0))
+		{
+			object.bOccluded = (samples == 0);
+			m_changedCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether the last result
+ *  for an object found it hidden.  Nothing is changed, so the
+ *  draw list chunks can check their objects on any thread.
+ ***********************************************************/
+bool OcclusionCuller::IsOccluded(int object) const
+{
+	if ((object < 0) || (object >= (int)m_objects.size()))
+	{
+		return(false);
+	}
+
+	return(m_objects[object].bOccluded);
+}
+
+/***********************************************************
+ *  IssueQueries()
+ *
+ *  This method is used for drawing the grown bounding box of
+ *  each object in the frustum inside its own query, against
+ *  the depth buffer of the frame.  Objects that still wait
+ *  for a result are skipped, and objects outside the frustum
+ *  are marked visible so they are drawn as soon as they come
+ *  back into view.  The corners of all of the boxes are
+ *  uploaded at once, so each query is a single draw.  Color
+ *  and depth writes are restored afterwards.
+ ***********************************************************/
+void OcclusionCuller::IssueQueries(
+	const TransformKernel::BOUNDS_ARRAYS& bounds,
+	const std::vector<uint32_t>* pFrustumBits,
+	const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition)
+{
+	GLint previousProgram = 0;
+
+	if ((IsAvailable() == false) || (bounds.minX.size() != m_objects.size()))
+	{
+		return;
+	}
+
+	m_queryObjects.clear();
+	m_corners.clear();
+
+	for (size_t index = 0; index < m_objects.size(); index++)
+	{
+		OBJECT_QUERY& object = m_objects[index];
+
+		if ((NULL != pFrustumBits) &&
+			(TransformKernel::IsVisible(*pFrustumBits, (int)index) == false))
+		{
+			object.bOccluded = false;
+			continue;
+		}
+		if (object.bPending == true)
+		{
+			continue;
+		}
+
+		glm::vec3 boxMin(bounds.minX[index], bounds.minY[index], bounds.minZ[index]);
+		glm::vec3 boxMax(bounds.maxX[index], bounds.maxY[index], bounds.maxZ[index]);
+		glm::vec3 growth = (boxMax - boxMin) * BOX_GROWTH + glm::vec3(BOX_MARGIN);
+
+		boxMin -= growth;
+		boxMax += growth;
+
+		if ((cameraPosition.x > boxMin.x - CAMERA_MARGIN) && (cameraPosition.x < boxMax.x + CAMERA_MARGIN) &&
+			(cameraPosition.y > boxMin.y - CAMERA_MARGIN) && (cameraPosition.y < boxMax.y + CAMERA_MARGIN) &&
+			(cameraPosition.z > boxMin.z - CAMERA_MARGIN) && (cameraPosition.z < boxMax.z + CAMERA_MARGIN))
+		{
+			object.bOccluded = false;
+			continue;
+		}
+
+		for (int corner = 0; corner < CORNER_COUNT; corner++)
+		{
+			m_corners.push_back(glm::vec3(
+				(corner & 1) ? boxMax.x : boxMin.x,
+				(corner & 2) ? boxMax.y : boxMin.y,
+				(corner & 4) ? boxMax.z : boxMin.z));
+		}
+		m_queryObjects.push_back((int)index);
+	}
+
+	if (m_queryObjects.size() == 0)
+	{
+		return;
+	}
+
+	// the buffer is orphaned, the boxes of the last frame may
+	// still be read
+	glBindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_corners.size() * sizeof(glm::vec3), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_corners.size() * sizeof(glm::vec3), m_corners.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_boxProgram);
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glBindVertexArray(m_vertexArray);
+
+	for (size_t query = 0; query < m_queryObjects.size(); query++)
+	{
+		OBJECT_QUERY& object = m_objects[m_queryObjects[query]];
+
+		glBeginQuery(m_queryTarget, object.query);
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			sizeof(BOX_INDICES),
+			GL_UNSIGNED_BYTE,
+			(void*)0,
+			(GLint)(query * CORNER_COUNT));
+		glEndQuery(m_queryTarget);
+		object.bPending = true;
+	}
+
+	glBindVertexArray(0);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for marking every object as visible,
+ *  for when occlusion culling is turned off.  The results of
+ *  pending queries are dropped, as they were drawn for an
+ *  older frame; the next query of the object replaces them.
+ ***********************************************************/
+void OcclusionCuller::Reset()
+{
+	for (size_t index = 0; index < m_objects.size(); index++)
+	{
+		m_objects[index].bOccluded = false;
+		m_objects[index].bPending = false;
+	}
+	m_changedCount = 0;
+	m_waitingCount = 0;
+}
+
+/***********************************************************
+ *  IsSettled()
+ *
+ *  This method is used for checking whether the last results
+ *  all arrived and none of them changed an object, so the
+ *  frame that was drawn with them is what the next frame
+ *  would draw as well.
+ ***********************************************************/
+bool OcclusionCuller::IsSettled() const
+{
+	return((m_changedCount == 0) && (m_waitingCount == 0));
+}
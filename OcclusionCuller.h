@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// skip the objects that were hidden behind others in the last frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderCache.h"
+#include "TransformKernel.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class keeps one hardware occlusion query per scene
+ *  object.  Each frame the world bounding box of every object
+ *  inside the view frustum is drawn against the depth buffer
+ *  of the frame, with color and depth writes off, and the
+ *  query tells whether any of it would be seen.  The results
+ *  are read at the start of the next frame, only once OpenGL
+ *  has them, so the CPU never waits for the GPU; an object
+ *  whose last result found no samples is skipped until a
+ *  later query finds it again.
+ *
+ *  Objects that become visible are therefore drawn one frame
+ *  late.  The boxes are grown a little so that an object is
+ *  never hidden by its own depth, and objects the camera is
+ *  inside or close to are always drawn, since the near plane
+ *  would clip their boxes.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// query state of one scene object
+	struct OBJECT_QUERY
+	{
+		GLuint query;
+		// the query was issued and its result not read yet
+		bool bPending;
+		// the last result found no visible samples
+		bool bOccluded;
+	};
+
+private:
+	// program drawing the boxes, and its uniform
+	GLuint m_boxProgram;
+	GLint m_viewProjectionLocation;
+	// shader cache building the box program, and its handle
+	// there, until the program has been picked up
+	ShaderCache* m_pShaderCache;
+	int m_boxHandle;
+	// box corners of the queried objects, 8 per query
+	GLuint m_vertexArray;
+	GLuint m_cornerBuffer;
+	GLuint m_indexBuffer;
+	// GL_ANY_SAMPLES_PASSED or its conservative form
+	GLenum m_queryTarget;
+	// query state by object index
+	std::vector<OBJECT_QUERY> m_objects;
+	// objects and box corners of the queries of the frame,
+	// kept so that they do not allocate every frame
+	std::vector<int> m_queryObjects;
+	std::vector<glm::vec3> m_corners;
+	// results of the last CollectResults() that changed an
+	// object, and queries that had no result yet
+	int m_changedCount;
+	int m_waitingCount;
+
+	// set the box program and look up its uniform
+	void SetBoxProgram(GLuint program);
+	// free every query
+	void DestroyQueries();
+
+public:
+	// compile the box program, in the background when a shader
+	// cache is passed in, and create the box geometry
+	bool Initialize(
+		const char* vertexShaderFile,
+		const char* fragmentShaderFile,
+		ShaderCache* pShaderCache = NULL);
+
+	// check whether the box program is ready
+	bool IsAvailable();
+
+	// read the results OpenGL has finished, for a scene with
+	// the passed in number of objects
+	void CollectResults(int objectCount);
+
+	// check whether an object was hidden in the last result,
+	// this can be called from any thread
+	bool IsOccluded(int object) const;
+
+	// draw the boxes of the objects in the frustum against the
+	// depth buffer, NULL frustum bits query every object
+	void IssueQueries(
+		const TransformKernel::BOUNDS_ARRAYS& bounds,
+		const std::vector<uint32_t>* pFrustumBits,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition);
+
+	// mark every object as visible again
+	void Reset();
+
+	// check whether the last results matched what was drawn, so
+	// another frame would look the same
+	bool IsSettled() const;
+};
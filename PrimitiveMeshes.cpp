@@ -0,0 +1,1487 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.cpp
+// ============
+// generate the basic 3D shape meshes and draw them with instancing
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PrimitiveMeshes.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// shader attribute locations for the vertex and instance data
+	const GLuint POSITION_LOCATION = 0;
+	const GLuint NORMAL_LOCATION = 1;
+	const GLuint TEXCOORD_LOCATION = 2;
+	const GLuint MODEL_LOCATION = 3;        // uses locations 3 to 6
+	const GLuint COLOR_LOCATION = 7;
+	const GLuint INSTANCE_INFO_LOCATION = 8;
+
+	// tessellation of the curved shapes for each level of
+	// detail, level 0 is the full tessellation
+	const int SPHERE_STACKS[PrimitiveMeshes::LOD_COUNT] = { 18, 10, 6 };
+	const int SPHERE_SECTORS[PrimitiveMeshes::LOD_COUNT] = { 36, 18, 10 };
+	const int CYLINDER_SECTORS[PrimitiveMeshes::LOD_COUNT] = { 36, 18, 10 };
+	const int TORUS_MAIN_SEGMENTS[PrimitiveMeshes::LOD_COUNT] = { 48, 24, 12 };
+	const int TORUS_TUBE_SEGMENTS[PrimitiveMeshes::LOD_COUNT] = { 16, 8, 6 };
+
+	const float PI = 3.14159265358979f;
+
+	// number of vertices the triangle order is optimized for,
+	// which is about the post-transform cache of current GPUs
+	const int VERTEX_CACHE_SIZE = 32;
+
+	// identifies a mesh cache file - "MSH1", the version must
+	// change whenever the generated shapes change
+	const uint32_t CACHE_FILE_MAGIC = 0x3148534D;
+	const uint32_t CACHE_FILE_VERSION = 1;
+
+	// layout of the start of a mesh cache file, followed by the
+	// shape ranges, the part ranges, the vertex data and the
+	// index data
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		// hash of the tessellation and the range layouts, the
+		// cache file is rebuilt when either one changes
+		uint32_t geometryKey;
+		uint32_t vertexFormat;
+		uint32_t shapeCount;
+		uint32_t partCount;
+		uint32_t vertexDataSize;
+		uint32_t indexDataSize;
+	};
+
+	/***********************************************************
+	 *  MakeVertex()
+	 *
+	 *  Builds a vertex from its position, normal and texture
+	 *  coordinate values.
+	 ***********************************************************/
+	PrimitiveMeshes::VERTEX MakeVertex(
+		glm::vec3 position,
+		glm::vec3 normal,
+		glm::vec2 textureCoordinate)
+	{
+		PrimitiveMeshes::VERTEX vertex;
+
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.textureCoordinate = textureCoordinate;
+
+		return(vertex);
+	}
+
+	/***********************************************************
+	 *  HashValues()
+	 *
+	 *  Adds the bytes of a value to an FNV-1a hash.
+	 ***********************************************************/
+	uint32_t HashValues(uint32_t hash, const void* pValues, size_t size)
+	{
+		const uint8_t* pBytes = (const uint8_t*)pValues;
+
+		for (size_t index = 0; index < size; index++)
+		{
+			hash = (hash ^ pBytes[index]) * 16777619u;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  GetGeometryKey()
+	 *
+	 *  Gets the hash of everything the cached geometry depends
+	 *  on apart from the generating code itself.
+	 ***********************************************************/
+	uint32_t GetGeometryKey()
+	{
+		uint32_t hash = 2166136261u;
+		uint32_t layout[4] = {
+			(uint32_t)PrimitiveMeshes::LOD_COUNT,
+			(uint32_t)PrimitiveMeshes::PART_COUNT,
+			(uint32_t)sizeof(PrimitiveMeshes::SHAPE_RANGE),
+			(uint32_t)sizeof(PrimitiveMeshes::MESH_RANGE) };
+
+		hash = HashValues(hash, layout, sizeof(layout));
+		hash = HashValues(hash, SPHERE_STACKS, sizeof(SPHERE_STACKS));
+		hash = HashValues(hash, SPHERE_SECTORS, sizeof(SPHERE_SECTORS));
+		hash = HashValues(hash, CYLINDER_SECTORS, sizeof(CYLINDER_SECTORS));
+		hash = HashValues(hash, TORUS_MAIN_SEGMENTS, sizeof(TORUS_MAIN_SEGMENTS));
+		hash = HashValues(hash, TORUS_TUBE_SEGMENTS, sizeof(TORUS_TUBE_SEGMENTS));
+
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  GetVertexScore()
+	 *
+	 *  Gets how much drawing a triangle that uses a vertex is
+	 *  worth next, from its position in the simulated vertex
+	 *  cache and the number of its triangles that are still to
+	 *  be drawn.  Vertices with few triangles left score higher
+	 *  so that no lone triangles are left behind.
+	 ***********************************************************/
+	float GetVertexScore(int cachePosition, int remainingTriangles)
+	{
+		float score = 0.0f;
+
+		if (remainingTriangles <= 0)
+		{
+			return(-1.0f);
+		}
+
+		if (cachePosition >= 0)
+		{
+			// the vertices of the last triangle get a fixed
+			// score, so the next triangle does not just repeat
+			// its edge
+			if (cachePosition < 3)
+			{
+				score = 0.75f;
+			}
+			else
+			{
+				float scale = 1.0f / (float)(VERTEX_CACHE_SIZE - 3);
+				score = powf(1.0f - (float)(cachePosition - 3) * scale, 1.5f);
+			}
+		}
+
+		score += 2.0f / sqrtf((float)remainingTriangles);
+
+		return(score);
+	}
+
+	/***********************************************************
+	 *  OptimizeTriangleOrder()
+	 *
+	 *  Reorders the triangles of an index range for the vertex
+	 *  cache, with the Forsyth linear-speed method.  Each step
+	 *  draws the best scoring triangle of the vertices in a
+	 *  simulated cache, and only those scores are updated.  The
+	 *  indices must be lower than the passed in vertex count.
+	 ***********************************************************/
+	void OptimizeTriangleOrder(GLuint* pIndices, GLuint nIndices, GLuint nVertices)
+	{
+		const GLuint nTriangles = nIndices / 3;
+
+		if (nTriangles < 2)
+		{
+			return;
+		}
+
+		// the triangles of each vertex, the ones still to be
+		// drawn are kept at the front of each list
+		std::vector<GLuint> remaining(nVertices, 0);
+		std::vector<GLuint> listStart(nVertices + 1, 0);
+		std::vector<GLuint> vertexTriangles(nTriangles * 3);
+
+		for (GLuint index = 0; index < nTriangles * 3; index++)
+		{
+			remaining[pIndices[index]]++;
+		}
+		for (GLuint vertex = 0; vertex < nVertices; vertex++)
+		{
+			listStart[vertex + 1] = listStart[vertex] + remaining[vertex];
+			remaining[vertex] = 0;
+		}
+		for (GLuint index = 0; index < nTriangles * 3; index++)
+		{
+			GLuint vertex = pIndices[index];
+			vertexTriangles[listStart[vertex] + remaining[vertex]] = index / 3;
+			remaining[vertex]++;
+		}
+
+		std::vector<int> cachePosition(nVertices, -1);
+		std::vector<float> vertexScore(nVertices, 0.0f);
+		std::vector<float> triangleScore(nTriangles, 0.0f);
+		std::vector<bool> bDrawn(nTriangles, false);
+
+		for (GLuint vertex = 0; vertex < nVertices; vertex++)
+		{
+			vertexScore[vertex] = GetVertexScore(-1, (int)remaining[vertex]);
+		}
+		for (GLuint triangle = 0; triangle < nTriangles; triangle++)
+		{
+			triangleScore[triangle] =
+				vertexScore[pIndices[triangle * 3]] +
+				vertexScore[pIndices[triangle * 3 + 1]] +
+				vertexScore[pIndices[triangle * 3 + 2]];
+		}
+
+		std::vector<GLuint> ordered;
+		std::vector<GLuint> cache;
+		std::vector<GLuint> newCache;
+		int bestTriangle = -1;
+
+		ordered.reserve(nTriangles * 3);
+		for (GLuint drawn = 0; drawn < nTriangles; drawn++)
+		{
+			// when the cache has no triangles left, the best
+			// of all the remaining triangles is drawn
+			if (bestTriangle < 0)
+			{
+				float bestScore = -1.0f;
+
+				for (GLuint triangle = 0; triangle < nTriangles; triangle++)
+				{
+					if ((bDrawn[triangle] == false) && (triangleScore[triangle] > bestScore))
+					{
+						bestScore = triangleScore[triangle];
+						bestTriangle = (int)triangle;
+					}
+				}
+			}
+
+			const GLuint* pCorners = &pIndices[bestTriangle * 3];
+			bDrawn[bestTriangle] = true;
+
+			// the drawn triangle is moved out of the remaining
+			// part of the lists of its vertices
+			for (int corner = 0; corner < 3; corner++)
+			{
+				GLuint vertex = pCorners[corner];
+				GLuint* pList = &vertexTriangles[listStart[vertex]];
+
+				ordered.push_back(vertex);
+				for (GLuint entry = 0; entry < remaining[vertex]; entry++)
+				{
+					if (pList[entry] == (GLuint)bestTriangle)
+					{
+						std::swap(pList[entry], pList[remaining[vertex] - 1]);
+						remaining[vertex]--;
+						break;
+					}
+				}
+			}
+
+			// the vertices of the triangle move to the front of
+			// the cache and the oldest entries fall out
+			newCache.assign(pCorners, pCorners + 3);
+			for (size_t entry = 0; entry < cache.size(); entry++)
+			{
+				if ((cache[entry] != pCorners[0]) && (cache[entry] != pCorners[1]) && (cache[entry] != pCorners[2]))
+				{
+					newCache.push_back(cache[entry]);
+				}
+			}
+			for (size_t entry = VERTEX_CACHE_SIZE; entry < newCache.size(); entry++)
+			{
+				cachePosition[newCache[entry]] = -1;
+			}
+			for (size_t entry = 0; (entry < newCache.size()) && (entry < (size_t)VERTEX_CACHE_SIZE); entry++)
+			{
+				cachePosition[newCache[entry]] = (int)entry;
+			}
+
+			// only the scores of the vertices that moved change
+			for (size_t entry = 0; entry < newCache.size(); entry++)
+			{
+				GLuint vertex = newCache[entry];
+				float score = GetVertexScore(cachePosition[vertex], (int)remaining[vertex]);
+				float change = score - vertexScore[vertex];
+
+				vertexScore[vertex] = score;
+				for (GLuint list = 0; list < remaining[vertex]; list++)
+				{
+					triangleScore[vertexTriangles[listStart[vertex] + list]] += change;
+				}
+			}
+
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (size_t entry = 0; (entry < newCache.size()) && (entry < (size_t)VERTEX_CACHE_SIZE); entry++)
+			{
+				GLuint vertex = newCache[entry];
+
+				for (GLuint list = 0; list < remaining[vertex]; list++)
+				{
+					GLuint triangle = vertexTriangles[listStart[vertex] + list];
+
+					if (triangleScore[triangle] > bestScore)
+					{
+						bestScore = triangleScore[triangle];
+						bestTriangle = (int)triangle;
+					}
+				}
+			}
+
+			if (newCache.size() > (size_t)VERTEX_CACHE_SIZE)
+			{
+				newCache.resize(VERTEX_CACHE_SIZE);
+			}
+			cache.swap(newCache);
+		}
+
+		std::copy(ordered.begin(), ordered.end(), pIndices);
+	}
+
+	/***********************************************************
+	 *  EncodeOctahedral()
+	 *
+	 *  Maps a unit normal onto the octahedron and unfolds it
+	 *  into the -1 to 1 square, as signed normalized values.
+	 ***********************************************************/
+	void EncodeOctahedral(glm::vec3 normal, GLshort encoded[2])
+	{
+		float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+		glm::vec2 point(0.0f, 0.0f);
+
+		if (length > 0.0f)
+		{
+			normal /= length;
+			point = glm::vec2(normal.x, normal.y);
+
+			// the lower half folds over the diagonals
+			if (normal.z < 0.0f)
+			{
+				point = glm::vec2(
+					(1.0f - fabsf(normal.y)) * ((normal.x >= 0.0f) ? 1.0f : -1.0f),
+					(1.0f - fabsf(normal.x)) * ((normal.y >= 0.0f) ? 1.0f : -1.0f));
+			}
+		}
+
+		for (int axis = 0; axis < 2; axis++)
+		{
+			encoded[axis] = (GLshort)lroundf(glm::clamp(point[axis], -1.0f, 1.0f) * 32767.0f);
+		}
+	}
+
+	/***********************************************************
+	 *  MakeCompactVertex()
+	 *
+	 *  Converts a vertex to the compact vertex layout.
+	 ***********************************************************/
+	PrimitiveMeshes::COMPACT_VERTEX MakeCompactVertex(const PrimitiveMeshes::VERTEX& vertex)
+	{
+		PrimitiveMeshes::COMPACT_VERTEX compact;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			compact.position[axis] = glm::packHalf1x16(vertex.position[axis]);
+		}
+		compact.position[3] = glm::packHalf1x16(0.0f);
+		EncodeOctahedral(vertex.normal, compact.normal);
+		for (int axis = 0; axis < 2; axis++)
+		{
+			compact.textureCoordinate[axis] =
+				(GLushort)lroundf(glm::clamp(vertex.textureCoordinate[axis], 0.0f, 1.0f) * 65535.0f);
+		}
+
+		return(compact);
+	}
+}
+
+/***********************************************************
+ *  PrimitiveMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PrimitiveMeshes::PrimitiveMeshes()
+{
+	m_vertexFormat = FORMAT_FULL;
+	m_finishedShapes = 0;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_bGeometryDirty = false;
+	m_instanceBuffer = 0;
+	m_instanceBufferSize = 0;
+
+	for (int index = 0; index < PART_COUNT; index++)
+	{
+		for (int lod = 0; lod < LOD_COUNT; lod++)
+		{
+			MESH_RANGE& range = m_parts[index][lod];
+			range.mesh = -1;
+			range.firstIndex = 0;
+			range.nIndices = 0;
+			range.baseVertex = 0;
+			range.boundsMin = glm::vec3(0.0f);
+			range.boundsMax = glm::vec3(0.0f);
+		}
+	}
+}
+
+/***********************************************************
+ *  ~PrimitiveMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PrimitiveMeshes::~PrimitiveMeshes()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_vao = 0;
+		m_vertexBuffer = 0;
+		m_indexBuffer = 0;
+	}
+	m_shapes.clear();
+	m_vertices.clear();
+	m_indices.clear();
+	m_vertexData.clear();
+	m_indexData.clear();
+
+	if (m_instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used for selecting the layout of the shared
+ *  buffers.  The compact layout halves the vertex size and
+ *  uses 16-bit indices, which is enough because the indices
+ *  are relative to the base vertex of their shape.  False is
+ *  returned once shapes have been loaded.
+ ***********************************************************/
+bool PrimitiveMeshes::SetVertexFormat(VERTEX_FORMAT format)
+{
+	if (m_shapes.empty() == false)
+	{
+		return(false);
+	}
+
+	m_vertexFormat = format;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetVertexSize()
+ *
+ *  This method is used for getting the size of a vertex in
+ *  the shared vertex buffer.
+ ***********************************************************/
+GLsizei PrimitiveMeshes::GetVertexSize() const
+{
+	return((m_vertexFormat == FORMAT_COMPACT) ? sizeof(COMPACT_VERTEX) : sizeof(VERTEX));
+}
+
+/***********************************************************
+ *  GetIndexSize()
+ *
+ *  This method is used for getting the size of an index in
+ *  the shared index buffer.
+ ***********************************************************/
+GLsizei PrimitiveMeshes::GetIndexSize() const
+{
+	return((m_vertexFormat == FORMAT_COMPACT) ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+/***********************************************************
+ *  GetIndexType()
+ *
+ *  This method is used for getting the type the shared
+ *  indices are drawn with.
+ ***********************************************************/
+GLenum PrimitiveMeshes::GetIndexType() const
+{
+	return((m_vertexFormat == FORMAT_COMPACT) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+}
+
+/***********************************************************
+ *  CreateMesh()
+ *
+ *  This method is used for appending generated shape data to
+ *  the shared vertex and index buffers.  The shape is finished
+ *  and the buffers are uploaded the next time a shape is
+ *  drawn.  The index of the new shape is returned.
+ ***********************************************************/
+int PrimitiveMeshes::CreateMesh(
+	const std::vector<VERTEX>& vertices,
+	const std::vector<GLuint>& indices)
+{
+	SHAPE_RANGE shape;
+
+	// the indices stay relative to the shape, the base vertex
+	// is added when the shape is drawn
+	shape.firstIndex = (GLuint)(m_indexData.size() / GetIndexSize() + m_indices.size());
+	shape.nIndices = (GLuint)indices.size();
+	shape.baseVertex = (GLint)(m_vertexData.size() / GetVertexSize() + m_vertices.size());
+	shape.nVertices = (GLuint)vertices.size();
+
+	m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+	m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+	m_bGeometryDirty = true;
+
+	m_shapes.push_back(shape);
+
+	return((int)m_shapes.size() - 1);
+}
+
+/***********************************************************
+ *  FinishGeometry()
+ *
+ *  This method is used for optimizing the shapes that were
+ *  added since the last call and appending them to the
+ *  finished geometry in the layout of the vertex format.  The
+ *  triangles of each part are put in vertex cache order, and
+ *  then the vertices of each shape in the order the triangles
+ *  first use them, so the vertex fetches of a draw also run
+ *  through memory in order.  The part ranges and bounds stay
+ *  the same.
+ ***********************************************************/
+void PrimitiveMeshes::FinishGeometry()
+{
+	if (m_finishedShapes == (int)m_shapes.size())
+	{
+		return;
+	}
+
+	const GLuint firstPendingIndex = m_shapes[m_finishedShapes].firstIndex;
+	const GLint firstPendingVertex = m_shapes[m_finishedShapes].baseVertex;
+
+	for (int mesh = m_finishedShapes; mesh < (int)m_shapes.size(); mesh++)
+	{
+		const SHAPE_RANGE& shape = m_shapes[mesh];
+		GLuint* pIndices = &m_indices[shape.firstIndex - firstPendingIndex];
+		VERTEX* pVertices = &m_vertices[shape.baseVertex - firstPendingVertex];
+
+		// the flat shapes use the same range for every level,
+		// which must only be reordered once
+		for (int part = 0; part < PART_COUNT; part++)
+		{
+			for (int lod = 0; lod < LOD_COUNT; lod++)
+			{
+				const MESH_RANGE& range = m_parts[part][lod];
+
+				if ((range.mesh == mesh) &&
+					((lod == 0) || (range.firstIndex != m_parts[part][lod - 1].firstIndex)))
+				{
+					OptimizeTriangleOrder(&pIndices[range.firstIndex - shape.firstIndex], range.nIndices, shape.nVertices);
+				}
+			}
+		}
+
+		// vertices no triangle uses are kept at the end
+		std::vector<GLint> remap(shape.nVertices, -1);
+		std::vector<VERTEX> reordered(shape.nVertices);
+		GLint nextVertex = 0;
+
+		for (GLuint index = 0; index < shape.nIndices; index++)
+		{
+			if (remap[pIndices[index]] < 0)
+			{
+				remap[pIndices[index]] = nextVertex++;
+			}
+			pIndices[index] = (GLuint)remap[pIndices[index]];
+		}
+		for (GLuint vertex = 0; vertex < shape.nVertices; vertex++)
+		{
+			if (remap[vertex] < 0)
+			{
+				remap[vertex] = nextVertex++;
+			}
+			reordered[remap[vertex]] = pVertices[vertex];
+		}
+		std::copy(reordered.begin(), reordered.end(), pVertices);
+	}
+
+	// append the pending geometry in the upload layout
+	size_t vertexOffset = m_vertexData.size();
+	size_t indexOffset = m_indexData.size();
+
+	m_vertexData.resize(vertexOffset + m_vertices.size() * GetVertexSize());
+	m_indexData.resize(indexOffset + m_indices.size() * GetIndexSize());
+	if (m_vertexFormat == FORMAT_COMPACT)
+	{
+		COMPACT_VERTEX* pVertexData = (COMPACT_VERTEX*)&m_vertexData[vertexOffset];
+		GLushort* pIndexData = (GLushort*)&m_indexData[indexOffset];
+
+		for (size_t vertex = 0; vertex < m_vertices.size(); vertex++)
+		{
+			pVertexData[vertex] = MakeCompactVertex(m_vertices[vertex]);
+		}
+		for (size_t index = 0; index < m_indices.size(); index++)
+		{
+			pIndexData[index] = (GLushort)m_indices[index];
+		}
+	}
+	else
+	{
+		memcpy(&m_vertexData[vertexOffset], m_vertices.data(), m_vertices.size() * sizeof(VERTEX));
+		memcpy(&m_indexData[indexOffset], m_indices.data(), m_indices.size() * sizeof(GLuint));
+	}
+
+	m_vertices.clear();
+	m_indices.clear();
+	m_finishedShapes = (int)m_shapes.size();
+	m_bGeometryDirty = true;
+}
+
+/***********************************************************
+ *  BindGeometry()
+ *
+ *  This method is used for binding the vertex array object of
+ *  the shared geometry.  The buffers are created the first
+ *  time, and uploaded again after more shapes were added.
+ ***********************************************************/
+void PrimitiveMeshes::BindGeometry()
+{
+	if (m_vao == 0)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vertexBuffer);
+		glGenBuffers(1, &m_indexBuffer);
+
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+		// the full vertex layout is the same as the course
+		// ShapeMeshes meshes - position, normal and texture
+		// coordinate - and its position W is read as 1
+		if (m_vertexFormat == FORMAT_COMPACT)
+		{
+			glVertexAttribPointer(POSITION_LOCATION, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(COMPACT_VERTEX), (void*)offsetof(COMPACT_VERTEX, position));
+			glVertexAttribPointer(NORMAL_LOCATION, 2, GL_SHORT, GL_TRUE, sizeof(COMPACT_VERTEX), (void*)offsetof(COMPACT_VERTEX, normal));
+			glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(COMPACT_VERTEX), (void*)offsetof(COMPACT_VERTEX, textureCoordinate));
+		}
+		else
+		{
+			glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, position));
+			glVertexAttribPointer(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, normal));
+			glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, textureCoordinate));
+		}
+		glEnableVertexAttribArray(POSITION_LOCATION);
+		glEnableVertexAttribArray(NORMAL_LOCATION);
+		glEnableVertexAttribArray(TEXCOORD_LOCATION);
+
+		// the instance attributes advance once per drawn instance
+		for (GLuint column = 0; column < 4; column++)
+		{
+			glEnableVertexAttribArray(MODEL_LOCATION + column);
+			glVertexAttribDivisor(MODEL_LOCATION + column, 1);
+		}
+		glEnableVertexAttribArray(COLOR_LOCATION);
+		glVertexAttribDivisor(COLOR_LOCATION, 1);
+		glEnableVertexAttribArray(INSTANCE_INFO_LOCATION);
+		glVertexAttribDivisor(INSTANCE_INFO_LOCATION, 1);
+	}
+	else
+	{
+		glBindVertexArray(m_vao);
+	}
+
+	FinishGeometry();
+	if (m_bGeometryDirty == true)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, m_vertexData.size(), m_vertexData.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexData.size(), m_indexData.data(), GL_STATIC_DRAW);
+		m_bGeometryDirty = false;
+	}
+}
+
+/***********************************************************
+ *  SetPartRange()
+ *
+ *  This method is used for registering the range of indices
+ *  that is drawn for one level of detail of a shape part.
+ ***********************************************************/
+void PrimitiveMeshes::SetPartRange(
+	MESH_PART part,
+	int lod,
+	int mesh,
+	const std::vector<VERTEX>& vertices,
+	const std::vector<GLuint>& indices,
+	GLuint firstIndex,
+	GLuint nIndices)
+{
+	MESH_RANGE& range = m_parts[part][lod];
+
+	range.mesh = mesh;
+	range.firstIndex = m_shapes[mesh].firstIndex + firstIndex;
+	range.nIndices = nIndices;
+	range.baseVertex = m_shapes[mesh].baseVertex;
+
+	// the bounds only cover the vertices the part draws
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	for (GLuint index = firstIndex; index < firstIndex + nIndices; index++)
+	{
+		const glm::vec3& position = vertices[indices[index]].position;
+
+		if (index == firstIndex)
+		{
+			boundsMin = position;
+			boundsMax = position;
+		}
+		else
+		{
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+	}
+	range.boundsMin = boundsMin;
+	range.boundsMax = boundsMax;
+}
+
+/***********************************************************
+ *  SetInstanceAttributes()
+ *
+ *  This method is used for pointing the instance attributes
+ *  of the bound vertex array object at the passed in byte
+ *  offset in an instance buffer.
+ ***********************************************************/
+void PrimitiveMeshes::SetInstanceAttributes(GLuint instanceBuffer, GLsizeiptr byteOffset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(
+			MODEL_LOCATION + column,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(INSTANCE_DATA),
+			(void*)(byteOffset + offsetof(INSTANCE_DATA, model) + column * sizeof(glm::vec4)));
+	}
+	glVertexAttribPointer(
+		COLOR_LOCATION,
+		4,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(INSTANCE_DATA),
+		(void*)(byteOffset + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribIPointer(
+		INSTANCE_INFO_LOCATION,
+		4,
+		GL_INT,
+		sizeof(INSTANCE_DATA),
+		(void*)(byteOffset + offsetof(INSTANCE_DATA, materialIndex)));
+}
+
+/***********************************************************
+ *  AppendCylinder()
+ *
+ *  This method is used for appending a cylinder with the
+ *  passed in bottom and top radius, running from Y=0 to Y=1.
+ *  The top, bottom and sides are appended in that order and
+ *  their index counts are returned in partIndices.
+ ***********************************************************/
+void PrimitiveMeshes::AppendCylinder(
+	std::vector<VERTEX>& vertices,
+	std::vector<GLuint>& indices,
+	float bottomRadius,
+	float topRadius,
+	int sectors,
+	GLuint partIndices[3])
+{
+	size_t startIndex = 0;
+	GLuint center = 0;
+
+	// top cap
+	startIndex = indices.size();
+	center = (GLuint)vertices.size();
+	vertices.push_back(MakeVertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.5f, 0.5f)));
+	for (int sector = 0; sector <= sectors; sector++)
+	{
+		float theta = 2.0f * PI * (float)sector / (float)sectors;
+		vertices.push_back(MakeVertex(
+			glm::vec3(topRadius * cos(theta), 1.0f, -topRadius * sin(theta)),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec2(0.5f + 0.5f * cos(theta), 0.5f + 0.5f * sin(theta))));
+	}
+	for (int sector = 0; sector < sectors; sector++)
+	{
+		indices.push_back(center);
+		indices.push_back(center + 1 + sector);
+		indices.push_back(center + 2 + sector);
+	}
+	partIndices[0] = (GLuint)(indices.size() - startIndex);
+
+	// bottom cap
+	startIndex = indices.size();
+	center = (GLuint)vertices.size();
+	vertices.push_back(MakeVertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.5f, 0.5f)));
+	for (int sector = 0; sector <= sectors; sector++)
+	{
+		float theta = 2.0f * PI * (float)sector / (float)sectors;
+		vertices.push_back(MakeVertex(
+			glm::vec3(bottomRadius * cos(theta), 0.0f, -bottomRadius * sin(theta)),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec2(0.5f + 0.5f * cos(theta), 0.5f - 0.5f * sin(theta))));
+	}
+	for (int sector = 0; sector < sectors; sector++)
+	{
+		indices.push_back(center);
+		indices.push_back(center + 2 + sector);
+		indices.push_back(center + 1 + sector);
+	}
+	partIndices[1] = (GLuint)(indices.size() - startIndex);
+
+	// sides - the normal leans towards the narrow end
+	startIndex = indices.size();
+	GLuint firstSide = (GLuint)vertices.size();
+	for (int sector = 0; sector <= sectors; sector++)
+	{
+		float theta = 2.0f * PI * (float)sector / (float)sectors;
+		float u = (float)sector / (float)sectors;
+		glm::vec3 normal = glm::normalize(glm::vec3(cos(theta), bottomRadius - topRadius, -sin(theta)));
+
+		vertices.push_back(MakeVertex(
+			glm::vec3(bottomRadius * cos(theta), 0.0f, -bottomRadius * sin(theta)),
+			normal,
+			glm::vec2(u, 0.0f)));
+		vertices.push_back(MakeVertex(
+			glm::vec3(topRadius * cos(theta), 1.0f, -topRadius * sin(theta)),
+			normal,
+			glm::vec2(u, 1.0f)));
+	}
+	for (int sector = 0; sector < sectors; sector++)
+	{
+		GLuint bottom = firstSide + sector * 2;
+		GLuint top = bottom + 1;
+
+		indices.push_back(bottom);
+		indices.push_back(bottom + 2);
+		indices.push_back(top);
+
+		indices.push_back(top);
+		indices.push_back(bottom + 2);
+		indices.push_back(top + 2);
+	}
+	partIndices[2] = (GLuint)(indices.size() - startIndex);
+}
+
+/***********************************************************
+ *  AppendSphereRings()
+ *
+ *  This method is used for appending the rings of a sphere
+ *  with a radius of 1, from the top down to the passed in
+ *  angle from the Y axis, split into the passed in number of
+ *  stacks.  The texture V coordinate runs from 1 at the top
+ *  to 0 at the last ring.
+ ***********************************************************/
+void PrimitiveMeshes::AppendSphereRings(
+	std::vector<VERTEX>& vertices,
+	std::vector<GLuint>& indices,
+	int stacks,
+	int sectors,
+	float endAngle)
+{
+	GLuint firstVertex = (GLuint)vertices.size();
+
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float phi = endAngle * (float)stack / (float)stacks;
+
+		for (int sector = 0; sector <= sectors; sector++)
+		{
+			float theta = 2.0f * PI * (float)sector / (float)sectors;
+			glm::vec3 position(sin(phi) * cos(theta), cos(phi), -sin(phi) * sin(theta));
+
+			vertices.push_back(MakeVertex(
+				position,
+				position,
+				glm::vec2((float)sector / (float)sectors, 1.0f - (float)stack / (float)stacks)));
+		}
+	}
+
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int sector = 0; sector < sectors; sector++)
+		{
+			GLuint k1 = firstVertex + stack * (sectors + 1) + sector;
+			GLuint k2 = k1 + sectors + 1;
+
+			indices.push_back(k1);
+			indices.push_back(k2);
+			indices.push_back(k1 + 1);
+
+			indices.push_back(k1 + 1);
+			indices.push_back(k2);
+			indices.push_back(k2 + 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadMeshCache()
+ *
+ *  This method is used for loading every shape from a mesh
+ *  cache file written by SaveMeshCache().  The geometry is
+ *  stored in its upload layout, so it goes to the shared
+ *  buffers as it is read.  False is returned, and nothing is
+ *  loaded, when shapes were already loaded or the file is
+ *  missing, out of date or for the other vertex format.
+ ***********************************************************/
+bool PrimitiveMeshes::LoadMeshCache(const char* filename)
+{
+	CACHE_FILE_HEADER header;
+
+	if (m_shapes.empty() == false)
+	{
+		return(false);
+	}
+
+	std::ifstream cacheFile(filename, std::ios::binary);
+	if (!cacheFile)
+	{
+		return(false);
+	}
+
+	cacheFile.read((char*)&header, sizeof(header));
+	if ((!cacheFile) ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.geometryKey != GetGeometryKey()) ||
+		(header.vertexFormat != (uint32_t)m_vertexFormat) ||
+		(header.partCount != (uint32_t)(PART_COUNT * LOD_COUNT)) ||
+		(header.shapeCount == 0) ||
+		((header.vertexDataSize % GetVertexSize()) != 0) ||
+		((header.indexDataSize % GetIndexSize()) != 0))
+	{
+		return(false);
+	}
+
+	std::vector<SHAPE_RANGE> shapes(header.shapeCount);
+	MESH_RANGE parts[PART_COUNT][LOD_COUNT];
+	std::vector<uint8_t> vertexData(header.vertexDataSize);
+	std::vector<uint8_t> indexData(header.indexDataSize);
+
+	cacheFile.read((char*)shapes.data(), shapes.size() * sizeof(SHAPE_RANGE));
+	cacheFile.read((char*)parts, sizeof(parts));
+	cacheFile.read((char*)vertexData.data(), vertexData.size());
+	cacheFile.read((char*)indexData.data(), indexData.size());
+	if (!cacheFile)
+	{
+		return(false);
+	}
+
+	// every range must lie inside the geometry it draws
+	GLuint nIndices = (GLuint)(indexData.size() / GetIndexSize());
+	GLuint nVertices = (GLuint)(vertexData.size() / GetVertexSize());
+	for (size_t mesh = 0; mesh < shapes.size(); mesh++)
+	{
+		if (((uint64_t)shapes[mesh].firstIndex + shapes[mesh].nIndices > nIndices) ||
+			(shapes[mesh].baseVertex < 0) ||
+			((uint64_t)shapes[mesh].baseVertex + shapes[mesh].nVertices > nVertices))
+		{
+			return(false);
+		}
+	}
+	for (int part = 0; part < PART_COUNT; part++)
+	{
+		for (int lod = 0; lod < LOD_COUNT; lod++)
+		{
+			const MESH_RANGE& range = parts[part][lod];
+
+			if ((range.mesh >= (int)shapes.size()) ||
+				((range.mesh >= 0) && ((uint64_t)range.firstIndex + range.nIndices > nIndices)))
+			{
+				return(false);
+			}
+		}
+	}
+
+	m_shapes.swap(shapes);
+	memcpy(m_parts, parts, sizeof(parts));
+	m_vertexData.swap(vertexData);
+	m_indexData.swap(indexData);
+	m_finishedShapes = (int)m_shapes.size();
+	m_bGeometryDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SaveMeshCache()
+ *
+ *  This method is used for writing the loaded shapes to a
+ *  mesh cache file, after finishing them.  The directory of
+ *  the file is created when it does not exist.
+ ***********************************************************/
+bool PrimitiveMeshes::SaveMeshCache(const char* filename)
+{
+	CACHE_FILE_HEADER header;
+	std::error_code error;
+
+	if (m_shapes.empty() == true)
+	{
+		return(false);
+	}
+	FinishGeometry();
+
+	std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+	if (directory.empty() == false)
+	{
+		std::filesystem::create_directories(directory, error);
+	}
+
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.geometryKey = GetGeometryKey();
+	header.vertexFormat = (uint32_t)m_vertexFormat;
+	header.shapeCount = (uint32_t)m_shapes.size();
+	header.partCount = (uint32_t)(PART_COUNT * LOD_COUNT);
+	header.vertexDataSize = (uint32_t)m_vertexData.size();
+	header.indexDataSize = (uint32_t)m_indexData.size();
+
+	std::ofstream cacheFile(filename, std::ios::binary | std::ios::trunc);
+	if (!cacheFile)
+	{
+		std::cout << "Could not write mesh cache:" << filename << std::endl;
+		return(false);
+	}
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write((const char*)m_shapes.data(), m_shapes.size() * sizeof(SHAPE_RANGE));
+	cacheFile.write((const char*)m_parts, sizeof(m_parts));
+	cacheFile.write((const char*)m_vertexData.data(), m_vertexData.size());
+	cacheFile.write((const char*)m_indexData.data(), m_indexData.size());
+
+	return(cacheFile.good());
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for generating a flat plane on the
+ *  XZ axes from -1 to 1, facing up.
+ ***********************************************************/
+void PrimitiveMeshes::LoadPlaneMesh()
+{
+	std::vector<VERTEX> vertices;
+	std::vector<GLuint> indices;
+	glm::vec3 normal(0.0f, 1.0f, 0.0f);
+
+	vertices.push_back(MakeVertex(glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f)));
+	vertices.push_back(MakeVertex(glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f)));
+	vertices.push_back(MakeVertex(glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f)));
+	vertices.push_back(MakeVertex(glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f)));
+
+	GLuint planeIndices[] = { 3, 2, 1, 3, 1, 0 };
+	indices.assign(planeIndices, planeIndices + 6);
+
+	// a flat plane has nothing to simplify
+	int mesh = CreateMesh(vertices, indices);
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		SetPartRange(PART_PLANE, lod, mesh, vertices, indices, 0, (GLuint)indices.size());
+	}
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for generating a unit box centered
+ *  on the origin, with separate vertices for each face.
+ ***********************************************************/
+void PrimitiveMeshes::LoadBoxMesh()
+{
+	std::vector<VERTEX> vertices;
+	std::vector<GLuint> indices;
+
+	// normal, horizontal and vertical direction of each face
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) }
+	};
+
+	for (int face = 0; face < 6; face++)
+	{
+		glm::vec3 normal = faces[face][0];
+		glm::vec3 center = normal * 0.5f;
+		glm::vec3 u = faces[face][1] * 0.5f;
+		glm::vec3 v = faces[face][2] * 0.5f;
+		GLuint first = (GLuint)vertices.size();
+
+		vertices.push_back(MakeVertex(center - u - v, normal, glm::vec2(0.0f, 0.0f)));
+		vertices.push_back(MakeVertex(center + u - v, normal, glm::vec2(1.0f, 0.0f)));
+		vertices.push_back(MakeVertex(center + u + v, normal, glm::vec2(1.0f, 1.0f)));
+		vertices.push_back(MakeVertex(center - u + v, normal, glm::vec2(0.0f, 1.0f)));
+
+		indices.push_back(first);
+		indices.push_back(first + 1);
+		indices.push_back(first + 2);
+		indices.push_back(first);
+		indices.push_back(first + 2);
+		indices.push_back(first + 3);
+	}
+
+	// the box is already as simple as it can be
+	int mesh = CreateMesh(vertices, indices);
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		SetPartRange(PART_BOX, lod, mesh, vertices, indices, 0, (GLuint)indices.size());
+	}
+}
+
+/***********************************************************
+ *  LoadSphereMesh()
+ *
+ *  This method is used for generating a sphere with a radius
+ *  of 1 centered on the origin, at each level of detail.
+ ***********************************************************/
+void PrimitiveMeshes::LoadSphereMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+
+		AppendSphereRings(vertices, indices, SPHERE_STACKS[lod], SPHERE_SECTORS[lod], PI);
+
+		int mesh = CreateMesh(vertices, indices);
+		SetPartRange(PART_SPHERE, lod, mesh, vertices, indices, 0, (GLuint)indices.size());
+	}
+}
+
+/***********************************************************
+ *  LoadHalfSphereMesh()
+ *
+ *  This method is used for generating the top half of a
+ *  sphere with a radius of 1, closed with a flat bottom, at
+ *  each level of detail.
+ ***********************************************************/
+void PrimitiveMeshes::LoadHalfSphereMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+		const int sectors = SPHERE_SECTORS[lod];
+
+		AppendSphereRings(vertices, indices, SPHERE_STACKS[lod] / 2, sectors, PI * 0.5f);
+
+		// flat bottom facing down
+		GLuint center = (GLuint)vertices.size();
+		vertices.push_back(MakeVertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.5f, 0.5f)));
+		for (int sector = 0; sector <= sectors; sector++)
+		{
+			float theta = 2.0f * PI * (float)sector / (float)sectors;
+			vertices.push_back(MakeVertex(
+				glm::vec3(cos(theta), 0.0f, -sin(theta)),
+				glm::vec3(0.0f, -1.0f, 0.0f),
+				glm::vec2(0.5f + 0.5f * cos(theta), 0.5f - 0.5f * sin(theta))));
+		}
+		for (int sector = 0; sector < sectors; sector++)
+		{
+			indices.push_back(center);
+			indices.push_back(center + 2 + sector);
+			indices.push_back(center + 1 + sector);
+		}
+
+		int mesh = CreateMesh(vertices, indices);
+		SetPartRange(PART_HALF_SPHERE, lod, mesh, vertices, indices, 0, (GLuint)indices.size());
+	}
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for generating a cylinder with a
+ *  radius of 1 that runs from Y=0 to Y=1, at each level of
+ *  detail.  The top, bottom and sides can be drawn
+ *  separately.
+ ***********************************************************/
+void PrimitiveMeshes::LoadCylinderMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+		GLuint partIndices[3] = { 0, 0, 0 };
+
+		AppendCylinder(vertices, indices, 1.0f, 1.0f, CYLINDER_SECTORS[lod], partIndices);
+
+		int mesh = CreateMesh(vertices, indices);
+		SetPartRange(PART_CYLINDER_TOP, lod, mesh, vertices, indices, 0, partIndices[0]);
+		SetPartRange(PART_CYLINDER_BOTTOM, lod, mesh, vertices, indices, partIndices[0], partIndices[1]);
+		SetPartRange(PART_CYLINDER_SIDES, lod, mesh, vertices, indices, partIndices[0] + partIndices[1], partIndices[2]);
+	}
+}
+
+/***********************************************************
+ *  LoadTaperedCylinderMesh()
+ *
+ *  This method is used for generating a cylinder with a
+ *  bottom radius of 1 and a top radius of 0.5 that runs from
+ *  Y=0 to Y=1, at each level of detail.  The top, bottom and
+ *  sides can be drawn separately.
+ ***********************************************************/
+void PrimitiveMeshes::LoadTaperedCylinderMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+		GLuint partIndices[3] = { 0, 0, 0 };
+
+		AppendCylinder(vertices, indices, 1.0f, 0.5f, CYLINDER_SECTORS[lod], partIndices);
+
+		int mesh = CreateMesh(vertices, indices);
+		SetPartRange(PART_TAPERED_CYLINDER_TOP, lod, mesh, vertices, indices, 0, partIndices[0]);
+		SetPartRange(PART_TAPERED_CYLINDER_BOTTOM, lod, mesh, vertices, indices, partIndices[0], partIndices[1]);
+		SetPartRange(PART_TAPERED_CYLINDER_SIDES, lod, mesh, vertices, indices, partIndices[0] + partIndices[1], partIndices[2]);
+	}
+}
+
+/***********************************************************
+ *  LoadTorusMesh()
+ *
+ *  This method is used for generating a torus on the XY axes
+ *  with a main radius of 1 and the passed in tube thickness,
+ *  at each level of detail.
+ ***********************************************************/
+void PrimitiveMeshes::LoadTorusMesh(float thickness)
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+		const int mainSegments = TORUS_MAIN_SEGMENTS[lod];
+		const int tubeSegments = TORUS_TUBE_SEGMENTS[lod];
+
+		for (int mainSegment = 0; mainSegment <= mainSegments; mainSegment++)
+		{
+			float theta = 2.0f * PI * (float)mainSegment / (float)mainSegments;
+
+			for (int tubeSegment = 0; tubeSegment <= tubeSegments; tubeSegment++)
+			{
+				float phi = 2.0f * PI * (float)tubeSegment / (float)tubeSegments;
+				glm::vec3 normal(cos(phi) * cos(theta), cos(phi) * sin(theta), sin(phi));
+				float ringRadius = 1.0f + thickness * cos(phi);
+
+				vertices.push_back(MakeVertex(
+					glm::vec3(ringRadius * cos(theta), ringRadius * sin(theta), thickness * sin(phi)),
+					normal,
+					glm::vec2((float)mainSegment / (float)mainSegments, (float)tubeSegment / (float)tubeSegments)));
+			}
+		}
+
+		for (int mainSegment = 0; mainSegment < mainSegments; mainSegment++)
+		{
+			for (int tubeSegment = 0; tubeSegment < tubeSegments; tubeSegment++)
+			{
+				GLuint current = mainSegment * (tubeSegments + 1) + tubeSegment;
+				GLuint next = current + tubeSegments + 1;
+
+				indices.push_back(current);
+				indices.push_back(next);
+				indices.push_back(current + 1);
+
+				indices.push_back(current + 1);
+				indices.push_back(next);
+				indices.push_back(next + 1);
+			}
+		}
+
+		int mesh = CreateMesh(vertices, indices);
+		SetPartRange(PART_TORUS, lod, mesh, vertices, indices, 0, (GLuint)indices.size());
+	}
+}
+
+/***********************************************************
+ *  IsPartLoaded()
+ *
+ *  This method is used for checking whether the mesh for the
+ *  passed in part has been generated.
+ ***********************************************************/
+bool PrimitiveMeshes::IsPartLoaded(MESH_PART part) const
+{
+	return((part >= 0) && (part < PART_COUNT) && (m_parts[part][0].mesh >= 0));
+}
+
+/***********************************************************
+ *  GetPartBounds()
+ *
+ *  This method is used for getting the local bounding box of
+ *  a part, which is empty at the origin if it is not loaded.
+ *  The full detail level is used, the coarser levels have
+ *  their vertices on its surface.
+ ***********************************************************/
+void PrimitiveMeshes::GetPartBounds(
+	MESH_PART part,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax) const
+{
+	boundsMin = glm::vec3(0.0f);
+	boundsMax = glm::vec3(0.0f);
+
+	if (IsPartLoaded(part) == true)
+	{
+		boundsMin = m_parts[part][0].boundsMin;
+		boundsMax = m_parts[part][0].boundsMax;
+	}
+}
+
+/***********************************************************
+ *  GetPartRange()
+ *
+ *  This method is used for getting the range of the shared
+ *  index buffer and the base vertex a level of detail of a
+ *  part is drawn with, which are all 0 if it is not loaded.
+ ***********************************************************/
+void PrimitiveMeshes::GetPartRange(
+	MESH_PART part,
+	int lod,
+	GLuint& firstIndex,
+	GLuint& nIndices,
+	GLint& baseVertex) const
+{
+	firstIndex = 0;
+	nIndices = 0;
+	baseVertex = 0;
+
+	if ((IsPartLoaded(part) == true) && (lod >= 0) && (lod < LOD_COUNT))
+	{
+		firstIndex = m_parts[part][lod].firstIndex;
+		nIndices = m_parts[part][lod].nIndices;
+		baseVertex = m_parts[part][lod].baseVertex;
+	}
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used for copying the per-instance data for
+ *  the current frame into the instance buffer.  The buffer
+ *  storage is orphaned first so the driver does not have to
+ *  wait for the previous frame to finish with it.
+ ***********************************************************/
+void PrimitiveMeshes::UploadInstances(
+	const INSTANCE_DATA* instances,
+	int instanceCount)
+{
+	GLsizeiptr dataSize = instanceCount * sizeof(INSTANCE_DATA);
+
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	// grow the buffer when needed, it never shrinks
+	if (dataSize > m_instanceBufferSize)
+	{
+		m_instanceBufferSize = dataSize * 2;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, NULL, GL_STREAM_DRAW);
+	if (dataSize > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, instances);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawInstanced()
+ *
+ *  This method is used for drawing a level of detail of a
+ *  shape part once for each instance in the passed in range
+ *  of the uploaded instances.
+ ***********************************************************/
+void PrimitiveMeshes::DrawInstanced(
+	MESH_PART part,
+	int lod,
+	int firstInstance,
+	int instanceCount)
+{
+	DrawInstanced(part, lod, m_instanceBuffer, 0, firstInstance, instanceCount);
+}
+
+/***********************************************************
+ *  DrawInstanced()
+ *
+ *  This method is used for drawing a level of detail of a
+ *  shape part once for each instance in the passed in range
+ *  of the instance data that starts at a byte offset in an
+ *  instance buffer, such as a region of a ring buffer the
+ *  frame was written into.
+ ***********************************************************/
+void PrimitiveMeshes::DrawInstanced(
+	MESH_PART part,
+	int lod,
+	GLuint instanceBuffer,
+	GLintptr byteOffset,
+	int firstInstance,
+	int instanceCount)
+{
+	if ((IsPartLoaded(part) == false) || (lod < 0) || (lod >= LOD_COUNT) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = m_parts[part][lod];
+
+	BindGeometry();
+	SetInstanceAttributes(instanceBuffer, byteOffset + firstInstance * sizeof(INSTANCE_DATA));
+
+	glDrawElementsInstancedBaseVertex(
+		GL_TRIANGLES,
+		range.nIndices,
+		GetIndexType(),
+		(void*)((GLintptr)range.firstIndex * GetIndexSize()),
+		instanceCount,
+		range.baseVertex);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing a range of the indirect
+ *  commands in a command buffer with one multi-draw call.
+ *  The base instance of each command selects its instances
+ *  in the instance buffer, so the instance attributes point
+ *  at the start of the buffer.
+ ***********************************************************/
+void PrimitiveMeshes::DrawIndirect(
+	GLuint commandBuffer,
+	GLuint instanceBuffer,
+	int firstCommand,
+	int commandCount)
+{
+	// the layout of DrawElementsIndirectCommand
+	const int COMMAND_SIZE = 5 * sizeof(GLuint);
+
+	if (commandCount <= 0)
+	{
+		return;
+	}
+
+	BindGeometry();
+	SetInstanceAttributes(instanceBuffer, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GetIndexType(),
+		(void*)((GLintptr)firstCommand * COMMAND_SIZE),
+		commandCount,
+		0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glBindVertexArray(0);
+}
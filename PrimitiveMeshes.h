@@ -0,0 +1,273 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.h
+// ============
+// generate the basic 3D shape meshes and draw them with instancing
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  PrimitiveMeshes
+ *
+ *  This class generates the same basic shapes as the course
+ *  ShapeMeshes class (plane, box, sphere, half sphere,
+ *  cylinder, tapered cylinder and torus) and packs all of
+ *  them into one shared vertex and index buffer behind a
+ *  single vertex array object.  The shapes can be drawn many
+ *  times with one instanced draw command by filling the
+ *  shared instance buffer with per-instance data, or with
+ *  multi-draw indirect commands written on the GPU.
+ *
+ *  The curved shapes are generated at LOD_COUNT levels of
+ *  detail, from the full tessellation at level 0 to the
+ *  coarsest at the last level.  The flat shapes use the same
+ *  range for every level.
+ *
+ *  Before the geometry is uploaded the triangles of each part
+ *  are put in vertex cache order and the vertices of each
+ *  shape in the order the triangles first use them.  The
+ *  finished geometry is kept in its upload layout, so it can
+ *  be saved to a mesh cache file and uploaded straight from
+ *  the file at the next start instead of being generated.
+ ***********************************************************/
+class PrimitiveMeshes
+{
+public:
+	// constructor
+	PrimitiveMeshes();
+	// destructor
+	~PrimitiveMeshes();
+
+	// number of generated levels of detail
+	static const int LOD_COUNT = 3;
+
+	// the separately drawable parts of the basic shapes
+	enum MESH_PART
+	{
+		PART_PLANE,
+		PART_BOX,
+		PART_SPHERE,
+		PART_HALF_SPHERE,
+		PART_CYLINDER_TOP,
+		PART_CYLINDER_BOTTOM,
+		PART_CYLINDER_SIDES,
+		PART_TAPERED_CYLINDER_TOP,
+		PART_TAPERED_CYLINDER_BOTTOM,
+		PART_TAPERED_CYLINDER_SIDES,
+		PART_TORUS,
+		PART_COUNT
+	};
+
+	// layout of the vertices and indices in the shared buffers
+	enum VERTEX_FORMAT
+	{
+		// VERTEX values and 32-bit indices
+		FORMAT_FULL,
+		// COMPACT_VERTEX values and 16-bit indices
+		FORMAT_COMPACT
+	};
+
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// half the size of VERTEX, the vertex shader tells the two
+	// layouts apart by the position W value
+	struct COMPACT_VERTEX
+	{
+		// half float position, W is 0
+		GLhalf position[4];
+		// octahedral normal as signed normalized values
+		GLshort normal[2];
+		// texture coordinate as unsigned normalized values
+		GLushort textureCoordinate[2];
+	};
+
+	// per-instance values read by the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		GLint materialIndex;
+		GLint bUseTexture;
+		GLint textureLayer;
+		// dithered level of detail fade, 0 when the instance
+		// is fully drawn, 1 to 255 when it is fading in and
+		// -1 to -255 when it is fading out
+		GLint lodFade;
+	};
+
+	// where one generated shape is in the shared buffers
+	struct SHAPE_RANGE
+	{
+		GLuint firstIndex;
+		GLuint nIndices;
+		GLint baseVertex;
+		GLuint nVertices;
+	};
+
+	struct MESH_RANGE
+	{
+		// index of the shape the part is stored in
+		int mesh;
+		// range of indices in the shared index buffer, the
+		// indices are relative to the base vertex
+		GLuint firstIndex;
+		GLuint nIndices;
+		GLint baseVertex;
+		// local bounding box of the vertices in the range
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+private:
+	// generated shapes, in the order they were loaded
+	std::vector<SHAPE_RANGE> m_shapes;
+	// layout of the finished geometry
+	VERTEX_FORMAT m_vertexFormat;
+	// vertices and indices of the shapes that have not been
+	// finished yet, starting with shape m_finishedShapes
+	std::vector<VERTEX> m_vertices;
+	std::vector<GLuint> m_indices;
+	int m_finishedShapes;
+	// finished vertices and indices of every shape in the
+	// layout of the vertex format, uploaded together
+	std::vector<uint8_t> m_vertexData;
+	std::vector<uint8_t> m_indexData;
+	// shared geometry buffers and the vertex array using them
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// shapes were added since the buffers were last uploaded
+	bool m_bGeometryDirty;
+	// index ranges for each level of each drawable part
+	MESH_RANGE m_parts[PART_COUNT][LOD_COUNT];
+	// shared buffer holding the per-instance data
+	GLuint m_instanceBuffer;
+	// allocated size of the instance buffer in bytes
+	GLsizeiptr m_instanceBufferSize;
+
+	// append generated vertices and indices to the shared geometry
+	int CreateMesh(
+		const std::vector<VERTEX>& vertices,
+		const std::vector<GLuint>& indices);
+	// register the index range of a level of a drawable part
+	void SetPartRange(
+		MESH_PART part,
+		int lod,
+		int mesh,
+		const std::vector<VERTEX>& vertices,
+		const std::vector<GLuint>& indices,
+		GLuint firstIndex,
+		GLuint nIndices);
+	// optimize the shapes added since the last call and append
+	// them to the finished geometry
+	void FinishGeometry();
+	// get the size of a vertex and an index of the format
+	GLsizei GetVertexSize() const;
+	GLsizei GetIndexSize() const;
+	GLenum GetIndexType() const;
+	// upload the shared geometry when shapes have been added
+	// and bind its vertex array object
+	void BindGeometry();
+	// point the instance attributes at an offset in an instance buffer
+	void SetInstanceAttributes(GLuint instanceBuffer, GLsizeiptr byteOffset);
+
+	// append the vertices and indices of a capped ring shape
+	static void AppendCylinder(
+		std::vector<VERTEX>& vertices,
+		std::vector<GLuint>& indices,
+		float bottomRadius,
+		float topRadius,
+		int sectors,
+		GLuint partIndices[3]);
+	// append the rings of a sphere from the top down to an angle
+	static void AppendSphereRings(
+		std::vector<VERTEX>& vertices,
+		std::vector<GLuint>& indices,
+		int stacks,
+		int sectors,
+		float endAngle);
+
+public:
+	// select the layout of the shared buffers, which can only
+	// be changed before any shape is loaded
+	bool SetVertexFormat(VERTEX_FORMAT format);
+
+	// load every shape from a mesh cache file instead of
+	// generating them, false is returned when the file is
+	// missing or was written for other shapes or another format
+	bool LoadMeshCache(const char* filename);
+	// write the loaded shapes to a mesh cache file
+	bool SaveMeshCache(const char* filename);
+
+	// generate the basic shape meshes
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadSphereMesh();
+	void LoadHalfSphereMesh();
+	void LoadCylinderMesh();
+	void LoadTaperedCylinderMesh();
+	void LoadTorusMesh(float thickness = 0.1f);
+
+	// check whether a part has been loaded
+	bool IsPartLoaded(MESH_PART part) const;
+
+	// get the local bounding box of a part
+	void GetPartBounds(
+		MESH_PART part,
+		glm::vec3& boundsMin,
+		glm::vec3& boundsMax) const;
+
+	// get the range of the shared buffers a level of a part is
+	// drawn from
+	void GetPartRange(
+		MESH_PART part,
+		int lod,
+		GLuint& firstIndex,
+		GLuint& nIndices,
+		GLint& baseVertex) const;
+
+	// copy the instance data for a frame into the instance buffer
+	void UploadInstances(
+		const INSTANCE_DATA* instances,
+		int instanceCount);
+
+	// draw a part once for each instance in a range of the
+	// uploaded instance data
+	void DrawInstanced(
+		MESH_PART part,
+		int lod,
+		int firstInstance,
+		int instanceCount);
+
+	// draw a part once for each instance in a range of the
+	// instance data at a byte offset in another buffer
+	void DrawInstanced(
+		MESH_PART part,
+		int lod,
+		GLuint instanceBuffer,
+		GLintptr byteOffset,
+		int firstInstance,
+		int instanceCount);
+
+	// draw the indirect commands in a range of a command buffer,
+	// with the instance attributes read from an instance buffer
+	// written on the GPU
+	void DrawIndirect(
+		GLuint commandBuffer,
+		GLuint instanceBuffer,
+		int firstCommand,
+		int commandCount);
+};
@@ -0,0 +1,940 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+// ============
+// record CPU and GPU frame timings and show them in an overlay
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "ResourcePaths.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// number of frames kept in the rolling frame time history
+	const int FRAME_HISTORY_SIZE = 240;
+
+	// frame time budgets used for coloring the graph
+	const float TARGET_FRAME_MILLISECONDS = 1000.0f / 60.0f;
+	const float SLOW_FRAME_MILLISECONDS = 1000.0f / 30.0f;
+	// frame time at the top of the graph
+	const float GRAPH_MAX_MILLISECONDS = 50.0f;
+
+	// area of the graph in normalized device coordinates
+	const float GRAPH_LEFT = -0.98f;
+	const float GRAPH_BOTTOM = -0.98f;
+	const float GRAPH_WIDTH = 0.6f;
+	const float GRAPH_HEIGHT = 0.3f;
+
+	// how often the window title is updated
+	const double TITLE_UPDATE_MICROSECONDS = 500000.0;
+
+	// overlay vertex with a position and a color
+	struct OVERLAY_VERTEX
+	{
+		float x;
+		float y;
+		float r;
+		float g;
+		float b;
+	};
+
+	/***********************************************************
+	 *  AppendQuad()
+	 *
+	 *  Appends the two triangles of a rectangle to the overlay
+	 *  vertices.
+	 ***********************************************************/
+	void AppendQuad(
+		FrameVector<OVERLAY_VERTEX>& vertices,
+		float left, float bottom, float right, float top,
+		float r, float g, float b)
+	{
+		OVERLAY_VERTEX corners[4] =
+		{
+			{ left, bottom, r, g, b },
+			{ right, bottom, r, g, b },
+			{ right, top, r, g, b },
+			{ left, top, r, g, b }
+		};
+
+		vertices.push_back(corners[0]);
+		vertices.push_back(corners[1]);
+		vertices.push_back(corners[2]);
+		vertices.push_back(corners[0]);
+		vertices.push_back(corners[2]);
+		vertices.push_back(corners[3]);
+	}
+}
+
+/***********************************************************
+ *  Profiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Profiler::Profiler()
+{
+	m_startTime = std::chrono::steady_clock::now();
+	m_frameIndex = 0;
+	m_frameStartMicroseconds = 0.0;
+	m_bGpuScopeOpen = false;
+	m_cpuHistoryHead = 0;
+	m_gpuHistoryHead = 0;
+	m_lastGpuFrame = -1;
+	m_lastGpuMilliseconds = 0.0f;
+	m_bFrameLogEnabled = false;
+	m_frameLogFirstFrame = 0;
+	m_captureFirstFrame = 0;
+	m_captureEndFrame = 0;
+	m_bOverlayEnabled = false;
+	m_pOverlayShader = NULL;
+	m_overlayVAO = 0;
+	m_overlayBuffer = 0;
+	m_lastTitleMicroseconds = 0.0;
+	m_bTitleChanged = false;
+	m_bSelectionChanged = false;
+}
+
+/***********************************************************
+ *  ~Profiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Profiler::~Profiler()
+{
+	for (int index = 0; index < QUERY_RING_SIZE; index++)
+	{
+		for (size_t query = 0; query < m_gpuQueries[index].size(); query++)
+		{
+			glDeleteQueries(1, &m_gpuQueries[index][query].query);
+		}
+		m_gpuQueries[index].clear();
+		if (m_freeQueries[index].size() > 0)
+		{
+			glDeleteQueries((GLsizei)m_freeQueries[index].size(), m_freeQueries[index].data());
+		}
+		m_freeQueries[index].clear();
+	}
+
+	if (m_overlayBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_overlayBuffer);
+		m_overlayBuffer = 0;
+	}
+	if (m_overlayVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_overlayVAO);
+		m_overlayVAO = 0;
+	}
+	if (NULL != m_pOverlayShader)
+	{
+		delete m_pOverlayShader;
+		m_pOverlayShader = NULL;
+	}
+}
+
+/***********************************************************
+ *  GetMicroseconds()
+ *
+ *  This method is used for getting the CPU time since the
+ *  profiler was created.
+ ***********************************************************/
+double Profiler::GetMicroseconds() const
+{
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - m_startTime;
+
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  The GPU
+ *  queries issued the last time this ring frame was used are
+ *  read back here.
+ ***********************************************************/
+void Profiler::BeginFrame()
+{
+	int ringIndex = m_frameIndex % QUERY_RING_SIZE;
+
+	// the queries of this ring frame were issued several
+	// frames ago, so their results are normally available
+	if (m_frameIndex >= QUERY_RING_SIZE)
+	{
+		ResolveGpuQueries(ringIndex);
+	}
+
+	m_frameStartMicroseconds = GetMicroseconds();
+	for (size_t index = 0; index < m_counters.size(); index++)
+	{
+		m_counters[index].value = 0;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending the current frame and
+ *  adding its CPU time to the frame history.
+ ***********************************************************/
+void Profiler::EndFrame()
+{
+	double frameEnd = GetMicroseconds();
+
+	// close any scopes that were left open
+	while (m_openScopes.size() > 0)
+	{
+		EndScope();
+	}
+	if (m_bGpuScopeOpen == true)
+	{
+		EndGpuScope();
+	}
+
+	AddFrameTime(m_cpuFrameTimes, m_cpuHistoryHead, (float)((frameEnd - m_frameStartMicroseconds) / 1000.0));
+
+	if (IsCapturingFrame(m_frameIndex) == true)
+	{
+		TRACE_EVENT event;
+		event.name = "Frame";
+		event.bGpu = false;
+		event.startMicroseconds = m_frameStartMicroseconds;
+		event.durationMicroseconds = frameEnd - m_frameStartMicroseconds;
+		m_capturedEvents.push_back(event);
+	}
+
+	m_lastCounters = m_counters;
+
+	if (m_bFrameLogEnabled == true)
+	{
+		FRAME_RECORD record;
+		record.cpuMilliseconds = (float)((frameEnd - m_frameStartMicroseconds) / 1000.0);
+		record.gpuMilliseconds = 0.0f;
+		for (size_t index = 0; index < m_counters.size(); index++)
+		{
+			record.counters[m_counters[index].name] = m_counters[index].value;
+		}
+		m_frameLog.push_back(record);
+	}
+
+	m_frameIndex++;
+
+	// the trace is written once the GPU results of the last
+	// captured frame have been read
+	if ((m_captureFilename.empty() == false) &&
+		(m_frameIndex >= m_captureEndFrame + QUERY_RING_SIZE))
+	{
+		WriteTrace(m_captureFilename.c_str());
+		m_captureFilename.clear();
+		m_capturedEvents.clear();
+	}
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used for starting a named CPU scope.
+ ***********************************************************/
+void Profiler::BeginScope(const char* name)
+{
+	OPEN_SCOPE scope;
+	scope.name = name;
+	scope.startMicroseconds = GetMicroseconds();
+	m_openScopes.push_back(scope);
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used for ending the innermost CPU scope.
+ ***********************************************************/
+void Profiler::EndScope()
+{
+	if (m_openScopes.size() == 0)
+	{
+		return;
+	}
+
+	OPEN_SCOPE scope = m_openScopes.back();
+	m_openScopes.pop_back();
+
+	if (IsCapturingFrame(m_frameIndex) == true)
+	{
+		TRACE_EVENT event;
+		event.name = scope.name;
+		event.bGpu = false;
+		event.startMicroseconds = scope.startMicroseconds;
+		event.durationMicroseconds = GetMicroseconds() - scope.startMicroseconds;
+		m_capturedEvents.push_back(event);
+	}
+}
+
+/***********************************************************
+ *  BeginGpuScope()
+ *
+ *  This method is used for starting a named GPU scope.  Time
+ *  elapsed queries cannot be nested, so a scope that is begun
+ *  while another one is open is ignored.
+ ***********************************************************/
+void Profiler::BeginGpuScope(const char* name)
+{
+	int ringIndex = m_frameIndex % QUERY_RING_SIZE;
+
+	if (m_bGpuScopeOpen == true)
+	{
+		return;
+	}
+
+	GPU_QUERY gpuQuery;
+	gpuQuery.name = name;
+	gpuQuery.startMicroseconds = GetMicroseconds();
+	gpuQuery.frame = m_frameIndex;
+
+	// reuse a query object from this ring frame when possible
+	if (m_freeQueries[ringIndex].size() > 0)
+	{
+		gpuQuery.query = m_freeQueries[ringIndex].back();
+		m_freeQueries[ringIndex].pop_back();
+	}
+	else
+	{
+		glGenQueries(1, &gpuQuery.query);
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, gpuQuery.query);
+	m_gpuQueries[ringIndex].push_back(gpuQuery);
+	m_bGpuScopeOpen = true;
+}
+
+/***********************************************************
+ *  EndGpuScope()
+ *
+ *  This method is used for ending the open GPU scope.
+ ***********************************************************/
+void Profiler::EndGpuScope()
+{
+	if (m_bGpuScopeOpen == false)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bGpuScopeOpen = false;
+}
+
+/***********************************************************
+ *  ResolveGpuQueries()
+ *
+ *  This method is used for reading the results of the GPU
+ *  queries issued for a ring frame and adding the total to
+ *  the GPU frame history.
+ ***********************************************************/
+void Profiler::ResolveGpuQueries(int ringIndex)
+{
+	std::vector<GPU_QUERY>& queries = m_gpuQueries[ringIndex];
+	double frameMicroseconds = 0.0;
+
+	if (queries.size() == 0)
+	{
+		return;
+	}
+
+	// every query in a ring frame was issued in the same frame
+	int frame = queries.front().frame;
+
+	for (size_t index = 0; index < queries.size(); index++)
+	{
+		GLuint64 elapsed = 0;
+
+		// waits if the result is still not available
+		glGetQueryObjectui64v(queries[index].query, GL_QUERY_RESULT, &elapsed);
+		frameMicroseconds += (double)elapsed / 1000.0;
+
+		if (IsCapturingFrame(queries[index].frame) == true)
+		{
+			// GPU scopes are placed at the CPU time they were
+			// issued, the GPU runs them some time later
+			TRACE_EVENT event;
+			event.name = queries[index].name;
+			event.bGpu = true;
+			event.startMicroseconds = queries[index].startMicroseconds;
+			event.durationMicroseconds = (double)elapsed / 1000.0;
+			m_capturedEvents.push_back(event);
+		}
+
+		m_freeQueries[ringIndex].push_back(queries[index].query);
+	}
+	queries.clear();
+
+	AddFrameTime(m_gpuFrameTimes, m_gpuHistoryHead, (float)(frameMicroseconds / 1000.0));
+	m_lastGpuFrame = frame;
+	m_lastGpuMilliseconds = (float)(frameMicroseconds / 1000.0);
+
+	if ((m_bFrameLogEnabled == true) &&
+		(frame >= m_frameLogFirstFrame) &&
+		(frame - m_frameLogFirstFrame < (int)m_frameLog.size()))
+	{
+		m_frameLog[frame - m_frameLogFirstFrame].gpuMilliseconds = (float)(frameMicroseconds / 1000.0);
+	}
+}
+
+/***********************************************************
+ *  AddFrameTime()
+ *
+ *  This method is used for adding a frame time to a rolling
+ *  history, replacing the oldest sample once it is full.
+ ***********************************************************/
+void Profiler::AddFrameTime(std::vector<float>& history, int& head, float milliseconds)
+{
+	if ((int)history.size() < FRAME_HISTORY_SIZE)
+	{
+		history.push_back(milliseconds);
+		head = (int)history.size() % FRAME_HISTORY_SIZE;
+	}
+	else
+	{
+		history[head] = milliseconds;
+		head = (head + 1) % FRAME_HISTORY_SIZE;
+	}
+}
+
+/***********************************************************
+ *  ComputeStats()
+ *
+ *  This method is used for computing the minimum, average
+ *  and 99th percentile of a rolling history.
+ ***********************************************************/
+Profiler::FRAME_STATS Profiler::ComputeStats(const std::vector<float>& history)
+{
+	FRAME_STATS stats;
+	stats.minMilliseconds = 0.0f;
+	stats.averageMilliseconds = 0.0f;
+	stats.p99Milliseconds = 0.0f;
+	stats.sampleCount = (int)history.size();
+
+	if (history.size() == 0)
+	{
+		return(stats);
+	}
+
+	FrameVector<float> sorted(history.begin(), history.end());
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (size_t index = 0; index < sorted.size(); index++)
+	{
+		total += sorted[index];
+	}
+
+	size_t p99Index = (sorted.size() * 99) / 100;
+	if (p99Index >= sorted.size())
+	{
+		p99Index = sorted.size() - 1;
+	}
+
+	stats.minMilliseconds = sorted.front();
+	stats.averageMilliseconds = (float)(total / sorted.size());
+	stats.p99Milliseconds = sorted[p99Index];
+
+	return(stats);
+}
+
+/***********************************************************
+ *  SetCounter()
+ *
+ *  This method is used for setting a named counter for the
+ *  current frame.  There are only a few counters, so they
+ *  are searched in order.
+ ***********************************************************/
+void Profiler::SetCounter(const char* name, int value)
+{
+	for (size_t index = 0; index < m_counters.size(); index++)
+	{
+		if (strcmp(m_counters[index].name, name) == 0)
+		{
+			m_counters[index].value = value;
+			return;
+		}
+	}
+
+	COUNTER counter;
+	counter.name = name;
+	counter.value = value;
+	m_counters.push_back(counter);
+}
+
+/***********************************************************
+ *  GetCounter()
+ *
+ *  This method is used for getting a named counter of the
+ *  last completed frame, 0 is returned if it was not set.
+ ***********************************************************/
+int Profiler::GetCounter(const char* name) const
+{
+	for (size_t index = 0; index < m_lastCounters.size(); index++)
+	{
+		if (strcmp(m_lastCounters[index].name, name) == 0)
+		{
+			return(m_lastCounters[index].value);
+		}
+	}
+
+	return(0);
+}
+
+/***********************************************************
+ *  GetCpuFrameStats()
+ *
+ *  This method is used for getting the CPU frame statistics.
+ ***********************************************************/
+Profiler::FRAME_STATS Profiler::GetCpuFrameStats() const
+{
+	return(ComputeStats(m_cpuFrameTimes));
+}
+
+/***********************************************************
+ *  GetGpuFrameStats()
+ *
+ *  This method is used for getting the GPU frame statistics.
+ ***********************************************************/
+Profiler::FRAME_STATS Profiler::GetGpuFrameStats() const
+{
+	return(ComputeStats(m_gpuFrameTimes));
+}
+
+/***********************************************************
+ *  GetFrameIndex()
+ *
+ *  This method is used for getting the number of the frame
+ *  that is being recorded.
+ ***********************************************************/
+int Profiler::GetFrameIndex() const
+{
+	return(m_frameIndex);
+}
+
+/***********************************************************
+ *  GetLastGpuFrame()
+ *
+ *  This method is used for getting the latest GPU frame time
+ *  that was read back.  The frame it was measured in is
+ *  returned, -1 when no GPU time has been read yet.
+ ***********************************************************/
+int Profiler::GetLastGpuFrame(float& milliseconds) const
+{
+	milliseconds = m_lastGpuMilliseconds;
+	return(m_lastGpuFrame);
+}
+
+/***********************************************************
+ *  ToggleOverlay()
+ *
+ *  This method is used for turning the overlay on or off.
+ ***********************************************************/
+void Profiler::ToggleOverlay()
+{
+	m_bOverlayEnabled = !m_bOverlayEnabled;
+}
+
+/***********************************************************
+ *  IsOverlayEnabled()
+ *
+ *  This method is used for checking whether the overlay is
+ *  drawn.
+ ***********************************************************/
+bool Profiler::IsOverlayEnabled() const
+{
+	return(m_bOverlayEnabled);
+}
+
+/***********************************************************
+ *  CreateOverlay()
+ *
+ *  This method is used for loading the overlay shader and
+ *  creating the buffer the graph vertices are streamed into.
+ ***********************************************************/
+void Profiler::CreateOverlay()
+{
+	m_pOverlayShader = new ShaderManager();
+	m_pOverlayShader->LoadShaders(
+		ResourcePaths::Resolve("shaders/overlayVertexShader.glsl").c_str(),
+		ResourcePaths::Resolve("shaders/overlayFragmentShader.glsl").c_str());
+
+	glGenVertexArrays(1, &m_overlayVAO);
+	glBindVertexArray(m_overlayVAO);
+
+	glGenBuffers(1, &m_overlayBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_overlayBuffer);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OVERLAY_VERTEX), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(OVERLAY_VERTEX), (void*)(2 * sizeof(float)));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UpdateWindowTitle()
+ *
+ *  This method is used for showing the frame statistics and
+ *  counters in the window title.
+ ***********************************************************/
+void Profiler::UpdateWindowTitle(GLFWwindow* window, const char* windowTitle)
+{
+	FRAME_STATS cpuStats = GetCpuFrameStats();
+	FRAME_STATS gpuStats = GetGpuFrameStats();
+	char title[1024];
+	size_t length = 0;
+
+	// the title is built in place, so it does not allocate
+	length = snprintf(
+		title,
+		sizeof(title),
+		"%s | %.1f fps | cpu avg %.2f ms p99 %.2f ms min %.2f ms | gpu avg %.2f ms p99 %.2f ms",
+		windowTitle,
+		(cpuStats.averageMilliseconds > 0.0f) ? 1000.0f / cpuStats.averageMilliseconds : 0.0f,
+		cpuStats.averageMilliseconds,
+		cpuStats.p99Milliseconds,
+		cpuStats.minMilliseconds,
+		gpuStats.averageMilliseconds,
+		gpuStats.p99Milliseconds);
+
+	if ((m_selectionText.empty() == false) && (length < sizeof(title)))
+	{
+		length += snprintf(
+			title + length,
+			sizeof(title) - length,
+			" | selected %s",
+			m_selectionText.c_str());
+	}
+
+	for (size_t index = 0; (index < m_lastCounters.size()) && (length < sizeof(title)); index++)
+	{
+		length += snprintf(
+			title + length,
+			sizeof(title) - length,
+			" | %s %d",
+			m_lastCounters[index].name,
+			m_lastCounters[index].value);
+	}
+
+	glfwSetWindowTitle(window, title);
+}
+
+/***********************************************************
+ *  DrawOverlay()
+ *
+ *  This method is used for drawing the frame time graph in
+ *  the lower left corner and updating the window title.  Each
+ *  bar is one CPU frame, colored by the frame budget, with
+ *  the matching GPU frame drawn over it in blue.
+ ***********************************************************/
+void Profiler::DrawOverlay(GLFWwindow* window, const char* windowTitle)
+{
+	FrameVector<OVERLAY_VERTEX> vertices;
+	double now = GetMicroseconds();
+
+	if (m_bOverlayEnabled == false)
+	{
+		// put the plain title back after the overlay is closed,
+		// keeping only the selection
+		if (((m_bTitleChanged == true) || (m_bSelectionChanged == true)) && (NULL != window))
+		{
+			if (m_selectionText.empty() == true)
+			{
+				glfwSetWindowTitle(window, windowTitle);
+			}
+			else
+			{
+				char title[1024];
+				snprintf(title, sizeof(title), "%s | selected %s", windowTitle, m_selectionText.c_str());
+				glfwSetWindowTitle(window, title);
+			}
+			m_bTitleChanged = false;
+			m_bSelectionChanged = false;
+		}
+		return;
+	}
+
+	// a new selection is shown at once
+	if ((NULL != window) &&
+		((now - m_lastTitleMicroseconds >= TITLE_UPDATE_MICROSECONDS) || (m_bSelectionChanged == true)))
+	{
+		UpdateWindowTitle(window, windowTitle);
+		m_lastTitleMicroseconds = now;
+		m_bTitleChanged = true;
+		m_bSelectionChanged = false;
+	}
+
+	if (m_pOverlayShader == NULL)
+	{
+		CreateOverlay();
+	}
+
+	float barWidth = GRAPH_WIDTH / FRAME_HISTORY_SIZE;
+	float scale = GRAPH_HEIGHT / GRAPH_MAX_MILLISECONDS;
+
+	// dark background behind the bars
+	AppendQuad(vertices, GRAPH_LEFT, GRAPH_BOTTOM, GRAPH_LEFT + GRAPH_WIDTH, GRAPH_BOTTOM + GRAPH_HEIGHT, 0.1f, 0.1f, 0.1f);
+
+	// oldest sample on the left
+	for (int sample = 0; sample < (int)m_cpuFrameTimes.size(); sample++)
+	{
+		int index = ((int)m_cpuFrameTimes.size() < FRAME_HISTORY_SIZE) ? sample : (m_cpuHistoryHead + sample) % FRAME_HISTORY_SIZE;
+		float milliseconds = std::min(m_cpuFrameTimes[index], GRAPH_MAX_MILLISECONDS);
+		float left = GRAPH_LEFT + sample * barWidth;
+		float r = 0.2f;
+		float g = 0.8f;
+
+		if (m_cpuFrameTimes[index] > SLOW_FRAME_MILLISECONDS)
+		{
+			r = 0.9f;
+			g = 0.2f;
+		}
+		else if (m_cpuFrameTimes[index] > TARGET_FRAME_MILLISECONDS)
+		{
+			r = 0.9f;
+			g = 0.8f;
+		}
+
+		AppendQuad(vertices, left, GRAPH_BOTTOM, left + barWidth, GRAPH_BOTTOM + milliseconds * scale, r, g, 0.2f);
+	}
+	for (int sample = 0; sample < (int)m_gpuFrameTimes.size(); sample++)
+	{
+		int index = ((int)m_gpuFrameTimes.size() < FRAME_HISTORY_SIZE) ? sample : (m_gpuHistoryHead + sample) % FRAME_HISTORY_SIZE;
+		float milliseconds = std::min(m_gpuFrameTimes[index], GRAPH_MAX_MILLISECONDS);
+		float left = GRAPH_LEFT + sample * barWidth;
+
+		AppendQuad(vertices, left, GRAPH_BOTTOM, left + barWidth * 0.5f, GRAPH_BOTTOM + milliseconds * scale, 0.3f, 0.5f, 1.0f);
+	}
+
+	float budget = GRAPH_BOTTOM + TARGET_FRAME_MILLISECONDS * scale;
+	AppendQuad(vertices, GRAPH_LEFT, budget, GRAPH_LEFT + GRAPH_WIDTH, budget + 0.004f, 1.0f, 1.0f, 1.0f);
+
+	// draw over the scene without disturbing its state
+	GLint previousProgram = 0;
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glDisable(GL_DEPTH_TEST);
+
+	m_pOverlayShader->use();
+	glBindVertexArray(m_overlayVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_overlayBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(OVERLAY_VERTEX), vertices.data(), GL_STREAM_DRAW);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	glUseProgram((GLuint)previousProgram);
+	if (bDepthTest == GL_TRUE)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+}
+
+/***********************************************************
+ *  SetSelection()
+ *
+ *  This method is used for setting the description of the
+ *  selected object that the window title shows, with or
+ *  without the overlay.
+ ***********************************************************/
+void Profiler::SetSelection(const std::string& text)
+{
+	if (text != m_selectionText)
+	{
+		m_selectionText = text;
+		m_bSelectionChanged = true;
+	}
+}
+
+/***********************************************************
+ *  StartCapture()
+ *
+ *  This method is used for capturing the scopes of the next
+ *  frames.  The trace file is written once their GPU results
+ *  have been read.
+ ***********************************************************/
+void Profiler::StartCapture(int frameCount, const char* filename)
+{
+	if ((IsCapturing() == true) || (frameCount <= 0))
+	{
+		return;
+	}
+
+	m_capturedEvents.clear();
+	m_captureFilename = filename;
+	m_captureFirstFrame = m_frameIndex;
+	m_captureEndFrame = m_frameIndex + frameCount;
+
+	std::cout << "Capturing " << frameCount << " frames to " << filename << std::endl;
+}
+
+/***********************************************************
+ *  IsCapturing()
+ *
+ *  This method is used for checking whether a capture is in
+ *  progress.
+ ***********************************************************/
+bool Profiler::IsCapturing() const
+{
+	return(m_captureFilename.empty() == false);
+}
+
+/***********************************************************
+ *  IsCapturingFrame()
+ *
+ *  This method is used for checking whether the events of the
+ *  passed in frame are kept for the trace.
+ ***********************************************************/
+bool Profiler::IsCapturingFrame(int frame) const
+{
+	return((IsCapturing() == true) &&
+		(frame >= m_captureFirstFrame) &&
+		(frame < m_captureEndFrame));
+}
+
+/***********************************************************
+ *  WriteTrace()
+ *
+ *  This method is used for writing the captured events in the
+ *  Chrome trace event format, which can be opened in
+ *  chrome://tracing or Perfetto.  CPU scopes are on thread 1
+ *  and GPU scopes on thread 2.
+ ***********************************************************/
+bool Profiler::WriteTrace(const char* filename) const
+{
+	std::ofstream traceFile(filename, std::ios::trunc);
+	if (!traceFile)
+	{
+		std::cout << "Could not write trace file:" << filename << std::endl;
+		return(false);
+	}
+
+	traceFile << "{\"traceEvents\":[\n";
+	traceFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	traceFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	for (size_t index = 0; index < m_capturedEvents.size(); index++)
+	{
+		const TRACE_EVENT& event = m_capturedEvents[index];
+		char text[256];
+
+		snprintf(
+			text,
+			sizeof(text),
+			",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+			event.name,
+			(event.bGpu == true) ? "gpu" : "cpu",
+			event.startMicroseconds,
+			event.durationMicroseconds,
+			(event.bGpu == true) ? 2 : 1);
+		traceFile << text;
+	}
+	traceFile << "\n]}\n";
+
+	std::cout << "Wrote " << m_capturedEvents.size() << " trace events to " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the frame statistics and
+ *  the counters of the last frame to the console.
+ ***********************************************************/
+void Profiler::PrintSummary() const
+{
+	FRAME_STATS cpuStats = GetCpuFrameStats();
+	FRAME_STATS gpuStats = GetGpuFrameStats();
+
+	std::cout << "Frames:" << m_frameIndex
+		<< ", cpu min:" << cpuStats.minMilliseconds
+		<< " avg:" << cpuStats.averageMilliseconds
+		<< " p99:" << cpuStats.p99Milliseconds << " ms"
+		<< ", gpu min:" << gpuStats.minMilliseconds
+		<< " avg:" << gpuStats.averageMilliseconds
+		<< " p99:" << gpuStats.p99Milliseconds << " ms" << std::endl;
+
+	for (size_t index = 0; index < m_lastCounters.size(); index++)
+	{
+		std::cout << "  " << m_lastCounters[index].name << ":" << m_lastCounters[index].value << std::endl;
+	}
+}
+
+/***********************************************************
+ *  EnableFrameLog()
+ *
+ *  This method is used for keeping the timings and counters
+ *  of every frame from the next frame on, for writing
+ *  benchmark results.
+ ***********************************************************/
+void Profiler::EnableFrameLog()
+{
+	m_bFrameLogEnabled = true;
+	m_frameLogFirstFrame = m_frameIndex;
+	m_frameLog.clear();
+}
+
+/***********************************************************
+ *  GetFrameLog()
+ *
+ *  This method is used for getting the logged frames.
+ ***********************************************************/
+const std::vector<Profiler::FRAME_RECORD>& Profiler::GetFrameLog() const
+{
+	return(m_frameLog);
+}
+
+/***********************************************************
+ *  ResolveAllQueries()
+ *
+ *  This method is used for reading every GPU query that is
+ *  still pending, oldest frame first, so that the last
+ *  frames of the frame log have their GPU times.
+ ***********************************************************/
+void Profiler::ResolveAllQueries()
+{
+	for (int offset = 0; offset < QUERY_RING_SIZE; offset++)
+	{
+		ResolveGpuQueries((m_frameIndex + offset) % QUERY_RING_SIZE);
+	}
+}
+
+/***********************************************************
+ *  ProfileScope()
+ *
+ *  The constructor for the class, begins the scope.
+ ***********************************************************/
+ProfileScope::ProfileScope(Profiler* pProfiler, const char* name)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginScope(name);
+	}
+}
+
+/***********************************************************
+ *  ~ProfileScope()
+ *
+ *  The destructor for the class, ends the scope.
+ ***********************************************************/
+ProfileScope::~ProfileScope()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+}
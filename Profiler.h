@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.h
+// ============
+// record CPU and GPU frame timings and show them in an overlay
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include "GLFW/glfw3.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  This class records named CPU scopes and GPU scopes for
+ *  each frame.  GPU scopes are measured with GL_TIME_ELAPSED
+ *  queries kept in a ring of frames, so the results are read
+ *  a few frames later without stalling.  Rolling frame time
+ *  statistics and per-frame counters are shown in the window
+ *  title and a frame time graph, and a number of frames can
+ *  be captured to a Chrome trace JSON file.
+ *
+ *  Scope and counter names must be string literals, they are
+ *  kept by address.  Scopes are only recorded on the OpenGL
+ *  thread.  A steady frame does not allocate any memory, so
+ *  the profiler does not show up in the heap allocation
+ *  counter.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// constructor
+	Profiler();
+	// destructor
+	~Profiler();
+
+	// number of frames a GPU query result is read after
+	static const int QUERY_RING_SIZE = 4;
+
+	// one completed scope for the Chrome trace
+	struct TRACE_EVENT
+	{
+		const char* name;
+		bool bGpu;
+		double startMicroseconds;
+		double durationMicroseconds;
+	};
+
+	// scope that has been started but not ended
+	struct OPEN_SCOPE
+	{
+		const char* name;
+		double startMicroseconds;
+	};
+
+	// GPU scope waiting for its query result
+	struct GPU_QUERY
+	{
+		const char* name;
+		GLuint query;
+		double startMicroseconds;
+		int frame;
+	};
+
+	// rolling statistics of the recorded frame times
+	struct FRAME_STATS
+	{
+		float minMilliseconds;
+		float averageMilliseconds;
+		float p99Milliseconds;
+		int sampleCount;
+	};
+
+	// value of a named counter
+	struct COUNTER
+	{
+		const char* name;
+		int value;
+	};
+
+	// timings and counters of one frame in the frame log
+	struct FRAME_RECORD
+	{
+		float cpuMilliseconds;
+		// 0 until the GPU queries of the frame have been read
+		float gpuMilliseconds;
+		std::unordered_map<std::string, int> counters;
+	};
+
+private:
+	// time the profiler was created
+	std::chrono::steady_clock::time_point m_startTime;
+	// number of frames started
+	int m_frameIndex;
+	double m_frameStartMicroseconds;
+
+	// CPU scopes that are still open, innermost last
+	std::vector<OPEN_SCOPE> m_openScopes;
+
+	// GPU queries for each frame in the query ring
+	std::vector<GPU_QUERY> m_gpuQueries[QUERY_RING_SIZE];
+	// unused query objects for each frame in the ring
+	std::vector<GLuint> m_freeQueries[QUERY_RING_SIZE];
+	// GPU scope that is open, only one can be open at a time
+	bool m_bGpuScopeOpen;
+
+	// recent CPU and GPU frame times in milliseconds
+	std::vector<float> m_cpuFrameTimes;
+	std::vector<float> m_gpuFrameTimes;
+	// next sample written in the frame time history
+	int m_cpuHistoryHead;
+	int m_gpuHistoryHead;
+	// frame of the latest GPU time that was read, -1 before the
+	// first, and that time
+	int m_lastGpuFrame;
+	float m_lastGpuMilliseconds;
+
+	// counters for the current and the last completed frame,
+	// in the order they were first set; a counter that is not
+	// set in a frame is 0
+	std::vector<COUNTER> m_counters;
+	std::vector<COUNTER> m_lastCounters;
+
+	// every frame recorded since the frame log was enabled
+	bool m_bFrameLogEnabled;
+	int m_frameLogFirstFrame;
+	std::vector<FRAME_RECORD> m_frameLog;
+
+	// Chrome trace capture state
+	std::vector<TRACE_EVENT> m_capturedEvents;
+	std::string m_captureFilename;
+	int m_captureFirstFrame;
+	int m_captureEndFrame;
+
+	// overlay state
+	bool m_bOverlayEnabled;
+	ShaderManager* m_pOverlayShader;
+	GLuint m_overlayVAO;
+	GLuint m_overlayBuffer;
+	double m_lastTitleMicroseconds;
+	// the window title shows the statistics
+	bool m_bTitleChanged;
+	// text shown in the window title for the selected object,
+	// empty when nothing is selected
+	std::string m_selectionText;
+	bool m_bSelectionChanged;
+
+	// get the microseconds since the profiler was created
+	double GetMicroseconds() const;
+	// read the results of the GPU queries of a ring frame
+	void ResolveGpuQueries(int ringIndex);
+	// add a frame time to a rolling history
+	void AddFrameTime(std::vector<float>& history, int& head, float milliseconds);
+	// check whether the passed in frame is being captured
+	bool IsCapturingFrame(int frame) const;
+	// create the overlay shader and buffers
+	void CreateOverlay();
+	// update the window title with the frame statistics
+	void UpdateWindowTitle(GLFWwindow* window, const char* windowTitle);
+
+public:
+	// mark the start and end of a frame
+	void BeginFrame();
+	void EndFrame();
+
+	// record a named CPU scope
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// record a named GPU scope, GPU scopes cannot be nested
+	void BeginGpuScope(const char* name);
+	void EndGpuScope();
+
+	// set a named counter for the current frame
+	void SetCounter(const char* name, int value);
+	// get a named counter of the last completed frame
+	int GetCounter(const char* name) const;
+
+	// get the rolling frame time statistics
+	FRAME_STATS GetCpuFrameStats() const;
+	FRAME_STATS GetGpuFrameStats() const;
+	// get the number of the frame being recorded, and the latest
+	// GPU frame time that was read with the frame it belongs to
+	int GetFrameIndex() const;
+	int GetLastGpuFrame(float& milliseconds) const;
+
+	// turn the frame time overlay on or off
+	void ToggleOverlay();
+	bool IsOverlayEnabled() const;
+	// draw the frame time graph and update the window title
+	void DrawOverlay(GLFWwindow* window, const char* windowTitle);
+	// show a description of the selected object in the window
+	// title, an empty text clears it
+	void SetSelection(const std::string& text);
+
+	// capture a number of frames and write them to a trace file
+	void StartCapture(int frameCount, const char* filename);
+	bool IsCapturing() const;
+	// write the captured events as Chrome trace JSON
+	bool WriteTrace(const char* filename) const;
+
+	// print the frame statistics and counters to the console
+	void PrintSummary() const;
+
+	// keep the timings of every frame from the next frame on
+	void EnableFrameLog();
+	const std::vector<FRAME_RECORD>& GetFrameLog() const;
+	// wait for and read every GPU query that is still pending
+	void ResolveAllQueries();
+
+	// compute the statistics of a list of frame times
+	static FRAME_STATS ComputeStats(const std::vector<float>& history);
+};
+
+/***********************************************************
+ *  ProfileScope
+ *
+ *  Records a CPU scope for the lifetime of the object.  A
+ *  NULL profiler records nothing.
+ ***********************************************************/
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler* pProfiler, const char* name);
+	~ProfileScope();
+
+private:
+	Profiler* m_pProfiler;
+};
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcepaths.cpp
+// ============
+// resolve the shader, texture and cache paths from the executable location
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResourcePaths.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// directory every resource path is relative to
+	std::string g_baseDirectory;
+
+	// longest executable path read from the system
+	const unsigned int MAX_EXECUTABLE_PATH = 4096;
+
+	/***********************************************************
+	 *  GetExecutablePath()
+	 *
+	 *  Gets the full path of the running executable, or an
+	 *  empty path when the system does not say.
+	 ***********************************************************/
+	std::filesystem::path GetExecutablePath()
+	{
+		std::error_code error;
+
+#if defined(_WIN32)
+		std::vector<wchar_t> buffer(MAX_EXECUTABLE_PATH);
+		DWORD length = GetModuleFileNameW(NULL, buffer.data(), (DWORD)buffer.size());
+		if ((length > 0) && (length < buffer.size()))
+		{
+			return(std::filesystem::path(std::wstring(buffer.data(), length)));
+		}
+#elif defined(__APPLE__)
+		std::vector<char> buffer(MAX_EXECUTABLE_PATH);
+		uint32_t size = (uint32_t)buffer.size();
+		if (_NSGetExecutablePath(buffer.data(), &size) == 0)
+		{
+			return(std::filesystem::canonical(buffer.data(), error));
+		}
+#else
+		std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+		if (!error)
+		{
+			return(executable);
+		}
+#endif
+
+		return(std::filesystem::path());
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for setting the base directory to the
+ *  directory of the executable.  When neither the system nor
+ *  the first argument gives the location, the base is left
+ *  empty and the paths stay relative to the working
+ *  directory.
+ ***********************************************************/
+void ResourcePaths::Initialize(const char* argument0)
+{
+	std::error_code error;
+	std::filesystem::path executable = GetExecutablePath();
+
+	if ((executable.empty() == true) && (NULL != argument0))
+	{
+		executable = std::filesystem::absolute(argument0, error);
+	}
+
+	if ((executable.empty() == true) || (error))
+	{
+		std::cout << "Could not find the executable location, resources are loaded from the working directory" << std::endl;
+		g_baseDirectory.clear();
+		return;
+	}
+
+	g_baseDirectory = executable.parent_path().string();
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used for joining a resource path to the
+ *  base directory.
+ ***********************************************************/
+std::string ResourcePaths::Resolve(const char* path)
+{
+	std::filesystem::path resource(path);
+
+	if ((g_baseDirectory.empty() == true) || (resource.is_absolute() == true))
+	{
+		return(resource.string());
+	}
+
+	return((std::filesystem::path(g_baseDirectory) / resource).lexically_normal().string());
+}
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcepaths.h
+// ============
+// resolve the shader, texture and cache paths from the executable location
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/***********************************************************
+ *  ResourcePaths
+ *
+ *  This class holds the one base directory that every
+ *  resource path of the program is relative to, which is the
+ *  directory of the executable.  The shaders are found next
+ *  to it and the textures and caches one directory above
+ *  it, so the program finds them whatever directory it is
+ *  started from.
+ *
+ *  Paths passed on the command line are not resolved, they
+ *  stay relative to the working directory.
+ ***********************************************************/
+class ResourcePaths
+{
+public:
+	// set the base directory from the executable location, the
+	// first command line argument is used when the location
+	// cannot be read from the system
+	static void Initialize(const char* argument0);
+
+	// get a resource path resolved against the base directory,
+	// absolute paths are returned as they are
+	static std::string Resolve(const char* path);
+};
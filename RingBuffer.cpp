@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.cpp
+// ============
+// persistently mapped buffer for the data written each frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RingBuffer.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the regions start at a multiple of this, which covers the
+	// uniform buffer offset alignment of current drivers
+	const GLsizeiptr REGION_ALIGNMENT = 256;
+
+	// smallest region, so that small scenes do not regrow the
+	// buffer as objects are added
+	const GLsizeiptr MIN_REGION_SIZE = 64 * 1024;
+
+	// longest time to wait for OpenGL to release a region
+	const GLuint64 RING_WAIT_TIMEOUT = 1000000000;
+
+	// binding target used to create and map the buffer, which
+	// leaves the vertex array and draw bindings alone
+	const GLenum RING_TARGET = GL_COPY_WRITE_BUFFER;
+}
+
+/***********************************************************
+ *  RingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RingBuffer::RingBuffer()
+{
+	m_buffer = 0;
+	m_regionSize = 0;
+	m_pPersistentMemory = NULL;
+	m_pFrameMemory = NULL;
+	for (int index = 0; index < FRAME_COUNT; index++)
+	{
+		m_fences[index] = NULL;
+	}
+	m_frame = 0;
+	m_head = 0;
+	m_waitCount = 0;
+}
+
+/***********************************************************
+ *  ~RingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RingBuffer::~RingBuffer()
+{
+	DestroyBuffer();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the buffer with
+ *  FRAME_COUNT regions of at least the passed in size.  When
+ *  buffer storage is supported the buffer is mapped once and
+ *  kept mapped.
+ ***********************************************************/
+void RingBuffer::CreateBuffer(GLsizeiptr regionSize)
+{
+	m_regionSize = (regionSize + REGION_ALIGNMENT - 1) & ~(REGION_ALIGNMENT - 1);
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(RING_TARGET, m_buffer);
+
+	if ((GLEW_VERSION_4_4) || (GLEW_ARB_buffer_storage))
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(RING_TARGET, m_regionSize * FRAME_COUNT, NULL, flags);
+		m_pPersistentMemory = (unsigned char*)glMapBufferRange(RING_TARGET, 0, m_regionSize * FRAME_COUNT, flags);
+		if (NULL == m_pPersistentMemory)
+		{
+			std::cout << "Could not map the frame data buffer persistently" << std::endl;
+		}
+	}
+	else
+	{
+		glBufferData(RING_TARGET, m_regionSize * FRAME_COUNT, NULL, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(RING_TARGET, 0);
+}
+
+/***********************************************************
+ *  DestroyBuffer()
+ *
+ *  This method is used for freeing the buffer and the fences
+ *  of its regions.  OpenGL keeps the storage alive until the
+ *  draws that still read it have finished.
+ ***********************************************************/
+void RingBuffer::DestroyBuffer()
+{
+	for (int index = 0; index < FRAME_COUNT; index++)
+	{
+		if (NULL != m_fences[index])
+		{
+			glDeleteSync(m_fences[index]);
+			m_fences[index] = NULL;
+		}
+	}
+
+	if (m_buffer != 0)
+	{
+		if ((NULL != m_pPersistentMemory) || (NULL != m_pFrameMemory))
+		{
+			glBindBuffer(RING_TARGET, m_buffer);
+			glUnmapBuffer(RING_TARGET);
+			glBindBuffer(RING_TARGET, 0);
+		}
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_pPersistentMemory = NULL;
+	m_pFrameMemory = NULL;
+	m_regionSize = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the writes of a frame in
+ *  the next region.  The fence of the region is waited on
+ *  first, which only blocks when OpenGL is still drawing the
+ *  frame that wrote it FRAME_COUNT frames ago.  A frame
+ *  larger than the regions replaces the buffer with a larger
+ *  one.
+ ***********************************************************/
+void RingBuffer::BeginFrame(GLsizeiptr frameSize)
+{
+	if ((m_buffer == 0) || (frameSize > m_regionSize))
+	{
+		GLsizeiptr regionSize = (frameSize > MIN_REGION_SIZE) ? frameSize * 2 : MIN_REGION_SIZE;
+
+		DestroyBuffer();
+		CreateBuffer(regionSize);
+	}
+
+	m_frame = (m_frame + 1) % FRAME_COUNT;
+	m_head = 0;
+
+	if (NULL != m_fences[m_frame])
+	{
+		// a fence that has not been signalled yet means the CPU
+		// is a full ring ahead of the GPU
+		GLenum status = glClientWaitSync(m_fences[m_frame], 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			m_waitCount++;
+			glClientWaitSync(m_fences[m_frame], GL_SYNC_FLUSH_COMMANDS_BIT, RING_WAIT_TIMEOUT);
+		}
+		glDeleteSync(m_fences[m_frame]);
+		m_fences[m_frame] = NULL;
+	}
+
+	if (NULL != m_pPersistentMemory)
+	{
+		m_pFrameMemory = m_pPersistentMemory + m_frame * m_regionSize;
+	}
+	else
+	{
+		// the fence already kept the region apart from the
+		// draws, so the driver does not have to synchronize
+		glBindBuffer(RING_TARGET, m_buffer);
+		m_pFrameMemory = (unsigned char*)glMapBufferRange(
+			RING_TARGET,
+			m_frame * m_regionSize,
+			m_regionSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(RING_TARGET, 0);
+	}
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving bytes in the region of
+ *  the current frame.  The returned memory must only be
+ *  written, as it may not be cached for reading.  NULL is
+ *  returned when the bytes do not fit or the region could not
+ *  be mapped, and the caller uploads the data another way.
+ ***********************************************************/
+void* RingBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset)
+{
+	GLsizeiptr start = ((m_head + alignment - 1) / alignment) * alignment;
+
+	offset = 0;
+	if ((NULL == m_pFrameMemory) || (start + size > m_regionSize))
+	{
+		return(NULL);
+	}
+
+	m_head = start + size;
+	offset = m_frame * m_regionSize + start;
+
+	return(m_pFrameMemory + start);
+}
+
+/***********************************************************
+ *  FinishWrites()
+ *
+ *  This method is used for ending the writes of the current
+ *  frame.  A coherent persistent mapping needs nothing more,
+ *  otherwise the region is unmapped so it can be drawn from.
+ ***********************************************************/
+void RingBuffer::FinishWrites()
+{
+	if ((NULL == m_pPersistentMemory) && (NULL != m_pFrameMemory))
+	{
+		glBindBuffer(RING_TARGET, m_buffer);
+		glUnmapBuffer(RING_TARGET);
+		glBindBuffer(RING_TARGET, 0);
+	}
+	m_pFrameMemory = NULL;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence of the current
+ *  region after the draws that read it.
+ ***********************************************************/
+void RingBuffer::EndFrame()
+{
+	FinishWrites();
+
+	if (m_buffer != 0)
+	{
+		m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+/***********************************************************
+ *  GetBuffer()
+ *
+ *  This method is used for getting the buffer the offsets
+ *  returned by Allocate() are in.
+ ***********************************************************/
+GLuint RingBuffer::GetBuffer() const
+{
+	return(m_buffer);
+}
+
+/***********************************************************
+ *  GetWaitCount()
+ *
+ *  This method is used for getting the number of frames that
+ *  had to wait for OpenGL to release their region since the
+ *  last ResetWaitCount().
+ ***********************************************************/
+int RingBuffer::GetWaitCount() const
+{
+	return(m_waitCount);
+}
+
+/***********************************************************
+ *  ResetWaitCount()
+ *
+ *  This method is used for starting a new count of waits.
+ ***********************************************************/
+void RingBuffer::ResetWaitCount()
+{
+	m_waitCount = 0;
+}
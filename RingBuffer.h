@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.h
+// ============
+// persistently mapped buffer for the data written each frame
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RingBuffer
+ *
+ *  This class holds the data the CPU writes for each frame,
+ *  such as the per-instance values, in one buffer split into
+ *  FRAME_COUNT regions.  Each frame writes into the next
+ *  region while OpenGL may still be reading the regions of
+ *  the frames before it, and a fence placed after the draws
+ *  of a frame tells when its region can be written again.
+ *  The CPU only waits when it gets FRAME_COUNT frames ahead
+ *  of the GPU, and the driver never has to copy or rename the
+ *  buffer behind the application's back.
+ *
+ *  With buffer storage (OpenGL 4.4) the buffer is mapped once
+ *  with persistent, coherent mapping, so the writes need no
+ *  map or unmap call.  Otherwise the region of each frame is
+ *  mapped unsynchronized and unmapped by FinishWrites(), and
+ *  the fences still keep the regions apart.
+ ***********************************************************/
+class RingBuffer
+{
+public:
+	// constructor
+	RingBuffer();
+	// destructor
+	~RingBuffer();
+
+	// number of frames that can be in flight at once
+	static const int FRAME_COUNT = 3;
+
+private:
+	GLuint m_buffer;
+	// size of the region of each frame
+	GLsizeiptr m_regionSize;
+	// persistently mapped start of the buffer, or NULL when each
+	// region is mapped for its frame
+	unsigned char* m_pPersistentMemory;
+	// mapped start of the region of the current frame, NULL
+	// outside of a frame or when it could not be mapped
+	unsigned char* m_pFrameMemory;
+	// signalled when OpenGL has read the region of each frame
+	GLsync m_fences[FRAME_COUNT];
+	// region written by the current frame
+	int m_frame;
+	// next free byte in the region of the current frame
+	GLsizeiptr m_head;
+	// frames that had to wait for their region
+	int m_waitCount;
+
+	// create the buffer with regions of at least the passed in size
+	void CreateBuffer(GLsizeiptr regionSize);
+	// free the buffer and its fences
+	void DestroyBuffer();
+
+public:
+	// start writing the next frame, growing the regions to the
+	// passed in size when needed; this waits when OpenGL is
+	// still reading the region from FRAME_COUNT frames ago
+	void BeginFrame(GLsizeiptr frameSize);
+
+	// reserve bytes of the current frame, NULL is returned when
+	// they do not fit; the offset is from the start of the
+	// buffer, as the draws that read the data need it
+	void* Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+
+	// end the writes of the frame, before it is drawn from
+	void FinishWrites();
+
+	// fence the frame after the draws that read it
+	void EndFrame();
+
+	// get the buffer the frame data is drawn from
+	GLuint GetBuffer() const;
+
+	// get and reset the number of frames that waited for the GPU
+	int GetWaitCount() const;
+	void ResetWaitCount();
+};
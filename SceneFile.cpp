@@ -0,0 +1,355 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// memory mapped binary scene description
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	/***********************************************************
+	 *  IsArrayInFile()
+	 *
+	 *  Checks that an array of elements of the passed in size
+	 *  lies inside a file of the passed in size and is aligned
+	 *  for its 32-bit values.
+	 ***********************************************************/
+	bool IsArrayInFile(const SceneFile::FILE_ARRAY& array, size_t elementSize, size_t fileSize)
+	{
+		uint64_t end = (uint64_t)array.offset + (uint64_t)array.count * elementSize;
+
+		return(((array.offset % 4) == 0) && (end <= (uint64_t)fileSize));
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a scene file into memory.
+ *  The pages are read by the operating system as the arrays
+ *  are used.  False is returned, and nothing is kept open,
+ *  when the file could not be mapped or is not valid.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(
+		filename,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	LARGE_INTEGER fileSize;
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+	m_fileHandle = fileHandle;
+
+	if ((GetFileSizeEx(fileHandle, &fileSize) == FALSE) || (fileSize.QuadPart < (LONGLONG)sizeof(FILE_HEADER)))
+	{
+		std::cout << "Scene file is too small:" << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL != m_mappingHandle)
+	{
+		m_pData = (const uint8_t*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	int fileDescriptor = open(filename, O_RDONLY);
+	struct stat fileStatus;
+
+	if (fileDescriptor < 0)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	if ((fstat(fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size < (off_t)sizeof(FILE_HEADER)))
+	{
+		std::cout << "Scene file is too small:" << filename << std::endl;
+		close(fileDescriptor);
+		return(false);
+	}
+
+	// the mapping keeps the file open, so the descriptor can
+	// be closed right away
+	void* pMapping = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (pMapping != MAP_FAILED)
+	{
+		m_pData = (const uint8_t*)pMapping;
+		m_size = (size_t)fileStatus.st_size;
+		// the arrays are read from the start to the end
+		madvise(pMapping, m_size, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (NULL == m_pData)
+	{
+		std::cout << "Could not map scene file:" << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	if (Validate() == false)
+	{
+		std::cout << "Not a valid scene file:" << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the scene file.
+ ***********************************************************/
+void SceneFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_size);
+	}
+#endif
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used for checking whether a scene file is
+ *  mapped.
+ ***********************************************************/
+bool SceneFile::IsOpen() const
+{
+	return(NULL != m_pData);
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used for checking that the mapped file is
+ *  a scene file of this version, that every array lies inside
+ *  it and that every index and string offset refers to an
+ *  element that exists.  Parents must come before their
+ *  children, as the scene graph requires.  Afterwards the
+ *  arrays can be used without any further checks.
+ ***********************************************************/
+bool SceneFile::Validate() const
+{
+	const FILE_HEADER& header = GetHeader();
+
+	if ((header.magic != FILE_MAGIC) ||
+		(header.version != FILE_VERSION) ||
+		(header.fileSize != m_size) ||
+		(IsArrayInFile(header.textures, sizeof(FILE_TEXTURE), m_size) == false) ||
+		(IsArrayInFile(header.materials, sizeof(FILE_MATERIAL), m_size) == false) ||
+		(IsArrayInFile(header.nodes, sizeof(FILE_NODE), m_size) == false) ||
+		(IsArrayInFile(header.objects, sizeof(FILE_OBJECT), m_size) == false) ||
+		(IsArrayInFile(header.strings, 1, m_size) == false))
+	{
+		return(false);
+	}
+
+	// every string ends inside the table when its last byte
+	// is a terminator
+	uint32_t stringSize = header.strings.count;
+	const char* pStrings = (const char*)GetArray(header.strings);
+
+	if ((stringSize == 0) || (pStrings[stringSize - 1] != '\0'))
+	{
+		return(false);
+	}
+
+	const FILE_TEXTURE* pTextures = GetTextures();
+	for (uint32_t index = 0; index < header.textures.count; index++)
+	{
+		if ((pTextures[index].tag >= stringSize) || (pTextures[index].filename >= stringSize))
+		{
+			return(false);
+		}
+	}
+
+	const FILE_MATERIAL* pMaterials = GetMaterials();
+	for (uint32_t index = 0; index < header.materials.count; index++)
+	{
+		if (pMaterials[index].tag >= stringSize)
+		{
+			return(false);
+		}
+	}
+
+	const FILE_NODE* pNodes = GetNodes();
+	for (uint32_t index = 0; index < header.nodes.count; index++)
+	{
+		if ((pNodes[index].parent < -1) || (pNodes[index].parent >= (int32_t)index))
+		{
+			return(false);
+		}
+	}
+
+	const FILE_OBJECT* pObjects = GetObjects();
+	for (uint32_t index = 0; index < header.objects.count; index++)
+	{
+		const FILE_OBJECT& object = pObjects[index];
+
+		if ((object.node < 0) || (object.node >= (int32_t)header.nodes.count) ||
+			(object.mesh >= MESH_TYPE_COUNT) ||
+			(object.material < 0) || (object.material >= (int32_t)header.materials.count) ||
+			(object.texture < -1) || (object.texture >= (int32_t)header.textures.count))
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetArray()
+ *
+ *  This method is used for getting the start of an array of
+ *  the mapped file.
+ ***********************************************************/
+const void* SceneFile::GetArray(const FILE_ARRAY& array) const
+{
+	return(m_pData + array.offset);
+}
+
+/***********************************************************
+ *  GetHeader()
+ *
+ *  This method is used for getting the header of the open
+ *  scene file.
+ ***********************************************************/
+const SceneFile::FILE_HEADER& SceneFile::GetHeader() const
+{
+	return(*(const FILE_HEADER*)m_pData);
+}
+
+/***********************************************************
+ *  GetTextures()
+ *
+ *  This method is used for getting the textures of the open
+ *  scene file.
+ ***********************************************************/
+const SceneFile::FILE_TEXTURE* SceneFile::GetTextures() const
+{
+	return((const FILE_TEXTURE*)GetArray(GetHeader().textures));
+}
+
+/***********************************************************
+ *  GetMaterials()
+ *
+ *  This method is used for getting the materials of the open
+ *  scene file.
+ ***********************************************************/
+const SceneFile::FILE_MATERIAL* SceneFile::GetMaterials() const
+{
+	return((const FILE_MATERIAL*)GetArray(GetHeader().materials));
+}
+
+/***********************************************************
+ *  GetNodes()
+ *
+ *  This method is used for getting the transform nodes of
+ *  the open scene file.
+ ***********************************************************/
+const SceneFile::FILE_NODE* SceneFile::GetNodes() const
+{
+	return((const FILE_NODE*)GetArray(GetHeader().nodes));
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used for getting the objects of the open
+ *  scene file.
+ ***********************************************************/
+const SceneFile::FILE_OBJECT* SceneFile::GetObjects() const
+{
+	return((const FILE_OBJECT*)GetArray(GetHeader().objects));
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string of the string
+ *  table by its byte offset.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	return((const char*)GetArray(GetHeader().strings) + offset);
+}
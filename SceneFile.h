@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// memory mapped binary scene description
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class maps a binary scene file into memory and gives
+ *  access to its arrays in place.  The file is a header
+ *  followed by flat arrays of textures, materials, transform
+ *  nodes and objects, and a table of the null terminated tag
+ *  and file name strings they refer to.  Nothing is parsed or
+ *  copied when the file is opened; only the header and the
+ *  references between the arrays are checked, so loading a
+ *  scene costs about as much as paging the file in.
+ *
+ *  The values are stored in the byte order of the machine
+ *  that wrote the file, which is little endian on every
+ *  supported platform.  Files are written by the
+ *  SceneConverter tool from a text description.  The layout
+ *  is not shared with OpenGL, so this header only needs the
+ *  standard library and can be used by the tool.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// "SCN1" in file byte order, and the layout version that
+	// changes whenever one of the structures below changes
+	static const uint32_t FILE_MAGIC = 0x314E4353;
+	static const uint32_t FILE_VERSION = 1;
+
+	// mesh parts drawn for an object, as bits
+	enum PART_FLAG
+	{
+		PART_TOP = 1,
+		PART_BOTTOM = 2,
+		PART_SIDES = 4,
+		PART_ALL = 7
+	};
+
+	// position of one array in the file
+	struct FILE_ARRAY
+	{
+		// byte offset from the start of the file
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		// size of the whole file in bytes
+		uint32_t fileSize;
+		FILE_ARRAY textures;
+		FILE_ARRAY materials;
+		FILE_ARRAY nodes;
+		FILE_ARRAY objects;
+		// the string table, count is its size in bytes
+		FILE_ARRAY strings;
+	};
+
+	// strings are byte offsets into the string table
+	struct FILE_TEXTURE
+	{
+		uint32_t tag;
+		uint32_t filename;
+	};
+
+	struct FILE_MATERIAL
+	{
+		uint32_t tag;
+		float ambientStrength;
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+	};
+
+	// transform node, parents are stored before their children
+	struct FILE_NODE
+	{
+		// index of the parent node, -1 for a root node
+		int32_t parent;
+		float scaleXYZ[3];
+		// X, Y and Z rotation in degrees
+		float rotationXYZ[3];
+		float positionXYZ[3];
+	};
+
+	struct FILE_OBJECT
+	{
+		int32_t node;
+		// SceneManager::MESH_TYPE value
+		uint32_t mesh;
+		// index in the material array
+		int32_t material;
+		// index in the texture array, -1 for a solid color
+		int32_t texture;
+		float color[4];
+		// PART_FLAG bits
+		uint32_t parts;
+	};
+
+	// number of SceneManager::MESH_TYPE values
+	static const uint32_t MESH_TYPE_COUNT = 7;
+
+private:
+	// start and size of the mapped file
+	const uint8_t* m_pData;
+	size_t m_size;
+	// operating system handles of the mapped file
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	// check the header and the references between the arrays
+	bool Validate() const;
+	// get an array of the file by its position
+	const void* GetArray(const FILE_ARRAY& array) const;
+
+public:
+	// map a scene file into memory, false is returned when it
+	// could not be opened or is not a valid scene file
+	bool Open(const char* filename);
+	// unmap the file, the arrays must no longer be used
+	void Close();
+	bool IsOpen() const;
+
+	// get the header and the arrays of the open file
+	const FILE_HEADER& GetHeader() const;
+	const FILE_TEXTURE* GetTextures() const;
+	const FILE_MATERIAL* GetMaterials() const;
+	const FILE_NODE* GetNodes() const;
+	const FILE_OBJECT* GetObjects() const;
+	// get a string of the string table
+	const char* GetString(uint32_t offset) const;
+};
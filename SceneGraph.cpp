@@ -0,0 +1,278 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// retained transform hierarchy for the objects in the 3D scene
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_bAnyDirty = false;
+}
+
+/***********************************************************
+ *  ~SceneGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneGraph::~SceneGraph()
+{
+	m_nodes.clear();
+}
+
+/***********************************************************
+ *  SetTransformValues()
+ *
+ *  This method is used for storing the local transformation
+ *  values of a node in the transform arrays.
+ ***********************************************************/
+void SceneGraph::SetTransformValues(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_transforms.scaleX[node] = scaleXYZ.x;
+	m_transforms.scaleY[node] = scaleXYZ.y;
+	m_transforms.scaleZ[node] = scaleXYZ.z;
+	m_transforms.rotationX[node] = XrotationDegrees;
+	m_transforms.rotationY[node] = YrotationDegrees;
+	m_transforms.rotationZ[node] = ZrotationDegrees;
+	m_transforms.positionX[node] = positionXYZ.x;
+	m_transforms.positionY[node] = positionXYZ.y;
+	m_transforms.positionZ[node] = positionXYZ.z;
+}
+
+/***********************************************************
+ *  ComposeDirtyTransforms()
+ *
+ *  This method is used for building the local matrices of
+ *  the dirty nodes.  Nodes are usually added and moved in
+ *  groups, so each run of neighbouring dirty nodes is passed
+ *  to the batched kernel at once.
+ ***********************************************************/
+void SceneGraph::ComposeDirtyTransforms()
+{
+	int nodeCount = (int)m_nodes.size();
+	int index = 0;
+
+	while (index < nodeCount)
+	{
+		if (m_nodes[index].bDirty == false)
+		{
+			index++;
+			continue;
+		}
+
+		int first = index;
+		while ((index < nodeCount) && (m_nodes[index].bDirty == true))
+		{
+			index++;
+		}
+
+		TransformKernel::ComposeTransforms(
+			m_transforms,
+			first,
+			index - first,
+			m_localMatrices.data());
+	}
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a new transform node to
+ *  the scene graph.  The parent must already exist, or be
+ *  -1 for a root node.  The index of the new node is
+ *  returned, or -1 if the parent is not valid.
+ ***********************************************************/
+int SceneGraph::AddNode(
+	int parent,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// parents must be added before their children so that a
+	// single forward pass can update the whole hierarchy
+	if ((parent < -1) || (parent >= (int)m_nodes.size()))
+	{
+		return(-1);
+	}
+
+	SCENE_NODE node;
+	node.parent = parent;
+	node.worldMatrix = glm::mat4(1.0f);
+	node.bDirty = true;
+	node.bWorldChanged = false;
+
+	m_nodes.push_back(node);
+	m_localMatrices.push_back(glm::mat4(1.0f));
+
+	m_transforms.scaleX.push_back(1.0f);
+	m_transforms.scaleY.push_back(1.0f);
+	m_transforms.scaleZ.push_back(1.0f);
+	m_transforms.rotationX.push_back(0.0f);
+	m_transforms.rotationY.push_back(0.0f);
+	m_transforms.rotationZ.push_back(0.0f);
+	m_transforms.positionX.push_back(0.0f);
+	m_transforms.positionY.push_back(0.0f);
+	m_transforms.positionZ.push_back(0.0f);
+	SetTransformValues(
+		(int)m_nodes.size() - 1,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	m_bAnyDirty = true;
+
+	return((int)m_nodes.size() - 1);
+}
+
+/***********************************************************
+ *  SetNodeTransform()
+ *
+ *  This method is used for changing the local transformation
+ *  values of a node.  The node and all of its children will
+ *  be recalculated on the next update.
+ ***********************************************************/
+void SceneGraph::SetNodeTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((node < 0) || (node >= (int)m_nodes.size()))
+	{
+		return;
+	}
+
+	SetTransformValues(
+		node,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+	m_nodes[node].bDirty = true;
+	m_bAnyDirty = true;
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for recalculating the cached world
+ *  matrices.  A node is only recalculated when it is dirty
+ *  or when its parent was recalculated in the same pass.
+ *  The number of recalculated nodes is returned.
+ ***********************************************************/
+int SceneGraph::UpdateWorldMatrices()
+{
+	int updatedNodes = 0;
+
+	// nothing has changed since the last update, so all of
+	// the cached world matrices are still valid
+	if (m_bAnyDirty == false)
+	{
+		return(0);
+	}
+
+	ComposeDirtyTransforms();
+
+	for (size_t index = 0; index < m_nodes.size(); index++)
+	{
+		SCENE_NODE& node = m_nodes[index];
+		bool bParentChanged = false;
+
+		if (node.parent >= 0)
+		{
+			bParentChanged = m_nodes[node.parent].bWorldChanged;
+		}
+
+		node.bWorldChanged = false;
+
+		if ((node.bDirty == true) || (bParentChanged == true))
+		{
+			if (node.parent >= 0)
+			{
+				node.worldMatrix = m_nodes[node.parent].worldMatrix * m_localMatrices[index];
+			}
+			else
+			{
+				node.worldMatrix = m_localMatrices[index];
+			}
+
+			node.bDirty = false;
+			node.bWorldChanged = true;
+			updatedNodes++;
+		}
+	}
+
+	m_bAnyDirty = false;
+
+	return(updatedNodes);
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method is used for getting the cached world matrix
+ *  of the passed in node.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldMatrix(int node) const
+{
+	return(m_nodes[node].worldMatrix);
+}
+
+/***********************************************************
+ *  IsWorldChanged()
+ *
+ *  This method is used for checking whether the world matrix
+ *  of the passed in node was recalculated by the last update
+ *  that had dirty nodes.
+ ***********************************************************/
+bool SceneGraph::IsWorldChanged(int node) const
+{
+	return(m_nodes[node].bWorldChanged);
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the total number of
+ *  retained nodes in the scene graph.
+ ***********************************************************/
+int SceneGraph::GetNodeCount() const
+{
+	return((int)m_nodes.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the retained
+ *  nodes from the scene graph.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_nodes.clear();
+	m_localMatrices.clear();
+	m_transforms = TransformKernel::TRANSFORM_ARRAYS();
+	m_bAnyDirty = false;
+}
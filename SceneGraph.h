@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// retained transform hierarchy for the objects in the 3D scene
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TransformKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class contains the retained transform nodes for the
+ *  3D scene.  The world matrix for every node is cached and
+ *  only recalculated when the node, or one of its parents,
+ *  has been marked as dirty.  The local transformation
+ *  values are stored as arrays so that runs of dirty nodes
+ *  are composed by the batched transform kernel.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+	// destructor
+	~SceneGraph();
+
+	struct SCENE_NODE
+	{
+		// index of the parent node, -1 for a root node
+		int parent;
+		// cached world transformation matrix
+		glm::mat4 worldMatrix;
+		// local values changed since the last update
+		bool bDirty;
+		// world matrix was recalculated in the last update
+		bool bWorldChanged;
+	};
+
+private:
+	// retained nodes - parents are always stored before children
+	std::vector<SCENE_NODE> m_nodes;
+	// local transformation values and matrices, by node index
+	TransformKernel::TRANSFORM_ARRAYS m_transforms;
+	std::vector<glm::mat4> m_localMatrices;
+	// at least one node needs to be recalculated
+	bool m_bAnyDirty;
+
+	// store the local transformation values of a node
+	void SetTransformValues(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// compose the local matrices of every dirty node
+	void ComposeDirtyTransforms();
+
+public:
+	// add a new transform node under the passed in parent
+	int AddNode(
+		int parent,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// change the local transformation values of a node
+	void SetNodeTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// recalculate the world matrices of all dirty nodes
+	int UpdateWorldMatrices();
+
+	// get the cached world matrix of a node
+	const glm::mat4& GetWorldMatrix(int node) const;
+
+	// check whether the world matrix of a node was recalculated
+	// in the last update that found dirty nodes
+	bool IsWorldChanged(int node) const;
+
+	// get the total number of retained nodes
+	int GetNodeCount() const;
+
+	// remove all of the retained nodes
+	void Clear();
+};
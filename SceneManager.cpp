@@ -8,6 +8,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "FrameArena.h"
+#include "ResourcePaths.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,15 +17,135 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdio>
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_MaterialBlockName = "MaterialBlock";
+	const char* g_LightBlockName = "LightBlock";
+
+	// uniform buffer binding points and array sizes, these
+	// must match the values in the fragment shader
+	const GLuint MATERIAL_BLOCK_BINDING = 0;
+	const GLuint LIGHT_BLOCK_BINDING = 1;
+	const int MAX_MATERIALS = 256;
+	const int MAX_LIGHTS = 16;
+
+	// scene files store the mesh of an object as a MESH_TYPE
+	static_assert(SceneManager::MESH_BOX + 1 == SceneFile::MESH_TYPE_COUNT, "the scene file mesh types must match MESH_TYPE");
+
+	// names of the meshes as they are written in scene files,
+	// by MESH_TYPE
+	const char* MESH_NAMES[] = { "plane", "sphere", "half_sphere", "cylinder", "tapered_cylinder", "torus", "box" };
+	static_assert(sizeof(MESH_NAMES) / sizeof(MESH_NAMES[0]) == SceneFile::MESH_TYPE_COUNT, "every MESH_TYPE must have a name");
+
+	// texture unit of the shadow maps, the first past the
+	// units of the texture arrays
+	const GLuint SHADOW_TEXTURE_UNIT = TextureArrays::MAX_GROUPS;
+
+	// first of the texture units holding the point light
+	// buffers, just past the shadow maps
+	const GLuint CLUSTER_TEXTURE_UNIT = SHADOW_TEXTURE_UNIT + 1;
+
+	// a fragment shader is only sure of 16 texture units
+	static_assert(TextureArrays::MAX_GROUPS + 1 + ClusteredLighting::TEXTURE_COUNT <= 16, "the texture arrays and lighting textures must fit in 16 texture units");
+
+	// generated shape meshes, rebuilt when the file is missing
+	// or out of date; each vertex layout has its own file so
+	// that switching layouts does not rebuild them every time
+	const char* MESH_CACHE_FILE = "../MeshCache/primitives.mesh";
+	const char* COMPACT_MESH_CACHE_FILE = "../MeshCache/primitives_compact.mesh";
+
+	// point lights in the demo strip of shelf lights
+	const int DEMO_POINT_LIGHT_COUNT = 64;
+
+	// decoded images uploaded to OpenGL in one frame
+	const int MAX_TEXTURE_UPLOADS_PER_FRAME = 2;
+
+	// items handled by each job when the draw list is built in
+	// parallel, the object chunk must be a multiple of 32 so
+	// that chunks never share a word of the visibility bits
+	const int OBJECT_CHUNK_SIZE = 256;
+	const int INSTANCE_CHUNK_SIZE = 512;
+
+	// fraction of the view height below which each coarser
+	// level of detail is drawn, and the margin an object has
+	// to cross a boundary by before it changes level again
+	const float LOD_SCREEN_SIZES[PrimitiveMeshes::LOD_COUNT - 1] = { 0.25f, 0.08f };
+	const float LOD_HYSTERESIS = 0.1f;
+	// frames taken to cross-fade between two levels
+	const int LOD_FADE_FRAMES = 16;
+
+	// std140 layout of one material in the material block
+	struct MATERIAL_BLOCK_ENTRY
+	{
+		glm::vec4 ambientColor;      // rgb = color, a = strength
+		glm::vec4 diffuseColor;      // rgb = color
+		glm::vec4 specularColor;     // rgb = color, a = shininess
+	};
+
+	// std140 layout of one light in the light block
+	struct LIGHT_BLOCK_ENTRY
+	{
+		glm::vec4 position;          // xyz = position
+		glm::vec4 ambientColor;      // rgb = color
+		glm::vec4 diffuseColor;      // rgb = color
+		glm::vec4 specularColor;     // rgb = color
+		glm::vec4 parameters;        // x = focal strength, y = specular intensity
+	};
+
+	/***********************************************************
+	 *  BindUniformBlock()
+	 *
+	 *  Connects a named uniform block in the active shader
+	 *  program to the passed in binding point.
+	 ***********************************************************/
+	void BindUniformBlock(const char* blockName, GLuint bindingPoint)
+	{
+		GLint programID = 0;
+		GLuint blockIndex = GL_INVALID_INDEX;
+
+		glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+		if (programID == 0)
+		{
+			return;
+		}
+
+		blockIndex = glGetUniformBlockIndex((GLuint)programID, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding((GLuint)programID, blockIndex, bindingPoint);
+		}
+	}
+
+	/***********************************************************
+	 *  CompareDrawCommands()
+	 *
+	 *  Orders draw commands by render state, then from front to
+	 *  back so that the nearest instances of a batch fill the
+	 *  depth buffer first, then by object so that the instance
+	 *  order is the same every frame for the same view.
+	 ***********************************************************/
+	bool CompareDrawCommands(
+		const SceneManager::DRAW_COMMAND& first,
+		const SceneManager::DRAW_COMMAND& second)
+	{
+		if (first.sortKey != second.sortKey)
+		{
+			return(first.sortKey < second.sortKey);
+		}
+		if (first.depth != second.depth)
+		{
+			return(first.depth < second.depth);
+		}
+		return(first.object < second.object);
+	}
 }
 
 /***********************************************************
@@ -34,7 +156,52 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_basicMeshes = new PrimitiveMeshes();
+	m_pSceneGraph = new SceneGraph();
+	m_pUniformCache = new UniformCache(pShaderManager);
+	m_pTextureLoader = new TextureLoader();
+	m_pTextureArrays = new TextureArrays();
+	m_pProfiler = NULL;
+	m_pJobSystem = NULL;
+	m_pShaderCache = NULL;
+	for (int variant = 0; variant < VARIANT_COUNT; variant++)
+	{
+		m_variantHandles[variant] = -1;
+		m_variantPrograms[variant] = 0;
+	}
+	m_baseProgram = 0;
+	m_activeProgram = 0;
+	m_programSwitches = 0;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_pIndirectRenderer = new IndirectRenderer();
+	m_pClusteredLighting = new ClusteredLighting();
+	m_pSceneFile = new SceneFile();
+	m_pFrameData = new RingBuffer();
+	m_pFrameInstances = NULL;
+	m_frameInstanceOffset = 0;
+	m_bIndirectDirty = true;
+	m_bCullingEnabled = true;
+	m_bBoundsDirty = true;
+	m_culledObjects = 0;
+	m_bDepthPrepassEnabled = true;
+	m_bCompactVertices = false;
+	m_bDemoPointLights = false;
+	m_pOcclusionCuller = new OcclusionCuller();
+	m_bOcclusionCullingEnabled = true;
+	m_occludedObjects = 0;
+	m_pShadowMaps = new ShadowMaps();
+	m_pBvh = new BoundingVolumeHierarchy();
+	m_clipRowW = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	m_projectionScale = 1.0f;
+	m_bLodEnabled = true;
+	m_bLodFadeEnabled = true;
+	m_bSceneChanged = true;
+	m_materialBuffer = 0;
+	m_lightBuffer = 0;
+
+	// a single view until the first frame sets the camera
+	SetViewProjection(glm::mat4(1.0f), glm::mat4(1.0f));
 }
 
 /***********************************************************
@@ -45,100 +212,155 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pProfiler = NULL;
+	m_pJobSystem = NULL;
+	m_pShaderCache = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_pSceneGraph;
+	m_pSceneGraph = NULL;
+	delete m_pUniformCache;
+	m_pUniformCache = NULL;
+	delete m_pIndirectRenderer;
+	m_pIndirectRenderer = NULL;
+	delete m_pClusteredLighting;
+	m_pClusteredLighting = NULL;
+	delete m_pSceneFile;
+	m_pSceneFile = NULL;
+	delete m_pFrameData;
+	m_pFrameData = NULL;
+	delete m_pOcclusionCuller;
+	m_pOcclusionCuller = NULL;
+	delete m_pShadowMaps;
+	m_pShadowMaps = NULL;
+	delete m_pBvh;
+	m_pBvh = NULL;
+	m_pFrameInstances = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	DestroyGLTextures();
+	delete m_pTextureArrays;
+	m_pTextureArrays = NULL;
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	for (int variant = 0; variant < VARIANT_COUNT; variant++)
+	{
+		if (m_variantPrograms[variant] != 0)
+		{
+			glDeleteProgram(m_variantPrograms[variant]);
+			m_variantPrograms[variant] = 0;
+		}
+	}
+	m_sceneObjects.clear();
+	m_drawList.clear();
+	m_instances.clear();
+	m_batches.clear();
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for registering a texture for an
+ *  image file in the next available texture slot in memory.
+ *  Only the image header is read here, to reserve a layer in
+ *  the texture array for images of the same size and format.
+ *  The image is decoded on a worker thread once the arrays
+ *  have been allocated by AllocateGLTextures().  The file is
+ *  found from the resource base directory.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
 {
-	int width = 0;
-	int height = 0;
+	TEXTURE_INFO texture;
 	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
+	std::string imagePath = ResourcePaths::Resolve(filename);
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	if (m_pTextureLoader->ReadImageInfo(imagePath.c_str(), texture.width, texture.height, colorChannels) == false)
+	{
+		std::cout << "Could not load image:" << imagePath << std::endl;
+		return false;
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	GLenum internalFormat = m_pTextureLoader->GetInternalFormat(colorChannels);
+	if (internalFormat == 0)
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		return false;
+	}
 
-		return true;
+	if (m_pTextureArrays->ReserveLayer(
+		texture.width,
+		texture.height,
+		colorChannels,
+		internalFormat,
+		texture.group,
+		texture.layer) == false)
+	{
+		return false;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the texture and associate it with the special tag string
+	texture.ID = 0;
+	texture.tag = tag;
+	texture.filename = imagePath;
+	m_textureSlots[tag] = (int)m_textureIDs.size();
+	m_textureIDs.push_back(texture);
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
- *  BindGLTextures()
+ *  AllocateGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for allocating the texture arrays for
+ *  the registered textures and queueing each image to be
+ *  decoded into its layer.  The layers show a placeholder
+ *  gray until their images have been uploaded.
  ***********************************************************/
-void SceneManager::BindGLTextures()
+void SceneManager::AllocateGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	m_pTextureArrays->AllocateStorage();
+
+	for (size_t index = 0; index < m_textureIDs.size(); index++)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		TEXTURE_INFO& texture = m_textureIDs[index];
+
+		if (texture.ID != 0)
+		{
+			continue;
+		}
+
+		// decode the image in the background
+		texture.ID = m_pTextureArrays->GetTextureID(texture.group);
+		m_pTextureLoader->QueueTexture(
+			texture.filename.c_str(),
+			texture.ID,
+			texture.layer,
+			texture.width,
+			texture.height);
 	}
 }
 
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for binding the texture arrays to
+ *  OpenGL texture memory slots.  Each array holds every
+ *  texture of one size and format, so the number of loaded
+ *  textures is not limited by the number of slots.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	m_pTextureArrays->BindArrays();
+}
+
 /***********************************************************
  *  DestroyGLTextures()
  *
@@ -147,10 +369,12 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (NULL != m_pTextureArrays)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_pTextureArrays->Destroy();
 	}
+	m_textureIDs.clear();
+	m_textureSlots.clear();
 }
 
 /***********************************************************
@@ -159,21 +383,14 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const std::string& tag)
 {
 	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	int textureSlot = FindTextureSlot(tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (textureSlot >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		textureID = m_textureIDs[textureSlot].ID;
 	}
 
 	return(textureID);
@@ -183,184 +400,395 @@ int SceneManager::FindTextureID(std::string tag)
  *  FindTextureSlot()
  *
  *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  loaded texture bitmap associated with the passed in tag.  The
+ *  slot is used as the texture handle for drawing.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(const std::string& tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
+	std::unordered_map<std::string, int>::const_iterator found;
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	found = m_textureSlots.find(tag);
+	if (found == m_textureSlots.end())
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureSlot);
+	return(found->second);
+}
+
+/***********************************************************
+ *  AddMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials list.  The handle of the new material is returned.
+ ***********************************************************/
+int SceneManager::AddMaterial(const OBJECT_MATERIAL& material)
+{
+	int handle = (int)m_objectMaterials.shininess.size();
+
+	m_objectMaterials.ambientStrength.push_back(material.ambientStrength);
+	m_objectMaterials.ambientColor.push_back(material.ambientColor);
+	m_objectMaterials.diffuseColor.push_back(material.diffuseColor);
+	m_objectMaterials.specularColor.push_back(material.specularColor);
+	m_objectMaterials.shininess.push_back(material.shininess);
+	m_materialHandles[material.tag] = handle;
+
+	return(handle);
 }
 
 /***********************************************************
  *  FindMaterial()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for getting the handle of a material from
+ *  the previously defined materials list that is associated with
+ *  the passed in tag.  -1 is returned if there is no material.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+int SceneManager::FindMaterial(const std::string& tag)
 {
-	if (m_objectMaterials.size() == 0)
+	std::unordered_map<std::string, int>::const_iterator found;
+
+	found = m_materialHandles.find(tag);
+	if (found == m_materialHandles.end())
 	{
-		return(false);
+		return(-1);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	return(found->second);
+}
+
+/***********************************************************
+ *  AddLightSource()
+ *
+ *  This method is used for adding a light source to the defined
+ *  lights list.  The index of the new light is returned, or -1
+ *  if the light block is already full.
+ ***********************************************************/
+int SceneManager::AddLightSource(const LIGHT_SOURCE& light)
+{
+	if ((int)m_lightSources.size() >= MAX_LIGHTS)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		std::cout << "Light source not added, the limit is " << MAX_LIGHTS << std::endl;
+		return(-1);
 	}
 
-	return(true);
+	m_lightSources.push_back(light);
+
+	return((int)m_lightSources.size() - 1);
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light to the
+ *  clustered lights.  There is no fixed limit, since each
+ *  fragment only adds up the lights that reach its cluster.
+ *  The index of the new light is returned.
+ ***********************************************************/
+int SceneManager::AddPointLight(const ClusteredLighting::POINT_LIGHT& light)
+{
+	m_pointLights.push_back(light);
+
+	return((int)m_pointLights.size() - 1);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  UploadMaterialBuffer()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for copying all of the defined materials
+ *  into the material uniform buffer.  Draws then only need to
+ *  select a material by its handle.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+void SceneManager::UploadMaterialBuffer()
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	std::vector<MATERIAL_BLOCK_ENTRY> entries(MAX_MATERIALS);
+	int materialCount = (int)m_objectMaterials.shininess.size();
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+	if (materialCount > MAX_MATERIALS)
+	{
+		std::cout << "Only the first " << MAX_MATERIALS << " materials are used, objects with later materials use the first" << std::endl;
+		materialCount = MAX_MATERIALS;
+	}
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	for (int index = 0; index < materialCount; index++)
+	{
+		entries[index].ambientColor = glm::vec4(
+			m_objectMaterials.ambientColor[index],
+			m_objectMaterials.ambientStrength[index]);
+		entries[index].diffuseColor = glm::vec4(
+			m_objectMaterials.diffuseColor[index],
+			0.0f);
+		entries[index].specularColor = glm::vec4(
+			m_objectMaterials.specularColor[index],
+			m_objectMaterials.shininess[index]);
+	}
 
-	if (NULL != m_pShaderManager)
+	if (m_materialBuffer == 0)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		glGenBuffers(1, &m_materialBuffer);
 	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, entries.size() * sizeof(MATERIAL_BLOCK_ENTRY), entries.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBuffer);
+	BindUniformBlock(g_MaterialBlockName, MATERIAL_BLOCK_BINDING);
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  UploadLightBuffer()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for copying all of the defined light
+ *  sources and the light count into the light uniform buffer.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::UploadLightBuffer()
 {
-	// variables for this method
-	glm::vec4 currentColor;
+	std::vector<LIGHT_BLOCK_ENTRY> entries(MAX_LIGHTS);
+	glm::ivec4 lightCount((int)m_lightSources.size(), 0, 0, 0);
+
+	for (size_t index = 0; index < m_lightSources.size(); index++)
+	{
+		entries[index].position = glm::vec4(m_lightSources[index].position, 1.0f);
+		entries[index].ambientColor = glm::vec4(m_lightSources[index].ambientColor, 0.0f);
+		entries[index].diffuseColor = glm::vec4(m_lightSources[index].diffuseColor, 0.0f);
+		entries[index].specularColor = glm::vec4(m_lightSources[index].specularColor, 0.0f);
+		entries[index].parameters = glm::vec4(
+			m_lightSources[index].focalStrength,
+			m_lightSources[index].specularIntensity,
+			0.0f,
+			0.0f);
+	}
 
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	GLsizeiptr lightArraySize = entries.size() * sizeof(LIGHT_BLOCK_ENTRY);
 
-	if (NULL != m_pShaderManager)
+	if (m_lightBuffer == 0)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		glGenBuffers(1, &m_lightBuffer);
 	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, lightArraySize + sizeof(glm::ivec4), NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, lightArraySize, entries.data());
+	glBufferSubData(GL_UNIFORM_BUFFER, lightArraySize, sizeof(glm::ivec4), &lightCount);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_lightBuffer);
+	BindUniformBlock(g_LightBlockName, LIGHT_BLOCK_BINDING);
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for setting the texture array bound
+ *  for the passed in group into the shader.  Whether an
+ *  instance uses a texture and which layer it samples are
+ *  part of its instance data.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	int textureGroup)
+{
+	m_pUniformCache->setSampler2DValue(g_TextureValueName, textureGroup);
+}
+
+/***********************************************************
+ *  RequestShaderVariants()
+ *
+ *  This method is used for requesting the fragment shader
+ *  variants from the shader cache.  Each variant is built
+ *  with defines that pick the solid color or the texture
+ *  path and the number of lights at compile time, so it has
+ *  no run time branches and a light loop the compiler can
+ *  unroll.  The lights must already be defined.
+ ***********************************************************/
+void SceneManager::RequestShaderVariants()
 {
-	if (NULL != m_pShaderManager)
+	int lightCount = std::min((int)m_lightSources.size(), MAX_LIGHTS);
+	std::string lightDefine = "#define LIGHT_COUNT " + std::to_string(lightCount) + "\n";
+
+	m_baseProgram = m_pShaderManager->m_programID;
+	m_activeProgram = m_baseProgram;
+
+	if (NULL == m_pShaderCache)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		return;
+	}
+
+	std::string vertexShaderPath = ResourcePaths::Resolve("shaders/vertexShader.glsl");
+	std::string fragmentShaderPath = ResourcePaths::Resolve("shaders/fragmentShader.glsl");
+
+	m_variantHandles[VARIANT_COLOR] = m_pShaderCache->RequestProgram(
+		vertexShaderPath.c_str(),
+		fragmentShaderPath.c_str(),
+		"#define TEXTURE_MODE 0\n" + lightDefine);
+	m_variantHandles[VARIANT_TEXTURED] = m_pShaderCache->RequestProgram(
+		vertexShaderPath.c_str(),
+		fragmentShaderPath.c_str(),
+		"#define TEXTURE_MODE 1\n" + lightDefine);
+	m_variantHandles[VARIANT_DEPTH] = m_pShaderCache->RequestProgram(
+		vertexShaderPath.c_str(),
+		fragmentShaderPath.c_str(),
+		"#define DEPTH_ONLY 1\n");
+}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for binding a shader program through
+ *  the shader manager, so that the uniforms set afterwards
+ *  go to that program.
+ ***********************************************************/
+void SceneManager::UseProgram(GLuint program)
+{
+	if ((program == 0) || (program == m_activeProgram))
+	{
+		return;
 	}
+
+	m_activeProgram = program;
+	m_pShaderManager->m_programID = program;
+	m_pShaderManager->use();
+	m_programSwitches++;
+
+	// the cached uniform values belong to the last program
+	m_pUniformCache->Invalidate();
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  UseShaderVariant()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for binding a shader variant, such as
+ *  the one that matches a batch.  A variant that the shader
+ *  cache has just finished is connected to the uniform
+ *  blocks first, and the camera uniforms are set on a
+ *  variant each time it is bound.  The base program is used
+ *  until the variant is ready.  The batches are sorted with
+ *  the texture flag in the highest bits of the key, so a
+ *  frame only switches between the two variants once.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+bool SceneManager::UseShaderVariant(SHADER_VARIANT variant)
 {
-	if (NULL != m_pShaderManager)
+	bool bFinished = false;
+
+	if ((m_variantPrograms[variant] == 0) &&
+		(NULL != m_pShaderCache) &&
+		(m_pShaderCache->IsProgramReady(m_variantHandles[variant]) == true))
+	{
+		m_variantPrograms[variant] = m_pShaderCache->GetProgram(m_variantHandles[variant]);
+		m_variantHandles[variant] = -1;
+		bFinished = true;
+	}
+
+	if (m_variantPrograms[variant] == 0)
+	{
+		UseProgram(m_baseProgram);
+		return(false);
+	}
+
+	if (m_variantPrograms[variant] == m_activeProgram)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		return(true);
 	}
+
+	UseProgram(m_variantPrograms[variant]);
+	if (bFinished == true)
+	{
+		BindUniformBlock(g_MaterialBlockName, MATERIAL_BLOCK_BINDING);
+		BindUniformBlock(g_LightBlockName, LIGHT_BLOCK_BINDING);
+	}
+
+	SetCameraUniforms();
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetCameraUniforms()
+ *
+ *  This method is used for setting the camera of the view
+ *  being drawn into the bound program, with the light
+ *  clusters of that view and the shadow maps.
+ ***********************************************************/
+void SceneManager::SetCameraUniforms()
+{
+	m_pShaderManager->setMat4Value("view", m_viewMatrix);
+	m_pShaderManager->setMat4Value("projection", m_projectionMatrix);
+	m_pShaderManager->setVec3Value("viewPosition", glm::vec3(glm::inverse(m_viewMatrix)[3]));
+	SetClusterUniforms();
+	SetShadowUniforms();
+}
+
+/***********************************************************
+ *  SetClusterUniforms()
+ *
+ *  This method is used for setting the point light buffers
+ *  and the cluster grid of the frame into the bound program.
+ *  The buffer samplers are always given their own units,
+ *  since samplers of different types must not share one.
+ ***********************************************************/
+void SceneManager::SetClusterUniforms()
+{
+	const ClusteredLighting::CLUSTER_VIEW& clusterView = m_pClusteredLighting->GetClusterView();
+
+	m_pShaderManager->setIntValue("pointLights", CLUSTER_TEXTURE_UNIT + ClusteredLighting::TEXTURE_LIGHTS);
+	m_pShaderManager->setIntValue("clusterLightCounts", CLUSTER_TEXTURE_UNIT + ClusteredLighting::TEXTURE_COUNTS);
+	m_pShaderManager->setIntValue("clusterLightIndices", CLUSTER_TEXTURE_UNIT + ClusteredLighting::TEXTURE_INDICES);
+	m_pShaderManager->setVec3Value("clusterCounts", clusterView.clusterCounts);
+	m_pShaderManager->setVec2Value("clusterTileScale", clusterView.tileScale);
+	m_pShaderManager->setVec2Value("clusterViewportOrigin", clusterView.viewportOrigin);
+	m_pShaderManager->setVec2Value("clusterDepthScaleBias", clusterView.depthScaleBias);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  SetShadowUniforms()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the shadow maps of the
+ *  lights into the bound program.  The sampler is always
+ *  given its unit, for the same reason as the point light
+ *  buffers, even when no light has a shadow map.  The face
+ *  matrices are looked up once per program and only
+ *  uploaded again after the lights have changed.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::SetShadowUniforms()
 {
-	if (m_objectMaterials.size() > 0)
+	int lightCount = m_pShadowMaps->GetLightCount();
+
+	m_pUniformCache->setIntValue("shadowMaps", SHADOW_TEXTURE_UNIT);
+	m_pUniformCache->setIntValue("shadowLightCount", lightCount);
+	if (lightCount == 0)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		return;
+	}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
+	std::unordered_map<GLuint, SHADOW_UNIFORMS>::iterator found = m_shadowUniforms.find(m_activeProgram);
+	if (found == m_shadowUniforms.end())
+	{
+		SHADOW_UNIFORMS uniforms;
+		uniforms.matricesLocation = glGetUniformLocation(m_activeProgram, "shadowMatrices");
+		uniforms.matrixVersion = m_pShadowMaps->GetMatrixVersion() - 1;
+		found = m_shadowUniforms.insert(std::make_pair(m_activeProgram, uniforms)).first;
+	}
+
+	if ((found->second.matricesLocation >= 0) &&
+		(found->second.matrixVersion != m_pShadowMaps->GetMatrixVersion()))
+	{
+		glUniformMatrix4fv(
+			found->second.matricesLocation,
+			lightCount * ShadowMaps::FACE_COUNT,
+			GL_FALSE,
+			glm::value_ptr(m_pShadowMaps->GetShadowMatrices()[0]));
+		found->second.matrixVersion = m_pShadowMaps->GetMatrixVersion();
+	}
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values into the shader.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->setVec2Value("UVscale", glm::vec2(u, v));
 	}
 }
 
@@ -374,12 +802,15 @@ void SceneManager::SetShaderMaterial(
 void SceneManager::LoadSceneTextures()
 {
 	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
+	/*** will be used for mapping to objects in the 3D scene. Refer  ***/
+	/*** to the code in the OpenGL Sample for help.                  ***/
 
 	bool bReturn = false;
 
+	// keep compressed copies of the textures next to the source
+	// images so that later runs skip decoding them
+	m_pTextureLoader->SetCacheDirectory(ResourcePaths::Resolve("../TextureCache").c_str());
+
 	// load countertop texture
 	bReturn = CreateGLTexture(
 		"../Textures/granite_counter.jpg",
@@ -420,101 +851,1387 @@ void SceneManager::LoadSceneTextures()
 		"../Textures/combat_patrol.png",
 		"craft_top");
 
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
+	// register the textures of the scene file with the others
+	AddSceneFileTextures();
+
+	// the texture arrays are allocated and bound right away -
+	// the decoded images replace the placeholder layers in
+	// place, so the arrays never need rebinding
+	AllocateGLTextures();
 	BindGLTextures();
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
+/***********************************************************
+ *  AddTexturedObject()
+ *
+ *  This method is used for adding an object that is drawn
+ *  with a texture to the retained scene.  The texture and
+ *  material tags are resolved to handles here, so drawing
+ *  the object never needs to search by tag.
+ ***********************************************************/
+void SceneManager::AddTexturedObject(
+	int node,
+	MESH_TYPE mesh,
+	const std::string& textureTag,
+	const std::string& materialTag,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	AddSceneObject(
+		node,
+		mesh,
+		FindTextureSlot(textureTag),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		FindMaterial(materialTag),
+		bDrawTop,
+		bDrawBottom,
+		bDrawSides);
+}
 
-/**************************************************************
-* Sets the necessary transformations, applies textures, colors
-* and materials, then draws the primatives for the lemon.
-***************************************************************/
-void SceneManager::DrawLemon() 
+/***********************************************************
+ *  AddColoredObject()
+ *
+ *  This method is used for adding an object that is drawn
+ *  with a solid color to the retained scene.
+ ***********************************************************/
+void SceneManager::AddColoredObject(
+	int node,
+	MESH_TYPE mesh,
+	glm::vec4 color,
+	const std::string& materialTag,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	AddSceneObject(
+		node,
+		mesh,
+		-1,
+		color,
+		FindMaterial(materialTag),
+		bDrawTop,
+		bDrawBottom,
+		bDrawSides);
+}
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object to the retained
+ *  scene by texture slot and material handle.  An object
+ *  without a texture slot, or whose texture did not load, is
+ *  drawn with the passed in color.
+ ***********************************************************/
+void SceneManager::AddSceneObject(
+	int node,
+	MESH_TYPE mesh,
+	int textureSlot,
+	glm::vec4 color,
+	int material,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	SCENE_OBJECT object;
+
+	object.node = node;
+	object.mesh = mesh;
+	SetObjectParts(object, bDrawTop, bDrawBottom, bDrawSides);
+	object.textureSlot = textureSlot;
+	object.bUseTexture = (object.textureSlot >= 0);
+	object.color = color;
+	object.material = material;
+	object.sortKey = BuildSortKey(object);
+	SetObjectBounds(object);
+	object.lod = 0;
+	object.fadeLod = -1;
+	object.fadeFrame = 0;
+
+	m_sceneObjects.push_back(object);
+	m_bBoundsDirty = true;
+}
 
-	// draw the body of the lemon
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.3f, 1.3f, 1.3f);
+/***********************************************************
+ *  AddSceneFileTextures()
+ *
+ *  This method is used for registering the textures of the
+ *  scene file.  A texture whose tag is already registered is
+ *  shared instead of being loaded again.
+ ***********************************************************/
+void SceneManager::AddSceneFileTextures()
+{
+	if (m_pSceneFile->IsOpen() == false)
+	{
+		return;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	const SceneFile::FILE_TEXTURE* pTextures = m_pSceneFile->GetTextures();
+	uint32_t textureCount = m_pSceneFile->GetHeader().textures.count;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.3f, 1.3f, 5.0f);
+	for (uint32_t index = 0; index < textureCount; index++)
+	{
+		const char* tag = m_pSceneFile->GetString(pTextures[index].tag);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		if (FindTextureSlot(tag) < 0)
+		{
+			CreateGLTexture(m_pSceneFile->GetString(pTextures[index].filename), tag);
+		}
+	}
+}
 
-	// change the color to yellow
-	// SetShaderColor(0.996078, 0.827451, 0.035294, 1);
+/***********************************************************
+ *  AddSceneFileMaterials()
+ *
+ *  This method is used for adding the materials of the scene
+ *  file to the defined materials.
+ ***********************************************************/
+void SceneManager::AddSceneFileMaterials()
+{
+	if (m_pSceneFile->IsOpen() == false)
+	{
+		return;
+	}
 
-	// change the lemon skin texture to orange
-	SetShaderTexture("lemon_skin");
+	const SceneFile::FILE_MATERIAL* pMaterials = m_pSceneFile->GetMaterials();
+	uint32_t materialCount = m_pSceneFile->GetHeader().materials.count;
 
-	// change the material to wood to mimic lemon skin
-	SetShaderMaterial("wood");
+	for (uint32_t index = 0; index < materialCount; index++)
+	{
+		const SceneFile::FILE_MATERIAL& fileMaterial = pMaterials[index];
+		OBJECT_MATERIAL material;
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+		material.ambientStrength = fileMaterial.ambientStrength;
+		material.ambientColor = glm::vec3(fileMaterial.ambientColor[0], fileMaterial.ambientColor[1], fileMaterial.ambientColor[2]);
+		material.diffuseColor = glm::vec3(fileMaterial.diffuseColor[0], fileMaterial.diffuseColor[1], fileMaterial.diffuseColor[2]);
+		material.specularColor = glm::vec3(fileMaterial.specularColor[0], fileMaterial.specularColor[1], fileMaterial.specularColor[2]);
+		material.shininess = fileMaterial.shininess;
+		material.tag = m_pSceneFile->GetString(fileMaterial.tag);
+		AddMaterial(material);
+	}
+}
 
-	// draw the bottom part of the stem
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 0.2f, 0.2f);
+/***********************************************************
+ *  BuildSceneFileObjects()
+ *
+ *  This method is used for building the retained scene from
+ *  the arrays of the mapped scene file.  The tags of the file
+ *  textures and materials are resolved once, so adding each
+ *  object is a straight copy of its values.  The file has
+ *  been validated when it was opened, so every index can be
+ *  used as it is.
+ ***********************************************************/
+void SceneManager::BuildSceneFileObjects()
+{
+	const SceneFile::FILE_HEADER& header = m_pSceneFile->GetHeader();
+	const SceneFile::FILE_TEXTURE* pTextures = m_pSceneFile->GetTextures();
+	const SceneFile::FILE_MATERIAL* pMaterials = m_pSceneFile->GetMaterials();
+	const SceneFile::FILE_NODE* pNodes = m_pSceneFile->GetNodes();
+	const SceneFile::FILE_OBJECT* pObjects = m_pSceneFile->GetObjects();
+	std::vector<int> textureSlots(header.textures.count);
+	std::vector<int> materials(header.materials.count);
+	std::vector<int> nodes(header.nodes.count);
+
+	for (uint32_t index = 0; index < header.textures.count; index++)
+	{
+		textureSlots[index] = FindTextureSlot(m_pSceneFile->GetString(pTextures[index].tag));
+	}
+	for (uint32_t index = 0; index < header.materials.count; index++)
+	{
+		materials[index] = FindMaterial(m_pSceneFile->GetString(pMaterials[index].tag));
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// parents are stored before their children, so the graph
+	// node of a parent always exists already
+	for (uint32_t index = 0; index < header.nodes.count; index++)
+	{
+		const SceneFile::FILE_NODE& node = pNodes[index];
+
+		nodes[index] = m_pSceneGraph->AddNode(
+			(node.parent < 0) ? -1 : nodes[node.parent],
+			glm::vec3(node.scaleXYZ[0], node.scaleXYZ[1], node.scaleXYZ[2]),
+			node.rotationXYZ[0],
+			node.rotationXYZ[1],
+			node.rotationXYZ[2],
+			glm::vec3(node.positionXYZ[0], node.positionXYZ[1], node.positionXYZ[2]));
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.3f, 2.5f, 5.0f);
+	m_sceneObjects.reserve(m_sceneObjects.size() + header.objects.count);
+	for (uint32_t index = 0; index < header.objects.count; index++)
+	{
+		const SceneFile::FILE_OBJECT& object = pObjects[index];
+
+		AddSceneObject(
+			nodes[object.node],
+			(MESH_TYPE)object.mesh,
+			(object.texture < 0) ? -1 : textureSlots[object.texture],
+			glm::vec4(object.color[0], object.color[1], object.color[2], object.color[3]),
+			materials[object.material],
+			(object.parts & SceneFile::PART_TOP) != 0,
+			(object.parts & SceneFile::PART_BOTTOM) != 0,
+			(object.parts & SceneFile::PART_SIDES) != 0);
+	}
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  SetObjectParts()
+ *
+ *  This method is used for setting the mesh parts that are
+ *  drawn for an object from its mesh type.  The top, bottom
+ *  and sides flags are only used for the cylinder meshes.
+ ***********************************************************/
+void SceneManager::SetObjectParts(
+	SCENE_OBJECT& object,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	object.nParts = 0;
+
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+		object.parts[object.nParts++] = PrimitiveMeshes::PART_PLANE;
+		break;
+	case MESH_SPHERE:
+		object.parts[object.nParts++] = PrimitiveMeshes::PART_SPHERE;
+		break;
+	case MESH_HALF_SPHERE:
+		object.parts[object.nParts++] = PrimitiveMeshes::PART_HALF_SPHERE;
+		break;
+	case MESH_CYLINDER:
+		if (bDrawTop == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_CYLINDER_TOP;
+		if (bDrawBottom == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_CYLINDER_BOTTOM;
+		if (bDrawSides == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_CYLINDER_SIDES;
+		break;
+	case MESH_TAPERED_CYLINDER:
+		if (bDrawTop == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_TAPERED_CYLINDER_TOP;
+		if (bDrawBottom == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_TAPERED_CYLINDER_BOTTOM;
+		if (bDrawSides == true)
+			object.parts[object.nParts++] = PrimitiveMeshes::PART_TAPERED_CYLINDER_SIDES;
+		break;
+	case MESH_TORUS:
+		object.parts[object.nParts++] = PrimitiveMeshes::PART_TORUS;
+		break;
+	case MESH_BOX:
+		object.parts[object.nParts++] = PrimitiveMeshes::PART_BOX;
+		break;
+	}
+}
+
+/***********************************************************
+ *  BuildSortKey()
+ *
+ *  This method is used for packing the render state of an
+ *  object into a key.  The level of detail and mesh part are
+ *  added to the key when the draw is recorded, so sorting
+ *  puts every draw of the same part and level from the same
+ *  texture array next to each other where they become a
+ *  single instanced draw, even when the objects use
+ *  different textures.
+ ***********************************************************/
+uint64_t SceneManager::BuildSortKey(const SCENE_OBJECT& object)
+{
+	uint64_t sortKey = 0;
+	uint64_t textureGroup = 0;
+
+	// one is added to the group so that a missing texture
+	// sorts first
+	if (object.bUseTexture == true)
+	{
+		textureGroup = (uint64_t)(m_textureIDs[object.textureSlot].group + 1);
+	}
+
+	// | textured (1) | texture group (16) | lod (4) | mesh part (8) |
+	sortKey = ((uint64_t)(object.bUseTexture ? 1 : 0) << 28) |
+		((textureGroup & 0xFFFF) << 12);
+
+	return(sortKey);
+}
+
+/***********************************************************
+ *  SetObjectBounds()
+ *
+ *  This method is used for setting the mesh space bounding
+ *  box of an object to the box around all of its parts.
+ ***********************************************************/
+void SceneManager::SetObjectBounds(SCENE_OBJECT& object)
+{
+	glm::vec3 partMin;
+	glm::vec3 partMax;
+
+	object.localMin = glm::vec3(0.0f);
+	object.localMax = glm::vec3(0.0f);
+
+	for (int part = 0; part < object.nParts; part++)
+	{
+		m_basicMeshes->GetPartBounds(object.parts[part], partMin, partMax);
+
+		if (part == 0)
+		{
+			object.localMin = partMin;
+			object.localMax = partMax;
+		}
+		else
+		{
+			object.localMin = glm::min(object.localMin, partMin);
+			object.localMax = glm::max(object.localMax, partMax);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateObjectBounds()
+ *
+ *  This method is used for transforming the mesh space
+ *  bounds of every object by its world matrix.  This only
+ *  needs to happen after the scene graph has changed.
+ ***********************************************************/
+void SceneManager::UpdateObjectBounds()
+{
+	int objectCount = (int)m_sceneObjects.size();
+	bool bSameObjects = ((int)m_worldBounds.minX.size() == objectCount);
+
+	// the shadows are redrawn where the moved objects were,
+	// and where they are now once the bounds are updated
+	if (bSameObjects == true)
+	{
+		InvalidateMovedShadows();
+	}
+	else
+	{
+		m_pShadowMaps->InvalidateAll();
+	}
+
+	// the bounds are stored as arrays for the culling kernel
+	m_worldBounds.minX.resize(objectCount);
+	m_worldBounds.minY.resize(objectCount);
+	m_worldBounds.minZ.resize(objectCount);
+	m_worldBounds.maxX.resize(objectCount);
+	m_worldBounds.maxY.resize(objectCount);
+	m_worldBounds.maxZ.resize(objectCount);
+
+	RunParallel(objectCount, OBJECT_CHUNK_SIZE, [this](int begin, int end)
+	{
+		glm::vec3 worldMin;
+		glm::vec3 worldMax;
+
+		for (int index = begin; index < end; index++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[index];
+
+			Frustum::TransformBox(
+				m_pSceneGraph->GetWorldMatrix(object.node),
+				object.localMin,
+				object.localMax,
+				worldMin,
+				worldMax);
+
+			m_worldBounds.minX[index] = worldMin.x;
+			m_worldBounds.minY[index] = worldMin.y;
+			m_worldBounds.minZ[index] = worldMin.z;
+			m_worldBounds.maxX[index] = worldMax.x;
+			m_worldBounds.maxY[index] = worldMax.y;
+			m_worldBounds.maxZ[index] = worldMax.z;
+		}
+	});
+
+	if (bSameObjects == true)
+	{
+		InvalidateMovedShadows();
+	}
+	UpdateBoundsTree();
+
+	m_bBoundsDirty = false;
+	m_bIndirectDirty = true;
+}
+
+/***********************************************************
+ *  InvalidateMovedShadows()
+ *
+ *  This method is used for marking the shadow map pixels
+ *  covered by the world bounds of each object whose node was
+ *  recalculated in the last scene graph update.
+ ***********************************************************/
+void SceneManager::InvalidateMovedShadows()
+{
+	for (size_t index = 0; index < m_sceneObjects.size(); index++)
+	{
+		if (m_pSceneGraph->IsWorldChanged(m_sceneObjects[index].node) == false)
+		{
+			continue;
+		}
+
+		m_pShadowMaps->InvalidateBox(
+			glm::vec3(m_worldBounds.minX[index], m_worldBounds.minY[index], m_worldBounds.minZ[index]),
+			glm::vec3(m_worldBounds.maxX[index], m_worldBounds.maxY[index], m_worldBounds.maxZ[index]));
+	}
+}
+
+/***********************************************************
+ *  UpdateBoundsTree()
+ *
+ *  This method is used for refitting the tree over the world
+ *  bounds to the objects whose node was recalculated in the
+ *  last scene graph update.  The tree is built again when
+ *  objects were added.
+ ***********************************************************/
+void SceneManager::UpdateBoundsTree()
+{
+	m_movedObjects.clear();
+	for (size_t index = 0; index < m_sceneObjects.size(); index++)
+	{
+		if (m_pSceneGraph->IsWorldChanged(m_sceneObjects[index].node) == true)
+		{
+			m_movedObjects.push_back((int)index);
+		}
+	}
+
+	if (m_pBvh->Refit(m_worldBounds, m_movedObjects) == false)
+	{
+		m_pBvh->Build(m_worldBounds);
+	}
+}
+
+/***********************************************************
+ *  UpdateShadowMaps()
+ *
+ *  This method is used for redrawing the dirty parts of the
+ *  shadow maps with the depth variant.  The casters are
+ *  sorted by part, so each face draws every part once.  The
+ *  maps stay dirty until the depth variant is ready.  The
+ *  number of faces drawn is returned.
+ ***********************************************************/
+int SceneManager::UpdateShadowMaps()
+{
+	if ((m_pShadowMaps->HasDirtyFaces() == false) ||
+		(UseShaderVariant(VARIANT_DEPTH) == false))
+	{
+		return(0);
+	}
+
+	m_shadowCasters.clear();
+	for (size_t index = 0; index < m_sceneObjects.size(); index++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[index];
+		ShadowMaps::SHADOW_CASTER caster;
+
+		caster.object = (int)index;
+		caster.model = m_pSceneGraph->GetWorldMatrix(object.node);
+		for (int part = 0; part < object.nParts; part++)
+		{
+			caster.part = object.parts[part];
+			m_shadowCasters.push_back(caster);
+		}
+	}
+
+	std::sort(m_shadowCasters.begin(), m_shadowCasters.end(),
+		[](const ShadowMaps::SHADOW_CASTER& a, const ShadowMaps::SHADOW_CASTER& b)
+	{
+		if (a.part != b.part)
+		{
+			return(a.part < b.part);
+		}
+		return(a.object < b.object);
+	});
+
+	m_pShadowMaps->Render(m_basicMeshes, m_activeProgram, m_shadowCasters, m_worldBounds);
+
+	// the depth variant got the matrices of the light faces,
+	// binding it again later sets the camera uniforms
+	UseProgram(m_baseProgram);
+
+	return(m_pShadowMaps->GetRenderedFaceCount());
+}
+
+/***********************************************************
+ *  RunParallel()
+ *
+ *  This method is used for running a function over chunks
+ *  of [0, count) on the job system, or directly on this
+ *  thread when no job system has been set.
+ ***********************************************************/
+void SceneManager::RunParallel(int count, int chunkSize, const JobSystem::JOB_FUNCTION& function)
+{
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(count, chunkSize, function);
+	}
+	else if (count > 0)
+	{
+		function(0, count);
+	}
+}
+
+/***********************************************************
+ *  GetScreenSize()
+ *
+ *  This method is used for getting the fraction of the view
+ *  height covered by the sphere around the world bounds of
+ *  an object.  Objects at or behind the camera plane are
+ *  treated as filling the view.  With several views the
+ *  largest size is used, as every view draws the same level.
+ ***********************************************************/
+float SceneManager::GetScreenSize(int object) const
+{
+	glm::vec3 boundsMin(m_worldBounds.minX[object], m_worldBounds.minY[object], m_worldBounds.minZ[object]);
+	glm::vec3 boundsMax(m_worldBounds.maxX[object], m_worldBounds.maxY[object], m_worldBounds.maxZ[object]);
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = glm::length(boundsMax - center);
+	float screenSize = 0.0f;
+
+	for (size_t index = 0; index < m_views.size(); index++)
+	{
+		const VIEW_STATE& view = m_views[index];
+		float w = glm::dot(glm::vec3(view.clipRowW), center) + view.clipRowW.w;
+
+		if (w <= 0.0001f)
+		{
+			return(1.0f);
+		}
+
+		screenSize = std::max(screenSize, radius * view.projectionScale / w);
+	}
+
+	return(screenSize);
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for picking the level of detail for
+ *  a projected size.  Each boundary is moved away from the
+ *  current level by the hysteresis margin, so an object near
+ *  a boundary does not switch back and forth every frame.
+ ***********************************************************/
+int SceneManager::SelectLod(float screenSize, int currentLod) const
+{
+	int lod = 0;
+
+	for (int level = 0; level < PrimitiveMeshes::LOD_COUNT - 1; level++)
+	{
+		float boundary = LOD_SCREEN_SIZES[level];
+
+		if (currentLod > level)
+		{
+			boundary *= (1.0f + LOD_HYSTERESIS);
+		}
+		else
+		{
+			boundary *= (1.0f - LOD_HYSTERESIS);
+		}
+
+		if (screenSize < boundary)
+		{
+			lod = level + 1;
+		}
+	}
+
+	return(lod);
+}
+
+/***********************************************************
+ *  UpdateObjectLod()
+ *
+ *  This method is used for moving an object to the level of
+ *  detail for its projected size.  With cross-fading on the
+ *  new level is faded in over LOD_FADE_FRAMES frames before
+ *  it replaces the old one, and no new level is picked until
+ *  the fade has finished.
+ ***********************************************************/
+void SceneManager::UpdateObjectLod(SCENE_OBJECT& object, int index)
+{
+	int lod = 0;
+
+	if (object.fadeLod >= 0)
+	{
+		object.fadeFrame++;
+		if (object.fadeFrame >= LOD_FADE_FRAMES)
+		{
+			object.lod = object.fadeLod;
+			object.fadeLod = -1;
+			object.fadeFrame = 0;
+		}
+		return;
+	}
+
+	lod = SelectLod(GetScreenSize(index), object.lod);
+	if (lod == object.lod)
+	{
+		return;
+	}
+
+	if (m_bLodFadeEnabled == true)
+	{
+		object.fadeLod = lod;
+		object.fadeFrame = 1;
+	}
+	else
+	{
+		object.lod = lod;
+	}
+}
+
+/***********************************************************
+ *  RecordDrawChunk()
+ *
+ *  This method is used for skipping the objects of one chunk
+ *  that the tree found outside the view frustum, picking the
+ *  levels of detail of the others,
+ *  and recording and sorting a draw command for each part of
+ *  the visible objects.  An object that is cross-fading is
+ *  recorded at both of its levels.  Each chunk only writes
+ *  its own list and objects, so the chunks can be recorded
+ *  on any thread.
+ ***********************************************************/
+void SceneManager::RecordDrawChunk(int chunk, bool bViewDependent)
+{
+	std::vector<DRAW_COMMAND>& commands = m_chunkLists[chunk];
+	DRAW_COMMAND command;
+	int first = chunk * OBJECT_CHUNK_SIZE;
+	int last = std::min(first + OBJECT_CHUNK_SIZE, (int)m_sceneObjects.size());
+	int culled = 0;
+	int occluded = 0;
+	int fading = 0;
+	bool bCullObjects = (bViewDependent == true) && (m_bCullingEnabled == true);
+	bool bCullOccluded = (bViewDependent == true) && (m_bOcclusionCullingEnabled == true) && (m_views.size() == 1);
+	bool bSelectLod = (bViewDependent == true) && (m_bLodEnabled == true);
+
+	// the lists keep their capacity, so recording does not
+	// allocate once the first frame has been drawn
+	commands.clear();
+
+	for (int index = first; index < last; index++)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[index];
+		int lods[2] = { 0, 0 };
+		int fades[2] = { 0, 0 };
+		int nLods = 1;
+
+		if ((bCullObjects == true) &&
+			(TransformKernel::IsVisible(m_visibleBits, index) == false))
+		{
+			culled++;
+			continue;
+		}
+		if ((bCullOccluded == true) && (m_pOcclusionCuller->IsOccluded(index) == true))
+		{
+			occluded++;
+			continue;
+		}
+
+		// clip space w grows with the distance along the view,
+		// for orthographic views it is the same for every object
+		command.depth = 0.0f;
+		if (bViewDependent == true)
+		{
+			command.depth =
+				m_clipRowW.x * (m_worldBounds.minX[index] + m_worldBounds.maxX[index]) * 0.5f +
+				m_clipRowW.y * (m_worldBounds.minY[index] + m_worldBounds.maxY[index]) * 0.5f +
+				m_clipRowW.z * (m_worldBounds.minZ[index] + m_worldBounds.maxZ[index]) * 0.5f +
+				m_clipRowW.w;
+		}
+
+		if (bSelectLod == true)
+		{
+			UpdateObjectLod(object, index);
+
+			lods[0] = object.lod;
+			if (object.fadeLod >= 0)
+			{
+				// the old level fades out as the new one fades in
+				fades[1] = object.fadeFrame * 255 / LOD_FADE_FRAMES;
+				fades[0] = -fades[1];
+				lods[1] = object.fadeLod;
+				nLods = 2;
+				fading++;
+			}
+		}
+
+		for (int level = 0; level < nLods; level++)
+		{
+			for (int part = 0; part < object.nParts; part++)
+			{
+				command.sortKey = object.sortKey |
+					(((uint64_t)lods[level] & 0xF) << 8) |
+					((uint64_t)object.parts[part] & 0xFF);
+				command.object = index;
+				command.part = object.parts[part];
+				command.lod = lods[level];
+				command.lodFade = fades[level];
+				commands.push_back(command);
+			}
+		}
+	}
+
+	std::sort(commands.begin(), commands.end(), CompareDrawCommands);
+	m_chunkCulled[chunk] = culled;
+	m_chunkOccluded[chunk] = occluded;
+	m_chunkFading[chunk] = fading;
+}
+
+/***********************************************************
+ *  MergeDrawChunks()
+ *
+ *  This method is used for merging the sorted chunk lists
+ *  into one sorted draw list.  The lists are placed end to
+ *  end and neighbouring runs are merged in pairs, doubling
+ *  the run length each pass, with the merges of a pass run
+ *  in parallel.  Each pass reads one buffer and writes the
+ *  other.  The run starts are temporary for the frame, so
+ *  they come from the frame arena.
+ ***********************************************************/
+void SceneManager::MergeDrawChunks()
+{
+	FrameVector<size_t> runStarts;
+	size_t total = 0;
+
+	for (size_t chunk = 0; chunk < m_chunkLists.size(); chunk++)
+	{
+		total += m_chunkLists[chunk].size();
+	}
+
+	m_drawList.clear();
+	m_drawList.reserve(total);
+	for (size_t chunk = 0; chunk < m_chunkLists.size(); chunk++)
+	{
+		runStarts.push_back(m_drawList.size());
+		m_drawList.insert(m_drawList.end(), m_chunkLists[chunk].begin(), m_chunkLists[chunk].end());
+	}
+	runStarts.push_back(total);
+
+	m_mergeBuffer.resize(total);
+
+	while (runStarts.size() > 2)
+	{
+		int runCount = (int)runStarts.size() - 1;
+		int pairCount = (runCount + 1) / 2;
+
+		// only two pointers are captured, which the job function
+		// stores without allocating
+		RunParallel(pairCount, 1, [this, &runStarts](int begin, int end)
+		{
+			int runCount = (int)runStarts.size() - 1;
+
+			for (int pair = begin; pair < end; pair++)
+			{
+				int run = pair * 2;
+				DRAW_COMMAND* pSource = m_drawList.data();
+				DRAW_COMMAND* pTarget = m_mergeBuffer.data();
+
+				if (run + 1 < runCount)
+				{
+					std::merge(
+						pSource + runStarts[run], pSource + runStarts[run + 1],
+						pSource + runStarts[run + 1], pSource + runStarts[run + 2],
+						pTarget + runStarts[run],
+						CompareDrawCommands);
+				}
+				else
+				{
+					// an odd run out is copied to the next pass as is
+					std::copy(pSource + runStarts[run], pSource + runStarts[run + 1], pTarget + runStarts[run]);
+				}
+			}
+		});
+
+		FrameVector<size_t> mergedStarts;
+		for (int run = 0; run < runCount; run += 2)
+		{
+			mergedStarts.push_back(runStarts[run]);
+		}
+		mergedStarts.push_back(total);
+		runStarts.swap(mergedStarts);
+
+		m_drawList.swap(m_mergeBuffer);
+	}
+}
+
+/***********************************************************
+ *  RecordDrawList()
+ *
+ *  This method is used for recording a draw command for each
+ *  part of each retained object that is inside the view
+ *  frustum, sorted by render state.  The objects are split
+ *  into chunks that are culled, recorded and sorted on the
+ *  job system, and the sorted chunks are then merged.  When
+ *  the list is not view dependent, every object is recorded
+ *  at full detail.
+ ***********************************************************/
+void SceneManager::RecordDrawList(bool bViewDependent)
+{
+	int objectCount = (int)m_sceneObjects.size();
+	int chunkCount = (objectCount + OBJECT_CHUNK_SIZE - 1) / OBJECT_CHUNK_SIZE;
+
+	m_chunkLists.resize(chunkCount);
+	m_chunkCulled.assign(chunkCount, 0);
+	m_chunkOccluded.assign(chunkCount, 0);
+	m_chunkFading.assign(chunkCount, 0);
+	m_visibleBits.resize((objectCount + 31) / 32);
+
+	// the frusta are tested against the tree before the chunks
+	// are recorded, which skips every object under a node that
+	// is outside and tests no planes under a node that is
+	// inside; with several views an object is kept when any of
+	// them may see it
+	if ((bViewDependent == true) && (m_bCullingEnabled == true))
+	{
+		Frustum frusta[MAX_VIEWS];
+		for (size_t index = 0; index < m_views.size(); index++)
+		{
+			frusta[index] = m_views[index].frustum;
+		}
+		m_pBvh->CullFrusta(frusta, (int)m_views.size(), m_visibleBits.data());
+	}
+
+	RunParallel(chunkCount, 1, [this, bViewDependent](int begin, int end)
+	{
+		for (int chunk = begin; chunk < end; chunk++)
+		{
+			RecordDrawChunk(chunk, bViewDependent);
+		}
+	});
+
+	// objects that are cross-fading change every frame until
+	// the fade has finished
+	m_culledObjects = 0;
+	m_occludedObjects = 0;
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		m_culledObjects += m_chunkCulled[chunk];
+		m_occludedObjects += m_chunkOccluded[chunk];
+		if (m_chunkFading[chunk] > 0)
+		{
+			m_bSceneChanged = true;
+		}
+	}
+
+	MergeDrawChunks();
+}
+
+/***********************************************************
+ *  BuildInstanceBatches()
+ *
+ *  This method is used for converting the sorted draw list
+ *  into batches, and writing the per-instance data of each
+ *  command to the passed in array in the same order.
+ *  Consecutive commands with the same render state become
+ *  one batch.  The array may be mapped buffer memory, so it
+ *  is only written.
+ ***********************************************************/
+void SceneManager::BuildInstanceBatches(PrimitiveMeshes::INSTANCE_DATA* pInstances)
+{
+	uint64_t batchKey = 0;
+
+	m_batches.clear();
+
+	// the batches only depend on the sort keys, so they are
+	// found first and the instance data is filled in parallel
+	for (size_t index = 0; index < m_drawList.size(); index++)
+	{
+		const DRAW_COMMAND& command = m_drawList[index];
+
+		// start a new batch when the render state changes
+		if ((m_batches.size() == 0) || (command.sortKey != batchKey))
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[command.object];
+
+			INSTANCE_BATCH batch;
+			batch.part = command.part;
+			batch.lod = command.lod;
+			batch.bUseTexture = object.bUseTexture;
+			batch.textureGroup = (object.bUseTexture == true) ? m_textureIDs[object.textureSlot].group : -1;
+			batch.firstInstance = (int)index;
+			batch.instanceCount = 0;
+			m_batches.push_back(batch);
+			batchKey = command.sortKey;
+		}
+
+		m_batches.back().instanceCount++;
+	}
+
+	RunParallel((int)m_drawList.size(), INSTANCE_CHUNK_SIZE, [this, pInstances](int begin, int end)
+	{
+		for (int index = begin; index < end; index++)
+		{
+			const DRAW_COMMAND& command = m_drawList[index];
+			const SCENE_OBJECT& object = m_sceneObjects[command.object];
+			PrimitiveMeshes::INSTANCE_DATA& instance = pInstances[index];
+
+			instance.model = m_pSceneGraph->GetWorldMatrix(object.node);
+			instance.color = object.color;
+			// materials past the uniform buffer were never uploaded
+			instance.materialIndex = ((object.material >= 0) && (object.material < MAX_MATERIALS)) ? object.material : 0;
+			instance.bUseTexture = (object.bUseTexture == true) ? 1 : 0;
+			instance.textureLayer = (object.bUseTexture == true) ? m_textureIDs[object.textureSlot].layer : 0;
+			instance.lodFade = command.lodFade;
+		}
+	});
+}
+
+/***********************************************************
+ *  BeginFrameInstances()
+ *
+ *  This method is used for reserving the instance data of the
+ *  recorded draw list in the next region of the frame ring
+ *  buffer, so that the instances are written where the draws
+ *  read them.  When the ring buffer cannot be mapped the
+ *  instances are written to m_instances and uploaded by
+ *  SubmitDrawList() instead.
+ ***********************************************************/
+PrimitiveMeshes::INSTANCE_DATA* SceneManager::BeginFrameInstances()
+{
+	GLsizeiptr size = (GLsizeiptr)(m_drawList.size() * sizeof(PrimitiveMeshes::INSTANCE_DATA));
+
+	m_pFrameData->BeginFrame(size);
+	m_pFrameInstances = (PrimitiveMeshes::INSTANCE_DATA*)m_pFrameData->Allocate(
+		size,
+		sizeof(glm::vec4),
+		m_frameInstanceOffset);
+	if (NULL != m_pFrameInstances)
+	{
+		return(m_pFrameInstances);
+	}
+
+	m_instances.resize(m_drawList.size());
+
+	return(m_instances.data());
+}
+
+/***********************************************************
+ *  DrawBatch()
+ *
+ *  This method is used for drawing a batch with one instanced
+ *  draw, from the ring buffer region of the frame or from the
+ *  uploaded instances when it could not be mapped.
+ ***********************************************************/
+void SceneManager::DrawBatch(const INSTANCE_BATCH& batch, bool bFrameData)
+{
+	if (bFrameData == true)
+	{
+		m_basicMeshes->DrawInstanced(
+			batch.part,
+			batch.lod,
+			m_pFrameData->GetBuffer(),
+			m_frameInstanceOffset,
+			batch.firstInstance,
+			batch.instanceCount);
+	}
+	else
+	{
+		m_basicMeshes->DrawInstanced(batch.part, batch.lod, batch.firstInstance, batch.instanceCount);
+	}
+}
+
+/***********************************************************
+ *  SubmitDrawList()
+ *
+ *  This method is used for drawing the batches into each
+ *  view, from the instances written to the ring buffer for
+ *  the frame.  The instances are written once however many
+ *  views there are.  The region of the frame is fenced after
+ *  the draws, so it is not written again until OpenGL has
+ *  read it.
+ ***********************************************************/
+void SceneManager::SubmitDrawList()
+{
+	bool bFrameData = (NULL != m_pFrameInstances);
+
+	m_pFrameData->FinishWrites();
+	if (bFrameData == false)
+	{
+		m_basicMeshes->UploadInstances(m_instances.data(), (int)m_instances.size());
+	}
+
+	for (size_t index = 0; index < m_views.size(); index++)
+	{
+		if (m_views.size() > 1)
+		{
+			BeginView((int)index);
+		}
+		SubmitViewDraws(bFrameData);
+	}
+
+	m_pFrameData->EndFrame();
+	m_pFrameInstances = NULL;
+}
+
+/***********************************************************
+ *  SubmitViewDraws()
+ *
+ *  This method is used for drawing each batch with one
+ *  instanced draw into the view being drawn.  With the depth
+ *  pre-pass every batch is drawn with the depth only variant
+ *  first, the batch with the nearest object first, and the
+ *  occlusion queries are drawn against that depth while the
+ *  shading pass runs.
+ ***********************************************************/
+void SceneManager::SubmitViewDraws(bool bFrameData)
+{
+	bool bPrepass = false;
+
+	if (BeginDepthPrepass() == true)
+	{
+		// the instances of a batch are already sorted front to
+		// back, so its first instance is its nearest
+		FrameVector<int> batchOrder(m_batches.size());
+		for (size_t index = 0; index < m_batches.size(); index++)
+		{
+			batchOrder[index] = (int)index;
+		}
+		std::sort(batchOrder.begin(), batchOrder.end(), [this](int first, int second)
+		{
+			return(m_drawList[m_batches[first].firstInstance].depth < m_drawList[m_batches[second].firstInstance].depth);
+		});
+
+		for (size_t index = 0; index < batchOrder.size(); index++)
+		{
+			DrawBatch(m_batches[batchOrder[index]], bFrameData);
+		}
+
+		IssueOcclusionQueries();
+		bPrepass = true;
+	}
+
+	BeginShadingPass(bPrepass);
+	for (size_t index = 0; index < m_batches.size(); index++)
+	{
+		const INSTANCE_BATCH& batch = m_batches[index];
+
+		UseShaderVariant((batch.bUseTexture == true) ? VARIANT_TEXTURED : VARIANT_COLOR);
+		if (batch.bUseTexture == true)
+		{
+			SetShaderTexture(batch.textureGroup);
+		}
+
+		DrawBatch(batch, bFrameData);
+	}
+	EndShadingPass(bPrepass);
+
+	// without the pre-pass the depth is only complete now
+	if (bPrepass == false)
+	{
+		IssueOcclusionQueries();
+	}
+}
+
+/***********************************************************
+ *  BeginDepthPrepass()
+ *
+ *  This method is used for starting the depth pre-pass, with
+ *  the depth only variant bound and the color writes off.
+ *  All of the scene objects are opaque, so every draw can
+ *  write its depth first.  False is returned, and nothing is
+ *  changed, when the pre-pass is off or the variant is still
+ *  compiling.
+ ***********************************************************/
+bool SceneManager::BeginDepthPrepass()
+{
+	if ((m_bDepthPrepassEnabled == false) ||
+		(UseShaderVariant(VARIANT_DEPTH) == false))
+	{
+		return(false);
+	}
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginShadingPass()
+ *
+ *  This method is used for setting the writes of the shading
+ *  pass.  After a depth pre-pass the depth buffer already
+ *  holds the nearest surface, so the depth is only tested
+ *  for being equal, and with depth writes off the early
+ *  depth test also keeps working for the dithered fade that
+ *  discards fragments.  The vertex shader has an invariant
+ *  position, so both passes compute the same depth.
+ ***********************************************************/
+void SceneManager::BeginShadingPass(bool bPrepass)
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	if (bPrepass == true)
+	{
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LEQUAL);
+	}
+}
+
+/***********************************************************
+ *  EndShadingPass()
+ *
+ *  This method is used for restoring the default depth
+ *  state after the shading pass.
+ ***********************************************************/
+void SceneManager::EndShadingPass(bool bPrepass)
+{
+	if (bPrepass == true)
+	{
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+	}
+}
+
+/***********************************************************
+ *  IssueOcclusionQueries()
+ *
+ *  This method is used for querying the objects in the view
+ *  frustum against the depth of the frame, when occlusion
+ *  culling is on and a single view is drawn.  The results
+ *  decide which objects the next frame skips.
+ ***********************************************************/
+void SceneManager::IssueOcclusionQueries()
+{
+	// the depth of one view cannot hide objects from the others
+	if ((m_bOcclusionCullingEnabled == false) || (m_views.size() > 1))
+	{
+		return;
+	}
+
+	m_pOcclusionCuller->IssueQueries(
+		m_worldBounds,
+		(m_bCullingEnabled == true) ? &m_visibleBits : NULL,
+		m_projectionMatrix * m_viewMatrix,
+		glm::vec3(glm::inverse(m_viewMatrix)[3]));
+}
+
+/***********************************************************
+ *  BuildIndirectDrawData()
+ *
+ *  This method is used for uploading every part of every
+ *  object as a candidate for the GPU culling pass.  The
+ *  unculled draw list is sorted and batched as usual, and
+ *  each batch becomes one indirect command per level of
+ *  detail.  The command for level l of a batch draws from
+ *  l * candidates + the first instance of the batch, so every
+ *  level has room for all of the candidates of the batch.
+ *  This only runs after the objects or their
+ *  transformations change.
+ ***********************************************************/
+void SceneManager::BuildIndirectDrawData()
+{
+	RecordDrawList(false);
+	m_instances.resize(m_drawList.size());
+	BuildInstanceBatches(m_instances.data());
+
+	m_candidates.resize(m_instances.size());
+	m_indirectCommands.resize(m_batches.size() * PrimitiveMeshes::LOD_COUNT);
+
+	for (size_t batchIndex = 0; batchIndex < m_batches.size(); batchIndex++)
+	{
+		const INSTANCE_BATCH& batch = m_batches[batchIndex];
+
+		for (int lod = 0; lod < PrimitiveMeshes::LOD_COUNT; lod++)
+		{
+			IndirectRenderer::INDIRECT_COMMAND& command =
+				m_indirectCommands[batchIndex * PrimitiveMeshes::LOD_COUNT + lod];
+
+			m_basicMeshes->GetPartRange(batch.part, lod, command.firstIndex, command.count, command.baseVertex);
+			command.instanceCount = 0;
+			command.baseInstance = (GLuint)(lod * m_candidates.size() + batch.firstInstance);
+		}
+
+		for (int index = batch.firstInstance; index < batch.firstInstance + batch.instanceCount; index++)
+		{
+			IndirectRenderer::CANDIDATE& candidate = m_candidates[index];
+			int object = m_drawList[index].object;
+
+			// the batch is stored in the spare w value of the bounds
+			candidate.instance = m_instances[index];
+			candidate.boundsMin = glm::vec4(
+				m_worldBounds.minX[object],
+				m_worldBounds.minY[object],
+				m_worldBounds.minZ[object],
+				(float)batchIndex);
+			candidate.boundsMax = glm::vec4(
+				m_worldBounds.maxX[object],
+				m_worldBounds.maxY[object],
+				m_worldBounds.maxZ[object],
+				1.0f);
+		}
+	}
+
+	m_pIndirectRenderer->SetDrawData(m_candidates, m_indirectCommands);
+	m_bIndirectDirty = false;
+}
+
+/***********************************************************
+ *  SubmitIndirectDraws()
+ *
+ *  This method is used for drawing the commands written by
+ *  the GPU culling pass.  The commands are sorted by render
+ *  state, so all of the commands that use the same texture
+ *  array, at every level of detail, are drawn with one
+ *  multi-draw call.  The depth pre-pass draws all of the
+ *  commands with one more call.  Occlusion culling needs the
+ *  objects on the CPU, so it is not used here.
+ ***********************************************************/
+void SceneManager::SubmitIndirectDraws()
+{
+	int multiDraws = 0;
+	size_t first = 0;
+	bool bPrepass = false;
+
+	// the depth only variant draws every command at once
+	if (BeginDepthPrepass() == true)
+	{
+		m_pIndirectRenderer->Draw(
+			m_basicMeshes,
+			0,
+			(int)m_batches.size() * PrimitiveMeshes::LOD_COUNT);
+		multiDraws++;
+		bPrepass = true;
+	}
+
+	BeginShadingPass(bPrepass);
+	while (first < m_batches.size())
+	{
+		const INSTANCE_BATCH& batch = m_batches[first];
+		size_t last = first + 1;
+
+		while ((last < m_batches.size()) &&
+			(m_batches[last].bUseTexture == batch.bUseTexture) &&
+			(m_batches[last].textureGroup == batch.textureGroup))
+		{
+			last++;
+		}
+
+		UseShaderVariant((batch.bUseTexture == true) ? VARIANT_TEXTURED : VARIANT_COLOR);
+		if (batch.bUseTexture == true)
+		{
+			SetShaderTexture(batch.textureGroup);
+		}
+
+		m_pIndirectRenderer->Draw(
+			m_basicMeshes,
+			(int)first * PrimitiveMeshes::LOD_COUNT,
+			(int)(last - first) * PrimitiveMeshes::LOD_COUNT);
+		multiDraws++;
+		first = last;
+	}
+	EndShadingPass(bPrepass);
+
+	// the visible counts stay on the GPU, so only the calls
+	// and the number of candidates are known here
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->SetCounter("draws", multiDraws);
+		m_pProfiler->SetCounter("instances", m_pIndirectRenderer->GetCandidateCount());
+	}
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+/**************************************************************
+* Sets the necessary transformations, textures, colors and
+* materials for the countertop that all other objects sit on.
+***************************************************************/
+void SceneManager::BuildCountertop()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+	int node = -1;
+
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		-1,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	// change the plane color to light brown
+	// AddColoredObject(node, MESH_PLANE, glm::vec4(0.843137, 0.737255, 0.529412, 1), "tile");
+
+	// apply a granite skin to the countertop with the
+	// tile material for lighting
+	AddTexturedObject(node, MESH_PLANE, "granite", "tile");
+}
+
+/**************************************************************
+* Sets the necessary transformations, textures, colors and
+* materials for the primatives of the lemon.
+***************************************************************/
+void SceneManager::BuildLemon() 
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+	int lemon = -1;
+	int node = -1;
+
+	// the lemon parts are positioned relative to the
+	// center of the lemon body
+	lemon = m_pSceneGraph->AddNode(
+		-1,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f,
+		0.0f,
+		0.0f,
+		glm::vec3(3.3f, 1.3f, 5.0f));
+
+	// the body of the lemon
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(1.3f, 1.3f, 1.3f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
 
-	// change the lemon stem texture to pale yellow
-	SetShaderTexture("lemon_stem");
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		lemon,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
-	// change the material to wood to mimic lemon skin
-	SetShaderMaterial("wood");
+	// change the color to yellow
+	// AddColoredObject(node, MESH_SPHERE, glm::vec4(0.996078, 0.827451, 0.035294, 1), "wood");
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
+	// apply the lemon skin texture with the wood
+	// material to mimic lemon skin
+	AddTexturedObject(node, MESH_SPHERE, "lemon_skin", "wood");
 
-	// draw the top part of the stem
+	// the bottom part of the stem
 	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.1f, 0.1f, 0.1f);
+	scaleXYZ = glm::vec3(0.2f, 0.2f, 0.2f);
 
 	// set the XYZ rotation for the mesh
 	XrotationDegrees = 0.0f;
@@ -522,31 +2239,52 @@ void SceneManager::DrawLemon()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.27f, 2.65f, 5.0f);
+	positionXYZ = glm::vec3(0.0f, 1.2f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		lemon,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	// change the color to white/yellow
-	SetShaderColor(0.858824, 0.780392, 0.65882, 1);
+	// apply the pale yellow lemon stem texture with the
+	// wood material to mimic lemon skin
+	AddTexturedObject(node, MESH_HALF_SPHERE, "lemon_stem", "wood");
+
+	// the top part of the stem
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(0.1f, 0.1f, 0.1f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(-0.03f, 1.35f, 0.0f);
 
-	// change the material to wood to mimic lemon skin
-	SetShaderMaterial("wood");
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		lemon,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	// change the color to white/yellow with the wood
+	// material to mimic lemon skin
+	AddColoredObject(node, MESH_TAPERED_CYLINDER, glm::vec4(0.858824, 0.780392, 0.65882, 1), "wood");
 }
 
 /**************************************************************
-* Sets the necessary transformations, applies textures, colors
-* and materials, then draws the primatives for the chapstick.
+* Sets the necessary transformations, textures, colors and
+* materials for the primatives of the chapstick.
 ***************************************************************/
-void SceneManager::DrawChapstick()
+void SceneManager::BuildChapstick()
 {
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -554,13 +2292,20 @@ void SceneManager::DrawChapstick()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-
-	// draw the yellow/tan part of the chapstick
+	int chapstick = -1;
+	int node = -1;
+
+	// the chapstick parts are positioned relative to the
+	// base of the chapstick body
+	chapstick = m_pSceneGraph->AddNode(
+		-1,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f,
+		0.0f,
+		0.0f,
+		glm::vec3(6.0f, 0.37f, 8.0f));
+
+	// the yellow/tan part of the chapstick
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(0.3f, 1.5f, 0.3f);
 
@@ -570,35 +2315,26 @@ void SceneManager::DrawChapstick()
 	ZrotationDegrees = -75.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(6.0f, 0.37f, 8.0f);
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		chapstick,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	 // apply the chapstick texture
-	 SetShaderTexture("chapstick_single");
+	// apply the chapstick texture to the sides with the
+	// tile material to mimic plastic
+	AddTexturedObject(node, MESH_CYLINDER, "chapstick_single", "tile", false, false, true);
 
-	// set the shader material to tile to mimic plastic
-	SetShaderMaterial("tile");
+	// change the color of the ends to yellow/tan with the
+	// tile material to mimic plastic
+	AddColoredObject(node, MESH_CYLINDER, glm::vec4(0.996078, 0.831373, 0.509804, 1), "tile", true, true, false);
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
-
-	// change the color to yellow/tan
-	SetShaderColor(0.996078, 0.831373, 0.509804, 1);
-
-	// set the shader material to tile to mimic plastic
-	SetShaderMaterial("tile");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh(true, true, false);
-
-	// draw the navy part of the chapstick
+	// the navy part of the chapstick
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(0.3f, 0.375f, 0.3f);
 
@@ -608,10 +2344,11 @@ void SceneManager::DrawChapstick()
 	ZrotationDegrees = -75.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(5.633f, 0.37f, 7.905f);
+	positionXYZ = glm::vec3(-0.367f, 0.0f, -0.095f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		chapstick,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
@@ -619,23 +2356,18 @@ void SceneManager::DrawChapstick()
 		positionXYZ);
 
 	// change the color to navy
-	// SetShaderColor(0.239216, 0.290196, 0.376471, 1);
+	// AddColoredObject(node, MESH_CYLINDER, glm::vec4(0.239216, 0.290196, 0.376471, 1), "tile");
 
-	// apply the cap texture
-	SetShaderTexture("chapstick_cap");
-
-	// set the shader material to tile to mimic plastic
-	SetShaderMaterial("tile");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
+	// apply the cap texture with the tile material to
+	// mimic plastic
+	AddTexturedObject(node, MESH_CYLINDER, "chapstick_cap", "tile");
 }
 
 /**************************************************************
-* Sets the necessary transformations, applies textures, colors
-* and materials, then draws the primatives for the water can.
+* Sets the necessary transformations, textures, colors and
+* materials for the primatives of the water can.
 ***************************************************************/
-void SceneManager::DrawWater()
+void SceneManager::BuildWater()
 {
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -643,11 +2375,18 @@ void SceneManager::DrawWater()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
+	int waterCan = -1;
+	int node = -1;
+
+	// the can parts all share one parent transform, so the
+	// whole can is moved by changing this node
+	waterCan = m_pSceneGraph->AddNode(
+		-1,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f,
+		0.0f,
+		0.0f,
+		glm::vec3(9.0f, 0.0f, 2.0f));
 
 	// can base
 	// set the XYZ scale for the mesh
@@ -659,48 +2398,41 @@ void SceneManager::DrawWater()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 0.26f, 2.0f);
+	positionXYZ = glm::vec3(0.0f, 0.26f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		waterCan,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	SetShaderColor(0.59216, 0.6, 0.59608, 1);
-
-	SetShaderMaterial("gold");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddColoredObject(node, MESH_TAPERED_CYLINDER, glm::vec4(0.59216, 0.6, 0.59608, 1), "gold");
 
 	// base "lip"
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(1.2f, 1.2f, 0.8f);
 
-	// set the XYZ rotation for the meshwe
+	// set the XYZ rotation for the mesh
 	XrotationDegrees = 90.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 0.1f, 2.0f);
+	positionXYZ = glm::vec3(0.0f, 0.1f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		waterCan,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	SetShaderColor(0.59216, 0.6, 0.59608, 1);
-
-	SetShaderMaterial("gold");
-
-	m_basicMeshes->DrawTorusMesh();
+	AddColoredObject(node, MESH_TORUS, glm::vec4(0.59216, 0.6, 0.59608, 1), "gold");
 
 	// can body
 	// set the XYZ scale for the mesh
@@ -712,22 +2444,18 @@ void SceneManager::DrawWater()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 0.25f, 2.0f);
+	positionXYZ = glm::vec3(0.0f, 0.25f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		waterCan,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	SetShaderTexture("water_can");
-
-	SetShaderMaterial("gold");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
+	AddTexturedObject(node, MESH_CYLINDER, "water_can", "gold", false, false, true);
 
 	// can top
 	// set the XYZ scale for the mesh
@@ -739,55 +2467,48 @@ void SceneManager::DrawWater()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 6.25f, 2.0f);
+	positionXYZ = glm::vec3(0.0f, 6.25f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		waterCan,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	SetShaderColor(0.87843, 0.69804, 0.32157, 1);
-
-	SetShaderMaterial("gold");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddColoredObject(node, MESH_TAPERED_CYLINDER, glm::vec4(0.87843, 0.69804, 0.32157, 1), "gold");
 
 	// top "lip"
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(1.35f, 1.35f, 1.2f);
 
-	// set the XYZ rotation for the meshwe
+	// set the XYZ rotation for the mesh
 	XrotationDegrees = 90.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 6.3f, 2.0f);
+	positionXYZ = glm::vec3(0.0f, 6.3f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		waterCan,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	SetShaderColor(0.70196, 0.60784, 0.35294, 1);
-
-	SetShaderMaterial("gold");
-
-	m_basicMeshes->DrawTorusMesh();
+	AddColoredObject(node, MESH_TORUS, glm::vec4(0.70196, 0.60784, 0.35294, 1), "gold");
 }
 
 /**************************************************************
-* Sets the necessary transformations, applies textures, colors
-* and materials, then draws the primatives for the craft set.
+* Sets the necessary transformations, textures, colors and
+* materials for the primatives of the craft set.
 ***************************************************************/
-void SceneManager::DrawCraftSet()
+void SceneManager::BuildCraftSet()
 {
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -795,281 +2516,931 @@ void SceneManager::DrawCraftSet()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
+	int craftSet = -1;
+	int node = -1;
+
+	// the box and the lid share the rotation of the craft set
+	craftSet = m_pSceneGraph->AddNode(
+		-1,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f,
+		10.0f,
+		0.0f,
+		glm::vec3(-4.5f, 0.0f, 2.0f));
 
 	// craft kit base
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(7.0f, 2.2f, 9.0f);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 10.0f;
-	ZrotationDegrees = 0.0f;
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 1.11f, 0.0f);
+
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		craftSet,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	//AddColoredObject(node, MESH_BOX, glm::vec4(0.05, 0.05, 0.05, 1), "cardboard");
+
+	AddTexturedObject(node, MESH_BOX, "cardboard", "cardboard");
+
+	// craft kit top
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(3.5f, 1.0f, 4.5f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 2.22f, 0.0f);
+
+	// set the transformations into the scene graph
+	node = m_pSceneGraph->AddNode(
+		craftSet,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	//AddColoredObject(node, MESH_PLANE, glm::vec4(0.05, 0.05, 0.05, 1), "cardboard");
+
+	AddTexturedObject(node, MESH_PLANE, "craft_top", "cardboard");
+}
+
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	/*** STUDENTS - add the code BELOW for defining object materials. ***/
+	/*** There is no limit to the number of object materials that can ***/
+	/*** be defined. Refer to the code in the OpenGL Sample for help  ***/
+
+	OBJECT_MATERIAL goldMaterial;
+	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.1f);
+	goldMaterial.ambientStrength = 0.4f;
+	goldMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.2f);
+	goldMaterial.specularColor = glm::vec3(0.6f, 0.5f, 0.4f);
+	goldMaterial.shininess = 60.0;
+	goldMaterial.tag = "gold";
+
+	AddMaterial(goldMaterial);
+
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.ambientColor = glm::vec3(0.4f, 0.3f, 0.1f);
+	woodMaterial.ambientStrength = 0.2f;
+	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
+	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.shininess = 0.3;
+	woodMaterial.tag = "wood";
+
+	AddMaterial(woodMaterial);
+
+	OBJECT_MATERIAL tileMaterial;
+	tileMaterial.ambientColor = glm::vec3(0.8549f, 0.7529f, 0.6078f);
+	tileMaterial.ambientStrength = 0.3f;
+	tileMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
+	tileMaterial.specularColor = glm::vec3(0.4f, 0.5f, 0.6f);
+	tileMaterial.shininess = 25.0;
+	tileMaterial.tag = "tile";
+
+	AddMaterial(tileMaterial);
+
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	glassMaterial.ambientStrength = 0.3f;
+	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	glassMaterial.shininess = 85.0;
+	glassMaterial.tag = "glass";
+
+	AddMaterial(glassMaterial);
+
+	OBJECT_MATERIAL cardboardMaterial;
+	cardboardMaterial.ambientColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	cardboardMaterial.ambientStrength = 0.3f;
+	cardboardMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.15f);
+	cardboardMaterial.specularColor = glm::vec3(0.2f, 0.17f, 0.1f);
+	cardboardMaterial.shininess = 0.5;
+	cardboardMaterial.tag = "cardboard";
+
+	AddMaterial(cardboardMaterial);
+
+	// add the materials of the scene file after the built in ones
+	AddSceneFileMaterials();
+
+	// copy all of the materials into the material block
+	UploadMaterialBuffer();
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  There are up to 16 light sources.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	// this line of code is NEEDED for telling the shaders to render 
+	// the 3D scene with custom lighting, if no light sources have
+	// been added then the display window will be black - to use the 
+	// default OpenGL lighting then comment out the following line
+	//m_pShaderManager->setBoolValue(g_UseLightingName, true);
+
+	/*** STUDENTS - add the code BELOW for setting up light sources ***/
+	/*** Up to sixteen light sources can be defined. Refer to the   ***/
+	/*** code in the OpenGL Sample for help                         ***/
+
+	LIGHT_SOURCE lightSource;
+
+	lightSource.position = glm::vec3(5.0f, 6.0f, -10.0f);
+	lightSource.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f);
+	lightSource.diffuseColor = glm::vec3(0.95686f, 0.60784f, 0.1451f);
+	lightSource.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	lightSource.focalStrength = 40.0f;
+	lightSource.specularIntensity = 0.05f;
+	AddLightSource(lightSource);
+
+	lightSource.position = glm::vec3(-15.0f, 6.0f, -10.0f);
+	lightSource.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f);
+	lightSource.diffuseColor = glm::vec3(0.95686f, 0.60784f, 0.1451f);
+	lightSource.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	lightSource.focalStrength = 40.0f;
+	lightSource.specularIntensity = 0.05f;
+	AddLightSource(lightSource);
+
+	// setup the light to the right, up slightly, and far in the foreground to mimic light coming from the window
+	lightSource.position = glm::vec3(-30.0f, 3.0f, 50.0f);
+	lightSource.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f);
+	lightSource.diffuseColor = glm::vec3(0.9f, 0.9f, 0.9f);
+	lightSource.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	lightSource.focalStrength = 40.0f;
+	lightSource.specularIntensity = 0.1f;
+	AddLightSource(lightSource);
+
+	//lightSource.position = glm::vec3(0.6f, 5.0f, 6.0f);
+	//lightSource.ambientColor = glm::vec3(0.01f, 0.01f, 0.01f);
+	//lightSource.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	//lightSource.specularColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	//lightSource.focalStrength = 12.0f;
+	//lightSource.specularIntensity = 0.5f;
+	//AddLightSource(lightSource);
+
+	// any number of small point lights can be added, such as
+	// this strip of shelf lights; each fragment only adds up
+	// the ones whose range reaches its cluster
+	if (m_bDemoPointLights == true)
+	{
+		ClusteredLighting::POINT_LIGHT pointLight;
+		pointLight.color = glm::vec3(1.0f, 0.85f, 0.6f);
+		pointLight.range = 2.0f;
+		pointLight.specularIntensity = 0.2f;
+		for (int index = 0; index < DEMO_POINT_LIGHT_COUNT; index++)
+		{
+			pointLight.position = glm::vec3(-16.0f + 0.5f * index, 9.0f, -6.0f);
+			AddPointLight(pointLight);
+		}
+	}
+
+	// copy all of the lights into the light block
+	UploadLightBuffer();
+
+	m_pShaderManager->setBoolValue("bUseLighting", true);
+
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	// map the scene file, its arrays are used in place while
+	// the scene is built
+	if (m_sceneFilename.empty() == false)
+	{
+		m_pSceneFile->Open(m_sceneFilename.c_str());
+	}
+
+	// load textures
+	LoadSceneTextures();
+
+	// load material options
+	DefineObjectMaterials();
+
+	// add the lights to the scene
+	SetupSceneLights();
+
+	// the first light sources cast shadows, their maps are
+	// drawn with the first frame
+	glm::vec3 shadowLights[ShadowMaps::MAX_SHADOW_LIGHTS];
+	int shadowLightCount = std::min((int)m_lightSources.size(), (int)ShadowMaps::MAX_SHADOW_LIGHTS);
+	for (int index = 0; index < shadowLightCount; index++)
+	{
+		shadowLights[index] = m_lightSources[index].position;
+	}
+	m_pShadowMaps->SetLights(shadowLights, shadowLightCount);
+
+	// build the shader variants for the defined lights in
+	// the background
+	RequestShaderVariants();
+
+	// bin the point lights on the GPU when it is supported
+	if (m_pClusteredLighting->Initialize(ResourcePaths::Resolve("shaders/clusterLightsComputeShader.glsl").c_str(), m_pShaderCache) == true)
+	{
+		m_pClusteredLighting->SetLights(m_pointLights);
+	}
+
+	// load object meshes in the selected vertex layout, from
+	// the mesh cache after the first start
+	m_basicMeshes->SetVertexFormat(
+		(m_bCompactVertices == true) ? PrimitiveMeshes::FORMAT_COMPACT : PrimitiveMeshes::FORMAT_FULL);
+	std::string meshCachePath = ResourcePaths::Resolve(
+		(m_bCompactVertices == true) ? COMPACT_MESH_CACHE_FILE : MESH_CACHE_FILE);
+	if (m_basicMeshes->LoadMeshCache(meshCachePath.c_str()) == false)
+	{
+		m_basicMeshes->LoadPlaneMesh();
+		m_basicMeshes->LoadSphereMesh();
+		m_basicMeshes->LoadHalfSphereMesh();
+		m_basicMeshes->LoadCylinderMesh();
+		m_basicMeshes->LoadTaperedCylinderMesh();
+		m_basicMeshes->LoadTorusMesh();
+		m_basicMeshes->LoadBoxMesh();
+		m_basicMeshes->SaveMeshCache(meshCachePath.c_str());
+	}
+
+	// cull and draw on the GPU when it is supported, the
+	// instanced draws are used while the shader compiles
+	m_pIndirectRenderer->Initialize(ResourcePaths::Resolve("shaders/cullComputeShader.glsl").c_str(), m_pShaderCache);
+
+	// skip the objects hidden behind others, occlusion culling
+	// stays off when the box program cannot be built
+	if (m_pOcclusionCuller->Initialize(
+		ResourcePaths::Resolve("shaders/occlusionVertexShader.glsl").c_str(),
+		ResourcePaths::Resolve("shaders/occlusionFragmentShader.glsl").c_str(),
+		m_pShaderCache) == false)
+	{
+		m_bOcclusionCullingEnabled = false;
+	}
+
+	// build the retained scene objects - the transformations
+	// are only calculated again when a node is changed
+	if (m_pSceneFile->IsOpen() == true)
+	{
+		BuildSceneFileObjects();
+		m_pSceneFile->Close();
+	}
+	else
+	{
+		BuildCountertop();
+		BuildLemon();
+		BuildChapstick();
+		BuildWater();
+		BuildCraftSet();
+	}
+	m_pSceneGraph->UpdateWorldMatrices();
+}
+
+/***********************************************************
+ *  AreTexturesLoaded()
+ *
+ *  This method is used for checking whether every scene
+ *  texture has replaced its placeholder.
+ ***********************************************************/
+bool SceneManager::AreTexturesLoaded()
+{
+	return(m_pTextureLoader->IsComplete());
+}
+
+/***********************************************************
+ *  WaitForTextures()
+ *
+ *  This method is used for blocking until every scene texture
+ *  has been decoded and uploaded.
+ ***********************************************************/
+void SceneManager::WaitForTextures()
+{
+	m_pTextureLoader->WaitForAll();
+}
+
+/***********************************************************
+ *  IsSceneChanged()
+ *
+ *  This method is used for checking whether drawing the
+ *  scene again with the same camera would give a different
+ *  frame, because textures are still being uploaded, objects
+ *  are cross-fading between levels of detail or the render
+ *  settings were changed.
+ ***********************************************************/
+bool SceneManager::IsSceneChanged() const
+{
+	return(m_bSceneChanged);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the retained scene objects with their cached
+ *  transformations
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	ProfileScope renderScope(m_pProfiler, "RenderScene");
+	GLint targetViewport[4] = { 0, 0, 0, 0 };
+
+	// several views are drawn into their own viewports, and the
+	// viewport that was set is restored after them
+	if (m_views.size() > 1)
+	{
+		glGetIntegerv(GL_VIEWPORT, targetViewport);
+	}
+	ApplyView(0);
+
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginGpuScope("RenderScene");
+	}
+
+	// replace placeholder textures with any images that have
+	// finished decoding, a few per frame to avoid hitches; the
+	// scene keeps changing until the last one is uploaded
+	{
+		ProfileScope scope(m_pProfiler, "ProcessUploads");
+		m_pTextureLoader->ProcessUploads(MAX_TEXTURE_UPLOADS_PER_FRAME);
+		m_bSceneChanged = (AreTexturesLoaded() == false);
+	}
+
+	// pick up the shader programs the driver has finished
+	// compiling in the background
+	if (NULL != m_pShaderCache)
+	{
+		ProfileScope scope(m_pProfiler, "ProcessShaders");
+		m_pShaderCache->ProcessPending();
+		if (m_pShaderCache->GetPendingCount() > 0)
+		{
+			m_bSceneChanged = true;
+		}
+	}
+
+	// bin the point lights into the clusters of the first view
+	{
+		ProfileScope scope(m_pProfiler, "ClusterLights");
+		m_pClusteredLighting->Update(m_viewMatrix, m_projectionMatrix);
+		m_pClusteredLighting->BindTextures(CLUSTER_TEXTURE_UNIT);
+		SetClusterUniforms();
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.5f, 1.11f, 2.0f);
+	// recalculate any transformations that were changed
+	// since the last frame
+	{
+		ProfileScope scope(m_pProfiler, "UpdateWorldMatrices");
+		if (m_pSceneGraph->UpdateWorldMatrices() > 0)
+		{
+			m_bBoundsDirty = true;
+		}
+		if (m_bBoundsDirty == true)
+		{
+			UpdateObjectBounds();
+		}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->SetCounter("bvh builds", m_pBvh->GetBuildCount());
+		}
+	}
 
-	//SetShaderColor(0.05, 0.05, 0.05, 1);
+	// redraw the shadows where objects have moved, nothing is
+	// drawn while the scene stands still
+	{
+		ProfileScope scope(m_pProfiler, "UpdateShadowMaps");
+		int shadowFaces = UpdateShadowMaps();
+		m_pShadowMaps->BindTexture(SHADOW_TEXTURE_UNIT);
+		SetShadowUniforms();
 
-	SetShaderTexture("cardboard");
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->SetCounter("shadow faces", shadowFaces);
+		}
+	}
 
-	SetShaderMaterial("cardboard");
+	if (m_pIndirectRenderer->IsAvailable() == true)
+	{
+		// the objects are culled and counted into indirect
+		// commands on the GPU, the CPU only redoes its part
+		// when the scene has changed
+		if (m_bIndirectDirty == true)
+		{
+			ProfileScope scope(m_pProfiler, "BuildIndirectDrawData");
+			BuildIndirectDrawData();
+		}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+		// the candidates are shared, and each view culls them
+		// into its own commands on the GPU
+		for (size_t index = 0; index < m_views.size(); index++)
+		{
+			if (m_views.size() > 1)
+			{
+				BeginView((int)index);
+			}
+			{
+				ProfileScope scope(m_pProfiler, "CullIndirect");
+				IndirectRenderer::LOD_VIEW lodView;
+
+				// sizes of 0 keep every candidate at full detail;
+				// the GPU path picks a level each frame without
+				// cross-fading
+				lodView.clipRowW = m_clipRowW;
+				lodView.projectionScale = m_projectionScale;
+				lodView.screenSizes = glm::vec2(0.0f);
+				if (m_bLodEnabled == true)
+				{
+					lodView.screenSizes = glm::vec2(LOD_SCREEN_SIZES[0], LOD_SCREEN_SIZES[1]);
+				}
+
+				// a default frustum keeps every candidate
+				m_pIndirectRenderer->Cull((m_bCullingEnabled == true) ? m_frustum : Frustum(), lodView);
+			}
+			{
+				ProfileScope scope(m_pProfiler, "SubmitIndirectDraws");
+				SubmitIndirectDraws();
+			}
+		}
+	}
+	else
+	{
+		// read the occlusion results of the earlier frames, the
+		// scene keeps changing until they stop changing it
+		if ((m_bOcclusionCullingEnabled == true) &&
+			(m_views.size() == 1) &&
+			(m_pOcclusionCuller->IsAvailable() == true))
+		{
+			ProfileScope scope(m_pProfiler, "CollectOcclusion");
+			m_pOcclusionCuller->CollectResults((int)m_sceneObjects.size());
+			if (m_pOcclusionCuller->IsSettled() == false)
+			{
+				m_bSceneChanged = true;
+			}
+		}
 
-	// craft kit top
-    // set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.5f, 1.0f, 4.5f);
+		// draw the retained scene objects sorted by render state,
+		// with all draws of the same part and texture batched into
+		// one instanced draw
+		{
+			ProfileScope scope(m_pProfiler, "RecordDrawList");
+			RecordDrawList(true);
+		}
+		{
+			ProfileScope scope(m_pProfiler, "BuildInstanceBatches");
+			BuildInstanceBatches(BeginFrameInstances());
+		}
+		{
+			ProfileScope scope(m_pProfiler, "SubmitDrawList");
+			SubmitDrawList();
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 10.0f;
-	ZrotationDegrees = 0.0f;
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->SetCounter("draws", (int)m_batches.size());
+			m_pProfiler->SetCounter("instances", (int)m_drawList.size());
+			m_pProfiler->SetCounter("ring buffer waits", m_pFrameData->GetWaitCount());
+			m_pProfiler->SetCounter("culled", m_culledObjects);
+			m_pProfiler->SetCounter("occluded", m_occludedObjects);
+		}
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.5f, 2.22f, 2.0f);
+	// leave the base program bound for the next frame, which
+	// the view manager sets the camera uniforms on
+	UseProgram(m_baseProgram);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	if (m_views.size() > 1)
+	{
+		glViewport(targetViewport[0], targetViewport[1], targetViewport[2], targetViewport[3]);
+	}
 
-	//SetShaderColor(0.05, 0.05, 0.05, 1);
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndGpuScope();
 
-	SetShaderTexture("craft_top");
+		m_pProfiler->SetCounter("views", (int)m_views.size());
+		m_pProfiler->SetCounter("program switches", m_programSwitches);
+		m_pProfiler->SetCounter("uniform uploads", m_pUniformCache->GetUploadCount());
+		m_pProfiler->SetCounter("uniforms skipped", m_pUniformCache->GetSkippedCount());
+	}
+	m_pUniformCache->ResetCounters();
+	m_pFrameData->ResetWaitCount();
+	m_programSwitches = 0;
 
-	SetShaderMaterial("cardboard");
+	// check wire frames for DEBUG
+	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler that records
+ *  the scene rendering scopes and counters.
+ ***********************************************************/
+void SceneManager::SetProfiler(Profiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
 }
 
 /***********************************************************
- *  DefineObjectMaterials()
+ *  SetJobSystem()
  *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
+ *  This method is used for setting the thread pool that the
+ *  object bounds, culling, draw list sorting and instance
+ *  data are built on.  OpenGL calls stay on this thread.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
 {
-	/*** STUDENTS - add the code BELOW for defining object materials. ***/
-	/*** There is no limit to the number of object materials that can ***/
-	/*** be defined. Refer to the code in the OpenGL Sample for help  ***/
+	m_pJobSystem = pJobSystem;
+}
 
-	OBJECT_MATERIAL goldMaterial;
-	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.1f);
-	goldMaterial.ambientStrength = 0.4f;
-	goldMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.2f);
-	goldMaterial.specularColor = glm::vec3(0.6f, 0.5f, 0.4f);
-	goldMaterial.shininess = 60.0;
-	goldMaterial.tag = "gold";
+/***********************************************************
+ *  SetShaderCache()
+ *
+ *  This method is used for setting the shader cache that the
+ *  scene shader programs are built and cached with.
+ ***********************************************************/
+void SceneManager::SetShaderCache(ShaderCache* pShaderCache)
+{
+	m_pShaderCache = pShaderCache;
+}
 
-	m_objectMaterials.push_back(goldMaterial);
+/***********************************************************
+ *  SetSceneFile()
+ *
+ *  This method is used for setting a binary scene file that
+ *  the retained objects are built from instead of the built
+ *  in scene.  The built in scene is used when the file cannot
+ *  be opened.
+ ***********************************************************/
+void SceneManager::SetSceneFile(const char* filename)
+{
+	m_sceneFilename = filename;
+}
 
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.ambientColor = glm::vec3(0.4f, 0.3f, 0.1f);
-	woodMaterial.ambientStrength = 0.2f;
-	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
-	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.shininess = 0.3;
-	woodMaterial.tag = "wood";
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the camera matrices of the
+ *  frame, which the view frustum and the projected sizes of
+ *  the objects are calculated from.  The scene is drawn as a
+ *  single view into the viewport that is set.
+ ***********************************************************/
+void SceneManager::SetViewProjection(
+	const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	SCENE_VIEW sceneView;
 
-	m_objectMaterials.push_back(woodMaterial);
+	sceneView.view = view;
+	sceneView.projection = projection;
+	sceneView.x = 0;
+	sceneView.y = 0;
+	sceneView.width = 0;
+	sceneView.height = 0;
 
-	OBJECT_MATERIAL tileMaterial;
-	tileMaterial.ambientColor = glm::vec3(0.8549f, 0.7529f, 0.6078f);
-	tileMaterial.ambientStrength = 0.3f;
-	tileMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
-	tileMaterial.specularColor = glm::vec3(0.4f, 0.5f, 0.6f);
-	tileMaterial.shininess = 25.0;
-	tileMaterial.tag = "tile";
+	SetViews(&sceneView, 1);
+}
 
-	m_objectMaterials.push_back(tileMaterial);
+/***********************************************************
+ *  SetViews()
+ *
+ *  This method is used for setting the views drawn in the
+ *  next frame, such as the cameras of a split screen or the
+ *  eyes of a stereo pair.  The objects are culled against
+ *  all of the frusta together, their levels of detail are
+ *  picked for the view they are largest in, and the sorted
+ *  draw list and its instances are shared by every view, so
+ *  a view only adds its draw calls.  Views past MAX_VIEWS
+ *  are left out.
+ ***********************************************************/
+void SceneManager::SetViews(const SCENE_VIEW* pViews, int viewCount)
+{
+	if (viewCount > MAX_VIEWS)
+	{
+		viewCount = MAX_VIEWS;
+	}
+	if (viewCount <= 0)
+	{
+		return;
+	}
 
-	OBJECT_MATERIAL glassMaterial;
-	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	glassMaterial.ambientStrength = 0.3f;
-	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	glassMaterial.shininess = 85.0;
-	glassMaterial.tag = "glass";
+	// the occlusion results of one view would hide objects
+	// the other views can see, so they are dropped while
+	// several views are drawn
+	if ((viewCount > 1) && (m_views.size() == 1))
+	{
+		m_pOcclusionCuller->Reset();
+	}
 
-	m_objectMaterials.push_back(glassMaterial);
+	m_views.resize(viewCount);
+	for (int index = 0; index < viewCount; index++)
+	{
+		VIEW_STATE& view = m_views[index];
+		glm::mat4 viewProjection = pViews[index].projection * pViews[index].view;
+
+		view.setup = pViews[index];
+		view.frustum.Extract(viewProjection);
+
+		// clip space w of a point is the dot product with the
+		// fourth row, and glm matrices are stored by column
+		view.clipRowW = glm::vec4(
+			viewProjection[0][3],
+			viewProjection[1][3],
+			viewProjection[2][3],
+			viewProjection[3][3]);
+		view.projectionScale = pViews[index].projection[1][1];
+	}
+}
 
-	OBJECT_MATERIAL cardboardMaterial;
-	cardboardMaterial.ambientColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	cardboardMaterial.ambientStrength = 0.3f;
-	cardboardMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.15f);
-	cardboardMaterial.specularColor = glm::vec3(0.2f, 0.17f, 0.1f);
-	cardboardMaterial.shininess = 0.5;
-	cardboardMaterial.tag = "cardboard";
+/***********************************************************
+ *  ApplyView()
+ *
+ *  This method is used for making one of the views the view
+ *  being drawn, whose camera the uniforms, the GPU culling
+ *  and the occlusion queries use, and for setting its
+ *  viewport when it has one.
+ ***********************************************************/
+void SceneManager::ApplyView(int index)
+{
+	const VIEW_STATE& view = m_views[index];
 
-	m_objectMaterials.push_back(cardboardMaterial);
+	m_viewMatrix = view.setup.view;
+	m_projectionMatrix = view.setup.projection;
+	m_frustum = view.frustum;
+	m_clipRowW = view.clipRowW;
+	m_projectionScale = view.projectionScale;
 
+	if (view.setup.width > 0)
+	{
+		glViewport(view.setup.x, view.setup.y, view.setup.width, view.setup.height);
+	}
 }
 
 /***********************************************************
- *  SetupSceneLights()
+ *  BeginView()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  This method is used for starting the draws of a view when
+ *  several are drawn.  The point lights are binned again for
+ *  each view after the first, which was binned at the start
+ *  of the frame, and the programs are given the camera of
+ *  the view as they are bound.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+void SceneManager::BeginView(int index)
 {
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting, if no light sources have
-	// been added then the display window will be black - to use the 
-	// default OpenGL lighting then comment out the following line
-	//m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
-
-	m_pShaderManager->setVec3Value("lightSources[0].position", 5.0f, 6.0f, -10.0f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.95686f, 0.60784f, 0.1451f);
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 40.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.05f);
-
-	m_pShaderManager->setVec3Value("lightSources[1].position", -15.0f, 6.0f, -10.0f);
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.95686f, 0.60784f, 0.1451f);
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 40.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.05f);
+	ApplyView(index);
 
-	// setup the light to the right, up slightly, and far in the foreground to mimic light coming from the window
-	m_pShaderManager->setVec3Value("lightSources[2].position", -30.0f, 3.0f, 50.0f);
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 0.9f, 0.9f, 0.9f);
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 40.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 0.1f);
-
-	//m_pShaderManager->setVec3Value("lightSources[2].position", 0.6f, 5.0f, 6.0f);
-	//m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.01f, 0.01f, 0.01f);
-	//m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 0.3f, 0.3f, 0.3f);
-	//m_pShaderManager->setVec3Value("lightSources[2].specularColor", 0.3f, 0.3f, 0.3f);
-	//m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 12.0f);
-	//m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 0.5f);
-
-	m_pShaderManager->setBoolValue("bUseLighting", true);
+	if (index > 0)
+	{
+		ProfileScope scope(m_pProfiler, "ClusterLights");
+		m_pClusteredLighting->Update(m_viewMatrix, m_projectionMatrix);
+	}
 
+	// binding the base program makes the next variant bound
+	// set the camera uniforms of this view
+	UseProgram(m_baseProgram);
+	SetCameraUniforms();
 }
 
 /***********************************************************
- *  PrepareScene()
+ *  SetCullingEnabled()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for turning view frustum culling on
+ *  or off, every object is drawn when it is off.
  ***********************************************************/
-void SceneManager::PrepareScene()
+void SceneManager::SetCullingEnabled(bool bEnabled)
 {
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
-	// load textures
-	LoadSceneTextures();
+	m_bCullingEnabled = bEnabled;
+	m_bSceneChanged = true;
+}
 
-	// load material options
-	DefineObjectMaterials();
+/***********************************************************
+ *  SetLodEnabled()
+ *
+ *  This method is used for turning level of detail selection
+ *  on or off, every object is drawn at full detail when it
+ *  is off.
+ ***********************************************************/
+void SceneManager::SetLodEnabled(bool bEnabled)
+{
+	m_bLodEnabled = bEnabled;
+	m_bSceneChanged = true;
+}
 
-	// add the lights to the scene
-	SetupSceneLights();
+/***********************************************************
+ *  SetLodCrossFade()
+ *
+ *  This method is used for turning the dithered cross-fade
+ *  between levels of detail on or off.  Objects change level
+ *  at once when it is off.
+ ***********************************************************/
+void SceneManager::SetLodCrossFade(bool bEnabled)
+{
+	m_bLodFadeEnabled = bEnabled;
+	m_bSceneChanged = true;
+}
 
-	// load object meshes
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
-	m_basicMeshes->LoadBoxMesh();
+/***********************************************************
+ *  SetDepthPrepassEnabled()
+ *
+ *  This method is used for turning the depth pre-pass on or
+ *  off.  Every fragment of every draw is shaded when it is
+ *  off.
+ ***********************************************************/
+void SceneManager::SetDepthPrepassEnabled(bool bEnabled)
+{
+	m_bDepthPrepassEnabled = bEnabled;
+	m_bSceneChanged = true;
 }
 
 /***********************************************************
- *  RenderScene()
+ *  SetCompactVerticesEnabled()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for selecting the compact vertex
+ *  layout, with half the vertex size and 16-bit indices, in
+ *  place of the full precision one.  The meshes are loaded in
+ *  the layout by PrepareScene().
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::SetCompactVerticesEnabled(bool bEnabled)
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	m_bCompactVertices = bEnabled;
+}
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+/***********************************************************
+ *  SetDemoPointLightsEnabled()
+ *
+ *  This method is used for adding a strip of small point
+ *  lights to the scene, which gives the clustered lighting
+ *  something to bin.  The lights are added by PrepareScene().
+ ***********************************************************/
+void SceneManager::SetDemoPointLightsEnabled(bool bEnabled)
+{
+	m_bDemoPointLights = bEnabled;
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SetOcclusionCullingEnabled()
+ *
+ *  This method is used for turning occlusion culling on or
+ *  off.  Every object in the view frustum is drawn again as
+ *  soon as it is off.
+ ***********************************************************/
+void SceneManager::SetOcclusionCullingEnabled(bool bEnabled)
+{
+	m_bOcclusionCullingEnabled = bEnabled;
+	if (bEnabled == false)
+	{
+		m_pOcclusionCuller->Reset();
+	}
+	m_bSceneChanged = true;
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the object a world space
+ *  ray hits first, such as the ray under the cursor.  The
+ *  tree gives the objects whose world bounds the ray passes
+ *  through, nearest first, and the ray is tested against the
+ *  mesh space box of each of them until the next world box
+ *  starts beyond the nearest hit.  The direction does not
+ *  need to be normalized, the distance is in units of it.
+ ***********************************************************/
+int SceneManager::PickObject(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance)
+{
+	int picked = -1;
+	float nearest = 0.0f;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	
-	// change the plane color to light brown
-	// SetShaderColor(0.843137, 0.737255, 0.529412, 1);
+	m_pBvh->IntersectRay(origin, direction, 1e30f, m_rayHits);
+	for (size_t index = 0; index < m_rayHits.size(); index++)
+	{
+		const BoundingVolumeHierarchy::RAY_HIT& hit = m_rayHits[index];
+		if ((picked >= 0) && (hit.distance > nearest))
+		{
+			break;
+		}
 
-	// apply a granite skin to the countertop
-	SetShaderTexture("granite");
+		// an affine transform keeps the ray parameter, so the
+		// mesh space distance is the world space distance
+		const SCENE_OBJECT& object = m_sceneObjects[hit.object];
+		glm::mat4 inverseWorld = glm::inverse(m_pSceneGraph->GetWorldMatrix(object.node));
+		glm::vec3 localOrigin = glm::vec3(inverseWorld * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection = glm::vec3(inverseWorld * glm::vec4(direction, 0.0f));
+		float entry = 0.0f;
+		float exit = 0.0f;
+
+		if ((BoundingVolumeHierarchy::IntersectBox(
+				localOrigin,
+				BoundingVolumeHierarchy::InvertDirection(localDirection),
+				object.localMin,
+				object.localMax,
+				entry,
+				exit) == true) &&
+			((picked < 0) || (entry < nearest)))
+		{
+			picked = hit.object;
+			nearest = entry;
+		}
+	}
 
-	// change the material to tile for lighting
-	SetShaderMaterial("tile");
+	distance = nearest;
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	return(picked);
+}
 
-	// render the lemon
-	DrawLemon();
+/***********************************************************
+ *  FindObjectsInBox()
+ *
+ *  This method is used for finding the objects whose world
+ *  bounds overlap a world space box, as of the last frame.
+ ***********************************************************/
+void SceneManager::FindObjectsInBox(
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	std::vector<int>& objects) const
+{
+	m_pBvh->QueryBox(boundsMin, boundsMax, objects);
+}
 
-	// render the chapstick
-	DrawChapstick();
+/***********************************************************
+ *  GetObjectDescription()
+ *
+ *  This method is used for describing an object by its mesh,
+ *  material and texture tags, or its color when it is not
+ *  textured, such as for showing the picked object.
+ ***********************************************************/
+std::string SceneManager::GetObjectDescription(int object) const
+{
+	if ((object < 0) || (object >= (int)m_sceneObjects.size()))
+	{
+		return(std::string());
+	}
 
-	// render the water
-	DrawWater();
+	const SCENE_OBJECT& sceneObject = m_sceneObjects[object];
+	std::string description = MESH_NAMES[sceneObject.mesh];
 
-	// render the craft set
-	DrawCraftSet();
+	// the materials are only looked up by tag while drawing,
+	// so the tag of a handle is searched for
+	std::string materialTag = "none";
+	for (std::unordered_map<std::string, int>::const_iterator found = m_materialHandles.begin();
+		found != m_materialHandles.end();
+		++found)
+	{
+		if (found->second == sceneObject.material)
+		{
+			materialTag = found->first;
+			break;
+		}
+	}
+	description += " | material " + materialTag;
 
-	// check wire frames for DEBUG
-	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	if ((sceneObject.bUseTexture == true) &&
+		(sceneObject.textureSlot < (int)m_textureIDs.size()))
+	{
+		description += " | texture " + m_textureIDs[sceneObject.textureSlot].tag;
+	}
+	else
+	{
+		char color[64];
+		snprintf(
+			color,
+			sizeof(color),
+			" | color %.2f %.2f %.2f %.2f",
+			sceneObject.color.r,
+			sceneObject.color.g,
+			sceneObject.color.b,
+			sceneObject.color.a);
+		description += color;
+	}
 
-	/****************************************************************/
+	return(description);
 }
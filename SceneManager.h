@@ -10,9 +10,26 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "PrimitiveMeshes.h"
+#include "SceneGraph.h"
+#include "UniformCache.h"
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+#include "Profiler.h"
+#include "Frustum.h"
+#include "TransformKernel.h"
+#include "JobSystem.h"
+#include "IndirectRenderer.h"
+#include "ShaderCache.h"
+#include "ClusteredLighting.h"
+#include "SceneFile.h"
+#include "RingBuffer.h"
+#include "OcclusionCuller.h"
+#include "ShadowMaps.h"
+#include "BoundingVolumeHierarchy.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /***********************************************************
@@ -32,7 +49,15 @@ public:
 	struct TEXTURE_INFO
 	{
 		std::string tag;
+		// texture array holding the texture, 0 until allocated
 		uint32_t ID;
+		// texture array group and the layer within it
+		int group;
+		int layer;
+		int width;
+		int height;
+		// image file decoded into the layer once allocated
+		std::string filename;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,72 +70,438 @@ public:
 		std::string tag;
 	};
 
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// defined object materials stored as one contiguous
+	// array per material value, indexed by material handle
+	struct MATERIAL_ARRAYS
+	{
+		std::vector<float> ambientStrength;
+		std::vector<glm::vec3> ambientColor;
+		std::vector<glm::vec3> diffuseColor;
+		std::vector<glm::vec3> specularColor;
+		std::vector<float> shininess;
+	};
+
+	// basic meshes that can be drawn for a scene object
+	enum MESH_TYPE
+	{
+		MESH_PLANE,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_CYLINDER,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS,
+		MESH_BOX
+	};
+
+	struct SCENE_OBJECT
+	{
+		// scene graph node that supplies the model matrix
+		int node;
+		MESH_TYPE mesh;
+		// mesh parts that are drawn for the object
+		int nParts;
+		PrimitiveMeshes::MESH_PART parts[3];
+		// texture slot or solid color for the object surface
+		bool bUseTexture;
+		int textureSlot;
+		glm::vec4 color;
+		// handle of the object material
+		int material;
+		// render state key used for sorting the draw list
+		uint64_t sortKey;
+		// bounding box of the drawn parts in mesh space
+		glm::vec3 localMin;
+		glm::vec3 localMax;
+		// level of detail the object is drawn at, and the level
+		// it is cross-fading to (-1 when it is not fading) with
+		// the frames of the fade done so far
+		int lod;
+		int fadeLod;
+		int fadeFrame;
+	};
+
+	struct DRAW_COMMAND
+	{
+		// render state key of the object part
+		uint64_t sortKey;
+		// index of the object in the retained scene objects
+		int object;
+		// mesh part of the object that is drawn
+		PrimitiveMeshes::MESH_PART part;
+		// level of detail of the part and its dithered fade
+		int lod;
+		int lodFade;
+		// clip space w of the object center, so the draws of
+		// the same render state go from front to back
+		float depth;
+	};
+
+	// consecutive instances drawn with one instanced draw
+	struct INSTANCE_BATCH
+	{
+		PrimitiveMeshes::MESH_PART part;
+		int lod;
+		bool bUseTexture;
+		// texture array group bound for the batch
+		int textureGroup;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// camera and viewport of one view of the scene
+	struct SCENE_VIEW
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		// viewport in framebuffer pixels, a width of 0 draws
+		// into the viewport that is already set
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// most views drawn from one recorded draw list
+	static const int MAX_VIEWS = BoundingVolumeHierarchy::MAX_FRUSTA;
+
 private:
+	// camera values of a view, worked out once per frame
+	// shadow matrix uniform of one shader program
+	struct SHADOW_UNIFORMS
+	{
+		GLint matricesLocation;
+		int matrixVersion;
+	};
+
+	struct VIEW_STATE
+	{
+		SCENE_VIEW setup;
+		Frustum frustum;
+		glm::vec4 clipRowW;
+		float projectionScale;
+	};
+
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
+	PrimitiveMeshes* m_basicMeshes;
 	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture arrays holding the loaded textures as layers
+	TextureArrays* m_pTextureArrays;
+	// texture slot for each loaded texture tag
+	std::unordered_map<std::string, int> m_textureSlots;
 	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	MATERIAL_ARRAYS m_objectMaterials;
+	// material handle for each defined material tag
+	std::unordered_map<std::string, int> m_materialHandles;
+	// defined light sources
+	std::vector<LIGHT_SOURCE> m_lightSources;
+	// small point lights, binned into view space clusters so
+	// that each fragment only adds up the ones that reach it
+	std::vector<ClusteredLighting::POINT_LIGHT> m_pointLights;
+	ClusteredLighting* m_pClusteredLighting;
+	// uniform buffer objects holding all materials and lights
+	GLuint m_materialBuffer;
+	GLuint m_lightBuffer;
+	// retained transform hierarchy for the scene
+	SceneGraph* m_pSceneGraph;
+	// retained objects drawn every frame
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// binary scene file the objects are built from, mapped
+	// while the scene is prepared; the built in objects are
+	// used when no file name is set
+	SceneFile* m_pSceneFile;
+	std::string m_sceneFilename;
+	// draws recorded for the current frame
+	std::vector<DRAW_COMMAND> m_drawList;
+	// sorted draws recorded by each chunk of objects, merged
+	// into the draw list through the merge buffer
+	std::vector<std::vector<DRAW_COMMAND>> m_chunkLists;
+	std::vector<int> m_chunkCulled;
+	std::vector<int> m_chunkOccluded;
+	std::vector<int> m_chunkFading;
+	std::vector<DRAW_COMMAND> m_mergeBuffer;
+	// per-instance data and batches built from the draw list
+	std::vector<PrimitiveMeshes::INSTANCE_DATA> m_instances;
+	std::vector<INSTANCE_BATCH> m_batches;
+	// ring buffer the instance data of each frame is written
+	// into, and where the current frame's instances start in
+	// it; the instances go to m_instances when it cannot be
+	// mapped
+	RingBuffer* m_pFrameData;
+	PrimitiveMeshes::INSTANCE_DATA* m_pFrameInstances;
+	GLintptr m_frameInstanceOffset;
+	// last uploaded values of the per-draw uniforms
+	UniformCache* m_pUniformCache;
+	// background decoder for the scene textures
+	TextureLoader* m_pTextureLoader;
+	// frame profiler, NULL when the scene is not profiled
+	Profiler* m_pProfiler;
+	// thread pool for building the draw list, NULL when the
+	// draw list is built on the OpenGL thread alone
+	JobSystem* m_pJobSystem;
+	// builds and caches the scene shader programs, NULL when
+	// they are compiled from source directly
+	ShaderCache* m_pShaderCache;
+	// fragment shader variants for solid colored and textured
+	// objects, each lit by a constant number of lights, and the
+	// depth only variant of the depth pre-pass
+	enum SHADER_VARIANT
+	{
+		VARIANT_COLOR,
+		VARIANT_TEXTURED,
+		VARIANT_DEPTH,
+		VARIANT_COUNT
+	};
+	// shader cache handles of the variants still compiling,
+	// and the programs of the finished ones
+	int m_variantHandles[VARIANT_COUNT];
+	GLuint m_variantPrograms[VARIANT_COUNT];
+	// program of the shader manager, which branches at run
+	// time and is drawn with until a variant is ready
+	GLuint m_baseProgram;
+	// program the current draws are submitted with
+	GLuint m_activeProgram;
+	// programs bound while drawing the last frame
+	int m_programSwitches;
+	// views of the frame, which share the culling, the levels
+	// of detail and the sorted draw list
+	std::vector<VIEW_STATE> m_views;
+	// camera matrices of the view being drawn, set again on
+	// each variant
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// GPU culling and multi-draw indirect, used instead of the
+	// per-frame draw list when OpenGL 4.3 is available
+	IndirectRenderer* m_pIndirectRenderer;
+	std::vector<IndirectRenderer::CANDIDATE> m_candidates;
+	std::vector<IndirectRenderer::INDIRECT_COMMAND> m_indirectCommands;
+	// the candidates need to be uploaded again
+	bool m_bIndirectDirty;
+	// view frustum of the view being drawn
+	Frustum m_frustum;
+	bool m_bCullingEnabled;
+	// world space bounds of the objects, by object index
+	TransformKernel::BOUNDS_ARRAYS m_worldBounds;
+	// one bit per object, set when it is inside the frustum
+	std::vector<uint32_t> m_visibleBits;
+	// tree over the world bounds, refitted where objects move,
+	// which the frustum culling and picking are done with
+	BoundingVolumeHierarchy* m_pBvh;
+	std::vector<int> m_movedObjects;
+	std::vector<BoundingVolumeHierarchy::RAY_HIT> m_rayHits;
+	// the world bounds need to be recalculated
+	bool m_bBoundsDirty;
+	// number of objects culled in the last recorded frame
+	int m_culledObjects;
+	// the depth of the opaque draws is written first, so the
+	// shading pass only shades the fragments that are seen
+	bool m_bDepthPrepassEnabled;
+	// the meshes are loaded in the compact vertex layout
+	bool m_bCompactVertices;
+	// the demo strip of point lights is added to the scene
+	bool m_bDemoPointLights;
+	// objects hidden in the last frame are skipped, found by
+	// occlusion queries against the depth of each frame
+	OcclusionCuller* m_pOcclusionCuller;
+	bool m_bOcclusionCullingEnabled;
+	int m_occludedObjects;
+	// shadow maps of the first light sources, redrawn only
+	// where objects have moved, and the parts drawn into them
+	ShadowMaps* m_pShadowMaps;
+	std::vector<ShadowMaps::SHADOW_CASTER> m_shadowCasters;
+	// location of the shadow matrices in each program, and the
+	// matrix version last uploaded to it
+	std::unordered_map<GLuint, SHADOW_UNIFORMS> m_shadowUniforms;
+	// fourth row of projection * view and the vertical
+	// projection scale of the view being drawn, used for the
+	// projected object sizes
+	glm::vec4 m_clipRowW;
+	float m_projectionScale;
+	// levels of detail are picked by projected size, and
+	// objects changing level are cross-faded
+	bool m_bLodEnabled;
+	bool m_bLodFadeEnabled;
+	// the next frame would differ from the last one drawn,
+	// even when the camera has not moved
+	bool m_bSceneChanged;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
+	bool CreateGLTexture(const char* filename, const std::string& tag);
+	// allocate the texture arrays and queue the images for them
+	void AllocateGLTextures();
+	// bind the texture arrays to units in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
+	int FindTextureID(const std::string& tag);
+	int FindTextureSlot(const std::string& tag);
+	// add a material to the defined materials
+	int AddMaterial(const OBJECT_MATERIAL& material);
+	// find the handle of a defined material by tag
+	int FindMaterial(const std::string& tag);
+	// add a light source to the defined lights
+	int AddLightSource(const LIGHT_SOURCE& light);
+	// add a point light to the clustered lights
+	int AddPointLight(const ClusteredLighting::POINT_LIGHT& light);
+
+	// copy the defined materials and lights into
+	// their uniform buffer objects
+	void UploadMaterialBuffer();
+	void UploadLightBuffer();
+
+	// set the texture array data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		int textureGroup);
+
+	// request the shader variants from the shader cache
+	void RequestShaderVariants();
+	// bind a shader program for the following draws
+	void UseProgram(GLuint program);
+	// bind a shader variant, false is returned when the base
+	// program had to be bound as the variant is not ready
+	bool UseShaderVariant(SHADER_VARIANT variant);
+	// set the point light clusters of the frame into the
+	// bound program
+	void SetClusterUniforms();
+	// set the shadow maps of the lights into the bound program
+	void SetShadowUniforms();
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
-
 	// load appropriate textures for the scene
 	void LoadSceneTextures();
 
-	// draw the lemon object
-	void DrawLemon();
+	// add a textured object to the retained scene
+	void AddTexturedObject(
+		int node,
+		MESH_TYPE mesh,
+		const std::string& textureTag,
+		const std::string& materialTag,
+		bool bDrawTop = true,
+		bool bDrawBottom = true,
+		bool bDrawSides = true);
+
+	// add a solid colored object to the retained scene
+	void AddColoredObject(
+		int node,
+		MESH_TYPE mesh,
+		glm::vec4 color,
+		const std::string& materialTag,
+		bool bDrawTop = true,
+		bool bDrawBottom = true,
+		bool bDrawSides = true);
 
-	// draw the chapstick object
-	void DrawChapstick();
+	// add an object by texture slot and material handle
+	void AddSceneObject(
+		int node,
+		MESH_TYPE mesh,
+		int textureSlot,
+		glm::vec4 color,
+		int material,
+		bool bDrawTop,
+		bool bDrawBottom,
+		bool bDrawSides);
 
-	// draw the water object
-	void DrawWater();
+	// add the textures, materials and objects of the scene file
+	void AddSceneFileTextures();
+	void AddSceneFileMaterials();
+	void BuildSceneFileObjects();
 
-	// draw the craft set object
-	void DrawCraftSet();
+	// set the mesh parts that are drawn for an object
+	void SetObjectParts(
+		SCENE_OBJECT& object,
+		bool bDrawTop,
+		bool bDrawBottom,
+		bool bDrawSides);
+
+	// build the render state sort key for an object
+	uint64_t BuildSortKey(const SCENE_OBJECT& object);
+
+	// set the mesh space bounds of an object from its parts
+	void SetObjectBounds(SCENE_OBJECT& object);
+	// recalculate the world bounds of every object
+	void UpdateObjectBounds();
+	// mark the shadows in the world bounds of the moved objects
+	void InvalidateMovedShadows();
+	// refit the tree over the world bounds to the moved objects
+	void UpdateBoundsTree();
+	// redraw the parts of the shadow maps that objects moved in
+	int UpdateShadowMaps();
+	// run a function over chunks of [0, count) on the job system
+	void RunParallel(int count, int chunkSize, const JobSystem::JOB_FUNCTION& function);
+	// get the fraction of the view height an object covers
+	float GetScreenSize(int object) const;
+	// pick the level of detail for a projected size
+	int SelectLod(float screenSize, int currentLod) const;
+	// advance the level of detail and fade of an object
+	void UpdateObjectLod(SCENE_OBJECT& object, int index);
+	// cull, pick the levels of detail, record and sort the
+	// draws of one chunk of objects
+	void RecordDrawChunk(int chunk, bool bViewDependent);
+	// merge the sorted chunk lists into the draw list
+	void MergeDrawChunks();
+
+	// record, sort, batch and submit the draw list
+	void RecordDrawList(bool bViewDependent);
+	void BuildInstanceBatches(PrimitiveMeshes::INSTANCE_DATA* pInstances);
+	// reserve the instance data of the frame in the ring buffer
+	PrimitiveMeshes::INSTANCE_DATA* BeginFrameInstances();
+	void SubmitDrawList();
+	// draw the batches into the current view
+	void SubmitViewDraws(bool bFrameData);
+	// make a view the one being drawn, and set its viewport
+	void ApplyView(int index);
+	// make a view the one being drawn before its draws are
+	// submitted, with its lights binned and camera uniforms set
+	void BeginView(int index);
+	// set the camera, cluster and shadow uniforms into the
+	// bound program
+	void SetCameraUniforms();
+	// draw one batch from the instances of the frame
+	void DrawBatch(const INSTANCE_BATCH& batch, bool bFrameData);
+	// set the depth and color writes of the depth pre-pass and
+	// the shading pass after it; the pre-pass is skipped and
+	// false returned when it is off or its variant not ready
+	bool BeginDepthPrepass();
+	void BeginShadingPass(bool bPrepass);
+	void EndShadingPass(bool bPrepass);
+	// query the objects in the frustum against the depth of
+	// the frame, for the draw list of the next frame
+	void IssueOcclusionQueries();
+	// upload every object part as a GPU culling candidate
+	void BuildIndirectDrawData();
+	// draw the commands written by the GPU culling pass
+	void SubmitIndirectDraws();
+
+	// build the countertop object
+	void BuildCountertop();
+
+	// build the lemon object
+	void BuildLemon();
+
+	// build the chapstick object
+	void BuildChapstick();
+
+	// build the water object
+	void BuildWater();
+
+	// build the craft set object
+	void BuildCraftSet();
 
 public:
 
@@ -124,4 +515,64 @@ public:
 	// pre-define the object materials for lighting
 	void DefineObjectMaterials();
 
+	// check whether all scene textures have been uploaded
+	bool AreTexturesLoaded();
+	// block until all scene textures have been uploaded
+	void WaitForTextures();
+
+	// check whether the scene would look different when drawn
+	// again with the same camera
+	bool IsSceneChanged() const;
+
+	// set the profiler that records the scene rendering
+	void SetProfiler(Profiler* pProfiler);
+	// set the thread pool the draw list is built on
+	void SetJobSystem(JobSystem* pJobSystem);
+	// set the shader cache the scene shaders are built with,
+	// must be called before PrepareScene()
+	void SetShaderCache(ShaderCache* pShaderCache);
+	// set a binary scene file to build the objects from instead
+	// of the built in scene, must be called before PrepareScene()
+	void SetSceneFile(const char* filename);
+
+	// set the camera matrices the objects are culled against,
+	// drawing a single view into the current viewport
+	void SetViewProjection(
+		const glm::mat4& view,
+		const glm::mat4& projection);
+	// set up to MAX_VIEWS views that are drawn each frame,
+	// culled together and drawn from one sorted draw list
+	void SetViews(const SCENE_VIEW* pViews, int viewCount);
+	// turn view frustum culling on or off
+	void SetCullingEnabled(bool bEnabled);
+	// turn level of detail selection on or off, every object
+	// is drawn at full detail when it is off
+	void SetLodEnabled(bool bEnabled);
+	// turn the dithered fade between levels of detail on or off
+	void SetLodCrossFade(bool bEnabled);
+	// turn the depth pre-pass on or off
+	void SetDepthPrepassEnabled(bool bEnabled);
+	// load the meshes in the compact vertex layout instead of
+	// the full one, must be called before PrepareScene()
+	void SetCompactVerticesEnabled(bool bEnabled);
+	// add the demo strip of point lights, must be called
+	// before PrepareScene()
+	void SetDemoPointLightsEnabled(bool bEnabled);
+	// turn occlusion culling on or off, which only applies
+	// when the draw list is built on the CPU
+	void SetOcclusionCullingEnabled(bool bEnabled);
+
+	// find the object whose mesh space box a world space ray
+	// hits first, -1 when it hits none
+	int PickObject(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance);
+	// find the objects whose world bounds overlap a box
+	void FindObjectsInBox(
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		std::vector<int>& objects) const;
+	// get the mesh, material and texture tags of an object
+	std::string GetObjectDescription(int object) const;
 };
\ No newline at end of file
@@ -0,0 +1,607 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.cpp
+// ============
+// cache linked shader programs on disk and compile them in the background
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// identifies a program binary cache file - "PGB1"
+	const uint32_t CACHE_FILE_MAGIC = 0x31424750;
+	const uint32_t CACHE_FILE_VERSION = 1;
+
+	// layout of the start of a cache file, followed by the
+	// program binary
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		// hash of the sources, defines and driver, checked in
+		// case two programs share a file name
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+
+	// 64 bit FNV-1a hash parameters
+	const uint64_t HASH_OFFSET = 0xCBF29CE484222325ULL;
+	const uint64_t HASH_PRIME = 0x100000001B3ULL;
+
+	/***********************************************************
+	 *  HashString()
+	 *
+	 *  Adds the characters of a string and a terminator to an
+	 *  FNV-1a hash.
+	 ***********************************************************/
+	uint64_t HashString(uint64_t hash, const std::string& text)
+	{
+		for (size_t index = 0; index < text.size(); index++)
+		{
+			hash = (hash ^ (uint8_t)text[index]) * HASH_PRIME;
+		}
+
+		return((hash ^ 0xFF) * HASH_PRIME);
+	}
+
+	/***********************************************************
+	 *  GetGLString()
+	 *
+	 *  Gets an OpenGL description string, never NULL.
+	 ***********************************************************/
+	std::string GetGLString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+
+		return((value != NULL) ? std::string((const char*)value) : std::string("unknown"));
+	}
+}
+
+/***********************************************************
+ *  ShaderCache()
+ *
+ *  The constructor for the class.  It must be created once
+ *  the OpenGL context is current, since the driver support
+ *  is checked here.
+ ***********************************************************/
+ShaderCache::ShaderCache()
+{
+	GLint formatCount = 0;
+
+	m_bBinarySupported = false;
+	if ((GLEW_VERSION_4_1) || (GLEW_ARB_get_program_binary))
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		m_bBinarySupported = (formatCount > 0);
+	}
+
+	// let the driver use as many compiler threads as it likes
+	m_bParallelCompile = (GLEW_KHR_parallel_shader_compile) ? true : false;
+	if (m_bParallelCompile == true)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
+	// a binary is only valid for the driver that saved it
+	m_driverName = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION);
+}
+
+/***********************************************************
+ *  ~ShaderCache()
+ *
+ *  The destructor for the class.  Finished programs belong
+ *  to the code that requested them, only the programs still
+ *  compiling are freed here.
+ ***********************************************************/
+ShaderCache::~ShaderCache()
+{
+	for (size_t handle = 0; handle < m_programs.size(); handle++)
+	{
+		PROGRAM_ENTRY& entry = m_programs[handle];
+
+		if (entry.state == PROGRAM_COMPILING)
+		{
+			for (size_t shader = 0; shader < entry.shaders.size(); shader++)
+			{
+				glDeleteShader(entry.shaders[shader]);
+			}
+			glDeleteProgram(entry.program);
+		}
+	}
+	m_programs.clear();
+}
+
+/***********************************************************
+ *  SetCacheDirectory()
+ *
+ *  This method is used for turning on the program binary
+ *  cache.  The directory is created when it does not exist.
+ *  The cache is only used when the driver supports program
+ *  binaries.
+ ***********************************************************/
+void ShaderCache::SetCacheDirectory(const char* directory)
+{
+	std::error_code error;
+
+	m_cacheDirectory = directory;
+
+	std::filesystem::create_directories(m_cacheDirectory, error);
+	if (error)
+	{
+		std::cout << "Could not create shader cache directory:" << m_cacheDirectory << std::endl;
+		m_cacheDirectory.clear();
+	}
+}
+
+/***********************************************************
+ *  ReadSource()
+ *
+ *  This method is used for reading the source of a shader
+ *  stage.  The defines are added after the #version line,
+ *  which must stay the first line of the source.
+ ***********************************************************/
+bool ShaderCache::ReadSource(const std::string& filename, const std::string& defines, std::string& source) const
+{
+	std::ifstream shaderFile(filename.c_str());
+	std::stringstream sourceStream;
+	size_t insertAt = 0;
+
+	if (shaderFile.is_open() == false)
+	{
+		std::cout << "Could not open shader:" << filename << std::endl;
+		return(false);
+	}
+
+	sourceStream << shaderFile.rdbuf();
+	source = sourceStream.str();
+
+	if (defines.empty() == false)
+	{
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			insertAt = source.find('\n');
+			insertAt = (insertAt == std::string::npos) ? source.size() : insertAt + 1;
+		}
+		source.insert(insertAt, defines + "\n");
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildKey()
+ *
+ *  This method is used for hashing the final sources of a
+ *  program together with the driver name, so that a change
+ *  to any of them selects a different cache file.
+ ***********************************************************/
+uint64_t ShaderCache::BuildKey(const std::vector<std::string>& sources, const std::string& defines) const
+{
+	uint64_t key = HASH_OFFSET;
+
+	key = HashString(key, m_driverName);
+	key = HashString(key, defines);
+	for (size_t index = 0; index < sources.size(); index++)
+	{
+		key = HashString(key, sources[index]);
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cache file
+ *  for a program.  The file is named after its first shader
+ *  and the program key.
+ ***********************************************************/
+std::string ShaderCache::GetCachePath(const PROGRAM_ENTRY& entry) const
+{
+	std::ostringstream cachePath;
+	std::filesystem::path sourcePath(entry.stages[0].filename);
+
+	cachePath << m_cacheDirectory << "/" << sourcePath.stem().string()
+		<< "_" << std::hex << entry.key << ".progbin";
+
+	return(cachePath.str());
+}
+
+/***********************************************************
+ *  ReadCacheFile()
+ *
+ *  This method is used for creating a program from the
+ *  binary in its cache file.  False is returned when there is
+ *  no cache file, or when the driver rejects the binary, for
+ *  example after a driver update.
+ ***********************************************************/
+bool ShaderCache::ReadCacheFile(PROGRAM_ENTRY& entry) const
+{
+	CACHE_FILE_HEADER header;
+	GLint bLinked = GL_FALSE;
+
+	if ((m_cacheDirectory.empty() == true) || (m_bBinarySupported == false))
+	{
+		return(false);
+	}
+
+	std::ifstream cacheFile(GetCachePath(entry).c_str(), std::ios::binary);
+	if (!cacheFile)
+	{
+		return(false);
+	}
+
+	cacheFile.read((char*)&header, sizeof(header));
+	if ((!cacheFile) ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.key != entry.key) ||
+		(header.binarySize == 0))
+	{
+		return(false);
+	}
+
+	std::vector<char> binary(header.binarySize);
+	cacheFile.read(binary.data(), binary.size());
+	if (!cacheFile)
+	{
+		return(false);
+	}
+
+	entry.program = glCreateProgram();
+	glProgramBinary(entry.program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+	glGetProgramiv(entry.program, GL_LINK_STATUS, &bLinked);
+	if (bLinked == GL_FALSE)
+	{
+		glDeleteProgram(entry.program);
+		entry.program = 0;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteCacheFile()
+ *
+ *  This method is used for saving the binary of a linked
+ *  program to its cache file.  This only happens the first
+ *  time a program is built with a driver.
+ ***********************************************************/
+void ShaderCache::WriteCacheFile(const PROGRAM_ENTRY& entry) const
+{
+	CACHE_FILE_HEADER header;
+	GLint binaryLength = 0;
+	GLsizei writtenLength = 0;
+	GLenum binaryFormat = 0;
+
+	if ((m_cacheDirectory.empty() == true) || (m_bBinarySupported == false))
+	{
+		return;
+	}
+
+	glGetProgramiv(entry.program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(binaryLength);
+	glGetProgramBinary(entry.program, binaryLength, &writtenLength, &binaryFormat, binary.data());
+	if (writtenLength <= 0)
+	{
+		return;
+	}
+
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.key = entry.key;
+	header.binaryFormat = binaryFormat;
+	header.binarySize = (uint32_t)writtenLength;
+
+	std::ofstream cacheFile(GetCachePath(entry).c_str(), std::ios::binary | std::ios::trunc);
+	if (!cacheFile)
+	{
+		std::cout << "Could not write shader cache for:" << entry.stages[0].filename << std::endl;
+		return;
+	}
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write(binary.data(), writtenLength);
+}
+
+/***********************************************************
+ *  FinishProgram()
+ *
+ *  This method is used for checking the compile and link
+ *  results of a program once the driver has finished it.
+ *  The shaders are freed, and a linked program is saved to
+ *  the cache.  These queries wait for the driver when it is
+ *  still compiling.
+ ***********************************************************/
+void ShaderCache::FinishProgram(PROGRAM_ENTRY& entry)
+{
+	GLint bSuccess = GL_FALSE;
+	char infoLog[1024];
+	bool bCompiled = true;
+
+	for (size_t index = 0; index < entry.shaders.size(); index++)
+	{
+		GLuint shader = entry.shaders[index];
+
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bSuccess);
+		if (bSuccess == GL_FALSE)
+		{
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Shader compile failed:" << entry.stages[index].filename << std::endl << infoLog << std::endl;
+			bCompiled = false;
+		}
+		glDetachShader(entry.program, shader);
+		glDeleteShader(shader);
+	}
+	entry.shaders.clear();
+
+	glGetProgramiv(entry.program, GL_LINK_STATUS, &bSuccess);
+	if ((bCompiled == false) || (bSuccess == GL_FALSE))
+	{
+		glGetProgramInfoLog(entry.program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Shader program link failed:" << entry.stages[0].filename << std::endl << infoLog << std::endl;
+		glDeleteProgram(entry.program);
+		entry.program = 0;
+		entry.state = PROGRAM_FAILED;
+		return;
+	}
+
+	entry.state = PROGRAM_READY;
+	WriteCacheFile(entry);
+}
+
+/***********************************************************
+ *  RequestProgram()
+ *
+ *  This method is used for requesting a program built from
+ *  the passed in shader stages.  A current cache file makes
+ *  the program ready at once; otherwise the stages are
+ *  compiled and linked, in the background when the driver
+ *  supports it.  The handle of the program is returned, or
+ *  -1 when a source file could not be read.
+ ***********************************************************/
+int ShaderCache::RequestProgram(
+	const std::vector<SHADER_STAGE>& stages,
+	const std::string& defines)
+{
+	std::vector<std::string> sources(stages.size());
+	PROGRAM_ENTRY entry;
+
+	if (stages.size() == 0)
+	{
+		return(-1);
+	}
+
+	for (size_t index = 0; index < stages.size(); index++)
+	{
+		if (ReadSource(stages[index].filename, defines, sources[index]) == false)
+		{
+			return(-1);
+		}
+	}
+
+	entry.stages = stages;
+	entry.defines = defines;
+	entry.program = 0;
+	entry.state = PROGRAM_COMPILING;
+	entry.key = BuildKey(sources, defines);
+
+	if (ReadCacheFile(entry) == true)
+	{
+		std::cout << "Successfully loaded cached shader program:" << stages[0].filename << std::endl;
+		entry.state = PROGRAM_READY;
+		m_programs.push_back(entry);
+		return((int)m_programs.size() - 1);
+	}
+
+	entry.program = glCreateProgram();
+	for (size_t index = 0; index < stages.size(); index++)
+	{
+		const char* pSource = sources[index].c_str();
+		GLuint shader = glCreateShader(stages[index].type);
+
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+		glAttachShader(entry.program, shader);
+		entry.shaders.push_back(shader);
+	}
+
+	// the binary can only be read back when this is set
+	// before linking
+	if (m_bBinarySupported == true)
+	{
+		glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(entry.program);
+
+	m_programs.push_back(entry);
+
+	if (m_bParallelCompile == false)
+	{
+		FinishProgram(m_programs.back());
+	}
+
+	return((int)m_programs.size() - 1);
+}
+
+/***********************************************************
+ *  RequestProgram()
+ *
+ *  This method is used for requesting a program built from a
+ *  vertex and a fragment shader.
+ ***********************************************************/
+int ShaderCache::RequestProgram(
+	const char* vertexShaderFile,
+	const char* fragmentShaderFile,
+	const std::string& defines)
+{
+	std::vector<SHADER_STAGE> stages(2);
+
+	stages[0].type = GL_VERTEX_SHADER;
+	stages[0].filename = vertexShaderFile;
+	stages[1].type = GL_FRAGMENT_SHADER;
+	stages[1].filename = fragmentShaderFile;
+
+	return(RequestProgram(stages, defines));
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for building a vertex and fragment
+ *  shader program and waiting until it is ready.  The
+ *  program is returned, or 0 if it could not be built.
+ ***********************************************************/
+GLuint ShaderCache::LoadProgram(
+	const char* vertexShaderFile,
+	const char* fragmentShaderFile,
+	const std::string& defines)
+{
+	int handle = RequestProgram(vertexShaderFile, fragmentShaderFile, defines);
+
+	WaitForProgram(handle);
+
+	return(GetProgram(handle));
+}
+
+/***********************************************************
+ *  LoadComputeProgram()
+ *
+ *  This method is used for building a compute shader program
+ *  and waiting until it is ready.  The program is returned,
+ *  or 0 if it could not be built.
+ ***********************************************************/
+GLuint ShaderCache::LoadComputeProgram(
+	const char* computeShaderFile,
+	const std::string& defines)
+{
+	std::vector<SHADER_STAGE> stages(1);
+
+	stages[0].type = GL_COMPUTE_SHADER;
+	stages[0].filename = computeShaderFile;
+
+	int handle = RequestProgram(stages, defines);
+
+	WaitForProgram(handle);
+
+	return(GetProgram(handle));
+}
+
+/***********************************************************
+ *  ProcessPending()
+ *
+ *  This method is used for finishing the programs that the
+ *  driver has compiled and linked in the background.  It
+ *  never waits, so it can be called every frame.  The number
+ *  of programs that finished is returned.
+ ***********************************************************/
+int ShaderCache::ProcessPending()
+{
+	int finished = 0;
+
+	for (size_t handle = 0; handle < m_programs.size(); handle++)
+	{
+		PROGRAM_ENTRY& entry = m_programs[handle];
+		GLint bComplete = GL_FALSE;
+
+		if (entry.state != PROGRAM_COMPILING)
+		{
+			continue;
+		}
+
+		glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &bComplete);
+		if (bComplete == GL_TRUE)
+		{
+			FinishProgram(entry);
+			finished++;
+		}
+	}
+
+	return(finished);
+}
+
+/***********************************************************
+ *  WaitForProgram()
+ *
+ *  This method is used for finishing one program, waiting
+ *  for the driver if it is still being compiled.
+ ***********************************************************/
+void ShaderCache::WaitForProgram(int handle)
+{
+	if ((handle < 0) || (handle >= (int)m_programs.size()))
+	{
+		return;
+	}
+
+	if (m_programs[handle].state == PROGRAM_COMPILING)
+	{
+		FinishProgram(m_programs[handle]);
+	}
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of requested
+ *  programs that the driver is still compiling.
+ ***********************************************************/
+int ShaderCache::GetPendingCount() const
+{
+	int pending = 0;
+
+	for (size_t handle = 0; handle < m_programs.size(); handle++)
+	{
+		if (m_programs[handle].state == PROGRAM_COMPILING)
+		{
+			pending++;
+		}
+	}
+
+	return(pending);
+}
+
+/***********************************************************
+ *  IsProgramReady()
+ *
+ *  This method is used for checking whether a requested
+ *  program has been built and can be used.
+ ***********************************************************/
+bool ShaderCache::IsProgramReady(int handle) const
+{
+	if ((handle < 0) || (handle >= (int)m_programs.size()))
+	{
+		return(false);
+	}
+
+	return(m_programs[handle].state == PROGRAM_READY);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting a requested program, 0 is
+ *  returned until it is ready or when it could not be built.
+ ***********************************************************/
+GLuint ShaderCache::GetProgram(int handle) const
+{
+	if (IsProgramReady(handle) == false)
+	{
+		return(0);
+	}
+
+	return(m_programs[handle].program);
+}
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.h
+// ============
+// cache linked shader programs on disk and compile them in the background
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ShaderCache
+ *
+ *  This class builds the shader programs of the scene.  When
+ *  a cache directory is set and the driver supports program
+ *  binaries, each linked program is saved with
+ *  glGetProgramBinary() in a file keyed by a hash of its
+ *  sources, defines and the driver version, and later runs
+ *  load that file with glProgramBinary() instead of
+ *  compiling.  A stale or rejected binary is compiled again.
+ *
+ *  Programs are requested by handle.  With
+ *  GL_KHR_parallel_shader_compile the driver compiles and
+ *  links requested programs on its own threads while frames
+ *  are drawn, and ProcessPending() picks up the finished
+ *  ones; otherwise a request compiles at once.
+ ***********************************************************/
+class ShaderCache
+{
+public:
+	// constructor
+	ShaderCache();
+	// destructor
+	~ShaderCache();
+
+	// one shader stage of a program
+	struct SHADER_STAGE
+	{
+		GLenum type;
+		std::string filename;
+	};
+
+	enum PROGRAM_STATE
+	{
+		PROGRAM_COMPILING,
+		PROGRAM_READY,
+		PROGRAM_FAILED
+	};
+
+	struct PROGRAM_ENTRY
+	{
+		std::vector<SHADER_STAGE> stages;
+		// lines added after the #version line of every stage
+		std::string defines;
+		GLuint program;
+		// compiled shaders, attached until linking finishes
+		std::vector<GLuint> shaders;
+		PROGRAM_STATE state;
+		// hash of the sources, defines and driver
+		uint64_t key;
+	};
+
+private:
+	// directory the program binaries are kept in, empty when
+	// the binary cache is off
+	std::string m_cacheDirectory;
+	// the driver can save and load program binaries
+	bool m_bBinarySupported;
+	// the driver compiles in the background
+	bool m_bParallelCompile;
+	// vendor, renderer and version strings of the driver
+	std::string m_driverName;
+	// requested programs, indexed by handle
+	std::vector<PROGRAM_ENTRY> m_programs;
+
+	// read a stage source and add the defines after #version
+	bool ReadSource(const std::string& filename, const std::string& defines, std::string& source) const;
+	// hash the sources of a program with the driver name
+	uint64_t BuildKey(const std::vector<std::string>& sources, const std::string& defines) const;
+	// get the cache file of a program
+	std::string GetCachePath(const PROGRAM_ENTRY& entry) const;
+	// create a program from its cache file
+	bool ReadCacheFile(PROGRAM_ENTRY& entry) const;
+	// save the binary of a linked program
+	void WriteCacheFile(const PROGRAM_ENTRY& entry) const;
+	// check the compile and link results and free the shaders
+	void FinishProgram(PROGRAM_ENTRY& entry);
+
+public:
+	// turn on the program binary cache, the directory is
+	// created when it does not exist
+	void SetCacheDirectory(const char* directory);
+
+	// request a program, the handle is returned or -1 when a
+	// source file could not be read
+	int RequestProgram(
+		const std::vector<SHADER_STAGE>& stages,
+		const std::string& defines = "");
+	int RequestProgram(
+		const char* vertexShaderFile,
+		const char* fragmentShaderFile,
+		const std::string& defines = "");
+
+	// build a program and wait for it, 0 is returned on failure
+	GLuint LoadProgram(
+		const char* vertexShaderFile,
+		const char* fragmentShaderFile,
+		const std::string& defines = "");
+	GLuint LoadComputeProgram(
+		const char* computeShaderFile,
+		const std::string& defines = "");
+
+	// finish the programs the driver has compiled, the number
+	// of programs that finished is returned
+	int ProcessPending();
+	// finish a program, waiting for the driver when needed
+	void WaitForProgram(int handle);
+	// get the number of programs that are still compiling
+	int GetPendingCount() const;
+
+	// check whether a program is ready to be used
+	bool IsProgramReady(int handle) const;
+	// get a program, 0 until it is ready or when it failed
+	GLuint GetProgram(int handle) const;
+};
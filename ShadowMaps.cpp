@@ -0,0 +1,514 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// cached shadow maps of the static lights, redrawn only where objects move
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+#include "FrameArena.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+// declaration of the global variables and defines
+namespace
+{
+	// width and height of every face in pixels
+	const int SHADOW_MAP_SIZE = 512;
+
+	// depth range of the faces, nothing past the far plane
+	// casts a shadow
+	const float SHADOW_NEAR_PLANE = 0.5f;
+	const float SHADOW_FAR_PLANE = 150.0f;
+
+	// depth offset of the drawn casters, so that lit surfaces
+	// do not shadow themselves
+	const float SHADOW_OFFSET_FACTOR = 2.0f;
+	const float SHADOW_OFFSET_UNITS = 4.0f;
+
+	// pixels added around each dirty rectangle, for the
+	// filtering of the edges
+	const int DIRTY_RECT_MARGIN = 1;
+
+	// corners of a box, bit 0 picks x, bit 1 y and bit 2 z
+	const int CORNER_COUNT = 8;
+
+	// view direction and up vector of each face, in the order
+	// +X, -X, +Y, -Y, +Z, -Z
+	const glm::vec3 FACE_DIRECTIONS[ShadowMaps::FACE_COUNT] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 FACE_UP_VECTORS[ShadowMaps::FACE_COUNT] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	/***********************************************************
+	 *  OverlapsRect()
+	 *
+	 *  Checks whether two pixel rectangles, stored as minimum
+	 *  x, minimum y, maximum x and maximum y, overlap.
+	 ***********************************************************/
+	bool OverlapsRect(const int rect[4], int minX, int minY, int maxX, int maxY)
+	{
+		return((rect[0] < maxX) && (rect[2] > minX) &&
+			(rect[1] < maxY) && (rect[3] > minY));
+	}
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMaps::ShadowMaps()
+{
+	m_texture = 0;
+	m_framebuffer = 0;
+	m_lightCount = 0;
+	m_renderedFaces = 0;
+	m_matrixVersion = 0;
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	DestroyMaps();
+}
+
+/***********************************************************
+ *  DestroyMaps()
+ *
+ *  This method is used for freeing the depth texture array
+ *  and the framebuffer it is drawn through.
+ ***********************************************************/
+void ShadowMaps::DestroyMaps()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_texture != 0)
+	{
+		glDeleteTextures(1, &m_texture);
+		m_texture = 0;
+	}
+
+	m_faces.clear();
+	m_shadowMatrices.clear();
+	m_matrixVersion++;
+	m_lightCount = 0;
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for creating the shadow maps of the
+ *  passed in light positions, up to MAX_SHADOW_LIGHTS.  The
+ *  texture compares the looked up depth, so the fragment
+ *  shader gets a filtered shadow factor from one lookup.
+ ***********************************************************/
+void ShadowMaps::SetLights(const glm::vec3* pPositions, int lightCount)
+{
+	DestroyMaps();
+
+	m_lightCount = std::min(std::max(lightCount, 0), MAX_SHADOW_LIGHTS);
+	if ((NULL == pPositions) || (m_lightCount == 0))
+	{
+		m_lightCount = 0;
+		return;
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR_PLANE, SHADOW_FAR_PLANE);
+
+	m_faces.resize(m_lightCount * FACE_COUNT);
+	m_shadowMatrices.resize(m_faces.size());
+	for (int light = 0; light < m_lightCount; light++)
+	{
+		for (int face = 0; face < FACE_COUNT; face++)
+		{
+			SHADOW_FACE& shadowFace = m_faces[light * FACE_COUNT + face];
+			glm::mat4 view = glm::lookAt(
+				pPositions[light],
+				pPositions[light] + FACE_DIRECTIONS[face],
+				FACE_UP_VECTORS[face]);
+
+			shadowFace.viewProjection = projection * view;
+			shadowFace.frustum.Extract(shadowFace.viewProjection);
+			m_shadowMatrices[light * FACE_COUNT + face] = shadowFace.viewProjection;
+		}
+	}
+	m_matrixVersion++;
+
+	// the texture array of the first group of TextureArrays is
+	// bound on the active unit and never bound again
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previousTexture);
+
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+	glTexImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		GL_DEPTH_COMPONENT24,
+		SHADOW_MAP_SIZE,
+		SHADOW_MAP_SIZE,
+		(GLsizei)m_faces.size(),
+		0,
+		GL_DEPTH_COMPONENT,
+		GL_UNSIGNED_INT,
+		NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)previousTexture);
+
+	GLint previousFramebuffer = 0;
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	InvalidateAll();
+}
+
+/***********************************************************
+ *  InvalidateAll()
+ *
+ *  This method is used for marking every face of every light
+ *  to be drawn again in full.
+ ***********************************************************/
+void ShadowMaps::InvalidateAll()
+{
+	for (size_t index = 0; index < m_faces.size(); index++)
+	{
+		SHADOW_FACE& face = m_faces[index];
+
+		face.dirtyMinX = 0;
+		face.dirtyMinY = 0;
+		face.dirtyMaxX = SHADOW_MAP_SIZE;
+		face.dirtyMaxY = SHADOW_MAP_SIZE;
+	}
+}
+
+/***********************************************************
+ *  GetFaceRect()
+ *
+ *  This method is used for getting the pixels of a face that
+ *  a world space box covers, as minimum x, minimum y, maximum
+ *  x and maximum y.  A box that reaches behind the near plane
+ *  of the face is given the whole face.
+ ***********************************************************/
+bool ShadowMaps::GetFaceRect(
+	const SHADOW_FACE& face,
+	const glm::vec3& boxMin,
+	const glm::vec3& boxMax,
+	int rect[4]) const
+{
+	if (face.frustum.IsBoxVisible(boxMin, boxMax) == false)
+	{
+		return(false);
+	}
+
+	glm::vec2 ndcMin(1.0f);
+	glm::vec2 ndcMax(-1.0f);
+
+	for (int corner = 0; corner < CORNER_COUNT; corner++)
+	{
+		glm::vec4 clip = face.viewProjection * glm::vec4(
+			(corner & 1) ? boxMax.x : boxMin.x,
+			(corner & 2) ? boxMax.y : boxMin.y,
+			(corner & 4) ? boxMax.z : boxMin.z,
+			1.0f);
+
+		if (clip.w <= SHADOW_NEAR_PLANE)
+		{
+			ndcMin = glm::vec2(-1.0f);
+			ndcMax = glm::vec2(1.0f);
+			break;
+		}
+
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	ndcMin = glm::max(ndcMin, glm::vec2(-1.0f));
+	ndcMax = glm::min(ndcMax, glm::vec2(1.0f));
+
+	float scale = 0.5f * (float)SHADOW_MAP_SIZE;
+
+	rect[0] = std::max((int)std::floor((ndcMin.x + 1.0f) * scale) - DIRTY_RECT_MARGIN, 0);
+	rect[1] = std::max((int)std::floor((ndcMin.y + 1.0f) * scale) - DIRTY_RECT_MARGIN, 0);
+	rect[2] = std::min((int)std::ceil((ndcMax.x + 1.0f) * scale) + DIRTY_RECT_MARGIN, SHADOW_MAP_SIZE);
+	rect[3] = std::min((int)std::ceil((ndcMax.y + 1.0f) * scale) + DIRTY_RECT_MARGIN, SHADOW_MAP_SIZE);
+
+	return((rect[0] < rect[2]) && (rect[1] < rect[3]));
+}
+
+/***********************************************************
+ *  InvalidateBox()
+ *
+ *  This method is used for adding the pixels a world space
+ *  box covers to the dirty rectangle of every face it is
+ *  seen by.  It is called with the box an object moved out
+ *  of and the box it moved into.
+ ***********************************************************/
+void ShadowMaps::InvalidateBox(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	int rect[4];
+
+	for (size_t index = 0; index < m_faces.size(); index++)
+	{
+		SHADOW_FACE& face = m_faces[index];
+
+		if (GetFaceRect(face, boxMin, boxMax, rect) == false)
+		{
+			continue;
+		}
+
+		face.dirtyMinX = std::min(face.dirtyMinX, rect[0]);
+		face.dirtyMinY = std::min(face.dirtyMinY, rect[1]);
+		face.dirtyMaxX = std::max(face.dirtyMaxX, rect[2]);
+		face.dirtyMaxY = std::max(face.dirtyMaxY, rect[3]);
+	}
+}
+
+/***********************************************************
+ *  HasDirtyFaces()
+ *
+ *  This method is used for checking whether any face has
+ *  pixels that need to be drawn again.
+ ***********************************************************/
+bool ShadowMaps::HasDirtyFaces() const
+{
+	for (size_t index = 0; index < m_faces.size(); index++)
+	{
+		const SHADOW_FACE& face = m_faces[index];
+
+		if ((face.dirtyMinX < face.dirtyMaxX) && (face.dirtyMinY < face.dirtyMaxY))
+		{
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing the dirty rectangle of
+ *  each face.  The rectangle is cleared under the scissor
+ *  test, and only the casters whose boxes overlap it are
+ *  drawn, each run of the same part with one instanced draw
+ *  at full detail.  The framebuffer, viewport and program
+ *  are restored afterwards.
+ ***********************************************************/
+void ShadowMaps::Render(
+	PrimitiveMeshes* pMeshes,
+	GLuint depthProgram,
+	const std::vector<SHADOW_CASTER>& casters,
+	const TransformKernel::BOUNDS_ARRAYS& bounds)
+{
+	m_renderedFaces = 0;
+
+	if ((NULL == pMeshes) || (depthProgram == 0) || (m_framebuffer == 0))
+	{
+		return;
+	}
+
+	GLint previousFramebuffer = 0;
+	GLint previousViewport[4];
+	GLint previousProgram = 0;
+	GLint viewLocation = glGetUniformLocation(depthProgram, "view");
+	GLint projectionLocation = glGetUniformLocation(depthProgram, "projection");
+	glm::mat4 identity(1.0f);
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+	glUseProgram(depthProgram);
+	glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(identity));
+
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(SHADOW_OFFSET_FACTOR, SHADOW_OFFSET_UNITS);
+	glDepthMask(GL_TRUE);
+
+	// instances of the casters in a face, and the part of each
+	FrameVector<PrimitiveMeshes::INSTANCE_DATA> instances;
+	FrameVector<PrimitiveMeshes::MESH_PART> parts;
+	int rect[4];
+
+	instances.reserve(casters.size());
+	parts.reserve(casters.size());
+
+	for (size_t index = 0; index < m_faces.size(); index++)
+	{
+		SHADOW_FACE& face = m_faces[index];
+
+		if ((face.dirtyMinX >= face.dirtyMaxX) || (face.dirtyMinY >= face.dirtyMaxY))
+		{
+			continue;
+		}
+
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, (GLint)index);
+		glScissor(
+			face.dirtyMinX,
+			face.dirtyMinY,
+			face.dirtyMaxX - face.dirtyMinX,
+			face.dirtyMaxY - face.dirtyMinY);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		// gather the casters that reach into the rectangle
+		instances.clear();
+		parts.clear();
+		for (size_t caster = 0; caster < casters.size(); caster++)
+		{
+			int object = casters[caster].object;
+			glm::vec3 boxMin(bounds.minX[object], bounds.minY[object], bounds.minZ[object]);
+			glm::vec3 boxMax(bounds.maxX[object], bounds.maxY[object], bounds.maxZ[object]);
+
+			if ((GetFaceRect(face, boxMin, boxMax, rect) == false) ||
+				(OverlapsRect(rect, face.dirtyMinX, face.dirtyMinY, face.dirtyMaxX, face.dirtyMaxY) == false))
+			{
+				continue;
+			}
+
+			PrimitiveMeshes::INSTANCE_DATA instance;
+			instance.model = casters[caster].model;
+			instance.color = glm::vec4(0.0f);
+			instance.materialIndex = 0;
+			instance.bUseTexture = 0;
+			instance.textureLayer = 0;
+			instance.lodFade = 0;
+			instances.push_back(instance);
+			parts.push_back(casters[caster].part);
+		}
+
+		if (instances.size() > 0)
+		{
+			pMeshes->UploadInstances(instances.data(), (int)instances.size());
+			glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(face.viewProjection));
+
+			size_t runStart = 0;
+			for (size_t instance = 1; instance <= instances.size(); instance++)
+			{
+				if ((instance < instances.size()) && (parts[instance] == parts[runStart]))
+				{
+					continue;
+				}
+
+				pMeshes->DrawInstanced(
+					parts[runStart],
+					0,
+					(int)runStart,
+					(int)(instance - runStart));
+				runStart = instance;
+			}
+		}
+
+		face.dirtyMinX = SHADOW_MAP_SIZE;
+		face.dirtyMinY = SHADOW_MAP_SIZE;
+		face.dirtyMaxX = 0;
+		face.dirtyMaxY = 0;
+		m_renderedFaces++;
+	}
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_SCISSOR_TEST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding the depth texture array
+ *  to the passed in texture unit.
+ ***********************************************************/
+void ShadowMaps::BindTexture(GLuint unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  GetMatrixVersion()
+ *
+ *  This method is used for getting the count that changes
+ *  each time the face matrices are set.
+ ***********************************************************/
+int ShadowMaps::GetMatrixVersion() const
+{
+	return(m_matrixVersion);
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used for getting the number of lights
+ *  that have shadow maps.
+ ***********************************************************/
+int ShadowMaps::GetLightCount() const
+{
+	return(m_lightCount);
+}
+
+/***********************************************************
+ *  GetShadowMatrices()
+ *
+ *  This method is used for getting the view projection of
+ *  every face, FACE_COUNT for each light in layer order.
+ ***********************************************************/
+const glm::mat4* ShadowMaps::GetShadowMatrices() const
+{
+	return(m_shadowMatrices.data());
+}
+
+/***********************************************************
+ *  GetRenderedFaceCount()
+ *
+ *  This method is used for getting the number of faces the
+ *  last Render() drew.
+ ***********************************************************/
+int ShadowMaps::GetRenderedFaceCount() const
+{
+	return(m_renderedFaces);
+}
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// cached shadow maps of the static lights, redrawn only where objects move
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+#include "Frustum.h"
+#include "TransformKernel.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class holds a depth cube for each of the first
+ *  MAX_SHADOW_LIGHTS light sources, stored as FACE_COUNT
+ *  layers of one depth texture array so it works with
+ *  OpenGL 3.3.  The lights never move, so a face is drawn
+ *  once and then kept until an object moves inside it.
+ *
+ *  Each face keeps a dirty rectangle.  The box of a moved
+ *  object, where it was and where it is now, is projected
+ *  into every face it touches and added to the rectangle of
+ *  that face, and Render() only clears and redraws the
+ *  rectangles, with the objects that overlap them.  A static
+ *  scene costs nothing, and a moving object only costs the
+ *  pixels it covers in the faces it is seen by.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// constructor
+	ShadowMaps();
+	// destructor
+	~ShadowMaps();
+
+	// lights that cast shadows and the faces of each, these
+	// must match the values in the fragment shader
+	static const int MAX_SHADOW_LIGHTS = 4;
+	static const int FACE_COUNT = 6;
+
+	// one mesh part of an object drawn into the shadow maps
+	struct SHADOW_CASTER
+	{
+		PrimitiveMeshes::MESH_PART part;
+		// index of the object in the world bounds
+		int object;
+		glm::mat4 model;
+	};
+
+private:
+	// one face of the cube of a light
+	struct SHADOW_FACE
+	{
+		glm::mat4 viewProjection;
+		Frustum frustum;
+		// pixels that need to be drawn again, empty when the
+		// minimum is past the maximum
+		int dirtyMinX;
+		int dirtyMinY;
+		int dirtyMaxX;
+		int dirtyMaxY;
+	};
+
+	// depth texture array with FACE_COUNT layers per light
+	GLuint m_texture;
+	GLuint m_framebuffer;
+	int m_lightCount;
+	// faces of every light, in layer order
+	std::vector<SHADOW_FACE> m_faces;
+	// view projection of every face, for the fragment shader,
+	// and a count that changes whenever they change
+	std::vector<glm::mat4> m_shadowMatrices;
+	int m_matrixVersion;
+	// faces drawn by the last Render()
+	int m_renderedFaces;
+
+	// get the pixels of a face covered by a world space box,
+	// false is returned when the box is outside the face
+	bool GetFaceRect(
+		const SHADOW_FACE& face,
+		const glm::vec3& boxMin,
+		const glm::vec3& boxMax,
+		int rect[4]) const;
+	// free the texture and the framebuffer
+	void DestroyMaps();
+
+public:
+	// create the maps for the light positions, every face is
+	// drawn by the next Render()
+	void SetLights(const glm::vec3* pPositions, int lightCount);
+
+	// mark every face, or the part of each face that a world
+	// space box covers, to be drawn again
+	void InvalidateAll();
+	void InvalidateBox(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+	// check whether any face needs to be drawn
+	bool HasDirtyFaces() const;
+
+	// draw the dirty rectangles with a depth program that
+	// takes the instance layout of the passed in meshes; the
+	// casters must be sorted by part
+	void Render(
+		PrimitiveMeshes* pMeshes,
+		GLuint depthProgram,
+		const std::vector<SHADOW_CASTER>& casters,
+		const TransformKernel::BOUNDS_ARRAYS& bounds);
+
+	// bind the depth texture array to a texture unit
+	void BindTexture(GLuint unit) const;
+
+	// get the number of lights with shadows, and the face
+	// matrices, FACE_COUNT for each light
+	int GetLightCount() const;
+	const glm::mat4* GetShadowMatrices() const;
+	// get the count that changes with the face matrices, so a
+	// program only needs them uploaded again when it differs
+	int GetMatrixVersion() const;
+
+	// get the number of faces drawn by the last Render()
+	int GetRenderedFaceCount() const;
+};
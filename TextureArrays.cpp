@@ -0,0 +1,350 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// group scene textures into 2D texture arrays selected by layer index
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// neutral gray shown until the images have been uploaded
+	const unsigned char PLACEHOLDER_GRAY = 128;
+
+	// 4x4 blocks of the placeholder gray - both endpoints are
+	// gray in RGB565 with every index selecting endpoint 0
+	const unsigned char PLACEHOLDER_BC1_BLOCK[8] = { 0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0 };
+	const unsigned char PLACEHOLDER_BC3_ALPHA[8] = { 0xFF, 0xFF, 0, 0, 0, 0, 0, 0 };
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	m_maxLayers = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting the number of mipmap
+ *  levels in a full chain for the passed in size.
+ ***********************************************************/
+int TextureArrays::GetLevelCount(int width, int height)
+{
+	int levelCount = 1;
+
+	while ((width > 1) || (height > 1))
+	{
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		levelCount++;
+	}
+
+	return(levelCount);
+}
+
+/***********************************************************
+ *  ReserveLayer()
+ *
+ *  This method is used for reserving a layer for a texture.
+ *  The layer is added to a group with the same size and
+ *  format that has not been allocated yet, or a new group is
+ *  started.  False is returned if no layer can be reserved,
+ *  including when a new group would pass MAX_GROUPS.
+ ***********************************************************/
+bool TextureArrays::ReserveLayer(
+	int width,
+	int height,
+	int colorChannels,
+	GLenum internalFormat,
+	int& group,
+	int& layer)
+{
+	group = -1;
+	layer = -1;
+
+	if ((width <= 0) || (height <= 0) || (internalFormat == 0))
+	{
+		return(false);
+	}
+
+	if (m_maxLayers == 0)
+	{
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+	}
+
+	for (size_t index = 0; index < m_groups.size(); index++)
+	{
+		ARRAY_GROUP& candidate = m_groups[index];
+
+		if ((candidate.bAllocated == false) &&
+			(candidate.width == width) &&
+			(candidate.height == height) &&
+			(candidate.internalFormat == internalFormat) &&
+			(candidate.layerCount < m_maxLayers))
+		{
+			group = (int)index;
+			layer = candidate.layerCount;
+			candidate.layerCount++;
+			return(true);
+		}
+	}
+
+	if ((int)m_groups.size() >= MAX_GROUPS)
+	{
+		std::cout << "Too many texture sizes and formats, at most " << MAX_GROUPS
+			<< " are supported for a " << width << "x" << height << " texture" << std::endl;
+		return(false);
+	}
+
+	ARRAY_GROUP newGroup;
+	newGroup.textureID = 0;
+	newGroup.width = width;
+	newGroup.height = height;
+	newGroup.colorChannels = colorChannels;
+	newGroup.internalFormat = internalFormat;
+	newGroup.levelCount = GetLevelCount(width, height);
+	newGroup.layerCount = 1;
+	newGroup.bAllocated = false;
+	m_groups.push_back(newGroup);
+
+	group = (int)m_groups.size() - 1;
+	layer = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AllocateStorage()
+ *
+ *  This method is used for creating the texture array of
+ *  every group that has not been allocated yet, sized for
+ *  the layers reserved in it.  Layers reserved afterwards
+ *  start new groups.
+ ***********************************************************/
+void TextureArrays::AllocateStorage()
+{
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previousTexture);
+
+	for (size_t index = 0; index < m_groups.size(); index++)
+	{
+		ARRAY_GROUP& group = m_groups[index];
+
+		if (group.bAllocated == true)
+		{
+			continue;
+		}
+
+		glGenTextures(1, &group.textureID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, group.textureID);
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, group.levelCount - 1);
+
+		// allocate every mipmap level for all of the layers
+		int levelWidth = group.width;
+		int levelHeight = group.height;
+		for (int level = 0; level < group.levelCount; level++)
+		{
+			GLenum pixelFormat = (group.colorChannels == 4) ? GL_RGBA : GL_RGB;
+
+			glTexImage3D(
+				GL_TEXTURE_2D_ARRAY,
+				level,
+				group.internalFormat,
+				levelWidth,
+				levelHeight,
+				group.layerCount,
+				0,
+				pixelFormat,
+				GL_UNSIGNED_BYTE,
+				NULL);
+
+			levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+			levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+		}
+
+		FillPlaceholder(group);
+		group.bAllocated = true;
+
+		std::cout << "Allocated texture array:" << index << ", width:" << group.width << ", height:" << group.height << ", layers:" << group.layerCount << std::endl;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)previousTexture);
+}
+
+/***********************************************************
+ *  FillPlaceholder()
+ *
+ *  This method is used for filling every layer of the bound
+ *  array with gray.  Compressed arrays are filled with gray
+ *  blocks for every level, uncompressed arrays are filled at
+ *  the top level and the mipmaps are generated.
+ ***********************************************************/
+void TextureArrays::FillPlaceholder(const ARRAY_GROUP& group)
+{
+	bool bCompressed = (group.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ||
+		(group.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (bCompressed == true)
+	{
+		int blockSize = (group.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+		int blocksWide = (group.width + 3) / 4;
+		int blocksHigh = (group.height + 3) / 4;
+		std::vector<unsigned char> blocks((size_t)blocksWide * blocksHigh * blockSize);
+
+		for (size_t offset = 0; offset < blocks.size(); offset += blockSize)
+		{
+			if (blockSize == 16)
+			{
+				memcpy(&blocks[offset], PLACEHOLDER_BC3_ALPHA, 8);
+				memcpy(&blocks[offset + 8], PLACEHOLDER_BC1_BLOCK, 8);
+			}
+			else
+			{
+				memcpy(&blocks[offset], PLACEHOLDER_BC1_BLOCK, 8);
+			}
+		}
+
+		// the top level buffer is large enough for every level
+		int levelWidth = group.width;
+		int levelHeight = group.height;
+		for (int level = 0; level < group.levelCount; level++)
+		{
+			GLsizei levelSize = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize;
+
+			for (int layer = 0; layer < group.layerCount; layer++)
+			{
+				glCompressedTexSubImage3D(
+					GL_TEXTURE_2D_ARRAY,
+					level,
+					0, 0, layer,
+					levelWidth, levelHeight, 1,
+					group.internalFormat,
+					levelSize,
+					blocks.data());
+			}
+
+			levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+			levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+		}
+	}
+	else
+	{
+		GLenum pixelFormat = (group.colorChannels == 4) ? GL_RGBA : GL_RGB;
+		std::vector<unsigned char> pixels((size_t)group.width * group.height * group.colorChannels, PLACEHOLDER_GRAY);
+
+		for (int layer = 0; layer < group.layerCount; layer++)
+		{
+			glTexSubImage3D(
+				GL_TEXTURE_2D_ARRAY,
+				0,
+				0, 0, layer,
+				group.width, group.height, 1,
+				pixelFormat,
+				GL_UNSIGNED_BYTE,
+				pixels.data());
+		}
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/***********************************************************
+ *  BindArrays()
+ *
+ *  This method is used for binding each array group to the
+ *  texture unit with the same index as the group.
+ ***********************************************************/
+void TextureArrays::BindArrays()
+{
+	GLint maxUnits = 0;
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+
+	for (size_t index = 0; index < m_groups.size(); index++)
+	{
+		if ((GLint)index >= maxUnits)
+		{
+			std::cout << "Too many texture array groups for the available texture units:" << m_groups.size() << std::endl;
+			break;
+		}
+
+		// bind texture arrays on corresponding texture units
+		glActiveTexture(GL_TEXTURE0 + (GLenum)index);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_groups[index].textureID);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing all of the texture arrays.
+ ***********************************************************/
+void TextureArrays::Destroy()
+{
+	for (size_t index = 0; index < m_groups.size(); index++)
+	{
+		if (m_groups[index].textureID != 0)
+		{
+			glDeleteTextures(1, &m_groups[index].textureID);
+			m_groups[index].textureID = 0;
+		}
+	}
+	m_groups.clear();
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the OpenGL texture object
+ *  of a group, 0 is returned before it is allocated.
+ ***********************************************************/
+GLuint TextureArrays::GetTextureID(int group) const
+{
+	if ((group < 0) || (group >= (int)m_groups.size()))
+	{
+		return(0);
+	}
+
+	return(m_groups[group].textureID);
+}
+
+/***********************************************************
+ *  GetGroupCount()
+ *
+ *  This method is used for getting the number of groups.
+ ***********************************************************/
+int TextureArrays::GetGroupCount() const
+{
+	return((int)m_groups.size());
+}
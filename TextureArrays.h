@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// group scene textures into 2D texture arrays selected by layer index
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class stores the scene textures as layers of 2D
+ *  texture arrays.  Textures with the same size and format
+ *  share an array, so one bound array serves any number of
+ *  textures and a draw selects its texture with a layer
+ *  index instead of a texture unit.  Layers are reserved
+ *  first and the arrays are allocated once the number of
+ *  layers in each group is known.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// most array groups, one texture unit each; the texture
+	// units past them are kept for the lighting textures
+	static const int MAX_GROUPS = 12;
+
+	// textures of one size and format stored in one array
+	struct ARRAY_GROUP
+	{
+		GLuint textureID;
+		int width;
+		int height;
+		int colorChannels;
+		GLenum internalFormat;
+		int levelCount;
+		int layerCount;
+		// storage is allocated and no more layers can be added
+		bool bAllocated;
+	};
+
+private:
+	// texture array groups in the order they were created
+	std::vector<ARRAY_GROUP> m_groups;
+	// largest number of layers in one array
+	GLint m_maxLayers;
+
+	// fill every layer of a new array with a neutral gray
+	void FillPlaceholder(const ARRAY_GROUP& group);
+
+public:
+	// get the number of mipmap levels down to 1x1
+	static int GetLevelCount(int width, int height);
+
+	// reserve a layer for a texture of the passed in size and format
+	bool ReserveLayer(
+		int width,
+		int height,
+		int colorChannels,
+		GLenum internalFormat,
+		int& group,
+		int& layer);
+
+	// allocate the storage of every group with reserved layers
+	void AllocateStorage();
+
+	// bind each array group to the texture unit of the same index
+	void BindArrays();
+
+	// free all of the texture arrays
+	void Destroy();
+
+	// get the OpenGL texture object of a group
+	GLuint GetTextureID(int group) const;
+
+	// get the number of array groups
+	int GetGroupCount() const;
+};
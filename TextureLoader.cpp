@@ -0,0 +1,1124 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream them to OpenGL
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// size of the staging pixel buffer, images larger than this
+	// are uploaded directly from the decoded memory
+	const GLsizeiptr STAGING_BUFFER_SIZE = 64 * 1024 * 1024;
+
+	// longest time to wait for OpenGL to release a staging region
+	const GLuint64 STAGING_WAIT_TIMEOUT = 1000000000;
+
+	// identifies a compressed texture cache file - "TXC1"
+	const uint32_t CACHE_FILE_MAGIC = 0x31435854;
+	const uint32_t CACHE_FILE_VERSION = 1;
+
+	// layout of the start of a cache file, followed by one
+	// level entry per mipmap level and then the level data
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		// size and modification time of the source image, the
+		// cache file is rebuilt when either one changes
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint32_t format;
+		int32_t width;
+		int32_t height;
+		int32_t levelCount;
+	};
+
+	struct CACHE_FILE_LEVEL
+	{
+		int32_t width;
+		int32_t height;
+		uint32_t size;
+		uint32_t reserved;
+	};
+
+	// a mipmap chain of a texture no larger than 2^31 on a side
+	const int32_t MAX_CACHE_LEVELS = 32;
+
+	/***********************************************************
+	 *  GetCompressedLevelSize()
+	 *
+	 *  Gets the size of one mipmap level in the passed in block
+	 *  format, or 0 when the format is not one the cache stores.
+	 ***********************************************************/
+	GLsizeiptr GetCompressedLevelSize(uint32_t format, int width, int height)
+	{
+		GLsizeiptr blockSize = 0;
+
+		if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+		{
+			blockSize = 8;
+		}
+		else if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+		{
+			blockSize = 16;
+		}
+
+		return((GLsizeiptr)((width + 3) / 4) * ((height + 3) / 4) * blockSize);
+	}
+
+	/***********************************************************
+	 *  GetSourceKey()
+	 *
+	 *  Gets the size and modification time of a source image
+	 *  that are used to check whether a cache file is current.
+	 ***********************************************************/
+	bool GetSourceKey(const std::string& filename, uint64_t& sourceSize, int64_t& sourceTime)
+	{
+		std::error_code error;
+
+		sourceSize = (uint64_t)std::filesystem::file_size(filename, error);
+		if (error)
+		{
+			return(false);
+		}
+
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filename, error);
+		if (error)
+		{
+			return(false);
+		}
+		sourceTime = (int64_t)writeTime.time_since_epoch().count();
+
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class.  When no worker count is
+ *  passed in, one worker is started for each spare core.
+ ***********************************************************/
+TextureLoader::TextureLoader(int workerCount)
+{
+	m_bStopping = false;
+	m_pendingCount = 0;
+	m_stagingBuffer = 0;
+	m_stagingSize = 0;
+	m_pStagingMemory = NULL;
+	m_stagingHead = 0;
+	m_bCompressionSupported = false;
+	m_scratchTexture = 0;
+
+	if (workerCount <= 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+
+	// indicate to always flip images vertically when loaded,
+	// this is set before any worker starts decoding
+	stbi_set_flip_vertically_on_load(true);
+
+	for (int index = 0; index < workerCount; index++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerMain, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	// tell the workers to exit and wait for them
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_bStopping = true;
+	}
+	m_requestReady.notify_all();
+
+	for (size_t index = 0; index < m_workers.size(); index++)
+	{
+		m_workers[index].join();
+	}
+	m_workers.clear();
+
+	// free any images that were never uploaded
+	for (size_t index = 0; index < m_decoded.size(); index++)
+	{
+		if (m_decoded[index].bCompressed == true)
+		{
+			free(m_decoded[index].pixels);
+		}
+		else if (m_decoded[index].pixels != NULL)
+		{
+			stbi_image_free(m_decoded[index].pixels);
+		}
+	}
+	m_decoded.clear();
+
+	for (size_t index = 0; index < m_inFlight.size(); index++)
+	{
+		glDeleteSync(m_inFlight[index].fence);
+	}
+	m_inFlight.clear();
+
+	if (m_scratchTexture != 0)
+	{
+		glDeleteTextures(1, &m_scratchTexture);
+		m_scratchTexture = 0;
+	}
+
+	if (m_stagingBuffer != 0)
+	{
+		if (m_pStagingMemory != NULL)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			m_pStagingMemory = NULL;
+		}
+		glDeleteBuffers(1, &m_stagingBuffer);
+		m_stagingBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is run by each worker thread.  It takes image
+ *  files from the request queue, decodes them and places the
+ *  decoded pixels in the upload queue.
+ ***********************************************************/
+void TextureLoader::WorkerMain()
+{
+	while (true)
+	{
+		LOAD_REQUEST request;
+
+		// wait for the next request
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			while ((m_bStopping == false) && (m_requests.size() == 0))
+			{
+				m_requestReady.wait(lock);
+			}
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		DECODED_IMAGE image;
+		image.request = request;
+		image.pixels = NULL;
+		image.width = 0;
+		image.height = 0;
+		image.colorChannels = 0;
+		image.bCompressed = false;
+		image.compressedFormat = 0;
+		image.dataSize = 0;
+
+		// a current cache file replaces decoding the source
+		if (ReadCacheFile(image) == false)
+		{
+			// try to parse the image data from the specified image file
+			image.pixels = stbi_load(
+				request.filename.c_str(),
+				&image.width,
+				&image.height,
+				&image.colorChannels,
+				0);
+		}
+
+		// failed images are queued as well so that the
+		// pending count is always brought back to zero
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_decoded.push_back(image);
+		}
+	}
+}
+
+/***********************************************************
+ *  CreateStagingBuffer()
+ *
+ *  This method is used for creating the staging pixel buffer.
+ *  When buffer storage is supported the buffer is mapped once
+ *  and kept mapped, otherwise it is mapped for every upload.
+ ***********************************************************/
+void TextureLoader::CreateStagingBuffer()
+{
+	glGenBuffers(1, &m_stagingBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBuffer);
+	m_stagingSize = STAGING_BUFFER_SIZE;
+
+	if ((GLEW_VERSION_4_4) || (GLEW_ARB_buffer_storage))
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_stagingSize, NULL, flags);
+		m_pStagingMemory = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_stagingSize, flags);
+	}
+	else
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, m_stagingSize, NULL, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/***********************************************************
+ *  AllocateStaging()
+ *
+ *  This method is used for reserving a region of the staging
+ *  buffer.  Regions are handed out in ring order, and any
+ *  earlier upload that is still reading an overlapping region
+ *  is waited on first.  -1 is returned if the region does not
+ *  fit in the staging buffer.
+ ***********************************************************/
+GLsizeiptr TextureLoader::AllocateStaging(GLsizeiptr size)
+{
+	if (size > m_stagingSize)
+	{
+		return(-1);
+	}
+
+	// wrap around when the region does not fit before the end
+	if (m_stagingHead + size > m_stagingSize)
+	{
+		m_stagingHead = 0;
+	}
+
+	GLsizeiptr offset = m_stagingHead;
+
+	std::deque<STAGING_REGION>::iterator region = m_inFlight.begin();
+	while (region != m_inFlight.end())
+	{
+		bool bOverlaps = (region->offset < offset + size) && (offset < region->offset + region->size);
+		if (bOverlaps == true)
+		{
+			glClientWaitSync(region->fence, GL_SYNC_FLUSH_COMMANDS_BIT, STAGING_WAIT_TIMEOUT);
+			glDeleteSync(region->fence);
+			region = m_inFlight.erase(region);
+		}
+		else
+		{
+			region++;
+		}
+	}
+
+	m_stagingHead = offset + size;
+
+	return(offset);
+}
+
+/***********************************************************
+ *  StageData()
+ *
+ *  This method is used for copying data into a new region of
+ *  the staging buffer.  The staging buffer is left bound and
+ *  the offset of the region is returned, or the buffer is
+ *  unbound and -1 returned when the data did not fit.
+ ***********************************************************/
+GLsizeiptr TextureLoader::StageData(const unsigned char* data, GLsizeiptr size)
+{
+	GLsizeiptr offset = -1;
+
+	if (m_stagingBuffer == 0)
+	{
+		CreateStagingBuffer();
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBuffer);
+	offset = AllocateStaging(size);
+	if (offset >= 0)
+	{
+		if (m_pStagingMemory != NULL)
+		{
+			memcpy(m_pStagingMemory + offset, data, size);
+		}
+		else
+		{
+			void* pMapped = glMapBufferRange(
+				GL_PIXEL_UNPACK_BUFFER,
+				offset,
+				size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (pMapped != NULL)
+			{
+				memcpy(pMapped, data, size);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			}
+			else
+			{
+				offset = -1;
+			}
+		}
+	}
+
+	if (offset < 0)
+	{
+		// the data is uploaded from client memory instead
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	return(offset);
+}
+
+/***********************************************************
+ *  FenceStaging()
+ *
+ *  This method is used for remembering when OpenGL has
+ *  finished reading the passed in staging region.
+ ***********************************************************/
+void TextureLoader::FenceStaging(GLsizeiptr offset, GLsizeiptr size)
+{
+	if (offset < 0)
+	{
+		return;
+	}
+
+	STAGING_REGION region;
+	region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	region.offset = offset;
+	region.size = size;
+	m_inFlight.push_back(region);
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for copying a decoded image into the
+ *  staging buffer and uploading it to its texture array
+ *  layer.  When the cache is enabled the mipmaps are made
+ *  uncompressed in a scratch texture and the driver then
+ *  compresses each level, and the compressed levels are
+ *  written to the cache and copied into the layer.
+ ***********************************************************/
+void TextureLoader::UploadImage(const DECODED_IMAGE& image)
+{
+	GLenum internalFormat = GetInternalFormat(image.colorChannels);
+	GLenum pixelFormat = (image.colorChannels == 4) ? GL_RGBA : GL_RGB;
+	GLsizeiptr imageSize = (GLsizeiptr)image.width * image.height * image.colorChannels;
+	GLsizeiptr offset = -1;
+	GLint previousTexture = 0;
+
+	if (internalFormat == 0)
+	{
+		std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+		return;
+	}
+	if ((image.width != image.request.width) || (image.height != image.request.height))
+	{
+		std::cout << "Image size changed since its texture layer was allocated:" << image.request.filename << std::endl;
+		return;
+	}
+
+	bool bCompress = (internalFormat != GL_RGB8) && (internalFormat != GL_RGBA8);
+
+	// copy the pixels into the staging buffer
+	offset = StageData(image.pixels, imageSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (bCompress == true)
+	{
+		std::vector<CACHED_LEVEL> levels;
+		std::vector<unsigned char> levelData;
+
+		// the upload must not disturb the textures bound for drawing
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+		if (m_scratchTexture == 0)
+		{
+			glGenTextures(1, &m_scratchTexture);
+		}
+		glBindTexture(GL_TEXTURE_2D, m_scratchTexture);
+
+		// drivers need not generate mipmaps of a compressed
+		// texture, so the mipmaps are generated uncompressed
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			(image.colorChannels == 4) ? GL_RGBA8 : GL_RGB8,
+			image.width,
+			image.height,
+			0,
+			pixelFormat,
+			GL_UNSIGNED_BYTE,
+			(offset >= 0) ? (const void*)offset : (const void*)image.pixels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		FenceStaging(offset, imageSize);
+
+		std::vector<CACHED_LEVEL> mipLevels;
+		std::vector<unsigned char> mipData;
+		ReadMipLevels(image.width, image.height, pixelFormat, image.colorChannels, mipLevels, mipData);
+
+		// then the driver compresses each level on its own
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)mipLevels.size() - 1);
+		for (size_t level = 0; level < mipLevels.size(); level++)
+		{
+			glTexImage2D(
+				GL_TEXTURE_2D,
+				(GLint)level,
+				internalFormat,
+				mipLevels[level].width,
+				mipLevels[level].height,
+				0,
+				pixelFormat,
+				GL_UNSIGNED_BYTE,
+				&mipData[mipLevels[level].offset]);
+		}
+
+		bool bReadBack = ReadCompressedLevels(image.width, image.height, levels, levelData);
+		// the default, so the next image gets its full chain
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+
+		if (bReadBack == true)
+		{
+			// store the compressed levels so that the next run
+			// can skip decoding and compressing this image
+			WriteCacheFile(image, internalFormat, levels, levelData);
+			UploadCompressedLevels(
+				image.request,
+				internalFormat,
+				levels,
+				levelData.data(),
+				(GLsizeiptr)levelData.size());
+		}
+		else
+		{
+			// the layer is still given the image, just without
+			// a cache file for the next run
+			std::cout << "The driver did not compress image:" << image.request.filename << std::endl;
+			UploadUncompressedLevels(image.request, pixelFormat, mipLevels, mipData.data());
+		}
+	}
+	else
+	{
+		// the upload must not disturb the textures bound for drawing
+		glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previousTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, image.request.textureID);
+
+		glTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			0, 0, image.request.layer,
+			image.width, image.height, 1,
+			pixelFormat,
+			GL_UNSIGNED_BYTE,
+			(offset >= 0) ? (const void*)offset : (const void*)image.pixels);
+
+		// generate the texture mipmaps for mapping textures to lower resolutions
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		FenceStaging(offset, imageSize);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)previousTexture);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	std::cout << "Successfully loaded image:" << image.request.filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+}
+
+/***********************************************************
+ *  UploadCompressedImage()
+ *
+ *  This method is used for uploading the compressed mipmap
+ *  levels that were read from a cache file.  The levels are
+ *  copied to the GPU as they are, no decoding or mipmap
+ *  generation is needed.
+ ***********************************************************/
+void TextureLoader::UploadCompressedImage(const DECODED_IMAGE& image)
+{
+	if ((image.width != image.request.width) ||
+		(image.height != image.request.height) ||
+		(image.compressedFormat != GetInternalFormat(image.colorChannels)))
+	{
+		std::cout << "Cached image does not match its texture layer:" << image.request.filename << std::endl;
+		return;
+	}
+
+	UploadCompressedLevels(
+		image.request,
+		image.compressedFormat,
+		image.levels,
+		image.pixels,
+		image.dataSize);
+
+	std::cout << "Successfully loaded cached image:" << image.request.filename << ", width:" << image.width << ", height:" << image.height << ", levels:" << image.levels.size() << std::endl;
+}
+
+/***********************************************************
+ *  UploadCompressedLevels()
+ *
+ *  This method is used for copying compressed mipmap levels
+ *  through the staging buffer into the layer of a texture
+ *  array.
+ ***********************************************************/
+void TextureLoader::UploadCompressedLevels(
+	const LOAD_REQUEST& request,
+	GLenum compressedFormat,
+	const std::vector<CACHED_LEVEL>& levels,
+	const unsigned char* data,
+	GLsizeiptr dataSize)
+{
+	GLsizeiptr offset = -1;
+	GLint previousTexture = 0;
+
+	offset = StageData(data, dataSize);
+
+	// the upload must not disturb the textures bound for drawing
+	glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previousTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, request.textureID);
+
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		const CACHED_LEVEL& cached = levels[level];
+		const void* pData = NULL;
+
+		if (offset >= 0)
+		{
+			pData = (const void*)(offset + cached.offset);
+		}
+		else
+		{
+			pData = (const void*)(data + cached.offset);
+		}
+
+		glCompressedTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			(GLint)level,
+			0, 0, request.layer,
+			cached.width, cached.height, 1,
+			compressedFormat,
+			(GLsizei)cached.size,
+			pData);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	FenceStaging(offset, dataSize);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)previousTexture);
+}
+
+/***********************************************************
+ *  UploadUncompressedLevels()
+ *
+ *  This method is used for copying uncompressed mipmap levels
+ *  into the layer of a texture array, used when the driver
+ *  could not give back the compressed levels.  A compressed
+ *  array compresses the levels as they are copied.
+ ***********************************************************/
+void TextureLoader::UploadUncompressedLevels(
+	const LOAD_REQUEST& request,
+	GLenum pixelFormat,
+	const std::vector<CACHED_LEVEL>& levels,
+	const unsigned char* data)
+{
+	GLint previousTexture = 0;
+
+	// the upload must not disturb the textures bound for drawing
+	glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previousTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, request.textureID);
+
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		glTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			(GLint)level,
+			0, 0, request.layer,
+			levels[level].width, levels[level].height, 1,
+			pixelFormat,
+			GL_UNSIGNED_BYTE,
+			data + levels[level].offset);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)previousTexture);
+}
+
+/***********************************************************
+ *  ReadMipLevels()
+ *
+ *  This method is used for reading back every uncompressed
+ *  mipmap level of the bound scratch texture, down to 1x1,
+ *  with the rows tightly packed.
+ ***********************************************************/
+void TextureLoader::ReadMipLevels(
+	int width,
+	int height,
+	GLenum pixelFormat,
+	int colorChannels,
+	std::vector<CACHED_LEVEL>& levels,
+	std::vector<unsigned char>& data) const
+{
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	int levelWidth = width;
+	int levelHeight = height;
+	for (GLint level = 0; ; level++)
+	{
+		CACHED_LEVEL mip;
+		mip.width = levelWidth;
+		mip.height = levelHeight;
+		mip.offset = (GLsizeiptr)data.size();
+		mip.size = (GLsizeiptr)levelWidth * levelHeight * colorChannels;
+		levels.push_back(mip);
+
+		data.resize(data.size() + mip.size);
+		glGetTexImage(GL_TEXTURE_2D, level, pixelFormat, GL_UNSIGNED_BYTE, &data[mip.offset]);
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
+/***********************************************************
+ *  ReadCompressedLevels()
+ *
+ *  This method is used for reading back every compressed
+ *  mipmap level of the bound scratch texture, down to 1x1.
+ *  False is returned if the driver stored it uncompressed.
+ ***********************************************************/
+bool TextureLoader::ReadCompressedLevels(
+	int width,
+	int height,
+	std::vector<CACHED_LEVEL>& levels,
+	std::vector<unsigned char>& data) const
+{
+	GLint bCompressed = GL_FALSE;
+
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &bCompressed);
+	if (bCompressed != GL_TRUE)
+	{
+		return(false);
+	}
+
+	int levelWidth = width;
+	int levelHeight = height;
+	for (GLint level = 0; ; level++)
+	{
+		GLint compressedSize = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressedSize);
+		if (compressedSize <= 0)
+		{
+			return(false);
+		}
+
+		CACHED_LEVEL cached;
+		cached.width = levelWidth;
+		cached.height = levelHeight;
+		cached.offset = (GLsizeiptr)data.size();
+		cached.size = compressedSize;
+		levels.push_back(cached);
+
+		data.resize(data.size() + compressedSize);
+		glGetCompressedTexImage(GL_TEXTURE_2D, level, &data[cached.offset]);
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cache file
+ *  for a source image.  The file name is used for readability
+ *  and a hash of the full path keeps the names unique.
+ ***********************************************************/
+std::string TextureLoader::GetCachePath(const std::string& filename) const
+{
+	std::ostringstream cachePath;
+	std::filesystem::path sourcePath(filename);
+
+	cachePath << m_cacheDirectory << "/" << sourcePath.stem().string()
+		<< "_" << std::hex << std::hash<std::string>()(filename) << ".texcache";
+
+	return(cachePath.str());
+}
+
+/***********************************************************
+ *  ReadCacheFile()
+ *
+ *  This method is used for reading the compressed levels of a
+ *  source image from its cache file.  False is returned when
+ *  there is no cache file, or when it is out of date.  This is
+ *  called on the worker threads.
+ ***********************************************************/
+bool TextureLoader::ReadCacheFile(DECODED_IMAGE& image) const
+{
+	CACHE_FILE_HEADER header;
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+
+	if ((m_cacheDirectory.empty() == true) || (m_bCompressionSupported == false))
+	{
+		return(false);
+	}
+	if (GetSourceKey(image.request.filename, sourceSize, sourceTime) == false)
+	{
+		return(false);
+	}
+
+	std::ifstream cacheFile(GetCachePath(image.request.filename).c_str(), std::ios::binary);
+	if (!cacheFile)
+	{
+		return(false);
+	}
+
+	cacheFile.read((char*)&header, sizeof(header));
+	if ((!cacheFile) ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.sourceSize != sourceSize) ||
+		(header.sourceTime != sourceTime) ||
+		(header.width != image.request.width) ||
+		(header.height != image.request.height) ||
+		(header.levelCount <= 0) ||
+		(header.levelCount > MAX_CACHE_LEVELS) ||
+		(GetCompressedLevelSize(header.format, 1, 1) == 0))
+	{
+		return(false);
+	}
+
+	// every level must have the size of the next level of the
+	// chain down to 1x1, so that a corrupt file never hands
+	// bad sizes to the upload
+	std::vector<CACHED_LEVEL> levels;
+	GLsizeiptr dataSize = 0;
+	int levelWidth = header.width;
+	int levelHeight = header.height;
+	for (int level = 0; level < header.levelCount; level++)
+	{
+		CACHE_FILE_LEVEL fileLevel;
+		cacheFile.read((char*)&fileLevel, sizeof(fileLevel));
+		if ((!cacheFile) ||
+			(fileLevel.width != levelWidth) ||
+			(fileLevel.height != levelHeight) ||
+			((GLsizeiptr)fileLevel.size != GetCompressedLevelSize(header.format, levelWidth, levelHeight)))
+		{
+			return(false);
+		}
+		if ((level == header.levelCount - 1) && ((levelWidth != 1) || (levelHeight != 1)))
+		{
+			return(false);
+		}
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+
+		CACHED_LEVEL cached;
+		cached.width = fileLevel.width;
+		cached.height = fileLevel.height;
+		cached.offset = dataSize;
+		cached.size = fileLevel.size;
+		levels.push_back(cached);
+		dataSize += fileLevel.size;
+	}
+
+	// the level data must fill the rest of the file exactly
+	std::streamoff dataStart = cacheFile.tellg();
+	cacheFile.seekg(0, std::ios::end);
+	std::streamoff fileEnd = cacheFile.tellg();
+	cacheFile.seekg(dataStart, std::ios::beg);
+	if ((!cacheFile) || (fileEnd - dataStart != (std::streamoff)dataSize))
+	{
+		return(false);
+	}
+
+	unsigned char* pData = (unsigned char*)malloc(dataSize);
+	if (pData == NULL)
+	{
+		return(false);
+	}
+	cacheFile.read((char*)pData, dataSize);
+	if (!cacheFile)
+	{
+		free(pData);
+		return(false);
+	}
+
+	image.pixels = pData;
+	image.width = header.width;
+	image.height = header.height;
+	image.colorChannels = (header.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+	image.bCompressed = true;
+	image.compressedFormat = header.format;
+	image.levels = levels;
+	image.dataSize = dataSize;
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteCacheFile()
+ *
+ *  This method is used for writing the compressed mipmap
+ *  levels of an image to the cache file for its source image.
+ *  This only happens the first time an image is loaded.
+ ***********************************************************/
+void TextureLoader::WriteCacheFile(
+	const DECODED_IMAGE& image,
+	GLenum compressedFormat,
+	const std::vector<CACHED_LEVEL>& levels,
+	const std::vector<unsigned char>& data) const
+{
+	CACHE_FILE_HEADER header;
+	std::vector<CACHE_FILE_LEVEL> fileLevels;
+
+	if (GetSourceKey(image.request.filename, header.sourceSize, header.sourceTime) == false)
+	{
+		return;
+	}
+
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		CACHE_FILE_LEVEL fileLevel;
+		fileLevel.width = levels[level].width;
+		fileLevel.height = levels[level].height;
+		fileLevel.size = (uint32_t)levels[level].size;
+		fileLevel.reserved = 0;
+		fileLevels.push_back(fileLevel);
+	}
+
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.format = compressedFormat;
+	header.width = image.width;
+	header.height = image.height;
+	header.levelCount = (int32_t)fileLevels.size();
+
+	std::ofstream cacheFile(GetCachePath(image.request.filename).c_str(), std::ios::binary | std::ios::trunc);
+	if (!cacheFile)
+	{
+		std::cout << "Could not write texture cache for:" << image.request.filename << std::endl;
+		return;
+	}
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write((const char*)fileLevels.data(), fileLevels.size() * sizeof(CACHE_FILE_LEVEL));
+	cacheFile.write((const char*)data.data(), data.size());
+}
+
+/***********************************************************
+ *  SetCacheDirectory()
+ *
+ *  This method is used for turning on the compressed texture
+ *  cache.  The directory is created when it does not exist.
+ *  The cache is only used when the driver supports S3TC.
+ ***********************************************************/
+void TextureLoader::SetCacheDirectory(const char* directory)
+{
+	std::error_code error;
+
+	m_bCompressionSupported = (GLEW_EXT_texture_compression_s3tc) ? true : false;
+	m_cacheDirectory = directory;
+
+	std::filesystem::create_directories(m_cacheDirectory, error);
+	if (error)
+	{
+		std::cout << "Texture cache disabled, could not create:" << directory << std::endl;
+		m_cacheDirectory.clear();
+	}
+}
+
+/***********************************************************
+ *  ReadImageInfo()
+ *
+ *  This method is used for reading the size and number of
+ *  color channels of an image from its file header, without
+ *  decoding the image.
+ ***********************************************************/
+bool TextureLoader::ReadImageInfo(
+	const char* filename,
+	int& width,
+	int& height,
+	int& colorChannels) const
+{
+	width = 0;
+	height = 0;
+	colorChannels = 0;
+
+	return(stbi_info(filename, &width, &height, &colorChannels) != 0);
+}
+
+/***********************************************************
+ *  GetInternalFormat()
+ *
+ *  This method is used for getting the texture format that
+ *  images with the passed in number of channels are stored
+ *  in.  Images are stored compressed when the cache is used.
+ ***********************************************************/
+GLenum TextureLoader::GetInternalFormat(int colorChannels) const
+{
+	bool bCompress = (m_bCompressionSupported == true) && (m_cacheDirectory.empty() == false);
+
+	// if the loaded image is in RGB format
+	if (colorChannels == 3)
+	{
+		return((bCompress == true) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB8);
+	}
+	// if the loaded image is in RGBA format - it supports transparency
+	if (colorChannels == 4)
+	{
+		return((bCompress == true) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_RGBA8);
+	}
+
+	return(0);
+}
+
+/***********************************************************
+ *  QueueTexture()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded and uploaded into the passed in layer of a
+ *  texture array.  The layer must have been allocated with
+ *  the size of the image.
+ ***********************************************************/
+void TextureLoader::QueueTexture(
+	const char* filename,
+	GLuint textureID,
+	int layer,
+	int width,
+	int height)
+{
+	LOAD_REQUEST request;
+	request.filename = filename;
+	request.textureID = textureID;
+	request.layer = layer;
+	request.width = width;
+	request.height = height;
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_requests.push_back(request);
+	}
+	m_requestReady.notify_one();
+
+	m_pendingCount++;
+}
+
+/***********************************************************
+ *  ProcessUploads()
+ *
+ *  This method is used for uploading up to the passed in
+ *  number of decoded images.  It must be called on the thread
+ *  that owns the OpenGL context.  The number of processed
+ *  images is returned.
+ ***********************************************************/
+int TextureLoader::ProcessUploads(int maxUploads)
+{
+	int processed = 0;
+
+	while ((m_pendingCount > 0) && (processed < maxUploads))
+	{
+		DECODED_IMAGE image;
+
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			if (m_decoded.size() == 0)
+			{
+				break;
+			}
+			image = m_decoded.front();
+			m_decoded.pop_front();
+		}
+
+		if (image.bCompressed == true)
+		{
+			UploadCompressedImage(image);
+
+			// free the cache file data from local memory
+			free(image.pixels);
+		}
+		else if (image.pixels != NULL)
+		{
+			UploadImage(image);
+
+			// free the image data from local memory
+			stbi_image_free(image.pixels);
+		}
+		else
+		{
+			std::cout << "Could not load image:" << image.request.filename << std::endl;
+		}
+
+		m_pendingCount--;
+		processed++;
+	}
+
+	// the scratch texture is only needed while compressing
+	if ((m_pendingCount == 0) && (m_scratchTexture != 0))
+	{
+		glDeleteTextures(1, &m_scratchTexture);
+		m_scratchTexture = 0;
+	}
+
+	return(processed);
+}
+
+/***********************************************************
+ *  WaitForAll()
+ *
+ *  This method is used for uploading images until every
+ *  queued texture has been processed.
+ ***********************************************************/
+void TextureLoader::WaitForAll()
+{
+	while (m_pendingCount > 0)
+	{
+		if (ProcessUploads(m_pendingCount) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  IsComplete()
+ *
+ *  This method is used for checking whether every queued
+ *  texture has been uploaded.
+ ***********************************************************/
+bool TextureLoader::IsComplete()
+{
+	return(m_pendingCount == 0);
+}
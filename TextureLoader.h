@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream them to OpenGL
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class decodes texture image files on a pool of worker
+ *  threads.  The decoded pixels are copied into a pixel buffer
+ *  object and uploaded to their texture array layer on the
+ *  OpenGL thread by ProcessUploads(), a few textures per
+ *  frame, so that the scene can be drawn with placeholder
+ *  layers while the real images are still loading.
+ *
+ *  When a cache directory is set and S3TC compression is
+ *  available, each texture is stored in the cache as BC1
+ *  (RGB) or BC3 (RGBA) blocks with a full mipmap chain the
+ *  first time it is uploaded.  Later runs read the cache file
+ *  directly and skip decoding the source image entirely.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader(int workerCount = 0);
+	// destructor
+	~TextureLoader();
+
+	struct LOAD_REQUEST
+	{
+		std::string filename;
+		// texture array and layer that receive the image
+		GLuint textureID;
+		int layer;
+		// size the layer was allocated with
+		int width;
+		int height;
+	};
+
+	// one mipmap level of a compressed cache file
+	struct CACHED_LEVEL
+	{
+		int width;
+		int height;
+		GLsizeiptr offset;
+		GLsizeiptr size;
+	};
+
+	struct DECODED_IMAGE
+	{
+		LOAD_REQUEST request;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+		// pixels hold compressed levels read from the cache
+		bool bCompressed;
+		GLenum compressedFormat;
+		std::vector<CACHED_LEVEL> levels;
+		GLsizeiptr dataSize;
+	};
+
+	struct STAGING_REGION
+	{
+		GLsync fence;
+		GLsizeiptr offset;
+		GLsizeiptr size;
+	};
+
+private:
+	// decoding worker threads
+	std::vector<std::thread> m_workers;
+	// images waiting to be decoded
+	std::deque<LOAD_REQUEST> m_requests;
+	// decoded images waiting to be uploaded
+	std::deque<DECODED_IMAGE> m_decoded;
+	// guards the request and decoded queues
+	std::mutex m_queueMutex;
+	std::condition_variable m_requestReady;
+	// tells the workers to exit
+	bool m_bStopping;
+	// number of requests that have not been uploaded yet
+	int m_pendingCount;
+
+	// staging pixel buffer shared by all uploads
+	GLuint m_stagingBuffer;
+	GLsizeiptr m_stagingSize;
+	// persistently mapped pointer, or NULL when the staging
+	// buffer is mapped for each upload
+	unsigned char* m_pStagingMemory;
+	// next free byte in the staging buffer
+	GLsizeiptr m_stagingHead;
+	// regions of the staging buffer still being read by OpenGL
+	std::deque<STAGING_REGION> m_inFlight;
+	// directory for the compressed texture cache, empty when
+	// the cache is not used
+	std::string m_cacheDirectory;
+	// the driver supports S3TC compressed textures
+	bool m_bCompressionSupported;
+	// 2D texture the driver compresses new images in
+	GLuint m_scratchTexture;
+
+	// worker thread loop
+	void WorkerMain();
+	// create the staging pixel buffer
+	void CreateStagingBuffer();
+	// reserve a region of the staging buffer for an upload
+	GLsizeiptr AllocateStaging(GLsizeiptr size);
+	// copy data into the staging buffer, -1 is returned
+	// when the data must be uploaded from client memory
+	GLsizeiptr StageData(const unsigned char* data, GLsizeiptr size);
+	// fence the staging region used by the last upload
+	void FenceStaging(GLsizeiptr offset, GLsizeiptr size);
+	// upload one decoded image to its texture layer
+	void UploadImage(const DECODED_IMAGE& image);
+	// upload the compressed levels read from the cache
+	void UploadCompressedImage(const DECODED_IMAGE& image);
+	// copy compressed mipmap levels into a texture layer
+	void UploadCompressedLevels(
+		const LOAD_REQUEST& request,
+		GLenum compressedFormat,
+		const std::vector<CACHED_LEVEL>& levels,
+		const unsigned char* data,
+		GLsizeiptr dataSize);
+	// copy uncompressed mipmap levels into a texture layer
+	void UploadUncompressedLevels(
+		const LOAD_REQUEST& request,
+		GLenum pixelFormat,
+		const std::vector<CACHED_LEVEL>& levels,
+		const unsigned char* data);
+	// read back the uncompressed levels of the scratch texture
+	void ReadMipLevels(
+		int width,
+		int height,
+		GLenum pixelFormat,
+		int colorChannels,
+		std::vector<CACHED_LEVEL>& levels,
+		std::vector<unsigned char>& data) const;
+	// read back the compressed levels of the scratch texture
+	bool ReadCompressedLevels(
+		int width,
+		int height,
+		std::vector<CACHED_LEVEL>& levels,
+		std::vector<unsigned char>& data) const;
+
+	// get the cache file path for a source image
+	std::string GetCachePath(const std::string& filename) const;
+	// try to read a valid cache file for a source image
+	bool ReadCacheFile(DECODED_IMAGE& image) const;
+	// write the compressed levels of an image to the cache
+	void WriteCacheFile(
+		const DECODED_IMAGE& image,
+		GLenum compressedFormat,
+		const std::vector<CACHED_LEVEL>& levels,
+		const std::vector<unsigned char>& data) const;
+
+public:
+	// set the directory used for the compressed texture cache,
+	// must be called on the OpenGL thread before queueing
+	void SetCacheDirectory(const char* directory);
+
+	// read the size and channel count from an image file header
+	bool ReadImageInfo(
+		const char* filename,
+		int& width,
+		int& height,
+		int& colorChannels) const;
+
+	// get the texture format used for an image, 0 is returned
+	// when the channel count is not supported
+	GLenum GetInternalFormat(int colorChannels) const;
+
+	// queue an image file to be decoded into a texture array layer
+	void QueueTexture(
+		const char* filename,
+		GLuint textureID,
+		int layer,
+		int width,
+		int height);
+
+	// upload decoded images, must be called on the OpenGL thread
+	int ProcessUploads(int maxUploads);
+
+	// block until every queued texture has been uploaded
+	void WaitForAll();
+
+	// check whether every queued texture has been uploaded
+	bool IsComplete();
+};
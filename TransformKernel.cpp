@@ -0,0 +1,319 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.cpp
+// ============
+// batched transform composition and frustum culling using SIMD
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TRANSFORM_KERNEL_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TRANSFORM_KERNEL_NEON
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	const float PI = 3.14159265f;
+	const float HALF_PI = 1.57079633f;
+	const float TWO_PI = 6.28318531f;
+	const float INV_TWO_PI = 0.159154943f;
+	const float DEGREES_TO_RADIANS = 0.0174532925f;
+
+	/***********************************************************
+	 *  The lane operations below are the only code that uses
+	 *  the instruction set directly, the kernels are written
+	 *  once on top of them.  Comparisons return a lane mask
+	 *  that is consumed by Select(), Or() and MoveMask().
+	 ***********************************************************/
+#if defined(__AVX2__)
+	typedef __m256 SIMD_FLOAT;
+	typedef __m256 SIMD_MASK;
+	const int SIMD_WIDTH = 8;
+	const char* const SIMD_NAME = "AVX2";
+
+	inline SIMD_FLOAT Load(const float* p) { return(_mm256_loadu_ps(p)); }
+	inline void Store(float* p, SIMD_FLOAT a) { _mm256_storeu_ps(p, a); }
+	inline SIMD_FLOAT Set1(float value) { return(_mm256_set1_ps(value)); }
+	inline SIMD_FLOAT Add(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm256_add_ps(a, b)); }
+	inline SIMD_FLOAT Sub(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm256_sub_ps(a, b)); }
+	inline SIMD_FLOAT Mul(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm256_mul_ps(a, b)); }
+	inline SIMD_FLOAT Round(SIMD_FLOAT a) { return(_mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); }
+	inline SIMD_MASK CmpLess(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	inline SIMD_MASK Or(SIMD_MASK a, SIMD_MASK b) { return(_mm256_or_ps(a, b)); }
+	inline SIMD_FLOAT Select(SIMD_MASK mask, SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm256_blendv_ps(b, a, mask)); }
+	inline uint32_t MoveMask(SIMD_MASK mask) { return((uint32_t)_mm256_movemask_ps(mask)); }
+#elif defined(TRANSFORM_KERNEL_SSE2)
+	typedef __m128 SIMD_FLOAT;
+	typedef __m128 SIMD_MASK;
+	const int SIMD_WIDTH = 4;
+	const char* const SIMD_NAME = "SSE2";
+
+	inline SIMD_FLOAT Load(const float* p) { return(_mm_loadu_ps(p)); }
+	inline void Store(float* p, SIMD_FLOAT a) { _mm_storeu_ps(p, a); }
+	inline SIMD_FLOAT Set1(float value) { return(_mm_set1_ps(value)); }
+	inline SIMD_FLOAT Add(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm_add_ps(a, b)); }
+	inline SIMD_FLOAT Sub(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm_sub_ps(a, b)); }
+	inline SIMD_FLOAT Mul(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm_mul_ps(a, b)); }
+	// SSE2 has no rounding instruction, but the conversion rounds
+	// to nearest and the angles are far inside the integer range
+	inline SIMD_FLOAT Round(SIMD_FLOAT a) { return(_mm_cvtepi32_ps(_mm_cvtps_epi32(a))); }
+	inline SIMD_MASK CmpLess(SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm_cmplt_ps(a, b)); }
+	inline SIMD_MASK Or(SIMD_MASK a, SIMD_MASK b) { return(_mm_or_ps(a, b)); }
+	inline SIMD_FLOAT Select(SIMD_MASK mask, SIMD_FLOAT a, SIMD_FLOAT b) { return(_mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))); }
+	inline uint32_t MoveMask(SIMD_MASK mask) { return((uint32_t)_mm_movemask_ps(mask)); }
+#elif defined(TRANSFORM_KERNEL_NEON)
+	typedef float32x4_t SIMD_FLOAT;
+	typedef uint32x4_t SIMD_MASK;
+	const int SIMD_WIDTH = 4;
+	const char* const SIMD_NAME = "NEON";
+
+	inline SIMD_FLOAT Load(const float* p) { return(vld1q_f32(p)); }
+	inline void Store(float* p, SIMD_FLOAT a) { vst1q_f32(p, a); }
+	inline SIMD_FLOAT Set1(float value) { return(vdupq_n_f32(value)); }
+	inline SIMD_FLOAT Add(SIMD_FLOAT a, SIMD_FLOAT b) { return(vaddq_f32(a, b)); }
+	inline SIMD_FLOAT Sub(SIMD_FLOAT a, SIMD_FLOAT b) { return(vsubq_f32(a, b)); }
+	inline SIMD_FLOAT Mul(SIMD_FLOAT a, SIMD_FLOAT b) { return(vmulq_f32(a, b)); }
+	inline SIMD_FLOAT Round(SIMD_FLOAT a) { return(vrndnq_f32(a)); }
+	inline SIMD_MASK CmpLess(SIMD_FLOAT a, SIMD_FLOAT b) { return(vcltq_f32(a, b)); }
+	inline SIMD_MASK Or(SIMD_MASK a, SIMD_MASK b) { return(vorrq_u32(a, b)); }
+	inline SIMD_FLOAT Select(SIMD_MASK mask, SIMD_FLOAT a, SIMD_FLOAT b) { return(vbslq_f32(mask, a, b)); }
+	inline uint32_t MoveMask(SIMD_MASK mask)
+	{
+		const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+		return(vaddvq_u32(vandq_u32(mask, vld1q_u32(laneBits))));
+	}
+#else
+	typedef float SIMD_FLOAT;
+	typedef bool SIMD_MASK;
+	const int SIMD_WIDTH = 1;
+	const char* const SIMD_NAME = "scalar";
+
+	inline SIMD_FLOAT Load(const float* p) { return(*p); }
+	inline void Store(float* p, SIMD_FLOAT a) { *p = a; }
+	inline SIMD_FLOAT Set1(float value) { return(value); }
+	inline SIMD_FLOAT Add(SIMD_FLOAT a, SIMD_FLOAT b) { return(a + b); }
+	inline SIMD_FLOAT Sub(SIMD_FLOAT a, SIMD_FLOAT b) { return(a - b); }
+	inline SIMD_FLOAT Mul(SIMD_FLOAT a, SIMD_FLOAT b) { return(a * b); }
+	inline SIMD_FLOAT Round(SIMD_FLOAT a) { return((a >= 0.0f) ? (float)(int)(a + 0.5f) : (float)(int)(a - 0.5f)); }
+	inline SIMD_MASK CmpLess(SIMD_FLOAT a, SIMD_FLOAT b) { return(a < b); }
+	inline SIMD_MASK Or(SIMD_MASK a, SIMD_MASK b) { return(a || b); }
+	inline SIMD_FLOAT Select(SIMD_MASK mask, SIMD_FLOAT a, SIMD_FLOAT b) { return(mask ? a : b); }
+	inline uint32_t MoveMask(SIMD_MASK mask) { return(mask ? 1u : 0u); }
+#endif
+
+	/***********************************************************
+	 *  LoadLanes()
+	 *
+	 *  Load a full set of lanes, padding the lanes past the end
+	 *  of the arrays with the fill value.
+	 ***********************************************************/
+	inline SIMD_FLOAT LoadLanes(const float* pValues, int available, float fill)
+	{
+		if (available >= SIMD_WIDTH)
+		{
+			return(Load(pValues));
+		}
+
+		float lanes[SIMD_WIDTH];
+		for (int lane = 0; lane < SIMD_WIDTH; lane++)
+		{
+			lanes[lane] = (lane < available) ? pValues[lane] : fill;
+		}
+		return(Load(lanes));
+	}
+
+	/***********************************************************
+	 *  Sin()
+	 *
+	 *  Polynomial sine of every lane.  The angle is wrapped into
+	 *  [-pi, pi] and reflected into [-pi/2, pi/2], where the
+	 *  degree 11 polynomial is accurate to about 1e-7.
+	 ***********************************************************/
+	inline SIMD_FLOAT Sin(SIMD_FLOAT x)
+	{
+		SIMD_FLOAT turns = Round(Mul(x, Set1(INV_TWO_PI)));
+		x = Sub(x, Mul(turns, Set1(TWO_PI)));
+
+		x = Select(CmpLess(Set1(HALF_PI), x), Sub(Set1(PI), x), x);
+		x = Select(CmpLess(x, Set1(-HALF_PI)), Sub(Set1(-PI), x), x);
+
+		SIMD_FLOAT x2 = Mul(x, x);
+		SIMD_FLOAT poly = Set1(-2.5052108e-8f);
+		poly = Add(Mul(poly, x2), Set1(2.7557319e-6f));
+		poly = Add(Mul(poly, x2), Set1(-1.9841270e-4f));
+		poly = Add(Mul(poly, x2), Set1(8.3333333e-3f));
+		poly = Add(Mul(poly, x2), Set1(-1.6666667e-1f));
+		poly = Add(Mul(poly, x2), Set1(1.0f));
+
+		return(Mul(poly, x));
+	}
+
+	inline SIMD_FLOAT Cos(SIMD_FLOAT x)
+	{
+		return(Sin(Add(x, Set1(HALF_PI))));
+	}
+}
+
+/***********************************************************
+ *  ComposeTransforms()
+ *
+ *  This method is used for building the model matrices of a
+ *  range of transforms.  The rotation and scale part of each
+ *  matrix is expanded by hand from
+ *  translation * rotationX * rotationY * rotationZ * scale,
+ *  which matches the matrices built one at a time with glm.
+ ***********************************************************/
+void TransformKernel::ComposeTransforms(
+	const TRANSFORM_ARRAYS& transforms,
+	int first,
+	int count,
+	glm::mat4* pMatrices)
+{
+	// upper 3x3 of each matrix, column major, one row per lane set
+	float columns[9][SIMD_WIDTH];
+
+	for (int batch = first; batch < first + count; batch += SIMD_WIDTH)
+	{
+		int available = first + count - batch;
+
+		SIMD_FLOAT toRadians = Set1(DEGREES_TO_RADIANS);
+		SIMD_FLOAT angleX = Mul(LoadLanes(&transforms.rotationX[batch], available, 0.0f), toRadians);
+		SIMD_FLOAT angleY = Mul(LoadLanes(&transforms.rotationY[batch], available, 0.0f), toRadians);
+		SIMD_FLOAT angleZ = Mul(LoadLanes(&transforms.rotationZ[batch], available, 0.0f), toRadians);
+		SIMD_FLOAT scaleX = LoadLanes(&transforms.scaleX[batch], available, 1.0f);
+		SIMD_FLOAT scaleY = LoadLanes(&transforms.scaleY[batch], available, 1.0f);
+		SIMD_FLOAT scaleZ = LoadLanes(&transforms.scaleZ[batch], available, 1.0f);
+
+		SIMD_FLOAT sa = Sin(angleX);
+		SIMD_FLOAT ca = Cos(angleX);
+		SIMD_FLOAT sb = Sin(angleY);
+		SIMD_FLOAT cb = Cos(angleY);
+		SIMD_FLOAT sc = Sin(angleZ);
+		SIMD_FLOAT cc = Cos(angleZ);
+
+		// rotationY * rotationZ terms shared by the second and third rows
+		SIMD_FLOAT sbcc = Mul(sb, cc);
+		SIMD_FLOAT sbsc = Mul(sb, sc);
+
+		// first column is scaled by x
+		Store(columns[0], Mul(Mul(cb, cc), scaleX));
+		Store(columns[1], Mul(Add(Mul(ca, sc), Mul(sa, sbcc)), scaleX));
+		Store(columns[2], Mul(Sub(Mul(sa, sc), Mul(ca, sbcc)), scaleX));
+		// second column is scaled by y
+		Store(columns[3], Mul(Sub(Set1(0.0f), Mul(cb, sc)), scaleY));
+		Store(columns[4], Mul(Sub(Mul(ca, cc), Mul(sa, sbsc)), scaleY));
+		Store(columns[5], Mul(Add(Mul(sa, cc), Mul(ca, sbsc)), scaleY));
+		// third column is scaled by z
+		Store(columns[6], Mul(sb, scaleZ));
+		Store(columns[7], Mul(Sub(Set1(0.0f), Mul(sa, cb)), scaleZ));
+		Store(columns[8], Mul(Mul(ca, cb), scaleZ));
+
+		int lanes = (available < SIMD_WIDTH) ? available : SIMD_WIDTH;
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			int index = batch + lane;
+			glm::mat4& matrix = pMatrices[index];
+
+			for (int column = 0; column < 3; column++)
+			{
+				matrix[column][0] = columns[column * 3 + 0][lane];
+				matrix[column][1] = columns[column * 3 + 1][lane];
+				matrix[column][2] = columns[column * 3 + 2][lane];
+				matrix[column][3] = 0.0f;
+			}
+
+			matrix[3][0] = transforms.positionX[index];
+			matrix[3][1] = transforms.positionY[index];
+			matrix[3][2] = transforms.positionZ[index];
+			matrix[3][3] = 1.0f;
+		}
+	}
+}
+
+/***********************************************************
+ *  CullBoxes()
+ *
+ *  This method is used for testing world space boxes against
+ *  the six frustum planes.  A box is outside when its corner
+ *  furthest along a plane normal is behind that plane, which
+ *  is the same test as Frustum::IsBoxVisible().  The plane is
+ *  the same for every lane, so the corner is picked per plane
+ *  instead of per box.
+ ***********************************************************/
+void TransformKernel::CullBoxes(
+	const BOUNDS_ARRAYS& bounds,
+	int first,
+	int count,
+	const Frustum& frustum,
+	uint32_t* pVisibleBits)
+{
+	for (int word = first / 32; word < (first + count + 31) / 32; word++)
+	{
+		pVisibleBits[word] = 0;
+	}
+
+	for (int batch = first; batch < first + count; batch += SIMD_WIDTH)
+	{
+		int available = first + count - batch;
+
+		SIMD_FLOAT minX = LoadLanes(&bounds.minX[batch], available, 0.0f);
+		SIMD_FLOAT minY = LoadLanes(&bounds.minY[batch], available, 0.0f);
+		SIMD_FLOAT minZ = LoadLanes(&bounds.minZ[batch], available, 0.0f);
+		SIMD_FLOAT maxX = LoadLanes(&bounds.maxX[batch], available, 0.0f);
+		SIMD_FLOAT maxY = LoadLanes(&bounds.maxY[batch], available, 0.0f);
+		SIMD_FLOAT maxZ = LoadLanes(&bounds.maxZ[batch], available, 0.0f);
+		SIMD_FLOAT zero = Set1(0.0f);
+		SIMD_MASK outside = CmpLess(zero, zero);
+
+		for (int index = 0; index < Frustum::PLANE_COUNT; index++)
+		{
+			const glm::vec4& plane = frustum.GetPlane((Frustum::FRUSTUM_PLANE)index);
+
+			SIMD_FLOAT cornerX = (plane.x >= 0.0f) ? maxX : minX;
+			SIMD_FLOAT cornerY = (plane.y >= 0.0f) ? maxY : minY;
+			SIMD_FLOAT cornerZ = (plane.z >= 0.0f) ? maxZ : minZ;
+
+			SIMD_FLOAT distance = Add(
+				Add(Mul(cornerX, Set1(plane.x)), Mul(cornerY, Set1(plane.y))),
+				Add(Mul(cornerZ, Set1(plane.z)), Set1(plane.w)));
+
+			outside = Or(outside, CmpLess(distance, zero));
+		}
+
+		uint32_t laneMask = (available < SIMD_WIDTH) ? ((1u << available) - 1u) : ((1u << SIMD_WIDTH) - 1u);
+		uint32_t visible = ~MoveMask(outside) & laneMask;
+
+		// the lane count divides 32, so a batch never spans two words
+		pVisibleBits[batch / 32] |= visible << (batch % 32);
+	}
+}
+
+/***********************************************************
+ *  IsVisible()
+ *
+ *  This method is used for checking whether a box was found
+ *  to be visible by the last CullBoxes().
+ ***********************************************************/
+bool TransformKernel::IsVisible(const std::vector<uint32_t>& visibleBits, int index)
+{
+	return((visibleBits[index / 32] & (1u << (index % 32))) != 0);
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for getting the name of the
+ *  instruction set the kernels were compiled for.
+ ***********************************************************/
+const char* TransformKernel::GetInstructionSet()
+{
+	return(SIMD_NAME);
+}
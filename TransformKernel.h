@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.h
+// ============
+// batched transform composition and frustum culling using SIMD
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  TransformKernel
+ *
+ *  This class contains the batched kernels used when a scene
+ *  holds many objects.  The inputs are stored as structure of
+ *  arrays so that 4 (SSE2 or NEON) or 8 (AVX2) objects are
+ *  processed with each instruction.  The instruction set is
+ *  chosen when the project is compiled, and a scalar path is
+ *  used when none of them are available.
+ ***********************************************************/
+class TransformKernel
+{
+public:
+	// local transformation values, one entry per transform
+	struct TRANSFORM_ARRAYS
+	{
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		// rotations are in degrees
+		std::vector<float> rotationX;
+		std::vector<float> rotationY;
+		std::vector<float> rotationZ;
+		std::vector<float> scaleX;
+		std::vector<float> scaleY;
+		std::vector<float> scaleZ;
+	};
+
+	// world space bounding boxes, one entry per object
+	struct BOUNDS_ARRAYS
+	{
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+	};
+
+	// build translation * rotationX * rotationY * rotationZ * scale
+	// for the transforms in [first, first + count), the matrix
+	// for transform i is written to pMatrices[i]
+	static void ComposeTransforms(
+		const TRANSFORM_ARRAYS& transforms,
+		int first,
+		int count,
+		glm::mat4* pMatrices);
+
+	// test the boxes in [first, first + count) against the
+	// frustum, bit i of the visible bits is set when box i may
+	// be visible; first must be a multiple of 32 so that ranges
+	// tested on different threads never share a word
+	static void CullBoxes(
+		const BOUNDS_ARRAYS& bounds,
+		int first,
+		int count,
+		const Frustum& frustum,
+		uint32_t* pVisibleBits);
+
+	// check a bit written by CullBoxes()
+	static bool IsVisible(const std::vector<uint32_t>& visibleBits, int index);
+
+	// get the name of the instruction set that was compiled in
+	static const char* GetInstructionSet();
+};
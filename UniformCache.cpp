@@ -0,0 +1,253 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// shadow copy of shader uniform values for skipping redundant uploads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <cstring>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_uploadCount = 0;
+	m_skippedCount = 0;
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_pShaderManager = NULL;
+	m_uniforms.clear();
+}
+
+/***********************************************************
+ *  UpdateValue()
+ *
+ *  This method is used for comparing the passed in value with
+ *  the cached value for the uniform.  True is returned and the
+ *  cache updated when the value needs to be uploaded.
+ ***********************************************************/
+bool UniformCache::UpdateValue(
+	const char* name,
+	UNIFORM_TYPE type,
+	const float* values,
+	int count)
+{
+	std::unordered_map<std::string, CACHED_UNIFORM>::iterator found;
+
+	found = m_uniforms.find(name);
+	if ((found != m_uniforms.end()) &&
+		(found->second.valid == true) &&
+		(found->second.type == type) &&
+		(memcmp(found->second.values, values, count * sizeof(float)) == 0))
+	{
+		m_skippedCount++;
+		return(false);
+	}
+
+	CACHED_UNIFORM& cached = (found != m_uniforms.end()) ? found->second : m_uniforms[name];
+	cached.type = type;
+	cached.valid = true;
+	memcpy(cached.values, values, count * sizeof(float));
+	m_uploadCount++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  setIntValue()
+ *
+ *  This method is used for setting an integer uniform.
+ ***********************************************************/
+void UniformCache::setIntValue(const char* name, int value)
+{
+	float cacheValue = (float)value;
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_INT, &cacheValue, 1) == true))
+	{
+		m_pShaderManager->setIntValue(name, value);
+	}
+}
+
+/***********************************************************
+ *  setBoolValue()
+ *
+ *  This method is used for setting a boolean uniform.
+ ***********************************************************/
+void UniformCache::setBoolValue(const char* name, bool value)
+{
+	float cacheValue = (value == true) ? 1.0f : 0.0f;
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_INT, &cacheValue, 1) == true))
+	{
+		m_pShaderManager->setBoolValue(name, value);
+	}
+}
+
+/***********************************************************
+ *  setSampler2DValue()
+ *
+ *  This method is used for setting a texture sampler uniform.
+ ***********************************************************/
+void UniformCache::setSampler2DValue(const char* name, int value)
+{
+	float cacheValue = (float)value;
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_INT, &cacheValue, 1) == true))
+	{
+		m_pShaderManager->setSampler2DValue(name, value);
+	}
+}
+
+/***********************************************************
+ *  setFloatValue()
+ *
+ *  This method is used for setting a float uniform.
+ ***********************************************************/
+void UniformCache::setFloatValue(const char* name, float value)
+{
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_FLOAT, &value, 1) == true))
+	{
+		m_pShaderManager->setFloatValue(name, value);
+	}
+}
+
+/***********************************************************
+ *  setVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform.
+ ***********************************************************/
+void UniformCache::setVec2Value(const char* name, glm::vec2 value)
+{
+	float cacheValue[2] = { value.x, value.y };
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_VEC2, cacheValue, 2) == true))
+	{
+		m_pShaderManager->setVec2Value(name, value);
+	}
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform.
+ ***********************************************************/
+void UniformCache::setVec3Value(const char* name, glm::vec3 value)
+{
+	float cacheValue[3] = { value.x, value.y, value.z };
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_VEC3, cacheValue, 3) == true))
+	{
+		m_pShaderManager->setVec3Value(name, value);
+	}
+}
+
+/***********************************************************
+ *  setVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform.
+ ***********************************************************/
+void UniformCache::setVec4Value(const char* name, glm::vec4 value)
+{
+	float cacheValue[4] = { value.x, value.y, value.z, value.w };
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_VEC4, cacheValue, 4) == true))
+	{
+		m_pShaderManager->setVec4Value(name, value);
+	}
+}
+
+/***********************************************************
+ *  setMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform.
+ ***********************************************************/
+void UniformCache::setMat4Value(const char* name, const glm::mat4& value)
+{
+	float cacheValue[16];
+
+	for (int column = 0; column < 4; column++)
+	{
+		cacheValue[column * 4 + 0] = value[column].x;
+		cacheValue[column * 4 + 1] = value[column].y;
+		cacheValue[column * 4 + 2] = value[column].z;
+		cacheValue[column * 4 + 3] = value[column].w;
+	}
+
+	if ((NULL != m_pShaderManager) &&
+		(UpdateValue(name, UNIFORM_MAT4, cacheValue, 16) == true))
+	{
+		m_pShaderManager->setMat4Value(name, value);
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for clearing all of the cached values
+ *  so that the next value of every uniform is uploaded.  The
+ *  entries are only marked, so the map does not free and
+ *  allocate its nodes again every time.
+ ***********************************************************/
+void UniformCache::Invalidate()
+{
+	std::unordered_map<std::string, CACHED_UNIFORM>::iterator entry;
+
+	for (entry = m_uniforms.begin(); entry != m_uniforms.end(); ++entry)
+	{
+		entry->second.valid = false;
+	}
+}
+
+/***********************************************************
+ *  GetUploadCount()
+ *
+ *  This method is used for getting the number of values that
+ *  were passed on to the shader manager.
+ ***********************************************************/
+int UniformCache::GetUploadCount() const
+{
+	return(m_uploadCount);
+}
+
+/***********************************************************
+ *  GetSkippedCount()
+ *
+ *  This method is used for getting the number of values that
+ *  were skipped because they matched the cached value.
+ ***********************************************************/
+int UniformCache::GetSkippedCount() const
+{
+	return(m_skippedCount);
+}
+
+/***********************************************************
+ *  ResetCounters()
+ *
+ *  This method is used for resetting the upload statistics.
+ ***********************************************************/
+void UniformCache::ResetCounters()
+{
+	m_uploadCount = 0;
+	m_skippedCount = 0;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// shadow copy of shader uniform values for skipping redundant uploads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class sits in front of the shader manager and keeps
+ *  the last value that was uploaded for each uniform.  A new
+ *  value is only passed to the shader manager when it is
+ *  different from the cached one.
+ *
+ *  Uniforms are identified by their name, so the same name is
+ *  one cached uniform wherever its string is stored.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache(ShaderManager* pShaderManager);
+	// destructor
+	~UniformCache();
+
+	enum UNIFORM_TYPE
+	{
+		UNIFORM_INT,
+		UNIFORM_FLOAT,
+		UNIFORM_VEC2,
+		UNIFORM_VEC3,
+		UNIFORM_VEC4,
+		UNIFORM_MAT4
+	};
+
+	struct CACHED_UNIFORM
+	{
+		UNIFORM_TYPE type;
+		float values[16];
+		// false after Invalidate() until the next upload
+		bool valid;
+	};
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// last uploaded value of each uniform, keyed by name
+	std::unordered_map<std::string, CACHED_UNIFORM> m_uniforms;
+	// number of values passed on to the shader manager
+	int m_uploadCount;
+	// number of values skipped because they were unchanged
+	int m_skippedCount;
+
+	// check the cache and store the value if it changed
+	bool UpdateValue(
+		const char* name,
+		UNIFORM_TYPE type,
+		const float* values,
+		int count);
+
+public:
+	// set the uniform values through the cache
+	void setIntValue(const char* name, int value);
+	void setBoolValue(const char* name, bool value);
+	void setSampler2DValue(const char* name, int value);
+	void setFloatValue(const char* name, float value);
+	void setVec2Value(const char* name, glm::vec2 value);
+	void setVec3Value(const char* name, glm::vec3 value);
+	void setVec4Value(const char* name, glm::vec4 value);
+	void setMat4Value(const char* name, const glm::mat4& value);
+
+	// forget all cached values, for example after the
+	// shader program has been changed or reloaded
+	void Invalidate();
+
+	// statistics for the uploaded and skipped values
+	int GetUploadCount() const;
+	int GetSkippedCount() const;
+	void ResetCounters();
+};
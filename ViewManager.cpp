@@ -9,6 +9,10 @@
 
 #include "ViewManager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
@@ -24,17 +28,19 @@ namespace
 	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
-	// the 3D scene
+	// the 3D scene, only moved by the camera simulation
 	Camera* g_pCamera = nullptr;
+	// fixed tick thread that moves the camera from the input
+	CameraSimulation* g_pCameraSimulation = nullptr;
 
 	// these variables are used for mouse movement processing
 	float gLastX = WINDOW_WIDTH / 2.0f;
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f;
-	float gLastFrame = 0.0f;
+	// the camera, projection or window contents changed since
+	// the last drawn frame
+	bool gViewChanged = true;
 
 	// speed multiplier for camera movement
 	float gBaseSpeed = 2.5f;
@@ -42,6 +48,39 @@ namespace
 	// if orthographic projection is on, this value will be
 	// true
 	bool bOrthographicProjection = false;
+
+	// profiler keys held down during the last frame, so that
+	// holding a key only toggles once
+	bool gOverlayKeyDown = false;
+	bool gCaptureKeyDown = false;
+
+	// number of frames written by a profiler capture
+	const int PROFILER_CAPTURE_FRAMES = 300;
+
+	// key that steps through the view layouts, held down during
+	// the last frame
+	bool gLayoutKeyDown = false;
+
+	// the orthographic top and front views of the split layout
+	// look at this point from this distance, showing this much
+	// of the scene above and below it
+	const glm::vec3 ORTHO_VIEW_CENTER = glm::vec3(0.0f, 2.0f, 0.0f);
+	const float ORTHO_VIEW_DISTANCE = 50.0f;
+	const float ORTHO_VIEW_HALF_HEIGHT = 10.0f;
+
+	// distance between the stereo eyes, and the distance from
+	// them at which the two images line up
+	const float STEREO_EYE_SEPARATION = 0.3f;
+	const float STEREO_CONVERGENCE = 18.0f;
+
+	// names of the view layouts on the command line
+	const char* g_LayoutNames[ViewManager::LAYOUT_COUNT] = { "single", "split", "stereo" };
+
+	// cursor position of the last left click, in window
+	// coordinates, waiting to be picked
+	bool gPickPending = false;
+	double gPickX = 0.0;
+	double gPickY = 0.0;
 }
 
 /***********************************************************
@@ -55,12 +94,23 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pProfiler = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_layout = LAYOUT_SINGLE;
+	m_viewCount = 0;
+	for (int index = 0; index < 4; index++)
+	{
+		m_targetViewport[index] = 0;
+	}
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(2.5f, 5.5f, 18.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
+	g_pCameraSimulation = new CameraSimulation(g_pCamera);
+	g_pCameraSimulation->SetMoveSpeed(gBaseSpeed);
 }
 
 /***********************************************************
@@ -73,6 +123,13 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	m_pProfiler = NULL;
+	// the simulation thread is stopped before the camera is freed
+	if (NULL != g_pCameraSimulation)
+	{
+		delete g_pCameraSimulation;
+		g_pCameraSimulation = NULL;
+	}
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -109,6 +166,18 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to receive mouse scrolling events
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Wheel_Callback);
 
+	// this callback is used to receive window damage events
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
+	// this callback is used to receive window resize events
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+
+	// this callback is used to receive mouse button events
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+
+	// this callback is used to receive the camera movement keys
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+
 	// tell GLFW to capture all mouse events
 	//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -118,6 +187,9 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 
 	m_pWindow = window;
 
+	// move the camera from the input at a fixed tick
+	g_pCameraSimulation->Start();
+
 	return(window);
 }
 
@@ -148,66 +220,147 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 	gLastY = yMousePos;
 
 	// move the 3D camera according to the calculated offsets
-	g_pCamera->ProcessMouseMovement(gBaseSpeed * xOffset, gBaseSpeed * yOffset);
+	// at the next simulation tick
+	g_pCameraSimulation->AddMouseOffset(gBaseSpeed * xOffset, gBaseSpeed * yOffset);
 }
 
 /***********************************************************
- *  ProcessKeyboardEvents()
+ *  Mouse_Button_Callback()
  *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  This method is automatically called from GLFW whenever a
+ *  mouse button is pressed or released.  A left click keeps
+ *  the cursor position for picking in the next frame.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
 {
-	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if ((button != GLFW_MOUSE_BUTTON_LEFT) || (action != GLFW_PRESS))
 	{
-		glfwSetWindowShouldClose(m_pWindow, true);
+		return;
 	}
 
-	// if the camera object is null, then exit this method
-	if (NULL == g_pCamera)
+	glfwGetCursorPos(window, &gPickX, &gPickY);
+	gPickPending = true;
+
+	// the pick is made while drawing, so a still view is drawn
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key is pressed or released.  The camera movement keys are
+ *  passed on to the camera simulation, which moves the camera
+ *  at every tick while they are held down.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	CameraSimulation::MOVE_KEY moveKey;
+
+	// key repeats do not change whether the key is held
+	if ((action != GLFW_PRESS) && (action != GLFW_RELEASE))
 	{
 		return;
 	}
 
-	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	switch (key)
 	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime * gBaseSpeed);
+	// camera zooming in and out
+	case GLFW_KEY_W:
+		moveKey = CameraSimulation::MOVE_FORWARD;
+		break;
+	case GLFW_KEY_S:
+		moveKey = CameraSimulation::MOVE_BACKWARD;
+		break;
+	// camera panning left and right
+	case GLFW_KEY_A:
+		moveKey = CameraSimulation::MOVE_LEFT;
+		break;
+	case GLFW_KEY_D:
+		moveKey = CameraSimulation::MOVE_RIGHT;
+		break;
+	// camera panning up and down
+	case GLFW_KEY_Q:
+		moveKey = CameraSimulation::MOVE_UP;
+		break;
+	case GLFW_KEY_E:
+		moveKey = CameraSimulation::MOVE_DOWN;
+		break;
+	default:
+		return;
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+
+	g_pCameraSimulation->SetKeyDown(moveKey, (action == GLFW_PRESS));
+}
+
+/***********************************************************
+ *  ProcessKeyboardEvents()
+ *
+ *  This method is called to process any keyboard events
+ *  that may be waiting in the event queue.
+ ***********************************************************/
+void ViewManager::ProcessKeyboardEvents()
+{
+	// close the window if the escape key has been pressed
+	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime * gBaseSpeed);
+		glfwSetWindowShouldClose(m_pWindow, true);
 	}
 
-	// process camera panning left and right
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime * gBaseSpeed);
+	// the camera movement keys are received by Key_Callback()
+	// and applied by the camera simulation thread
+
+	// process orthographic projection toggle
+	if ((glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS) && (bOrthographicProjection == false)) {
+		bOrthographicProjection = true;
+		gViewChanged = true;
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime * gBaseSpeed);
+	if ((glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS) && (bOrthographicProjection == true)) {
+		bOrthographicProjection = false;
+		gViewChanged = true;
 	}
 
-	// process camera panning up and down
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	// step through the view layouts
+	bool bLayoutKey = (glfwGetKey(m_pWindow, GLFW_KEY_V) == GLFW_PRESS);
+	if ((bLayoutKey == true) && (gLayoutKeyDown == false))
 	{
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime * gBaseSpeed);
+		SetViewLayout((VIEW_LAYOUT)((m_layout + 1) % LAYOUT_COUNT));
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	gLayoutKeyDown = bLayoutKey;
+
+	// process the profiler overlay toggle and trace capture
+	if (NULL != m_pProfiler)
 	{
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime * gBaseSpeed);
+		bool bOverlayKey = (glfwGetKey(m_pWindow, GLFW_KEY_F1) == GLFW_PRESS);
+		bool bCaptureKey = (glfwGetKey(m_pWindow, GLFW_KEY_F12) == GLFW_PRESS);
+
+		if ((bOverlayKey == true) && (gOverlayKeyDown == false))
+		{
+			m_pProfiler->ToggleOverlay();
+			gViewChanged = true;
+		}
+		if ((bCaptureKey == true) && (gCaptureKeyDown == false))
+		{
+			m_pProfiler->StartCapture(PROFILER_CAPTURE_FRAMES, "frame_trace.json");
+		}
+		gOverlayKeyDown = bOverlayKey;
+		gCaptureKeyDown = bCaptureKey;
 	}
+}
 
-	// process orthographic projection toggle
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS) {
-		bOrthographicProjection = true;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS) {
-		bOrthographicProjection = false;
-	}
+/***********************************************************
+ *  ProcessInput()
+ *
+ *  This method is used for processing the window, projection
+ *  and profiler keys.  It runs whether or not a frame is
+ *  drawn, so that on-demand rendering can tell the view has
+ *  changed.
+ ***********************************************************/
+void ViewManager::ProcessInput()
+{
+	// process any keyboard events that may be waiting in the 
+	// event queue
+	ProcessKeyboardEvents();
 }
 
 /***********************************************************
@@ -215,52 +368,146 @@ void ViewManager::ProcessKeyboardEvents()
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  rendering.  The views of the layout are laid out in the
+ *  viewport that is set, which may be a scaled part of the
+ *  window, and the camera uniforms are set for the first.
  ***********************************************************/
 void ViewManager::PrepareSceneView()
 {
-	glm::mat4 view;
-	glm::mat4 projection;
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	ProfileScope scope(m_pProfiler, "PrepareSceneView");
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		viewport[0] = 0;
+		viewport[1] = 0;
+		GetViewSize(viewport[2], viewport[3]);
+	}
+	for (int index = 0; index < 4; index++)
+	{
+		m_targetViewport[index] = viewport[index];
+	}
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	int x = viewport[0];
+	int y = viewport[1];
+	int width = viewport[2];
+	int height = viewport[3];
+	int halfWidth = width / 2;
+	int halfHeight = height / 2;
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	// get the camera state blended between the last two
+	// simulation ticks for this frame
+	CameraSimulation::CAMERA_STATE camera = g_pCameraSimulation->GetInterpolatedState();
 
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	glm::mat4 view = glm::lookAt(camera.position, camera.position + camera.front, camera.up);
 
-	// check and set perspective
-	// define the current projection matrix
-	if (bOrthographicProjection == false)
+	m_viewCount = 0;
+	if (m_layout == LAYOUT_STEREO)
 	{
-		// perspective projection
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+		// each eye is moved along the camera right vector, and
+		// its frustum is sheared so both meet at the convergence
+		// distance
+		glm::vec3 right = glm::normalize(glm::cross(camera.front, camera.up));
+		float nearPlane = 0.1f;
+		float top = nearPlane * tanf(glm::radians(camera.zoom) * 0.5f);
+		float side = top * (float)halfWidth / (float)height;
+
+		for (int eye = 0; eye < 2; eye++)
+		{
+			float offset = ((eye == 0) ? -0.5f : 0.5f) * STEREO_EYE_SEPARATION;
+			float shift = offset * nearPlane / STEREO_CONVERGENCE;
+			glm::vec3 eyePosition = camera.position + right * offset;
+
+			AddView(
+				glm::lookAt(eyePosition, eyePosition + camera.front, camera.up),
+				glm::frustum(-side - shift, side - shift, -top, top, nearPlane, 100.0f),
+				x + eye * halfWidth, y, (eye == 0) ? halfWidth : width - halfWidth, height);
+		}
 	}
 	else
 	{
-		// front-view orthographic projection
-		double scale = 0.0;
-		scale = (double)WINDOW_HEIGHT / (double)WINDOW_WIDTH;
-		projection = glm::ortho(-5.0f, 5.0f, -5.0f * (float)scale, 5.0f * (float)scale, 0.1f, 100.0f);
+		int cameraWidth = (m_layout == LAYOUT_SPLIT) ? halfWidth : width;
+		glm::mat4 projection;
+
+		// check and set perspective
+		// define the current projection matrix
+		if (bOrthographicProjection == false)
+		{
+			// perspective projection
+			projection = glm::perspective(glm::radians(camera.zoom), (GLfloat)cameraWidth / (GLfloat)height, 0.1f, 100.0f);
+		}
+		else
+		{
+			// front-view orthographic projection
+			double scale = 0.0;
+			scale = (double)height / (double)cameraWidth;
+			projection = glm::ortho(-5.0f, 5.0f, -5.0f * (float)scale, 5.0f * (float)scale, 0.1f, 100.0f);
+		}
+		AddView(view, projection, x, y, cameraWidth, height);
+
+		if (m_layout == LAYOUT_SPLIT)
+		{
+			// top view above the front view, to the right of the
+			// camera
+			int orthoWidth = width - halfWidth;
+			float aspect = (float)orthoWidth / (float)std::max(halfHeight, 1);
+			glm::mat4 orthoProjection = glm::ortho(
+				-ORTHO_VIEW_HALF_HEIGHT * aspect, ORTHO_VIEW_HALF_HEIGHT * aspect,
+				-ORTHO_VIEW_HALF_HEIGHT, ORTHO_VIEW_HALF_HEIGHT,
+				0.1f, 100.0f);
+
+			AddView(
+				glm::lookAt(ORTHO_VIEW_CENTER + glm::vec3(0.0f, ORTHO_VIEW_DISTANCE, 0.0f), ORTHO_VIEW_CENTER, glm::vec3(0.0f, 0.0f, -1.0f)),
+				orthoProjection,
+				x + halfWidth, y + halfHeight, orthoWidth, height - halfHeight);
+			AddView(
+				glm::lookAt(ORTHO_VIEW_CENTER + glm::vec3(0.0f, 0.0f, ORTHO_VIEW_DISTANCE), ORTHO_VIEW_CENTER, glm::vec3(0.0f, 1.0f, 0.0f)),
+				orthoProjection,
+				x + halfWidth, y, orthoWidth, halfHeight);
+		}
 	}
 
+	// keep the matrices of the first view for culling the
+	// scene objects
+	m_viewMatrix = m_views[0].view;
+	m_projectionMatrix = m_views[0].projection;
+
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		m_pShaderManager->setMat4Value(g_ViewName, m_viewMatrix);
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		m_pShaderManager->setMat4Value(g_ProjectionName, m_projectionMatrix);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderManager->setVec3Value("viewPosition", glm::vec3(glm::inverse(m_viewMatrix)[3]));
 	}
 }
 
+/***********************************************************
+ *  AddView()
+ *
+ *  This method is used for adding one view to the layout of
+ *  the frame.
+ ***********************************************************/
+void ViewManager::AddView(const glm::mat4& view, const glm::mat4& projection, int x, int y, int width, int height)
+{
+	if (m_viewCount >= MAX_CAMERA_VIEWS)
+	{
+		return;
+	}
+
+	CAMERA_VIEW& cameraView = m_views[m_viewCount++];
+	cameraView.view = view;
+	cameraView.projection = projection;
+	cameraView.x = x;
+	cameraView.y = y;
+	cameraView.width = std::max(width, 1);
+	cameraView.height = std::max(height, 1);
+}
+
 /***********************************************************
  *  Mouse_Wheel_Callback()
  *
@@ -276,4 +523,261 @@ void ViewManager::Mouse_Wheel_Callback(GLFWwindow* window, double xoffset, doubl
 	if (gBaseSpeed <= 0) {
 		gBaseSpeed = 0.1f;
 	}
-}
\ No newline at end of file
+	g_pCameraSimulation->SetMoveSpeed(gBaseSpeed);
+
+	// only the speed of later moves changes, the view itself
+	// stays the same so no frame needs to be drawn
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is called from GLFW when the contents of the
+ *  window were damaged, for example after it was uncovered
+ *  or resized, and need to be drawn again.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is called from GLFW when the framebuffer of
+ *  the window changes size, so the projection and the scene
+ *  framebuffer have to follow.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler that records
+ *  the view preparation and receives the profiler keys.
+ ***********************************************************/
+void ViewManager::SetProfiler(Profiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
+
+/***********************************************************
+ *  GetViewSize()
+ *
+ *  This method is used for getting the size the view is
+ *  rendered at, which the views are laid out in when no
+ *  viewport has been set.  It
+ *  is the size of the window framebuffer, which may differ
+ *  from the window size on high density displays; while the
+ *  window is minimized the size it was created with is used.
+ ***********************************************************/
+void ViewManager::GetViewSize(int& width, int& height) const
+{
+	width = 0;
+	height = 0;
+	if (NULL != m_pWindow)
+	{
+		glfwGetFramebufferSize(m_pWindow, &width, &height);
+	}
+
+	if ((width <= 0) || (height <= 0))
+	{
+		width = WINDOW_WIDTH;
+		height = WINDOW_HEIGHT;
+	}
+}
+
+/***********************************************************
+ *  SetCameraView()
+ *
+ *  This method is used for placing the camera, for example
+ *  along a scripted benchmark path.
+ ***********************************************************/
+void ViewManager::SetCameraView(glm::vec3 position, glm::vec3 front)
+{
+	if (NULL == g_pCameraSimulation)
+	{
+		return;
+	}
+
+	g_pCameraSimulation->SetCameraView(position, front);
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method is used for getting the view matrix that was
+ *  set up by the last PrepareSceneView().
+ ***********************************************************/
+const glm::mat4& ViewManager::GetViewMatrix() const
+{
+	return(m_viewMatrix);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method is used for getting the projection matrix,
+ *  perspective or orthographic, that was set up by the last
+ *  PrepareSceneView().
+ ***********************************************************/
+const glm::mat4& ViewManager::GetProjectionMatrix() const
+{
+	return(m_projectionMatrix);
+}
+
+/***********************************************************
+ *  IsViewChanged()
+ *
+ *  This method is used for checking whether the camera, the
+ *  projection or the window contents have changed since the
+ *  last ResetViewChanged(), so the view needs to be drawn.
+ ***********************************************************/
+bool ViewManager::IsViewChanged() const
+{
+	return((gViewChanged == true) || (g_pCameraSimulation->IsChanged() == true));
+}
+
+/***********************************************************
+ *  ResetViewChanged()
+ *
+ *  This method is used for clearing the view changed flag
+ *  once a frame has been drawn for the current view.
+ ***********************************************************/
+void ViewManager::ResetViewChanged()
+{
+	gViewChanged = false;
+	g_pCameraSimulation->ResetChanged();
+}
+
+/***********************************************************
+ *  SetViewLayout()
+ *
+ *  This method is used for setting how the views are arranged
+ *  in the window from the next frame on.
+ ***********************************************************/
+void ViewManager::SetViewLayout(VIEW_LAYOUT layout)
+{
+	if ((layout < 0) || (layout >= LAYOUT_COUNT) || (layout == m_layout))
+	{
+		return;
+	}
+
+	m_layout = layout;
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  GetViewLayout()
+ *
+ *  This method is used for getting how the views are
+ *  arranged in the window.
+ ***********************************************************/
+ViewManager::VIEW_LAYOUT ViewManager::GetViewLayout() const
+{
+	return(m_layout);
+}
+
+/***********************************************************
+ *  GetViewCount()
+ *
+ *  This method is used for getting the number of views set
+ *  up by the last PrepareSceneView().
+ ***********************************************************/
+int ViewManager::GetViewCount() const
+{
+	return(m_viewCount);
+}
+
+/***********************************************************
+ *  GetView()
+ *
+ *  This method is used for getting the camera matrices and
+ *  viewport of one of the views of the current frame.
+ ***********************************************************/
+const ViewManager::CAMERA_VIEW& ViewManager::GetView(int index) const
+{
+	return(m_views[index]);
+}
+
+/***********************************************************
+ *  ParseViewLayout()
+ *
+ *  This method is used for converting a view layout name
+ *  from the command line.
+ ***********************************************************/
+bool ViewManager::ParseViewLayout(const char* name, VIEW_LAYOUT& layout)
+{
+	for (int index = 0; index < LAYOUT_COUNT; index++)
+	{
+		if (strcmp(name, g_LayoutNames[index]) == 0)
+		{
+			layout = (VIEW_LAYOUT)index;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the world space ray under
+ *  the last clicked cursor position.  The cursor is converted
+ *  from window coordinates to the viewport the views were
+ *  laid out in, which covers the window even when it is
+ *  drawn at a reduced scale, and then to the normalized
+ *  device coordinates of the view under it.  The points on
+ *  the near and far planes are taken back through the
+ *  inverse camera matrices of that view, which works for the
+ *  perspective and orthographic projections alike.  The ray
+ *  goes from the near plane to the far plane at parameter 1.
+ ***********************************************************/
+bool ViewManager::GetPickRay(glm::vec3& origin, glm::vec3& direction)
+{
+	int width = 0;
+	int height = 0;
+
+	if ((gPickPending == false) || (NULL == m_pWindow))
+	{
+		return(false);
+	}
+	gPickPending = false;
+
+	glfwGetWindowSize(m_pWindow, &width, &height);
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	float targetX = m_targetViewport[0] + (float)(gPickX / width) * m_targetViewport[2];
+	float targetY = m_targetViewport[1] + (float)(1.0 - gPickY / height) * m_targetViewport[3];
+
+	for (int index = 0; index < m_viewCount; index++)
+	{
+		const CAMERA_VIEW& view = m_views[index];
+
+		if ((targetX < view.x) || (targetX >= view.x + view.width) ||
+			(targetY < view.y) || (targetY >= view.y + view.height))
+		{
+			continue;
+		}
+
+		float x = 2.0f * (targetX - view.x) / view.width - 1.0f;
+		float y = 2.0f * (targetY - view.y) / view.height - 1.0f;
+		glm::mat4 inverseViewProjection = glm::inverse(view.projection * view.view);
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+
+		origin = glm::vec3(nearPoint) / nearPoint.w;
+		direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+		return(true);
+	}
+
+	return(false);
+}
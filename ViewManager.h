@@ -10,6 +10,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "Profiler.h"
+#include "CameraSimulation.h"
 #include "camera.h"
 
 // GLFW library
@@ -24,25 +26,116 @@ public:
 	// destructor
 	~ViewManager();
 
+	// arrangement of the views drawn each frame
+	enum VIEW_LAYOUT
+	{
+		// the camera over the whole window
+		LAYOUT_SINGLE,
+		// the camera beside orthographic top and front views
+		LAYOUT_SPLIT,
+		// left and right eye images side by side
+		LAYOUT_STEREO,
+		LAYOUT_COUNT
+	};
+
+	// camera matrices and viewport of one view
+	struct CAMERA_VIEW
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		// viewport in framebuffer pixels
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// most views any layout draws
+	static const int MAX_CAMERA_VIEWS = 3;
+
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 
 	// mouse scroll wheel callback for changing panning speed
 	static void Mouse_Wheel_Callback(GLFWwindow* window, double xoffset, double yoffset);
 
+	// window refresh callback for redrawing damaged window contents
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+	// framebuffer size callback for redrawing a resized window
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
+	// mouse button callback for picking the object under the cursor
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+
+	// keyboard callback for the camera movement keys
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// frame profiler, NULL when the view is not profiled
+	Profiler* m_pProfiler;
+	// camera matrices set up by the last PrepareSceneView(),
+	// those of the first view
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// views of the layout set up by the last PrepareSceneView(),
+	// and the viewport they were laid out in
+	VIEW_LAYOUT m_layout;
+	CAMERA_VIEW m_views[MAX_CAMERA_VIEWS];
+	int m_viewCount;
+	int m_targetViewport[4];
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// add a view of the layout
+	void AddView(const glm::mat4& view, const glm::mat4& projection, int x, int y, int width, int height);
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
 	
+	// process the window and profiler keys, called once per
+	// main loop iteration; the camera is moved by the camera
+	// simulation thread
+	void ProcessInput();
+
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// check whether the camera or window changed since the last
+	// ResetViewChanged(), so that the next frame looks different
+	bool IsViewChanged() const;
+	void ResetViewChanged();
+
+	// set the profiler that records the view preparation
+	void SetProfiler(Profiler* pProfiler);
+
+	// get the size the view is rendered at
+	void GetViewSize(int& width, int& height) const;
+
+	// place the camera at a position looking along a direction
+	void SetCameraView(glm::vec3 position, glm::vec3 front);
+
+	// get the camera matrices of the current frame
+	const glm::mat4& GetViewMatrix() const;
+	const glm::mat4& GetProjectionMatrix() const;
+
+	// set how the views are arranged, and get the views of the
+	// current frame
+	void SetViewLayout(VIEW_LAYOUT layout);
+	VIEW_LAYOUT GetViewLayout() const;
+	int GetViewCount() const;
+	const CAMERA_VIEW& GetView(int index) const;
+
+	// parse a view layout name, false for an unknown name
+	static bool ParseViewLayout(const char* name, VIEW_LAYOUT& layout);
+
+	// get the world space ray under the cursor position of the
+	// last click, false when there was no click since the last
+	// call; must be called after PrepareSceneView()
+	bool GetPickRay(glm::vec3& origin, glm::vec3& direction);
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#version 430 core
+
+// this must match CLUSTER_GROUP_SIZE in ClusteredLighting.cpp
+#define GROUP_SIZE 64
+layout (local_size_x = GROUP_SIZE) in;
+
+// these must match the values in ClusteredLighting.h
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 64
+
+// std430 layout of ClusteredLighting::POINT_LIGHT, two vec4
+// values per light
+layout (std430, binding = 0) readonly buffer LightBlock
+{
+	vec4 lightData[];       // [2i] xyz = world position, w = range; [2i + 1] rgb = color, a = specular intensity
+};
+
+layout (std430, binding = 1) writeonly buffer CountBlock
+{
+	uint clusterLightCounts[];
+};
+
+layout (std430, binding = 2) writeonly buffer IndexBlock
+{
+	uint clusterLightIndices[];
+};
+
+uniform mat4 inverseProjection;
+uniform mat4 view;
+// view space distances of the near and far planes
+uniform vec2 depthRange;
+uniform uint lightCount;
+
+// view space lights loaded by the group, xyz = position,
+// w = range
+shared vec4 groupLights[GROUP_SIZE];
+
+/***********************************************************
+ *  GetClusterPoint()
+ *
+ *  Gets the view space point at a view depth on the line
+ *  through a normalized device position, which works for
+ *  perspective and orthographic projections.
+ ***********************************************************/
+vec3 GetClusterPoint(vec2 ndc, float depth)
+{
+	vec4 nearPoint = inverseProjection * vec4(ndc, -1.0f, 1.0f);
+	vec4 farPoint = inverseProjection * vec4(ndc, 1.0f, 1.0f);
+
+	nearPoint.xyz /= nearPoint.w;
+	farPoint.xyz /= farPoint.w;
+
+	float amount = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+
+	return(mix(nearPoint.xyz, farPoint.xyz, amount));
+}
+
+void main()
+{
+	uint cluster = gl_GlobalInvocationID.x;
+	bool bCluster = (cluster < uint(CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z));
+	vec3 boxMin = vec3(0.0f);
+	vec3 boxMax = vec3(0.0f);
+	uint count = 0u;
+
+	// the cluster is the box around the corners of its screen
+	// tile at the near and far depth of its slice
+	if (bCluster == true)
+	{
+		uvec3 cell = uvec3(
+			cluster % uint(CLUSTER_COUNT_X),
+			(cluster / uint(CLUSTER_COUNT_X)) % uint(CLUSTER_COUNT_Y),
+			cluster / uint(CLUSTER_COUNT_X * CLUSTER_COUNT_Y));
+		vec2 tileMin = vec2(cell.xy) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0f - 1.0f;
+		vec2 tileMax = vec2(cell.xy + 1u) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0f - 1.0f;
+		float depthRatio = depthRange.y / depthRange.x;
+		float nearDepth = depthRange.x * pow(depthRatio, float(cell.z) / float(CLUSTER_COUNT_Z));
+		float farDepth = depthRange.x * pow(depthRatio, float(cell.z + 1u) / float(CLUSTER_COUNT_Z));
+
+		boxMin = GetClusterPoint(tileMin, nearDepth);
+		boxMax = boxMin;
+		for (int corner = 1; corner < 8; corner++)
+		{
+			vec2 ndc = vec2(((corner & 1) != 0) ? tileMax.x : tileMin.x, ((corner & 2) != 0) ? tileMax.y : tileMin.y);
+			vec3 point = GetClusterPoint(ndc, ((corner & 4) != 0) ? farDepth : nearDepth);
+
+			boxMin = min(boxMin, point);
+			boxMax = max(boxMax, point);
+		}
+	}
+
+	// the lights are moved to view space a group at a time, so
+	// each light is only read and transformed once per group
+	for (uint first = 0u; first < lightCount; first += uint(GROUP_SIZE))
+	{
+		uint light = first + gl_LocalInvocationID.x;
+
+		if (light < lightCount)
+		{
+			vec4 positionRange = lightData[light * 2u];
+			groupLights[gl_LocalInvocationID.x] = vec4((view * vec4(positionRange.xyz, 1.0f)).xyz, positionRange.w);
+		}
+		barrier();
+
+		uint groupCount = min(uint(GROUP_SIZE), lightCount - first);
+
+		for (uint index = 0u; (bCluster == true) && (index < groupCount); index++)
+		{
+			vec4 groupLight = groupLights[index];
+			vec3 closest = clamp(groupLight.xyz, boxMin, boxMax);
+			vec3 offset = groupLight.xyz - closest;
+
+			// lights past the end of a full list are dropped
+			if ((dot(offset, offset) <= groupLight.w * groupLight.w) &&
+				(count < uint(MAX_LIGHTS_PER_CLUSTER)))
+			{
+				clusterLightIndices[cluster * uint(MAX_LIGHTS_PER_CLUSTER) + count] = first + index;
+				count++;
+			}
+		}
+		barrier();
+	}
+
+	if (bCluster == true)
+	{
+		clusterLightCounts[cluster] = count;
+	}
+}
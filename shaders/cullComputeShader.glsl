@@ -0,0 +1,111 @@
+#version 430 core
+
+// this must match CULL_GROUP_SIZE in IndirectRenderer.cpp
+layout (local_size_x = 64) in;
+
+// this must match PrimitiveMeshes::LOD_COUNT
+#define LOD_COUNT 3
+
+// std430 layout of PrimitiveMeshes::INSTANCE_DATA
+struct Instance
+{
+	mat4 model;
+	vec4 color;
+	ivec4 info;             // x = material, y = use texture, z = texture layer, w = lod fade
+};
+
+// std430 layout of IndirectRenderer::CANDIDATE
+struct Candidate
+{
+	Instance instance;
+	vec4 boundsMin;         // xyz = world space box minimum, w = batch
+	vec4 boundsMax;         // xyz = world space box maximum
+};
+
+// layout of DrawElementsIndirectCommand
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer CandidateBlock
+{
+	Candidate candidates[];
+};
+
+layout (std430, binding = 1) buffer CommandBlock
+{
+	DrawCommand commands[];
+};
+
+layout (std430, binding = 2) writeonly buffer InstanceBlock
+{
+	Instance instances[];
+};
+
+// xyz = inward facing normal, w = distance
+uniform vec4 frustumPlanes[6];
+uniform uint candidateCount;
+
+// fourth row of projection * view and the vertical projection
+// scale, which give the projected size of a bounding sphere
+uniform vec4 clipRowW;
+uniform float projectionScale;
+// projected sizes below which levels 1 and 2 are drawn
+uniform vec2 lodScreenSizes;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= candidateCount)
+	{
+		return;
+	}
+
+	vec3 boundsMin = candidates[index].boundsMin.xyz;
+	vec3 boundsMax = candidates[index].boundsMax.xyz;
+
+	// reject the box when the corner furthest along a plane
+	// normal is behind that plane
+	for (int plane = 0; plane < 6; plane++)
+	{
+		vec4 frustumPlane = frustumPlanes[plane];
+		vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(frustumPlane.xyz, vec3(0.0f)));
+
+		if (dot(frustumPlane.xyz, corner) + frustumPlane.w < 0.0f)
+		{
+			return;
+		}
+	}
+
+	// pick the level of detail from the fraction of the view
+	// height covered by the bounding sphere
+	vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = length(boundsMax - center);
+	float w = dot(clipRowW.xyz, center) + clipRowW.w;
+	int lod = 0;
+
+	if (w > 0.0001f)
+	{
+		float screenSize = radius * projectionScale / w;
+
+		if (screenSize < lodScreenSizes.x)
+		{
+			lod = 1;
+		}
+		if (screenSize < lodScreenSizes.y)
+		{
+			lod = 2;
+		}
+	}
+
+	// append the instance to the range of the command for its
+	// batch and level of detail
+	int command = int(candidates[index].boundsMin.w) * LOD_COUNT + lod;
+	uint slot = atomicAdd(commands[command].instanceCount, 1u);
+	instances[commands[command].baseInstance + slot] = candidates[index].instance;
+}
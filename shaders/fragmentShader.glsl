@@ -0,0 +1,274 @@
+#version 330 core
+
+// these limits must match the values in SceneManager.cpp
+#define MAX_MATERIALS 256
+#define MAX_LIGHTS 16
+
+// the scene manager builds variants of this shader by adding
+// these defines after the #version line, the defaults give the
+// general program that chooses both paths at run time
+#ifndef TEXTURE_MODE
+#define TEXTURE_MODE 2          // 0 = solid color, 1 = textured, 2 = chosen per instance
+#endif
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT -1          // 0 = unlit, n = lit by n lights, -1 = chosen by bUseLighting
+#endif
+#ifndef DEPTH_ONLY
+#define DEPTH_ONLY 0            // 1 = only the level of detail fade, for the depth pre-pass
+#endif
+
+// std140 layout - each value is packed into a vec4
+struct Material
+{
+	vec4 ambientColor;      // rgb = ambient color, a = ambient strength
+	vec4 diffuseColor;      // rgb = diffuse color
+	vec4 specularColor;     // rgb = specular color, a = shininess
+};
+
+struct LightSource
+{
+	vec4 position;          // xyz = world position
+	vec4 ambientColor;      // rgb = ambient color
+	vec4 diffuseColor;      // rgb = diffuse color
+	vec4 specularColor;     // rgb = specular color
+	vec4 parameters;        // x = focal strength, y = specular intensity
+};
+
+layout (std140) uniform MaterialBlock
+{
+	Material materials[MAX_MATERIALS];
+};
+
+layout (std140) uniform LightBlock
+{
+	LightSource lightSources[MAX_LIGHTS];
+	ivec4 lightCount;       // x = number of defined light sources
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentColor;
+flat in int fragmentMaterialIndex;
+flat in int fragmentUseTexture;
+flat in int fragmentTextureLayer;
+flat in int fragmentLodFade;
+
+out vec4 outFragmentColor;
+
+#if LIGHT_COUNT < 0
+uniform bool bUseLighting = false;
+#endif
+uniform sampler2DArray objectTexture;
+uniform vec3 viewPosition;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform mat4 view;
+
+// these must match the values in ClusteredLighting.h
+#define MAX_LIGHTS_PER_CLUSTER 64
+
+// point lights binned into view space clusters by the light
+// binning compute shader, see ClusteredLighting
+uniform samplerBuffer pointLights;              // 2 texels per light: xyz = position, w = range; rgb = color, a = specular intensity
+uniform usamplerBuffer clusterLightCounts;
+uniform usamplerBuffer clusterLightIndices;
+uniform vec3 clusterCounts = vec3(0.0f);        // clusters along each axis, 0 when the point lights are off
+uniform vec2 clusterTileScale;                  // window coordinates to screen tiles
+uniform vec2 clusterViewportOrigin;             // window coordinates of the viewport corner
+uniform vec2 clusterDepthScaleBias;             // log(view depth) to depth slice
+
+// shadow maps of the first light sources, 6 layers per light
+// in the order +X, -X, +Y, -Y, +Z, -Z, these must match the
+// values in ShadowMaps
+#define MAX_SHADOW_LIGHTS 4
+#define SHADOW_NORMAL_OFFSET 0.02f
+uniform sampler2DArrayShadow shadowMaps;
+uniform int shadowLightCount = 0;
+uniform mat4 shadowMatrices[MAX_SHADOW_LIGHTS * 6];
+
+float CalcShadow(int light, vec3 lightPosition, vec3 lightNormal, vec3 vertexPosition)
+{
+	if (light >= shadowLightCount)
+	{
+		return(1.0f);
+	}
+
+	// the face the fragment is in is picked by the major axis
+	// of the direction from the light
+	vec3 fromLight = vertexPosition - lightPosition;
+	vec3 axis = abs(fromLight);
+	int face;
+
+	if ((axis.x >= axis.y) && (axis.x >= axis.z))
+	{
+		face = (fromLight.x >= 0.0f) ? 0 : 1;
+	}
+	else if (axis.y >= axis.z)
+	{
+		face = (fromLight.y >= 0.0f) ? 2 : 3;
+	}
+	else
+	{
+		face = (fromLight.z >= 0.0f) ? 4 : 5;
+	}
+
+	// the position is pushed out along the normal a little, so
+	// lit surfaces do not shadow themselves
+	int layer = light * 6 + face;
+	vec4 clip = shadowMatrices[layer] * vec4(vertexPosition + lightNormal * SHADOW_NORMAL_OFFSET, 1.0f);
+	vec3 coordinate = (clip.xyz / clip.w) * 0.5f + 0.5f;
+
+	return(texture(shadowMaps, vec4(coordinate.xy, float(layer), coordinate.z)));
+}
+
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow)
+{
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+
+	// ambient lighting
+	ambient = light.ambientColor.rgb * material.ambientColor.rgb * material.ambientColor.a;
+
+	// diffuse lighting
+	vec3 lightDirection = normalize(light.position.xyz - vertexPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	diffuse = impact * light.diffuseColor.rgb * material.diffuseColor.rgb;
+
+	// specular lighting
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), light.parameters.x);
+	specular = light.parameters.y * specularComponent * light.specularColor.rgb * material.specularColor.rgb;
+
+	// a shadowed fragment only keeps the ambient light
+	return(ambient + shadow * (diffuse + specular));
+}
+
+vec3 CalcPointLight(int index, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+	vec4 positionRange = texelFetch(pointLights, index * 2);
+	vec4 colorSpecular = texelFetch(pointLights, index * 2 + 1);
+
+	// the light fades out smoothly at its range
+	vec3 toLight = positionRange.xyz - vertexPosition;
+	float distanceSquared = dot(toLight, toLight);
+	float falloff = clamp(1.0f - distanceSquared / (positionRange.w * positionRange.w), 0.0f, 1.0f);
+	falloff *= falloff;
+
+	// diffuse lighting
+	vec3 lightDirection = toLight * inversesqrt(max(distanceSquared, 0.0001f));
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	vec3 diffuse = impact * colorSpecular.rgb * material.diffuseColor.rgb;
+
+	// specular lighting
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), material.specularColor.a);
+	vec3 specular = colorSpecular.a * specularComponent * colorSpecular.rgb * material.specularColor.rgb;
+
+	return(falloff * (diffuse + specular));
+}
+
+vec3 CalcClusterLights(Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+	// find the cluster from the screen tile and the slice of
+	// the view depth
+	float viewDepth = max(-(view * vec4(vertexPosition, 1.0f)).z, 0.0001f);
+	ivec3 cell = ivec3(
+		ivec2((gl_FragCoord.xy - clusterViewportOrigin) * clusterTileScale),
+		int(log(viewDepth) * clusterDepthScaleBias.x + clusterDepthScaleBias.y));
+	cell = clamp(cell, ivec3(0), ivec3(clusterCounts) - 1);
+
+	int cluster = (cell.z * int(clusterCounts.y) + cell.y) * int(clusterCounts.x) + cell.x;
+	int count = int(texelFetch(clusterLightCounts, cluster).r);
+	vec3 result = vec3(0.0f);
+
+	for (int i = 0; i < count; i++)
+	{
+		int index = int(texelFetch(clusterLightIndices, cluster * MAX_LIGHTS_PER_CLUSTER + i).r);
+		result += CalcPointLight(index, material, lightNormal, vertexPosition, viewDirection);
+	}
+
+	return(result);
+}
+
+vec3 CalcPhong(int count)
+{
+	Material material = materials[fragmentMaterialIndex];
+	vec3 lightNormal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+	vec3 phongResult = vec3(0.0f);
+
+	for (int i = 0; i < count; i++)
+	{
+		float shadow = CalcShadow(i, lightSources[i].position.xyz, lightNormal, fragmentPosition);
+		phongResult += CalcLightSource(lightSources[i], material, lightNormal, fragmentPosition, viewDirection, shadow);
+	}
+
+	// only the point lights that reach the cluster of the
+	// fragment are added
+	if (clusterCounts.x > 0.0f)
+	{
+		phongResult += CalcClusterLights(material, lightNormal, fragmentPosition, viewDirection);
+	}
+
+	return(phongResult);
+}
+
+// 4x4 ordered dither thresholds for the level of detail fade
+const float DITHER_THRESHOLDS[16] = float[16](
+	0.0f, 8.0f, 2.0f, 10.0f,
+	12.0f, 4.0f, 14.0f, 6.0f,
+	3.0f, 11.0f, 1.0f, 9.0f,
+	15.0f, 7.0f, 13.0f, 5.0f);
+
+void main()
+{
+	// while two levels of detail cross-fade, the level fading in
+	// keeps the pixels below the coverage and the level fading
+	// out keeps the rest, so every pixel is drawn exactly once
+	if (fragmentLodFade != 0)
+	{
+		ivec2 cell = ivec2(gl_FragCoord.xy) % 4;
+		float threshold = (DITHER_THRESHOLDS[cell.y * 4 + cell.x] + 0.5f) / 16.0f;
+		float coverage = float(abs(fragmentLodFade)) / 255.0f;
+
+		if ((fragmentLodFade > 0) == (threshold >= coverage))
+		{
+			discard;
+		}
+	}
+
+#if DEPTH_ONLY
+	// the color writes are masked during the depth pre-pass
+	outFragmentColor = vec4(0.0f);
+#else
+#if TEXTURE_MODE == 1
+	vec4 surfaceColor = texture(objectTexture, vec3(fragmentTextureCoordinate * UVscale, float(fragmentTextureLayer)));
+#elif TEXTURE_MODE == 2
+	vec4 surfaceColor = fragmentColor;
+
+	if (fragmentUseTexture != 0)
+	{
+		surfaceColor = texture(objectTexture, vec3(fragmentTextureCoordinate * UVscale, float(fragmentTextureLayer)));
+	}
+#else
+	vec4 surfaceColor = fragmentColor;
+#endif
+
+#if LIGHT_COUNT < 0
+	if (bUseLighting == true)
+	{
+		outFragmentColor = vec4(CalcPhong(lightCount.x) * surfaceColor.rgb, surfaceColor.a);
+	}
+	else
+	{
+		outFragmentColor = surfaceColor;
+	}
+#elif LIGHT_COUNT > 0
+	// the constant count lets the compiler unroll the loop
+	outFragmentColor = vec4(CalcPhong(LIGHT_COUNT) * surfaceColor.rgb, surfaceColor.a);
+#else
+	outFragmentColor = surfaceColor;
+#endif
+#endif
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+// the color writes are masked while the boxes are drawn, only
+// the samples that pass the depth test are counted
+out vec4 outFragmentColor;
+
+void main()
+{
+	outFragmentColor = vec4(1.0f);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// world space corner of an object bounding box, see OcclusionCuller
+layout (location = 0) in vec3 inCornerPosition;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+	gl_Position = viewProjection * vec4(inCornerPosition, 1.0f);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec3 fragmentColor;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	outFragmentColor = vec4(fragmentColor, 0.85f);
+}
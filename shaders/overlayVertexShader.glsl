@@ -0,0 +1,13 @@
+#version 330 core
+
+// frame time graph vertices, already in normalized device coordinates
+layout (location = 0) in vec2 inVertexPosition;
+layout (location = 1) in vec3 inVertexColor;
+
+out vec3 fragmentColor;
+
+void main()
+{
+	gl_Position = vec4(inVertexPosition, 0.0f, 1.0f);
+	fragmentColor = inVertexColor;
+}
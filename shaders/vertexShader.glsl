@@ -0,0 +1,72 @@
+#version 330 core
+
+// the full PrimitiveMeshes layout reads W as 1, the compact
+// layout stores 0 there and an octahedral normal in XY
+layout (location = 0) in vec4 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// per-instance values from the PrimitiveMeshes instance buffer
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in ivec4 inInstanceInfo;   // x = material, y = use texture, z = texture layer, w = lod fade
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentColor;
+flat out int fragmentMaterialIndex;
+flat out int fragmentUseTexture;
+flat out int fragmentTextureLayer;
+flat out int fragmentLodFade;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// the depth pre-pass draws with another program from this
+// shader, and the shading pass tests for the same depth
+invariant gl_Position;
+
+/***********************************************************
+ *  DecodeOctahedral()
+ *
+ *  Folds a point of the -1 to 1 square back onto the
+ *  octahedron and returns the unit normal it stands for.
+ ***********************************************************/
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0f);
+
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+
+	return(normalize(normal));
+}
+
+void main()
+{
+	mat4 model = inInstanceModel;
+	vec4 position = vec4(inVertexPosition.xyz, 1.0f);
+	vec3 normal = inVertexNormal;
+
+	if (inVertexPosition.w == 0.0f)
+	{
+		normal = DecodeOctahedral(inVertexNormal.xy);
+	}
+
+	// transform the vertex into clip space
+	gl_Position = projection * view * model * position;
+
+	// world space position and normal for the lighting calculations
+	fragmentPosition = vec3(model * position);
+	fragmentVertexNormal = mat3(transpose(inverse(model))) * normal;
+	fragmentTextureCoordinate = inTextureCoordinate;
+
+	// surface values that are the same for the whole instance
+	fragmentColor = inInstanceColor;
+	fragmentMaterialIndex = inInstanceInfo.x;
+	fragmentUseTexture = inInstanceInfo.y;
+	fragmentTextureLayer = inInstanceInfo.z;
+	fragmentLodFade = inInstanceInfo.w;
+}
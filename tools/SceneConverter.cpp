@@ -0,0 +1,386 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneconverter.cpp
+// ============
+// convert a text scene description into a binary scene file
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "../SceneFile.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// mesh names in SceneManager::MESH_TYPE order
+	const char* g_MeshNames[SceneFile::MESH_TYPE_COUNT] = {
+		"plane",
+		"sphere",
+		"half_sphere",
+		"cylinder",
+		"tapered_cylinder",
+		"torus",
+		"box"
+	};
+
+	// the values read from the description, with the names
+	// they are referred to by
+	struct SCENE_DESCRIPTION
+	{
+		std::vector<SceneFile::FILE_TEXTURE> textures;
+		std::vector<SceneFile::FILE_MATERIAL> materials;
+		std::vector<SceneFile::FILE_NODE> nodes;
+		std::vector<SceneFile::FILE_OBJECT> objects;
+		std::string strings;
+		std::unordered_map<std::string, int> textureIndices;
+		std::unordered_map<std::string, int> materialIndices;
+		std::unordered_map<std::string, int> nodeIndices;
+	};
+
+	/***********************************************************
+	 *  AddString()
+	 *
+	 *  Adds a string to the string table and returns its offset.
+	 ***********************************************************/
+	uint32_t AddString(SCENE_DESCRIPTION& scene, const std::string& value)
+	{
+		uint32_t offset = (uint32_t)scene.strings.size();
+
+		scene.strings += value;
+		scene.strings += '\0';
+
+		return(offset);
+	}
+
+	/***********************************************************
+	 *  FindIndex()
+	 *
+	 *  Finds a name in a table of names, -1 is returned when it
+	 *  has not been defined.
+	 ***********************************************************/
+	int FindIndex(const std::unordered_map<std::string, int>& indices, const std::string& name)
+	{
+		std::unordered_map<std::string, int>::const_iterator found = indices.find(name);
+
+		if (found == indices.end())
+		{
+			return(-1);
+		}
+
+		return(found->second);
+	}
+
+	/***********************************************************
+	 *  ReadFloats()
+	 *
+	 *  Reads a number of float values from a line.
+	 ***********************************************************/
+	bool ReadFloats(std::istringstream& line, float* pValues, int count)
+	{
+		for (int index = 0; index < count; index++)
+		{
+			if (!(line >> pValues[index]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseLine()
+	 *
+	 *  Reads one line of the description.  An error message is
+	 *  returned, which is empty when the line was read.
+	 ***********************************************************/
+	std::string ParseLine(SCENE_DESCRIPTION& scene, const std::string& text)
+	{
+		std::istringstream line(text);
+		std::string keyword;
+
+		// blank lines and comments are skipped
+		if ((!(line >> keyword)) || (keyword[0] == '#'))
+		{
+			return("");
+		}
+
+		if (keyword == "texture")
+		{
+			// texture <tag> <filename>
+			std::string tag;
+			std::string filename;
+			SceneFile::FILE_TEXTURE texture;
+
+			if (!(line >> tag >> filename))
+			{
+				return("expected: texture <tag> <filename>");
+			}
+			texture.tag = AddString(scene, tag);
+			texture.filename = AddString(scene, filename);
+			scene.textureIndices[tag] = (int)scene.textures.size();
+			scene.textures.push_back(texture);
+		}
+		else if (keyword == "material")
+		{
+			// material <tag> <ambient strength> <ambient rgb>
+			// <diffuse rgb> <specular rgb> <shininess>
+			std::string tag;
+			SceneFile::FILE_MATERIAL material;
+
+			if ((!(line >> tag)) ||
+				(ReadFloats(line, &material.ambientStrength, 1) == false) ||
+				(ReadFloats(line, material.ambientColor, 3) == false) ||
+				(ReadFloats(line, material.diffuseColor, 3) == false) ||
+				(ReadFloats(line, material.specularColor, 3) == false) ||
+				(ReadFloats(line, &material.shininess, 1) == false))
+			{
+				return("expected: material <tag> <strength> <ambient rgb> <diffuse rgb> <specular rgb> <shininess>");
+			}
+			material.tag = AddString(scene, tag);
+			scene.materialIndices[tag] = (int)scene.materials.size();
+			scene.materials.push_back(material);
+		}
+		else if (keyword == "node")
+		{
+			// node <name> <parent name, or - for a root node>
+			// <scale xyz> <rotation xyz in degrees> <position xyz>
+			std::string name;
+			std::string parent;
+			SceneFile::FILE_NODE node;
+
+			if ((!(line >> name >> parent)) ||
+				(ReadFloats(line, node.scaleXYZ, 3) == false) ||
+				(ReadFloats(line, node.rotationXYZ, 3) == false) ||
+				(ReadFloats(line, node.positionXYZ, 3) == false))
+			{
+				return("expected: node <name> <parent> <scale xyz> <rotation xyz> <position xyz>");
+			}
+			node.parent = -1;
+			if (parent != "-")
+			{
+				node.parent = FindIndex(scene.nodeIndices, parent);
+				if (node.parent < 0)
+				{
+					return("parent node must be defined first: " + parent);
+				}
+			}
+			scene.nodeIndices[name] = (int)scene.nodes.size();
+			scene.nodes.push_back(node);
+		}
+		else if (keyword == "object")
+		{
+			// object <node> <mesh> <material> texture <tag> [parts]
+			// object <node> <mesh> <material> color <rgba> [parts]
+			std::string nodeName;
+			std::string meshName;
+			std::string materialTag;
+			std::string surface;
+			std::string part;
+			SceneFile::FILE_OBJECT object;
+
+			if (!(line >> nodeName >> meshName >> materialTag >> surface))
+			{
+				return("expected: object <node> <mesh> <material> texture <tag> | color <r g b a>");
+			}
+
+			object.node = FindIndex(scene.nodeIndices, nodeName);
+			object.material = FindIndex(scene.materialIndices, materialTag);
+			object.mesh = SceneFile::MESH_TYPE_COUNT;
+			for (uint32_t mesh = 0; mesh < SceneFile::MESH_TYPE_COUNT; mesh++)
+			{
+				if (meshName == g_MeshNames[mesh])
+				{
+					object.mesh = mesh;
+				}
+			}
+			if (object.node < 0)
+			{
+				return("unknown node: " + nodeName);
+			}
+			if (object.material < 0)
+			{
+				return("unknown material: " + materialTag);
+			}
+			if (object.mesh == SceneFile::MESH_TYPE_COUNT)
+			{
+				return("unknown mesh: " + meshName);
+			}
+
+			// textured objects are drawn white where the
+			// texture is missing
+			object.texture = -1;
+			object.color[0] = 1.0f;
+			object.color[1] = 1.0f;
+			object.color[2] = 1.0f;
+			object.color[3] = 1.0f;
+			if (surface == "texture")
+			{
+				std::string textureTag;
+
+				if (!(line >> textureTag))
+				{
+					return("expected: texture <tag>");
+				}
+				object.texture = FindIndex(scene.textureIndices, textureTag);
+				if (object.texture < 0)
+				{
+					return("unknown texture: " + textureTag);
+				}
+			}
+			else if ((surface != "color") || (ReadFloats(line, object.color, 4) == false))
+			{
+				return("expected: texture <tag> | color <r g b a>");
+			}
+
+			// every part is drawn unless some are listed
+			object.parts = 0;
+			while (line >> part)
+			{
+				if (part == "top")
+				{
+					object.parts |= SceneFile::PART_TOP;
+				}
+				else if (part == "bottom")
+				{
+					object.parts |= SceneFile::PART_BOTTOM;
+				}
+				else if (part == "sides")
+				{
+					object.parts |= SceneFile::PART_SIDES;
+				}
+				else
+				{
+					return("unknown part: " + part);
+				}
+			}
+			if (object.parts == 0)
+			{
+				object.parts = SceneFile::PART_ALL;
+			}
+
+			scene.objects.push_back(object);
+		}
+		else
+		{
+			return("unknown keyword: " + keyword);
+		}
+
+		return("");
+	}
+
+	/***********************************************************
+	 *  PlaceArray()
+	 *
+	 *  Sets the position of the next array in the file and
+	 *  returns the offset after it, kept at a multiple of 16.
+	 ***********************************************************/
+	uint32_t PlaceArray(SceneFile::FILE_ARRAY& array, uint32_t offset, size_t count, size_t elementSize)
+	{
+		array.offset = offset;
+		array.count = (uint32_t)count;
+
+		return((uint32_t)((offset + count * elementSize + 15) & ~(size_t)15));
+	}
+
+	/***********************************************************
+	 *  WriteScene()
+	 *
+	 *  Writes the header and the arrays of a scene file.  Any
+	 *  padding between the arrays is written as zeros.
+	 ***********************************************************/
+	bool WriteScene(const SCENE_DESCRIPTION& scene, const char* filename)
+	{
+		SceneFile::FILE_HEADER header;
+		uint32_t offset = (uint32_t)((sizeof(header) + 15) & ~(size_t)15);
+
+		memset(&header, 0, sizeof(header));
+		header.magic = SceneFile::FILE_MAGIC;
+		header.version = SceneFile::FILE_VERSION;
+		offset = PlaceArray(header.textures, offset, scene.textures.size(), sizeof(SceneFile::FILE_TEXTURE));
+		offset = PlaceArray(header.materials, offset, scene.materials.size(), sizeof(SceneFile::FILE_MATERIAL));
+		offset = PlaceArray(header.nodes, offset, scene.nodes.size(), sizeof(SceneFile::FILE_NODE));
+		offset = PlaceArray(header.objects, offset, scene.objects.size(), sizeof(SceneFile::FILE_OBJECT));
+		header.strings.offset = offset;
+		header.strings.count = (uint32_t)scene.strings.size();
+		header.fileSize = offset + header.strings.count;
+
+		std::vector<char> data(header.fileSize, 0);
+
+		memcpy(&data[0], &header, sizeof(header));
+		memcpy(&data[header.textures.offset], scene.textures.data(), scene.textures.size() * sizeof(SceneFile::FILE_TEXTURE));
+		memcpy(&data[header.materials.offset], scene.materials.data(), scene.materials.size() * sizeof(SceneFile::FILE_MATERIAL));
+		memcpy(&data[header.nodes.offset], scene.nodes.data(), scene.nodes.size() * sizeof(SceneFile::FILE_NODE));
+		memcpy(&data[header.objects.offset], scene.objects.data(), scene.objects.size() * sizeof(SceneFile::FILE_OBJECT));
+		memcpy(&data[header.strings.offset], scene.strings.data(), scene.strings.size());
+
+		std::ofstream file(filename, std::ios::binary);
+		if (file.is_open() == false)
+		{
+			return(false);
+		}
+		file.write(data.data(), data.size());
+
+		return(file.good());
+	}
+}
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function converts the text scene description named
+ *  on the command line into a binary scene file.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	SCENE_DESCRIPTION scene;
+	std::string text;
+	int lineNumber = 0;
+
+	if (argc != 3)
+	{
+		std::cout << "usage: SceneConverter <description.txt> <scene.scn>" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	std::ifstream input(argv[1]);
+	if (input.is_open() == false)
+	{
+		std::cout << "Could not open scene description:" << argv[1] << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	// the string table always has at least one terminator
+	AddString(scene, "");
+
+	while (std::getline(input, text))
+	{
+		std::string error;
+
+		lineNumber++;
+		error = ParseLine(scene, text);
+		if (error.empty() == false)
+		{
+			std::cout << argv[1] << ":" << lineNumber << ": " << error << std::endl;
+			return(EXIT_FAILURE);
+		}
+	}
+
+	if (WriteScene(scene, argv[2]) == false)
+	{
+		std::cout << "Could not write scene file:" << argv[2] << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	std::cout << "Wrote " << scene.objects.size() << " objects, " << scene.nodes.size() << " nodes, " <<
+		scene.materials.size() << " materials and " << scene.textures.size() << " textures to " << argv[2] << std::endl;
+
+	return(EXIT_SUCCESS);
+}